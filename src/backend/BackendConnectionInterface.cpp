@@ -271,6 +271,18 @@ BackendConnectionInterface::remove(const Namespace& nspace,
                    may_not_exist);
 }
 
+void
+BackendConnectionInterface::remove_objects(const Namespace& nspace,
+                                           const std::vector<std::string>& names,
+                                           const ObjectMayNotExist may_not_exist)
+{
+    Logger l(__FUNCTION__, nspace);
+    LOG_INFO(nspace << ": removing " << names.size() << " objects");
+    return remove_objects_(nspace,
+                           names,
+                           may_not_exist);
+}
+
 uint64_t
 BackendConnectionInterface::getSize(const Namespace& nspace,
                                     const std::string& name)
@@ -386,6 +398,19 @@ BackendConnectionInterface::invalidate_cache_(const boost::optional<Namespace>&
              ": not invalidating local cache because there presumably isn't one");
 }
 
+void
+BackendConnectionInterface::remove_objects_(const Namespace& nspace,
+                                            const std::vector<std::string>& names,
+                                            const ObjectMayNotExist may_not_exist)
+{
+    for (const auto& name : names)
+    {
+        remove_(nspace,
+                name,
+                may_not_exist);
+    }
+}
+
 void
 BackendConnectionInterface::clearNamespace_(const Namespace& nspace)
 {
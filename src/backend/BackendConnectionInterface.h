@@ -23,9 +23,10 @@
 
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/intrusive/slist.hpp>
 #include <boost/optional.hpp>
 
+#include <vector>
+
 #include <youtils/Assert.h>
 #include <youtils/BooleanEnum.h>
 #include <youtils/CheckSum.h>
@@ -44,7 +45,6 @@ using byte = unsigned char;
 using buffer = byte*;
 
 class BackendConnectionInterface
-    : public boost::intrusive::slist_base_hook<>
 {
 protected:
     boost::posix_time::time_duration timeout_;
@@ -181,6 +181,14 @@ protected:
            const std::string& name,
            const ObjectMayNotExist may_not_exist = ObjectMayNotExist::F);
 
+    // Bulk removal of objects. Backends that support deleting several objects
+    // in one go (or in parallel) override remove_objects_, the default removes
+    // them one after another over this connection.
+    void
+    remove_objects(const Namespace& nspace,
+                   const std::vector<std::string>& names,
+                   const ObjectMayNotExist may_not_exist = ObjectMayNotExist::F);
+
     uint64_t
     getSize(const Namespace& nspace,
             const std::string& name);
@@ -308,6 +316,11 @@ private:
             const std::string& name,
             const ObjectMayNotExist) = 0;
 
+    virtual void
+    remove_objects_(const Namespace&,
+                    const std::vector<std::string>& names,
+                    const ObjectMayNotExist);
+
     virtual uint64_t
     getSize_(const Namespace&,
              const std::string& name) = 0;
@@ -86,10 +86,16 @@ BackendConnectionManager::BackendConnectionManager(const bpt::ptree& pt,
     , backend_interface_retries_on_error(pt)
     , backend_interface_retry_interval_secs(pt)
     , backend_interface_retry_backoff_multiplier(pt)
-    , connection_pools_(num_connection_pools(backend_connection_pool_shards.value()))
     , config_(BackendConfig::makeBackendConfig(pt))
 {
-    VERIFY(connection_pools_.size() > 0);
+    const size_t shards = num_connection_pools(backend_connection_pool_shards.value());
+    VERIFY(shards > 0);
+
+    connection_pools_.reserve(shards);
+    for (size_t i = 0; i < shards; ++i)
+    {
+        connection_pools_.emplace_back(std::make_unique<ConnectionPool>(backend_connection_pool_capacity.value() / shards));
+    }
 
     switch (config_->backend_type.value())
     {
@@ -128,10 +134,9 @@ BackendConnectionManager::~BackendConnectionManager()
 {
     for (auto& p : connection_pools_)
     {
-        while (not p.connections_.empty())
+        while (BackendConnectionInterface* c = p->pop())
         {
-            std::unique_ptr<BackendConnectionInterface> conn(&p.connections_.front());
-            p.connections_.pop_front();
+            delete c;
         }
     }
 
@@ -190,13 +195,55 @@ BackendConnectionManager::size() const
     size_t n = 0;
     for (const auto& p : connection_pools_)
     {
-        boost::lock_guard<decltype(p.lock_)> g(p.lock_);
-        n += p.connections_.size();
+        n += p->size_;
     }
 
     return n;
 }
 
+BackendConnectionInterface*
+BackendConnectionManager::pop_connection_(size_t idx)
+{
+    ConnectionPool& pool = *connection_pools_[idx];
+
+    BackendConnectionInterface* conn = pool.pop();
+    if (conn)
+    {
+        ++pool.hits_;
+        return conn;
+    }
+
+    const size_t n = connection_pools_.size();
+    for (size_t i = 1; i < n; ++i)
+    {
+        conn = connection_pools_[(idx + i) % n]->pop();
+        if (conn)
+        {
+            ++pool.steals_;
+            return conn;
+        }
+    }
+
+    ++pool.misses_;
+    return nullptr;
+}
+
+BackendConnectionManager::PoolCounters
+BackendConnectionManager::pool_counters() const
+{
+    PoolCounters c;
+
+    for (const auto& p : connection_pools_)
+    {
+        c.hits += p->hits_;
+        c.misses += p->misses_;
+        c.steals += p->steals_;
+        c.creations += p->creations_;
+    }
+
+    return c;
+}
+
 size_t
 BackendConnectionManager::shards() const
 {
@@ -335,11 +382,13 @@ BackendConnectionManager::update(const bpt::ptree& pt,
 
     for (auto& p : connection_pools_)
     {
-        boost::lock_guard<decltype(p.lock_)> g(p.lock_);
-        while (p.connections_.size() > new_cap.value() / connection_pools_.size())
+        while (p->size_ > new_cap.value() / connection_pools_.size())
         {
-            std::unique_ptr<BackendConnectionInterface> conn(&p.connections_.front());
-            p.connections_.pop_front();
+            std::unique_ptr<BackendConnectionInterface> conn(p->pop());
+            if (not conn)
+            {
+                break;
+            }
         }
     }
 
@@ -20,13 +20,14 @@
 #include "BackendParameters.h"
 #include "Namespace.h"
 
+#include <atomic>
+
 #include <boost/chrono.hpp>
-#include <boost/thread/lock_guard.hpp>
+#include <boost/lockfree/stack.hpp>
 
 #include <youtils/BooleanEnum.h>
 #include <youtils/ConfigurationReport.h>
 #include <youtils/IOException.h>
-#include <youtils/SpinLock.h>
 #include <youtils/StrongTypedString.h>
 #include <youtils/VolumeDriverComponent.h>
 
@@ -89,12 +90,61 @@ class BackendConnectionManager
     , public std::enable_shared_from_this<BackendConnectionManager>
 {
 private:
-    // Uses boost::intrusive to avoid (de)allocations when modifying the container.
-    // (which has to happen under the spinlock).
+    // One per shard (CPU). Connections are kept on a lock-free stack, size_
+    // enforces the shard's share of backend_connection_pool_capacity.
     struct ConnectionPool
     {
-        mutable fungi::SpinLock lock_;
-        boost::intrusive::slist<BackendConnectionInterface> connections_;
+        explicit ConnectionPool(size_t reserve)
+            : connections_(reserve)
+            , size_(0)
+            , hits_(0)
+            , misses_(0)
+            , steals_(0)
+            , creations_(0)
+        {}
+
+        ~ConnectionPool() = default;
+
+        ConnectionPool(const ConnectionPool&) = delete;
+
+        ConnectionPool&
+        operator=(const ConnectionPool&) = delete;
+
+        BackendConnectionInterface*
+        pop()
+        {
+            BackendConnectionInterface* conn = nullptr;
+            if (connections_.pop(conn))
+            {
+                --size_;
+            }
+
+            return conn;
+        }
+
+        bool
+        push(BackendConnectionInterface* conn,
+             size_t limit)
+        {
+            if (size_.fetch_add(1) < limit and connections_.push(conn))
+            {
+                return true;
+            }
+            else
+            {
+                --size_;
+                return false;
+            }
+        }
+
+        boost::lockfree::stack<BackendConnectionInterface*> connections_;
+        std::atomic<size_t> size_;
+
+        // accounted to the shard of the requesting thread
+        std::atomic<uint64_t> hits_;
+        std::atomic<uint64_t> misses_;
+        std::atomic<uint64_t> steals_;
+        std::atomic<uint64_t> creations_;
     };
 
 public:
@@ -120,22 +170,19 @@ public:
     inline BackendConnectionInterfacePtr
     getConnection(ForceNewConnection force_new = ForceNewConnection::F)
     {
-        ConnectionPool& pool = get_connection_pool_();
+        const size_t idx = get_connection_pool_index_();
         BackendConnectionDeleter d(shared_from_this());
         BackendConnectionInterfacePtr conn(nullptr, d);
 
+        if (force_new != ForceNewConnection::T)
         {
-            boost::lock_guard<decltype(pool.lock_)> g(pool.lock_);
-            if (force_new != ForceNewConnection::T and not pool.connections_.empty())
-            {
-                conn = BackendConnectionInterfacePtr(&pool.connections_.front(),
-                                                     d);
-                pool.connections_.pop_front();
-            }
+            conn = BackendConnectionInterfacePtr(pop_connection_(idx),
+                                                 d);
         }
 
         if (not conn)
         {
+            ++connection_pools_[idx]->creations_;
             conn = BackendConnectionInterfacePtr(newConnection_(),
                                                  d);
         }
@@ -180,6 +227,21 @@ public:
     size_t
     shards() const;
 
+    struct PoolCounters
+    {
+        // connection taken from the pool of the current CPU
+        uint64_t hits = 0;
+        // all pools were empty
+        uint64_t misses = 0;
+        // connection taken from the pool of another CPU
+        uint64_t steals = 0;
+        // new connections, including forced ones
+        uint64_t creations = 0;
+    };
+
+    PoolCounters
+    pool_counters() const;
+
     // VolumeDriverComponent Interface
     virtual void
     persist(boost::property_tree::ptree& pt,
@@ -232,7 +294,7 @@ private:
     DECLARE_PARAMETER(backend_interface_retry_backoff_multiplier);
 
     // one per (logical) CPU.
-    std::vector<ConnectionPool> connection_pools_;
+    std::vector<std::unique_ptr<ConnectionPool>> connection_pools_;
 
     std::unique_ptr<BackendConfig> config_;
 
@@ -254,11 +316,10 @@ private:
         ASSERT(conn != nullptr);
         if (conn->healthy())
         {
-            ConnectionPool& pool = get_connection_pool_();
-            boost::lock_guard<decltype(pool.lock_)> g(pool.lock_);
-            if (pool.connections_.size() < backend_connection_pool_capacity.value() / connection_pools_.size())
+            ConnectionPool& pool = *connection_pools_[get_connection_pool_index_()];
+            if (pool.push(conn,
+                          backend_connection_pool_capacity.value() / connection_pools_.size()))
             {
-                pool.connections_.push_front(*conn);
                 return;
             }
         }
@@ -266,8 +327,13 @@ private:
         delete conn;
     }
 
-    ConnectionPool&
-    get_connection_pool_()
+    // Tries the pool of the current CPU first and steals from the others
+    // if that one's empty.
+    BackendConnectionInterface*
+    pop_connection_(size_t idx);
+
+    size_t
+    get_connection_pool_index_() const
     {
         int cpu = sched_getcpu();
         if (cpu < 0)
@@ -278,7 +344,7 @@ private:
         ASSERT(not connection_pools_.empty());
         const auto n = static_cast<unsigned>(cpu);
 
-        return connection_pools_[n % connection_pools_.size()];
+        return n % connection_pools_.size();
     }
 
     friend class BackendConnectionDeleter;
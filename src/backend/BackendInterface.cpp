@@ -331,6 +331,19 @@ BackendInterface::remove(const std::string& name,
                              may_not_exist);
 }
 
+void
+BackendInterface::remove_objects(const std::vector<std::string>& names,
+                                 const ObjectMayNotExist may_not_exist,
+                                 const BackendRequestParameters& params)
+{
+    wrap_<void,
+          decltype(names),
+          ObjectMayNotExist>(params,
+                             &BackendConnectionInterface::remove_objects,
+                             names,
+                             may_not_exist);
+}
+
 void
 BackendInterface::partial_read(const BackendConnectionInterface::PartialReads& partial_reads,
                                BackendConnectionInterface::PartialReadFallbackFun& fallback_fun,
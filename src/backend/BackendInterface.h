@@ -102,6 +102,11 @@ public:
            const ObjectMayNotExist = ObjectMayNotExist::F,
            const BackendRequestParameters& = default_request_parameters());
 
+    void
+    remove_objects(const std::vector<std::string>& names,
+                   const ObjectMayNotExist = ObjectMayNotExist::F,
+                   const BackendRequestParameters& = default_request_parameters());
+
     BackendInterfacePtr
     clone() const;
 
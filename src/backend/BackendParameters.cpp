@@ -351,6 +351,20 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(bgc_threads,
                                       ShowDocumentation::T,
                                       4);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(bgc_batch_size,
+                                      backend::GarbageCollector::name(),
+                                      "bgc_batch_size",
+                                      "Maximum number of objects the BackendGarbageCollector removes with one bulk delete",
+                                      ShowDocumentation::T,
+                                      256U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(bgc_max_parallel_batches,
+                                      backend::GarbageCollector::name(),
+                                      "bgc_max_parallel_batches",
+                                      "Maximum number of bulk deletes the BackendGarbageCollector runs concurrently for a heap of garbage of a namespace",
+                                      ShowDocumentation::T,
+                                      2U);
+
 }
 
 // Local Variables: **
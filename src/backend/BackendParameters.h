@@ -100,6 +100,8 @@ DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(alba_connection_use_rora, bool);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(alba_connection_rora_manifest_cache_capacity, size_t);
 
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(bgc_threads, uint32_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(bgc_batch_size, std::atomic<uint32_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(bgc_max_parallel_batches, std::atomic<uint32_t>);
 
 }
 
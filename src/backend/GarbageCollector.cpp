@@ -17,23 +17,44 @@
 #include "BackendInterface.h"
 #include "GarbageCollector.h"
 
+#include <algorithm>
+#include <functional>
+
 #include <boost/property_tree/ptree.hpp>
 
 namespace backend
 {
 
+namespace bc = boost::chrono;
 namespace bpt = boost::property_tree;
+namespace ip = initialized_params;
 namespace yt = youtils;
 
+namespace
+{
+
+// length of the window over which the deletion rate is measured
+const bc::seconds rate_window(10);
+
+}
+
 const char*
 GarbageCollectorThreadPoolTraits::component_name = GarbageCollector::name();
 
 GarbageCollector::GarbageCollector(BackendConnectionManagerPtr cm,
                                    const bpt::ptree& pt,
                                    const RegisterComponent registerize)
-    : cm_(cm)
+    : yt::VolumeDriverComponent(registerize,
+                                pt)
+    , bgc_batch_size(pt)
+    , bgc_max_parallel_batches(pt)
+    , cm_(cm)
+    , deleted_objects_(0)
+    , rate_window_start_(Clock::now())
+    , rate_window_deletes_(0)
+    , deletes_per_second_(0)
     , thread_pool_(pt,
-                   registerize)
+                   RegisterComponent::F)
 {
 }
 
@@ -83,39 +104,63 @@ struct BarrierTask
     std::string nspace;
 };
 
-struct DeleteObjectTask
+struct DeleteObjectsTask
     : public GarbageCollector::ThreadPool::Task
 {
-    DeleteObjectTask(BackendConnectionManagerPtr c,
-                     const std::string& n,
-                     std::string o)
+    using DeletedFun = std::function<void(size_t)>;
+
+    DeleteObjectsTask(BackendConnectionManagerPtr c,
+                      const std::string& n,
+                      std::vector<std::string> o,
+                      size_t b,
+                      DeletedFun f)
         : GarbageCollector::ThreadPool::Task(yt::BarrierTask::F)
         , cm(c)
         , nspace(n)
-        , object_name(std::move(o))
-    {}
+        , object_names(std::move(o))
+        , batch_size(b)
+        , deleted(std::move(f))
+    {
+        VERIFY(batch_size > 0);
+    }
 
-    virtual ~DeleteObjectTask() = default;
+    virtual ~DeleteObjectsTask() = default;
 
     void
     run(int /* thread id */) override final
     {
+        // On errors the task is requeued by the ThreadPool and resumes with
+        // the batch that failed.
         try
         {
-            cm->newBackendInterface(Namespace(nspace))->remove(object_name,
-                                                               ObjectMayNotExist::T);
+            BackendInterfacePtr bi(cm->newBackendInterface(Namespace(nspace)));
+
+            while (next < object_names.size())
+            {
+                const size_t n = std::min(batch_size,
+                                          object_names.size() - next);
+                const std::vector<std::string>
+                    batch(object_names.begin() + next,
+                          object_names.begin() + next + n);
+
+                bi->remove_objects(batch,
+                                   ObjectMayNotExist::T);
+                next += n;
+                deleted(n);
+            }
         }
         catch (BackendNamespaceDoesNotExistException&)
         {
-            LOG_ERROR(nspace << "/" << object_name <<
-                      ": namespace does not exist (anymore?) - ignoring it");
+            LOG_ERROR(nspace << ": namespace does not exist (anymore?) - ignoring " <<
+                      (object_names.size() - next) << " objects");
+            next = object_names.size();
         }
     }
 
     const std::string&
     getName() const override final
     {
-        static const std::string s("GarbageCollectorDeleteObjectTask");
+        static const std::string s("GarbageCollectorDeleteObjectsTask");
         return s;
     }
 
@@ -127,7 +172,10 @@ struct DeleteObjectTask
 
     BackendConnectionManagerPtr cm;
     const std::string nspace;
-    const std::string object_name;
+    const std::vector<std::string> object_names;
+    const size_t batch_size;
+    DeletedFun deleted;
+    size_t next = 0;
 };
 
 }
@@ -135,13 +183,77 @@ struct DeleteObjectTask
 void
 GarbageCollector::queue(Garbage garbage)
 {
-    for (auto&& g : garbage.object_names)
+    const size_t count = garbage.object_names.size();
+    if (count == 0)
     {
-        std::unique_ptr<ThreadPool::Task> t(new DeleteObjectTask(cm_,
-                                                                 garbage.nspace.str(),
-                                                                 std::move(g)));
+        return;
+    }
+
+    const size_t batch_size = std::max<size_t>(1,
+                                               bgc_batch_size.value());
+    const size_t batches = (count + batch_size - 1) / batch_size;
+    const size_t ntasks = std::max<size_t>(1,
+                                           std::min<size_t>(batches,
+                                                            bgc_max_parallel_batches.value()));
+
+    // Hand out whole batches to the tasks, the first ones get an extra batch
+    // if it doesn't add up.
+    auto it = std::make_move_iterator(garbage.object_names.begin());
+    const auto end = std::make_move_iterator(garbage.object_names.end());
+
+    for (size_t i = 0; i < ntasks; ++i)
+    {
+        const size_t nbatches = batches / ntasks + (i < batches % ntasks ? 1 : 0);
+        const size_t n = std::min<size_t>(nbatches * batch_size,
+                                          end - it);
+
+        std::vector<std::string> names(it, it + n);
+        it += n;
+
+        std::unique_ptr<ThreadPool::Task>
+            t(new DeleteObjectsTask(cm_,
+                                    garbage.nspace.str(),
+                                    std::move(names),
+                                    batch_size,
+                                    [this](size_t count)
+                                    {
+                                        account_deletes_(count);
+                                    }));
         thread_pool_.addTask(std::move(t));
     }
+
+    VERIFY(it == end);
+}
+
+void
+GarbageCollector::account_deletes_(size_t count)
+{
+    deleted_objects_ += count;
+
+    boost::lock_guard<decltype(rate_lock_)> g(rate_lock_);
+
+    rate_window_deletes_ += count;
+
+    const Clock::time_point now = Clock::now();
+    const bc::duration<double> elapsed(now - rate_window_start_);
+
+    if (elapsed >= rate_window)
+    {
+        deletes_per_second_ = rate_window_deletes_ / elapsed.count();
+        LOG_INFO("removed " << rate_window_deletes_ << " objects in " <<
+                 elapsed << ": " << deletes_per_second_ << " deletes/s, " <<
+                 deleted_objects_ << " in total");
+
+        rate_window_start_ = now;
+        rate_window_deletes_ = 0;
+    }
+}
+
+double
+GarbageCollector::deletes_per_second() const
+{
+    boost::lock_guard<decltype(rate_lock_)> g(rate_lock_);
+    return deletes_per_second_;
 }
 
 std::future<bool>
@@ -160,4 +272,72 @@ GarbageCollector::name()
     return "backend_garbage_collector";
 }
 
+const char*
+GarbageCollector::componentName() const
+{
+    return name();
+}
+
+// The ThreadPool is not registered as a component of its own (it's
+// an implementation detail of ours) so we forward to it.
+void
+GarbageCollector::update(const bpt::ptree& pt,
+                         yt::UpdateReport& report)
+{
+    static_cast<yt::VolumeDriverComponent&>(thread_pool_).update(pt,
+                                                                 report);
+#define U(x)                                    \
+    x.update(pt,                                \
+             report)
+
+    U(bgc_batch_size);
+    U(bgc_max_parallel_batches);
+
+#undef U
+}
+
+void
+GarbageCollector::persist(bpt::ptree& pt,
+                          const ReportDefault report_default) const
+{
+    static_cast<const yt::VolumeDriverComponent&>(thread_pool_).persist(pt,
+                                                                        report_default);
+#define P(x)                                    \
+    x.persist(pt,                               \
+              report_default)
+
+    P(bgc_batch_size);
+    P(bgc_max_parallel_batches);
+
+#undef P
+}
+
+bool
+GarbageCollector::checkConfig(const bpt::ptree& pt,
+                              yt::ConfigurationReport& rep) const
+{
+    bool res = static_cast<const yt::VolumeDriverComponent&>(thread_pool_).checkConfig(pt,
+                                                                                      rep);
+
+    const ip::PARAMETER_TYPE(bgc_batch_size) batch_size(pt);
+    if (batch_size.value() == 0)
+    {
+        rep.emplace_back(yt::ConfigurationProblem(batch_size.name(),
+                                                  batch_size.section_name(),
+                                                  "bgc_batch_size must be > 0"));
+        res = false;
+    }
+
+    const ip::PARAMETER_TYPE(bgc_max_parallel_batches) par(pt);
+    if (par.value() == 0)
+    {
+        rep.emplace_back(yt::ConfigurationProblem(par.name(),
+                                                  par.section_name(),
+                                                  "bgc_max_parallel_batches must be > 0"));
+        res = false;
+    }
+
+    return res;
+}
+
 }
@@ -20,11 +20,16 @@
 #include "GarbageCollectorFwd.h"
 #include "BackendParameters.h"
 
+#include <atomic>
 #include <future>
+
+#include <boost/chrono.hpp>
 #include <boost/property_tree/ptree_fwd.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <youtils/Logging.h>
 #include <youtils/ThreadPool.h>
+#include <youtils/VolumeDriverComponent.h>
 
 #include <backend/BackendConnectionManager.h>
 
@@ -85,7 +90,13 @@ struct GarbageCollectorThreadPoolTraits
     }
 };
 
+// Garbage is split into batches of up to bgc_batch_size objects which are
+// removed with BackendConnectionInterface::remove_objects. The batches of a
+// queued Garbage are spread over at most bgc_max_parallel_batches tasks so a
+// large heap of garbage (scrubbing, snapshot deletion) of one namespace cannot
+// monopolize the thread pool.
 class GarbageCollector
+    : public youtils::VolumeDriverComponent
 {
     friend class backendtest::GarbageCollectorTest;
 
@@ -110,14 +121,60 @@ public:
     static const char*
     name();
 
+    // Total number of objects removed so far (including those that were
+    // already gone).
+    uint64_t
+    deleted_objects() const
+    {
+        return deleted_objects_;
+    }
+
+    // Deletion rate over the last completed measurement window.
+    double
+    deletes_per_second() const;
+
     using ThreadPool = youtils::ThreadPool<std::string,
                                            GarbageCollectorThreadPoolTraits>;
 
+    // VolumeDriverComponent Interface
+    const char*
+    componentName() const override final;
+
+    void
+    update(const boost::property_tree::ptree&,
+           youtils::UpdateReport&) override final;
+
+    void
+    persist(boost::property_tree::ptree&,
+            const ReportDefault = ReportDefault::F) const override final;
+
+    bool
+    checkConfig(const boost::property_tree::ptree&,
+                youtils::ConfigurationReport&) const override final;
+    // end VolumeDriverComponent Interface
+
 private:
     DECLARE_LOGGER("GarbageCollector");
 
+    DECLARE_PARAMETER(bgc_batch_size);
+    DECLARE_PARAMETER(bgc_max_parallel_batches);
+
+    using Clock = boost::chrono::steady_clock;
+
     backend::BackendConnectionManagerPtr cm_;
+
+    std::atomic<uint64_t> deleted_objects_;
+
+    mutable boost::mutex rate_lock_;
+    Clock::time_point rate_window_start_;
+    uint64_t rate_window_deletes_;
+    double deletes_per_second_;
+
+    // declared last so the threads are gone before the above members
     ThreadPool thread_pool_;
+
+    void
+    account_deletes_(size_t count);
 };
 
 }
@@ -252,6 +252,33 @@ Connection::remove_(const Namespace& nspace,
     }
 }
 
+void
+Connection::remove_objects_(const Namespace& nspace,
+                            const std::vector<std::string>& names,
+                            const ObjectMayNotExist may_not_exist)
+{
+    // Check the namespace once for the whole batch and save a stat per object:
+    // fs::remove tells us whether there was something to remove.
+    if (not namespaceExists_(nspace))
+    {
+        throw BackendNamespaceDoesNotExistException();
+    }
+
+    for (const auto& name : names)
+    {
+        const fs::path src(objectPath_(nspace, name));
+        if (fs::remove(src))
+        {
+            lruCache().erase_no_evict(src);
+        }
+        else if (F(may_not_exist))
+        {
+            LOG_TRACE("*not* removing " << src << " as it doesn't appear to exist");
+            throw BackendObjectDoesNotExistException();
+        }
+    }
+}
+
 void
 Connection::deleteNamespace_(const Namespace& nspace)
 {
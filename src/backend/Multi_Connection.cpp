@@ -325,6 +325,43 @@ Connection::remove_(const Namespace& nspace,
     throw BackendNoMultiBackendAvailableException();
 }
 
+void
+Connection::remove_objects_(const Namespace& nspace,
+                            const std::vector<std::string>& names,
+                            const ObjectMayNotExist may_not_exist)
+{
+    iterator_t start_iterator = current_iterator_;
+    while(maybe_switch_back_to_default())
+    {
+        try
+        {
+            return (*current_iterator_)->remove_objects(nspace,
+                                                        names,
+                                                        may_not_exist);
+        }
+        catch(BackendNotImplementedException)
+        {
+            throw;
+        }
+        catch(BackendNamespaceAlreadyExistsException&)
+        {
+            throw;
+        }
+        catch(BackendObjectDoesNotExistException)
+        {
+            throw;
+        }
+        catch(std::exception&)
+        {
+            if(update_current_index(start_iterator))
+            {
+                throw;
+            }
+        }
+    }
+    throw BackendNoMultiBackendAvailableException();
+}
+
 void
 Connection::deleteNamespace_(const Namespace& nspace)
 {
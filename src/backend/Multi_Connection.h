@@ -106,6 +106,11 @@ public:
             const std::string& name,
             const ObjectMayNotExist) override final;
 
+    virtual void
+    remove_objects_(const Namespace& nspace,
+                    const std::vector<std::string>& names,
+                    const ObjectMayNotExist) override final;
+
     virtual uint64_t
     getSize_(const Namespace& nspace,
              const std::string& name) override final;
@@ -40,11 +40,17 @@ public:
 
     void
     pin_to_cpu_0()
+    {
+        pin_to_cpu(0);
+    }
+
+    void
+    pin_to_cpu(unsigned cpu)
     {
         cpu_set_t cpu_set;
 
         CPU_ZERO(&cpu_set);
-        CPU_SET(0, &cpu_set);
+        CPU_SET(cpu, &cpu_set);
 
         ASSERT_EQ(0, pthread_setaffinity_np(pthread_self(),
                                             sizeof(cpu_set),
@@ -162,4 +168,64 @@ TEST_F(ConnectionManagerTest, no_pool)
               cm_->size());
 }
 
+TEST_F(ConnectionManagerTest, pool_counters_and_stealing)
+{
+    // stealing requires the two threads to run on different shards
+    if (boost::thread::hardware_concurrency() < 2)
+    {
+        return;
+    }
+
+    bpt::ptree pt;
+    backend_config().persist_internal(pt,
+                                      ReportDefault::F);
+    ip::PARAMETER_TYPE(backend_connection_pool_shards)(2).persist(pt);
+
+    be::BackendConnectionManagerPtr cm(be::BackendConnectionManager::create(pt,
+                                                                            RegisterComponent::F));
+    ASSERT_EQ(2U,
+              cm->shards());
+
+    std::async(std::launch::async,
+               [&]
+               {
+                   pin_to_cpu(0);
+
+                   cm->getConnection();
+
+                   const be::BackendConnectionManager::PoolCounters c(cm->pool_counters());
+                   EXPECT_EQ(0U, c.hits);
+                   EXPECT_EQ(1U, c.misses);
+                   EXPECT_EQ(0U, c.steals);
+                   EXPECT_EQ(1U, c.creations);
+                   EXPECT_EQ(1U, cm->size());
+
+                   cm->getConnection();
+                   EXPECT_EQ(1U, cm->pool_counters().hits);
+                   EXPECT_EQ(1U, cm->size());
+               }).wait();
+
+    std::async(std::launch::async,
+               [&]
+               {
+                   pin_to_cpu(1);
+
+                   {
+                       be::BackendConnectionInterfacePtr conn(cm->getConnection());
+                       EXPECT_EQ(0U, cm->size());
+                   }
+
+                   const be::BackendConnectionManager::PoolCounters c(cm->pool_counters());
+                   EXPECT_EQ(1U, c.hits);
+                   EXPECT_EQ(1U, c.misses);
+                   EXPECT_EQ(1U, c.steals);
+                   EXPECT_EQ(1U, c.creations);
+
+                   // returned to the pool of CPU 1
+                   EXPECT_EQ(1U, cm->size());
+                   cm->getConnection();
+                   EXPECT_EQ(2U, cm->pool_counters().hits);
+               }).wait();
+}
+
 }
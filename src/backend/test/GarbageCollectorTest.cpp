@@ -26,6 +26,7 @@ using namespace backend;
 
 namespace bpt = boost::property_tree;
 namespace fs = boost::filesystem;
+namespace ip = initialized_params;
 namespace yt = youtils;
 
 class GarbageCollectorTest
@@ -150,6 +151,75 @@ TEST_F(GarbageCollectorTest, real_garbage)
     check_object_count(0);
 }
 
+TEST_F(GarbageCollectorTest, batched_garbage)
+{
+    const size_t object_size = 4096;
+    const size_t object_count = 29;
+    const uint32_t batch_size = 4;
+
+    bpt::ptree pt;
+    ip::PARAMETER_TYPE(bgc_batch_size)(batch_size).persist(pt);
+    ip::PARAMETER_TYPE(bgc_max_parallel_batches)(3).persist(pt);
+
+    gc_ = std::make_unique<GarbageCollector>(cm_,
+                                             pt,
+                                             RegisterComponent::F);
+
+    auto wrns(make_random_namespace());
+
+    std::vector<std::string> objects;
+    objects.reserve(object_count);
+
+    for (size_t i = 0; i < object_count; ++i)
+    {
+        auto s(boost::lexical_cast<std::string>(i));
+        const fs::path p(path_ / s);
+
+        createAndPut(p,
+                     object_size,
+                     s,
+                     cm_,
+                     s,
+                     wrns->ns(),
+                     OverwriteObject::F);
+
+        objects.emplace_back(s);
+    }
+
+    // some objects are already gone, which is not a problem
+    objects.emplace_back("does-not-exist");
+    objects.emplace_back("does-not-exist-either");
+
+    EXPECT_EQ(0U, gc_->deleted_objects());
+
+    gc_->queue(Garbage(wrns->ns(),
+                       objects));
+
+    EXPECT_TRUE(gc_->barrier(wrns->ns()).get());
+
+    std::list<std::string> l;
+    cm_->getConnection()->listObjects(wrns->ns(),
+                                      l);
+    EXPECT_TRUE(l.empty());
+
+    EXPECT_EQ(objects.size(),
+              gc_->deleted_objects());
+}
+
+TEST_F(GarbageCollectorTest, config)
+{
+    bpt::ptree pt;
+    gc_->persist(pt);
+
+    yt::ConfigurationReport rep;
+    EXPECT_TRUE(gc_->checkConfig(pt, rep));
+    EXPECT_TRUE(rep.empty());
+
+    ip::PARAMETER_TYPE(bgc_batch_size)(0).persist(pt);
+    EXPECT_FALSE(gc_->checkConfig(pt, rep));
+    EXPECT_EQ(1U, rep.size());
+}
+
 namespace
 {
 
@@ -16,7 +16,10 @@
 #include "MDSClient.h"
 
 #include <boost/python/class.hpp>
+#include <boost/python/data_members.hpp>
 #include <boost/python/enum.hpp>
+#include <boost/python/return_by_value.hpp>
+#include <boost/python/return_value_policy.hpp>
 
 #include <youtils/Logger.h>
 
@@ -73,6 +76,18 @@ MDSClient::registerize()
         DEF_READONLY(full_rebuilds)
 
 #undef DEF_READONLY
+
+#define ADD_HISTOGRAM(name)                                             \
+        .add_property(#name,                                            \
+                      bpy::make_getter(&mds::TableCounters::name,       \
+                                       bpy::return_value_policy<bpy::return_by_value>()))
+
+        ADD_HISTOGRAM(multiset_batch_sizes)
+        ADD_HISTOGRAM(multiget_batch_sizes)
+        ADD_HISTOGRAM(global_multiset_batch_sizes)
+        ADD_HISTOGRAM(global_multiget_batch_sizes)
+
+#undef ADD_HISTOGRAM
         ;
 
     bpy::class_<mds::PythonClient>("MDSClient",
@@ -558,6 +558,12 @@ BOOST_PYTHON_MODULE(storagerouterclient)
              "List client connections per node.\n"
              "@param node_id: string, Node ID\n"
              "@returns: ClientInfo object\n")
+        .def("list_migration_decisions",
+             &vfs::PythonClient::list_migration_decisions,
+             (bpy::args("node_id")),
+             "List the most recent auto-migration decisions of a node.\n"
+             "@param node_id: string, Node ID\n"
+             "@returns: list of MigrationDecision objects, most recent last\n")
         .def("statistics_node",
              &vfs::PythonClient::statistics_node,
              (bpy::args("node_id"),
@@ -959,6 +965,29 @@ BOOST_PYTHON_MODULE(storagerouterclient)
         ;
     REGISTER_ITERABLE_CONVERTER(std::vector<vfs::ClientInfo>);
 
+    bpy::class_<vfs::MigrationDecision>("MigrationDecision",
+                                        "Auto-migration decision about an object accessed through redirection",
+                                        bpy::no_init)
+        .def("__str__", &vfs::MigrationDecision::str)
+        .def("__repr__", &vfs::MigrationDecision::str)
+
+#define DEF_READONLY_PROP_(name)                                \
+        .def_readonly(#name, &vfs::MigrationDecision::name)
+
+        DEF_READONLY_PROP_(object_id)
+        DEF_READONLY_PROP_(owner_id)
+        DEF_READONLY_PROP_(read_kib_per_sec)
+        DEF_READONLY_PROP_(write_kib_per_sec)
+        DEF_READONLY_PROP_(remote_time_percent)
+        DEF_READONLY_PROP_(hot_periods)
+        DEF_READONLY_PROP_(required_periods)
+        DEF_READONLY_PROP_(verdict)
+        DEF_READONLY_PROP_(timestamp)
+
+#undef DEF_READONLY_PROP_
+        ;
+    REGISTER_ITERABLE_CONVERTER(std::vector<vfs::MigrationDecision>);
+
     bpy::class_<vfs::ClusterRegistry,
                 boost::noncopyable>("ClusterRegistry",
                                     "volumedriverfs cluster registry access",
@@ -1024,6 +1053,8 @@ BOOST_PYTHON_MODULE(storagerouterclient)
         DEF_READONLY_PROP_(vrouter_id)
         DEF_READONLY_PROP_(metadata_backend_config)
         DEF_READONLY_PROP_(cluster_cache_handle)
+        DEF_READONLY_PROP_(metadata_cache_pages)
+        DEF_READONLY_PROP_(metadata_cache_used_pages)
         .add_property("owner_tag",
                       &get_volume_info_owner_tag)
         .add_property("cluster_cache_limit",
@@ -1167,6 +1198,13 @@ BOOST_PYTHON_MODULE(storagerouterclient)
          "RocksDB metadata backend configuration")
         ;
 
+    bpy::class_<vd::MMapMetaDataBackendConfig,
+                bpy::bases<vd::MetaDataBackendConfig>,
+                boost::shared_ptr<vd::MMapMetaDataBackendConfig>>
+        ("MMapMetaDataBackendConfig",
+         "Memory mapped file metadata backend configuration")
+        ;
+
     bpy::class_<vd::ArakoonMetaDataBackendConfig,
                 bpy::bases<vd::MetaDataBackendConfig>,
                 boost::shared_ptr<vd::ArakoonMetaDataBackendConfig>>
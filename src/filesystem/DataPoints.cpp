@@ -157,6 +157,8 @@ VolumeMetaDataStoreDataPoint::VolumeMetaDataStoreDataPoint(const vd::VolumeId& v
     used_clusters = m.used_clusters;
     cached_pages = m.cached_pages;
     max_pages = m.max_pages;
+    dirty_pages = m.dirty_pages;
+    eviction_stalls = m.eviction_stalls;
 }
 
 constexpr const char* VolumeMetaDataStoreDataPoint::name;
@@ -171,7 +173,9 @@ operator<<(std::ostream& os,
         ",cache_misses=" << vmc.cache_misses <<
         ",used_clusters=" << vmc.used_clusters <<
         ",cached_pages=" << vmc.cached_pages <<
-        ",max_pages=" << vmc.max_pages;
+        ",max_pages=" << vmc.max_pages <<
+        ",dirty_pages=" << vmc.dirty_pages <<
+        ",eviction_stalls=" << vmc.eviction_stalls;
 }
 
 VolumeClusterCacheDataPoint::VolumeClusterCacheDataPoint(const vd::VolumeId& vid)
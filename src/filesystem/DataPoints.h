@@ -112,6 +112,8 @@ struct VolumeMetaDataStoreDataPoint
     uint64_t used_clusters;
     uint64_t cached_pages;
     uint64_t max_pages;
+    uint64_t dirty_pages;
+    uint64_t eviction_stalls;
 
     explicit VolumeMetaDataStoreDataPoint(const volumedriver::VolumeId&);
 };
@@ -27,17 +27,29 @@ class Volume;
 
 }
 
+namespace fungi
+{
+
+class RWLock;
+
+}
+
 namespace volumedriverfs
 {
 
 // OUR_STRONG_TYPEDEFs would be nice but we ain't got no operator== for weak_ptr.
 // No support for local files for now. Look into boost::variant when going there.
+// The cookie also carries the object's lock (the very same one LocalNode hands
+// out for the object) so the fast path doesn't need to look it up.
 struct LocalVolumeCookie
 {
     std::weak_ptr<volumedriver::Volume> volume;
+    std::shared_ptr<fungi::RWLock> lock;
 
-    explicit LocalVolumeCookie(std::weak_ptr<volumedriver::Volume> v)
+    LocalVolumeCookie(std::weak_ptr<volumedriver::Volume> v,
+                      std::shared_ptr<fungi::RWLock> l)
         : volume(v)
+        , lock(l)
     {}
 };
 
@@ -159,6 +159,7 @@ FileSystem::FileSystem(const bpt::ptree& pt,
     , fs_dtl_mode(pt)
     , fs_enable_shm_interface(pt)
     , fs_enable_network_interface(pt)
+    , fs_read_ahead_max_window(pt)
     , registry_(std::make_shared<Registry>(pt))
     , router_(pt,
               std::static_pointer_cast<yt::LockedArakoon>(registry_),
@@ -261,6 +262,7 @@ FileSystem::update(const bpt::ptree& pt,
     U(fs_dtl_mode);
     U(fs_enable_shm_interface);
     U(fs_enable_network_interface);
+    U(fs_read_ahead_max_window);
     U(ip::PARAMETER_TYPE(fs_virtual_disk_format)(vdisk_format_->name()));
     U(ip::PARAMETER_TYPE(fs_file_event_rules)(file_event_rules_));
 #undef U
@@ -290,6 +292,7 @@ FileSystem::persist(bpt::ptree& pt,
     P(fs_dtl_port);
     P(fs_enable_shm_interface);
     P(fs_enable_network_interface);
+    P(fs_read_ahead_max_window);
 
     P(ip::PARAMETER_TYPE(fs_virtual_disk_format)(vdisk_format_->name()));
     P(ip::PARAMETER_TYPE(fs_file_event_rules)(file_event_rules_));
@@ -352,6 +355,7 @@ FileSystem::checkConfig(const bpt::ptree& pt,
         }
     case vd::MetaDataBackendType::RocksDB:
     case vd::MetaDataBackendType::TCBT:
+    case vd::MetaDataBackendType::MMap:
         break;
     }
 
@@ -364,6 +368,29 @@ FileSystem::is_volume_path_(const FrontendPath& p) const
     return vdisk_format_->is_volume_path(p);
 }
 
+void
+FileSystem::maybe_read_ahead_(Handle& h,
+                              off_t off,
+                              size_t size)
+{
+    const boost::optional<StreamDetector::ReadAhead>
+        ra(h.stream_detector().observe(off,
+                                       size,
+                                       fs_read_ahead_max_window.value()));
+    if (ra)
+    {
+        LOG_TRACE(h.path() << ": read ahead, off " << ra->off << ", size " <<
+                  ra->size);
+        try
+        {
+            router_.read_ahead(h.dentry()->object_id(),
+                               ra->off,
+                               ra->size);
+        }
+        CATCH_STD_ALL_LOG_IGNORE(h.path() << ": failed to schedule read ahead");
+    }
+}
+
 void
 FileSystem::restart_()
 {
@@ -690,6 +717,9 @@ FileSystem::make_metadata_backend_config()
     case vd::MetaDataBackendType::TCBT:
         mdb.reset(new vd::TCBTMetaDataBackendConfig());
         break;
+    case vd::MetaDataBackendType::MMap:
+        mdb.reset(new vd::MMapMetaDataBackendConfig());
+        break;
     }
 
     return mdb;
@@ -1172,6 +1202,14 @@ FileSystem::read(Handle& h,
                                      off));
 
         eof = rsize < size;
+
+        if (not eof)
+        {
+            maybe_read_ahead_(h,
+                              off,
+                              size);
+        }
+
         size = rsize;
     }
 }
@@ -561,6 +561,7 @@ private:
     DECLARE_PARAMETER(fs_dtl_mode);
     DECLARE_PARAMETER(fs_enable_shm_interface);
     DECLARE_PARAMETER(fs_enable_network_interface);
+    DECLARE_PARAMETER(fs_read_ahead_max_window);
 
     std::shared_ptr<Registry> registry_;
     ObjectRouter router_;
@@ -582,6 +583,11 @@ private:
     bool
     is_volume_path_(const FrontendPath& p) const;
 
+    void
+    maybe_read_ahead_(Handle& h,
+                      off_t off,
+                      size_t size);
+
     template<typename T>
     void
     update_parent_mtime(const T& entity)
@@ -44,7 +44,7 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_local_io_retries,
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_check_local_volume_potential_period,
                                       volumerouter_component_name,
                                       "vrouter_check_local_volume_potential_period",
-                                      "how often to recheck the local volume potential during migration",
+                                      "how often (in auto-migration check intervals) to recheck the local volume potential of a volume considered for auto-migration",
                                       ShowDocumentation::T,
                                       1);
 
@@ -76,6 +76,41 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_file_write_threshold,
                                       ShowDocumentation::T,
                                       0UL);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_check_interval_secs,
+                                      volumerouter_component_name,
+                                      "vrouter_migrate_check_interval_secs",
+                                      "interval (seconds) at which redirected objects are checked for auto-migration",
+                                      ShowDocumentation::T,
+                                      10UL);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_min_redirect_kib_per_sec,
+                                      volumerouter_component_name,
+                                      "vrouter_migrate_min_redirect_kib_per_sec",
+                                      "minimum (decayed) rate of redirected I/O (KiB/s) for auto-migrating an object - 0 accepts any rate",
+                                      ShowDocumentation::T,
+                                      0UL);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_min_remote_time_percent,
+                                      volumerouter_component_name,
+                                      "vrouter_migrate_min_remote_time_percent",
+                                      "alternatively to the rate: minimum (decayed) percentage of time spent waiting for redirected I/O for auto-migrating an object - 0 turns it off",
+                                      ShowDocumentation::T,
+                                      0U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_sustain_periods,
+                                      volumerouter_component_name,
+                                      "vrouter_migrate_sustain_periods",
+                                      "number of consecutive check intervals an object needs to qualify for auto-migration (multiplied if migrating it here is costly)",
+                                      ShowDocumentation::T,
+                                      3U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_holdoff_secs,
+                                      volumerouter_component_name,
+                                      "vrouter_migrate_holdoff_secs",
+                                      "period (seconds) after (re)starting an object here during which it's not auto-migrated back here",
+                                      ShowDocumentation::T,
+                                      300UL);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_redirect_timeout_ms,
                                       volumerouter_component_name,
                                       "vrouter_redirect_timeout_ms",
@@ -111,6 +146,13 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_redirect_retries,
                                       ShowDocumentation::T,
                                       10);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_redirect_max_inflight,
+                                      volumerouter_component_name,
+                                      "vrouter_redirect_max_inflight",
+                                      "maximum number of outstanding redirected requests per remote node",
+                                      ShowDocumentation::T,
+                                      64U);
+
 DEFINE_INITIALIZED_PARAM(vrouter_id,
                          volumerouter_component_name,
                          "vrouter_id",
@@ -138,6 +180,13 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_lock_reaper_interval,
                                       ShowDocumentation::F,
                                       60 * 60 * 8);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_read_ahead_threads,
+                                      volumerouter_component_name,
+                                      "vrouter_read_ahead_threads",
+                                      "number of threads prefetching data for sequential readers of local objects, 0 disables read ahead",
+                                      ShowDocumentation::T,
+                                      2U);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_min_workers,
                                       volumerouter_component_name,
                                       "vrouter_min_workers",
@@ -192,6 +241,27 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_max_workers,
                                       ShowDocumentation::T,
                                       8U);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_use_lowlevel_api,
+                                      fuse_component_name,
+                                      "fuse_use_lowlevel_api",
+                                      "use the inode based FUSE low level API (splice I/O) instead of the path based one",
+                                      ShowDocumentation::T,
+                                      false);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_max_write,
+                                      fuse_component_name,
+                                      "fuse_max_write",
+                                      "maximum size of a FUSE write request (low level API only, capped by the kernel)",
+                                      ShowDocumentation::T,
+                                      1U << 20);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_writeback_cache,
+                                      fuse_component_name,
+                                      "fuse_writeback_cache",
+                                      "let the kernel cache FUSE writes (low level API only) - only safe if volumes are not accessed through other paths concurrently",
+                                      ShowDocumentation::T,
+                                      false);
+
 // SHM:
 const char shm_interface_component_name[] = "shm_interface";
 
@@ -221,10 +291,31 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(network_snd_rcv_queue_depth,
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(network_workqueue_max_threads,
                                       network_interface_component_name,
                                       "network_workqueue_max_threads",
-                                      "Maximum workqueue threads",
+                                      "Number of workqueue threads, shared by all network connections",
                                       ShowDocumentation::T,
                                       std::thread::hardware_concurrency());
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(network_portals,
+                                      network_interface_component_name,
+                                      "network_portals",
+                                      "Number of XIO portals (event loop, context and workqueue) to spread connections over. Clients are redirected to the additional portals, which hence require network_portal_base_port and a routable address",
+                                      ShowDocumentation::T,
+                                      1);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(network_portal_address,
+                                      network_interface_component_name,
+                                      "network_portal_address",
+                                      "Address clients are redirected to for the additional XIO portals - defaults to the host of the network URI unless that's a wildcard address",
+                                      ShowDocumentation::T,
+                                      ""s);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(network_portal_base_port,
+                                      network_interface_component_name,
+                                      "network_portal_base_port",
+                                      "First port of the range (network_portals - 1 ports) the additional XIO portals listen on; 0: none configured, only a single portal is used",
+                                      ShowDocumentation::T,
+                                      0);
+
 // FileSystem:
 const char filesystem_component_name[] = "filesystem";
 
@@ -360,6 +451,13 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_enable_shm_interface,
                                       ShowDocumentation::T,
                                       false);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_read_ahead_max_window,
+                                      filesystem_component_name,
+                                      "fs_read_ahead_max_window",
+                                      "maximum size (in bytes) of the read ahead window of sequential readers, 0 disables read ahead",
+                                      ShowDocumentation::T,
+                                      4U << 20);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(fs_enable_network_interface,
                                       filesystem_component_name,
                                       "fs_enable_network_interface",
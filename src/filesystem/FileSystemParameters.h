@@ -55,6 +55,16 @@ DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_file_read_threshold,
                                                   uint64_t);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_file_write_threshold,
                                                   uint64_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_check_interval_secs,
+                                                  std::atomic<uint64_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_min_redirect_kib_per_sec,
+                                                  uint64_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_min_remote_time_percent,
+                                                  uint32_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_sustain_periods,
+                                                  uint32_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_holdoff_secs,
+                                                  uint64_t);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_redirect_timeout_ms,
                                                   uint64_t);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_backend_sync_timeout_ms,
@@ -66,6 +76,8 @@ DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_migrate_timeout_ms,
                                                   uint64_t);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_redirect_retries,
                                                   uint32_t);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_redirect_max_inflight,
+                                                  std::atomic<uint32_t>);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_routing_retries,
                                                   uint32_t);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_lock_reaper_interval,
@@ -77,6 +89,8 @@ DECLARE_INITIALIZED_PARAM(vrouter_id,
                           std::string);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_sco_multiplier,
                                        uint32_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_read_ahead_threads,
+                                       uint32_t);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(vrouter_registry_cache_capacity,
                                        uint32_t);
 
@@ -146,6 +160,8 @@ DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(fs_dtl_mode,
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(fs_enable_shm_interface,
                                        bool);
 
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(fs_read_ahead_max_window,
+                                                  std::atomic<uint32_t>);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(fs_enable_network_interface,
                                        bool);
 
@@ -156,6 +172,12 @@ DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_min_workers,
                                                   std::atomic<uint32_t>);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_max_workers,
                                                   std::atomic<uint32_t>);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_use_lowlevel_api,
+                                       bool);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_max_write,
+                                       uint32_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(fuse_writeback_cache,
+                                       bool);
 
 // SHM:
 extern const char shm_interface_component_name[];
@@ -175,6 +197,15 @@ DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(network_snd_rcv_queue_depth,
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(network_workqueue_max_threads,
                                        unsigned int);
 
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(network_portals,
+                                       unsigned int);
+
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(network_portal_address,
+                                       std::string);
+
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(network_portal_base_port,
+                                       uint16_t);
+
 // EventPublisher:
 extern const char events_component_name[];
 
@@ -145,6 +145,9 @@ FuseInterface::FuseInterface(const bpt::ptree& pt,
                                 pt)
     , fuse_min_workers(pt)
     , fuse_max_workers(pt)
+    , fuse_use_lowlevel_api(pt)
+    , fuse_max_write(pt)
+    , fuse_writeback_cache(pt)
     , fs_(pt,
           registerizle)
     , fuse_(nullptr)
@@ -255,38 +258,61 @@ FuseInterface::operator()(const fs::path& mntpoint,
 
     fuse_argv[fuse_args.size() + 1] = ::strdup(mntpoint.string().c_str());
 
-    fuse_operations ops;
-    init_ops_(ops);
-
-    // The following is based on fuse_main_common. fuse_setup is done in the context
-    // of the caller so any errors parsing the arguments etc. can be reported.
-    // Only once that succeeded a thread is spawned to run the fuse event loop
-    // - it also has to do the clean up (free(mountpoint) etc. in fuse_teardown).
-    // Yes, this and in particular the back and forth of the mountpoint param is ugly
-    // as sin - to get rid of this (and the string params in general, while at it)
-    // fuse_setup and fuse_teardown need to be dissected - be my guest.
-
-    char *mountpoint;
-    int multithreaded;
-    fuse* fuse = fuse_setup(fuse_argv.size(),
-                            &fuse_argv[0],
-                            &ops,
-                            sizeof(ops),
-                            &mountpoint,
-                            &multithreaded,
-                            this);
-    if (not fuse)
+    char *mountpoint = nullptr;
+    int multithreaded = 0;
+    fuse* fuse = nullptr;
+
+    if (fuse_use_lowlevel_api.value())
     {
-        LOG_ERROR(fs_.name() << ": fuse_setup_common failed");
-        throw Exception("problem running filesystem");
+        LOG_INFO(fs_.name() << ": using the FUSE low level API, max_write " <<
+                 fuse_max_write.value() << ", writeback cache " <<
+                 fuse_writeback_cache.value());
+
+        lowlevel_ = std::make_unique<FuseLowLevelInterface>(fs_,
+                                                            fuse_max_write.value(),
+                                                            fuse_writeback_cache.value());
+        multithreaded = lowlevel_->mount(fuse_argv) ? 1 : 0;
+    }
+    else
+    {
+        fuse_operations ops;
+        init_ops_(ops);
+
+        // The following is based on fuse_main_common. fuse_setup is done in the context
+        // of the caller so any errors parsing the arguments etc. can be reported.
+        // Only once that succeeded a thread is spawned to run the fuse event loop
+        // - it also has to do the clean up (free(mountpoint) etc. in fuse_teardown).
+        // Yes, this and in particular the back and forth of the mountpoint param is ugly
+        // as sin - to get rid of this (and the string params in general, while at it)
+        // fuse_setup and fuse_teardown need to be dissected - be my guest.
+        fuse = fuse_setup(fuse_argv.size(),
+                          &fuse_argv[0],
+                          &ops,
+                          sizeof(ops),
+                          &mountpoint,
+                          &multithreaded,
+                          this);
+        if (not fuse)
+        {
+            LOG_ERROR(fs_.name() << ": fuse_setup_common failed");
+            throw Exception("problem running filesystem");
+        }
     }
 
-    auto fuse_exit(yt::make_scope_exit([&fuse,
-                                        &mountpoint]
+    auto fuse_exit(yt::make_scope_exit([&]
                                        {
-                                          LOG_INFO("tearing down fuse");
-                                           fuse_teardown(fuse,
-                                                         mountpoint);
+                                           LOG_INFO("tearing down fuse");
+                                           if (fuse)
+                                           {
+                                               fuse_teardown(fuse,
+                                                             mountpoint);
+                                           }
+                                           else
+                                           {
+                                               VERIFY(lowlevel_);
+                                               lowlevel_->unmount();
+                                               lowlevel_.reset();
+                                           }
                                        }));
 
     // FUSE installs handlers for these, but we don't want to be interrupted at all.
@@ -383,8 +409,15 @@ FuseInterface::operator()(const fs::path& mntpoint,
                            {
                                try
                                {
-                                   run_(fuse,
-                                        multithreaded ? true : false);
+                                   if (lowlevel_)
+                                   {
+                                       lowlevel_->run(multithreaded ? true : false);
+                                   }
+                                   else
+                                   {
+                                       run_(fuse,
+                                            multithreaded ? true : false);
+                                   }
                                }
                                CATCH_STD_ALL_LOG_IGNORE("exception running FUSE");
                            });
@@ -743,6 +776,9 @@ FuseInterface::update(const bpt::ptree& pt,
 
     U(fuse_min_workers);
     U(fuse_max_workers);
+    U(fuse_use_lowlevel_api);
+    U(fuse_max_write);
+    U(fuse_writeback_cache);
 #undef U
 }
 
@@ -755,6 +791,9 @@ FuseInterface::persist(bpt::ptree& pt,
 
     P(fuse_min_workers);
     P(fuse_max_workers);
+    P(fuse_use_lowlevel_api);
+    P(fuse_max_write);
+    P(fuse_writeback_cache);
 
 #undef U
 }
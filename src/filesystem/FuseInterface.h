@@ -27,6 +27,7 @@
 
 #define FUSE_USE_VERSION 30
 #include "FileSystem.h"
+#include "FuseLowLevelInterface.h"
 #include "ShmOrbInterface.h"
 #include "NetworkXioInterface.h"
 
@@ -182,17 +183,39 @@ public:
     {
         LOG_TRACE(path);
 
+        const int ret = errno_from_exceptions(path,
+                                              [&]
+                                              {
+                                                  ((&fs)->*mem_fun)(path,
+                                                                    std::forward<A>(args)...);
+                                              });
+        if (ret < 0)
+        {
+            fs.drop_from_cache(path);
+        }
+
+        return ret;
+    }
+
+    // Runs fun and maps the exceptions it throws to -errno codes; what is
+    // only used for logging. Shared with the low level frontend which
+    // identifies entities by ObjectId rather than by path.
+    template<typename T,
+             typename F>
+    static int
+    errno_from_exceptions(const T& what,
+                          F&& fun) throw ()
+    {
         int ret = 0;
 
         // consolidate these exceptions
         try
         {
-            ((&fs)->*mem_fun)(path,
-                              std::forward<A>(args)...);
+            fun();
         }
         catch (GetAttrOnInexistentPath&)
         {
-            LOG_TRACE(path << ": getattr on inexistent path");
+            LOG_TRACE(what << ": getattr on inexistent path");
             ret = -ENOENT;
         }
         catch (InternalNameException& e)
@@ -202,42 +225,42 @@ public:
         }
         catch (volumedriver::VolManager::VolumeDoesNotExistException& e)
         {
-            LOG_ERROR(path << ": " << e.what());
+            LOG_ERROR(what << ": " << e.what());
             ret = -ENOENT;
         }
         catch (ObjectNotRegisteredException& e)
         {
-            LOG_ERROR(path << ": " << e.what());
+            LOG_ERROR(what << ": " << e.what());
             ret = -ENOENT;
         }
         catch (ConflictingUpdateException& e)
         {
-            LOG_ERROR(path << ": " << e.what());
+            LOG_ERROR(what << ": " << e.what());
             ret = -EAGAIN;
         }
         catch (std::system_error& e)
         {
-            LOG_ERROR(path << ": caught std::system_error " << e.what());
+            LOG_ERROR(what << ": caught std::system_error " << e.what());
             ret = -e.code().value();
         }
         catch (boost::system::system_error& e)
         {
-            LOG_ERROR(path << ": caught boost::system::system_error " << e.what());
+            LOG_ERROR(what << ": caught boost::system::system_error " << e.what());
             ret = -e.code().value();
         }
         catch (std::error_code& e)
         {
-            LOG_ERROR(path << ": caught std::error_code: " << e.message());
+            LOG_ERROR(what << ": caught std::error_code: " << e.message());
             ret = -e.value();
         }
         catch (boost::system::error_code& e)
         {
-            LOG_ERROR(path << ": caught boost::system::error_code: " << e.message());
+            LOG_ERROR(what << ": caught boost::system::error_code: " << e.message());
             ret = -e.value();
         }
         catch (fungi::IOException& e)
         {
-            LOG_ERROR(path << ": caught fungi::IOException: " << e.what() <<
+            LOG_ERROR(what << ": caught fungi::IOException: " << e.what() <<
                       ", code " << e.getErrorCode());
             ret = -e.getErrorCode();
             // There are a lot of call (throw) sites that don't set the error code and
@@ -248,16 +271,11 @@ public:
             }
         }
         CATCH_STD_ALL_EWHAT({
-                LOG_ERROR(path << ": caught exception " << EWHAT <<
+                LOG_ERROR(what << ": caught exception " << EWHAT <<
                           ": returning I/O error");
                 ret = -EIO;
             });
 
-        if (ret < 0)
-        {
-            fs.drop_from_cache(path);
-        }
-
         return ret;
     }
 
@@ -273,14 +291,24 @@ public:
         return fuse_max_workers.value();
     }
 
+    bool
+    lowlevel() const
+    {
+        return fuse_use_lowlevel_api.value();
+    }
+
 private:
     DECLARE_LOGGER("FuseInterface");
 
     DECLARE_PARAMETER(fuse_min_workers);
     DECLARE_PARAMETER(fuse_max_workers);
+    DECLARE_PARAMETER(fuse_use_lowlevel_api);
+    DECLARE_PARAMETER(fuse_max_write);
+    DECLARE_PARAMETER(fuse_writeback_cache);
 
     FileSystem fs_;
     fuse* fuse_;
+    std::unique_ptr<FuseLowLevelInterface> lowlevel_;
     std::unique_ptr<ShmOrbInterface> shm_orb_server_;
     std::unique_ptr<NetworkXioInterface> network_server_;
 
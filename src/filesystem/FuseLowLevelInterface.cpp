@@ -0,0 +1,1185 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "FuseInterface.h"
+#include "FuseLowLevelInterface.h"
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/ScopeExit.h>
+
+namespace volumedriverfs
+{
+
+namespace yt = youtils;
+
+namespace
+{
+
+DECLARE_LOGGER("FuseLowLevelInterfaceHelpers");
+
+// Attributes and entries can change behind our back (other nodes, the
+// shm / network frontends), so don't let the kernel cache them for too long.
+const double attr_timeout = 1.0;
+
+void
+set_handle(fuse_file_info& fi, Handle::Ptr h)
+{
+    fi.fh = reinterpret_cast<uint64_t>(h.release());
+}
+
+Handle*
+get_handle(fuse_file_info& fi)
+{
+    Handle* h(reinterpret_cast<Handle*>(fi.fh));
+    VERIFY(h);
+    return h;
+}
+
+// Buffer the volume reads land in before they're handed to FUSE. Kept per
+// (FUSE worker) thread to avoid an allocation per request.
+std::vector<char>&
+read_buffer(size_t size)
+{
+    static thread_local std::vector<char> buf;
+    if (buf.size() < size)
+    {
+        buf.resize(size);
+    }
+    return buf;
+}
+
+void
+reply_err(fuse_req_t req,
+          int ret)
+{
+    ASSERT(ret <= 0);
+    fuse_reply_err(req, -ret);
+}
+
+}
+
+FuseLowLevelInterface::FuseLowLevelInterface(FileSystem& fs,
+                                             uint32_t max_write,
+                                             bool writeback_cache)
+    : fs_(fs)
+    , max_write_(max_write)
+    , writeback_cache_(writeback_cache)
+    , session_(nullptr)
+    , chan_(nullptr)
+    , mountpoint_(nullptr)
+{
+    boost::optional<ObjectId> root(fs_.find_id(FrontendPath("/")));
+    VERIFY(root);
+    root_id_ = *root;
+
+    // The root is never looked up and hence never forgotten.
+    inodes_.emplace(FUSE_ROOT_ID,
+                    InodeEntry{ root_id_, 1 });
+}
+
+FuseLowLevelInterface::~FuseLowLevelInterface()
+{
+    if (session_)
+    {
+        try
+        {
+            unmount();
+        }
+        CATCH_STD_ALL_LOG_IGNORE("failed to unmount");
+    }
+}
+
+void
+FuseLowLevelInterface::init_ops_(fuse_lowlevel_ops& ops)
+{
+    bzero(&ops, sizeof(ops));
+
+#define INSTALL_CB(name)                        \
+    ops.name = FuseLowLevelInterface::name
+
+    INSTALL_CB(init);
+    INSTALL_CB(lookup);
+    INSTALL_CB(forget);
+    INSTALL_CB(forget_multi);
+    INSTALL_CB(getattr);
+    INSTALL_CB(setattr);
+    INSTALL_CB(mknod);
+    INSTALL_CB(mkdir);
+    INSTALL_CB(unlink);
+    INSTALL_CB(rmdir);
+    INSTALL_CB(rename);
+    INSTALL_CB(create);
+    INSTALL_CB(open);
+    INSTALL_CB(release);
+    INSTALL_CB(read);
+    INSTALL_CB(write_buf);
+    INSTALL_CB(fsync);
+    INSTALL_CB(opendir);
+    INSTALL_CB(readdir);
+    INSTALL_CB(releasedir);
+    INSTALL_CB(statfs);
+
+#undef INSTALL_CB
+}
+
+bool
+FuseLowLevelInterface::mount(std::vector<char*>& argv)
+{
+    VERIFY(not session_);
+
+    fuse_args args = FUSE_ARGS_INIT(static_cast<int>(argv.size()),
+                                    argv.data());
+    auto args_exit(yt::make_scope_exit([&args]
+                                       {
+                                           fuse_opt_free_args(&args);
+                                       }));
+
+    int multithreaded = 0;
+    int foreground = 0;
+
+    if (fuse_parse_cmdline(&args,
+                           &mountpoint_,
+                           &multithreaded,
+                           &foreground) == -1)
+    {
+        LOG_ERROR(fs_.name() << ": failed to parse FUSE command line");
+        throw Exception("failed to parse FUSE command line");
+    }
+
+    auto mp_exit(yt::make_scope_exit([&]
+                                     {
+                                         if (not session_)
+                                         {
+                                             free(mountpoint_);
+                                             mountpoint_ = nullptr;
+                                         }
+                                     }));
+
+    chan_ = fuse_mount(mountpoint_,
+                       &args);
+    if (not chan_)
+    {
+        LOG_ERROR(fs_.name() << ": failed to mount " << mountpoint_);
+        throw Exception("failed to mount FUSE filesystem");
+    }
+
+    auto chan_exit(yt::make_scope_exit([&]
+                                       {
+                                           if (not session_)
+                                           {
+                                               fuse_unmount(mountpoint_,
+                                                            chan_);
+                                               chan_ = nullptr;
+                                           }
+                                       }));
+
+    fuse_lowlevel_ops ops;
+    init_ops_(ops);
+
+    fuse_session* se = fuse_lowlevel_new(&args,
+                                         &ops,
+                                         sizeof(ops),
+                                         this);
+    if (not se)
+    {
+        LOG_ERROR(fs_.name() << ": failed to create FUSE low level session");
+        throw Exception("failed to create FUSE session");
+    }
+
+    if (fuse_set_signal_handlers(se) == -1)
+    {
+        fuse_session_destroy(se);
+        LOG_ERROR(fs_.name() << ": failed to install FUSE signal handlers");
+        throw Exception("failed to install FUSE signal handlers");
+    }
+
+    fuse_session_add_chan(se,
+                          chan_);
+    session_ = se;
+
+    return multithreaded != 0;
+}
+
+void
+FuseLowLevelInterface::run(bool multithreaded)
+{
+    VERIFY(session_);
+
+    // N.B. the worker limits of the high level loop (fuse_{min,max}_workers)
+    // do not apply here, fuse_session_loop_mt manages its workers itself.
+    const int res = multithreaded ?
+        fuse_session_loop_mt(session_) :
+        fuse_session_loop(session_);
+    if (res != 0)
+    {
+        LOG_ERROR("fuse low level loop exited with status " << res);
+    }
+    else
+    {
+        LOG_INFO("fuse low level loop exited");
+    }
+}
+
+void
+FuseLowLevelInterface::unmount()
+{
+    VERIFY(session_);
+
+    fuse_remove_signal_handlers(session_);
+    fuse_session_remove_chan(chan_);
+    fuse_session_destroy(session_);
+    session_ = nullptr;
+
+    fuse_unmount(mountpoint_,
+                 chan_);
+    chan_ = nullptr;
+
+    free(mountpoint_);
+    mountpoint_ = nullptr;
+}
+
+FuseLowLevelInterface&
+FuseLowLevelInterface::get_(fuse_req_t req)
+{
+    auto ll = static_cast<FuseLowLevelInterface*>(fuse_req_userdata(req));
+    VERIFY(ll);
+    return *ll;
+}
+
+ObjectId
+FuseLowLevelInterface::object_id_(fuse_ino_t ino) const
+{
+    std::lock_guard<decltype(inodes_lock_)> g(inodes_lock_);
+
+    auto it = inodes_.find(ino);
+    if (it == inodes_.end())
+    {
+        // the kernel only uses inodes we handed out and didn't forget yet
+        LOG_N_THROW(ESTALE,
+                    "unknown inode " << ino);
+    }
+
+    return it->second.id;
+}
+
+fuse_ino_t
+FuseLowLevelInterface::inode_(const ObjectId& id,
+                              const struct stat& st) const
+{
+    return id == root_id_ ?
+        FUSE_ROOT_ID :
+        st.st_ino;
+}
+
+void
+FuseLowLevelInterface::getattr_(const ObjectId& id,
+                                struct stat& st)
+{
+    fs_.getattr(id,
+                st);
+    st.st_ino = inode_(id,
+                       st);
+}
+
+void
+FuseLowLevelInterface::lookup_(const ObjectId& parent_id,
+                               const std::string& name,
+                               fuse_entry_param& e)
+{
+    const FrontendPath path(fs_.find_path(parent_id) / name);
+
+    memset(&e, 0x0, sizeof(e));
+
+    boost::optional<ObjectId> id(fs_.find_id(path));
+    if (not id)
+    {
+        throw GetAttrOnInexistentPath("Path does not exist",
+                                      path.str().c_str(),
+                                      ENOENT);
+    }
+
+    getattr_(*id,
+             e.attr);
+
+    e.ino = e.attr.st_ino;
+    e.attr_timeout = attr_timeout;
+    e.entry_timeout = attr_timeout;
+
+    if (e.ino == 0)
+    {
+        // fuse reserves 0 for negative entries
+        LOG_N_THROW(EIO,
+                    path << ": invalid inode number 0");
+    }
+
+    std::lock_guard<decltype(inodes_lock_)> g(inodes_lock_);
+
+    auto res(inodes_.emplace(e.ino,
+                             InodeEntry{ *id, 0 }));
+    if (not res.second and res.first->second.id != *id)
+    {
+        LOG_ERROR(path << ": inode " << e.ino << " was mapped to " <<
+                  res.first->second.id << ", remapping to " << *id);
+        res.first->second.id = *id;
+    }
+
+    ++res.first->second.nlookup;
+}
+
+void
+FuseLowLevelInterface::forget_(fuse_ino_t ino,
+                               uint64_t nlookup)
+{
+    if (ino == FUSE_ROOT_ID)
+    {
+        return;
+    }
+
+    std::lock_guard<decltype(inodes_lock_)> g(inodes_lock_);
+
+    auto it = inodes_.find(ino);
+    if (it != inodes_.end())
+    {
+        if (it->second.nlookup <= nlookup)
+        {
+            inodes_.erase(it);
+        }
+        else
+        {
+            it->second.nlookup -= nlookup;
+        }
+    }
+}
+
+// The lookup only happens once the file is open as it takes a reference on
+// the inode that the kernel is only told about on success.
+void
+FuseLowLevelInterface::create_(const ObjectId& parent_id,
+                               const std::string& name,
+                               UserId uid,
+                               GroupId gid,
+                               Permissions pms,
+                               int flags,
+                               fuse_entry_param& e,
+                               Handle::Ptr& h)
+{
+    fs_.mknod(parent_id,
+              name,
+              uid,
+              gid,
+              pms);
+
+    fs_.open(FrontendPath(fs_.find_path(parent_id) / name),
+             flags,
+             h);
+
+    try
+    {
+        lookup_(parent_id,
+                name,
+                e);
+    }
+    catch (...)
+    {
+        try
+        {
+            fs_.release(std::move(h));
+        }
+        CATCH_STD_ALL_LOG_IGNORE(name << ": failed to release handle");
+        throw;
+    }
+}
+
+void
+FuseLowLevelInterface::init(void* userdata,
+                            fuse_conn_info* conn)
+{
+    auto ll = static_cast<FuseLowLevelInterface*>(userdata);
+    VERIFY(ll);
+
+    // Only ask for what the kernel offers - the FUSE headers we build against
+    // might also be newer than the kernel we run on.
+#define WANT(cap)                                                       \
+    if (conn->capable & cap)                                            \
+    {                                                                   \
+        conn->want |= cap;                                              \
+    }                                                                   \
+    else                                                                \
+    {                                                                   \
+        LOG_INFO(#cap " not supported by the kernel");                  \
+    }
+
+#ifdef FUSE_CAP_SPLICE_READ
+    WANT(FUSE_CAP_SPLICE_READ);
+#endif
+#ifdef FUSE_CAP_SPLICE_WRITE
+    WANT(FUSE_CAP_SPLICE_WRITE);
+#endif
+#ifdef FUSE_CAP_SPLICE_MOVE
+    WANT(FUSE_CAP_SPLICE_MOVE);
+#endif
+#ifdef FUSE_CAP_BIG_WRITES
+    WANT(FUSE_CAP_BIG_WRITES);
+#endif
+#ifdef FUSE_CAP_PARALLEL_DIROPS
+    WANT(FUSE_CAP_PARALLEL_DIROPS);
+#endif
+#ifdef FUSE_CAP_WRITEBACK_CACHE
+    if (ll->writeback_cache_)
+    {
+        WANT(FUSE_CAP_WRITEBACK_CACHE);
+    }
+#else
+    if (ll->writeback_cache_)
+    {
+        LOG_WARN("FUSE headers lack writeback cache support - ignoring request to enable it");
+    }
+#endif
+
+#undef WANT
+
+    // FUSE caps this to its channel buffer size and the kernel to what it
+    // supports.
+    if (ll->max_write_ > conn->max_write)
+    {
+        conn->max_write = ll->max_write_;
+    }
+
+    LOG_INFO("FUSE low level session: want " << std::hex << conn->want <<
+             ", capable " << conn->capable << std::dec <<
+             ", max_write " << conn->max_write);
+}
+
+void
+FuseLowLevelInterface::lookup(fuse_req_t req,
+                              fuse_ino_t parent,
+                              const char* name)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    fuse_entry_param e;
+
+    const int ret = FuseInterface::errno_from_exceptions(parent,
+                                                         [&]
+                                                         {
+                                                             ll.lookup_(ll.object_id_(parent),
+                                                                        name,
+                                                                        e);
+                                                         });
+    if (ret == 0)
+    {
+        fuse_reply_entry(req, &e);
+    }
+    else if (ret == -ENOENT)
+    {
+        // cache the negative entry
+        memset(&e, 0x0, sizeof(e));
+        e.entry_timeout = attr_timeout;
+        fuse_reply_entry(req, &e);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::forget(fuse_req_t req,
+                              fuse_ino_t ino,
+                              uint64_t nlookup)
+{
+    get_(req).forget_(ino,
+                      nlookup);
+    fuse_reply_none(req);
+}
+
+void
+FuseLowLevelInterface::forget_multi(fuse_req_t req,
+                                    size_t count,
+                                    fuse_forget_data* forgets)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ll.forget_(forgets[i].ino,
+                   forgets[i].nlookup);
+    }
+
+    fuse_reply_none(req);
+}
+
+void
+FuseLowLevelInterface::getattr(fuse_req_t req,
+                               fuse_ino_t ino,
+                               fuse_file_info* /* fi */)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    struct stat st;
+
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         [&]
+                                                         {
+                                                             ll.getattr_(ll.object_id_(ino),
+                                                                         st);
+                                                         });
+    if (ret == 0)
+    {
+        fuse_reply_attr(req, &st, attr_timeout);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::setattr(fuse_req_t req,
+                               fuse_ino_t ino,
+                               struct stat* attr,
+                               int to_set,
+                               fuse_file_info* /* fi */)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    struct stat st;
+
+    auto fun([&]
+             {
+                 const ObjectId id(ll.object_id_(ino));
+
+                 if (to_set & FUSE_SET_ATTR_MODE)
+                 {
+                     ll.fs_.chmod(id,
+                                  attr->st_mode);
+                 }
+
+                 if (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID))
+                 {
+                     ll.fs_.chown(id,
+                                  (to_set & FUSE_SET_ATTR_UID) ?
+                                  attr->st_uid :
+                                  static_cast<uid_t>(-1),
+                                  (to_set & FUSE_SET_ATTR_GID) ?
+                                  attr->st_gid :
+                                  static_cast<gid_t>(-1));
+                 }
+
+                 if (to_set & FUSE_SET_ATTR_SIZE)
+                 {
+                     ll.fs_.truncate(id,
+                                     attr->st_size);
+                 }
+
+                 const int times = FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME;
+                 if (to_set & times)
+                 {
+                     // FileSystem::utimens wants both: keep the one that's
+                     // not supposed to change.
+                     ll.getattr_(id,
+                                 st);
+
+                     struct timespec ts[2];
+                     ts[0].tv_sec = st.st_atime;
+                     ts[0].tv_nsec = 0;
+                     ts[1].tv_sec = st.st_mtime;
+                     ts[1].tv_nsec = 0;
+
+                     struct timespec now;
+                     clock_gettime(CLOCK_REALTIME, &now);
+
+#ifdef FUSE_SET_ATTR_ATIME_NOW
+                     if (to_set & FUSE_SET_ATTR_ATIME_NOW)
+                     {
+                         ts[0] = now;
+                     }
+                     else
+#endif
+                     if (to_set & FUSE_SET_ATTR_ATIME)
+                     {
+                         ts[0] = attr->st_atim;
+                     }
+
+#ifdef FUSE_SET_ATTR_MTIME_NOW
+                     if (to_set & FUSE_SET_ATTR_MTIME_NOW)
+                     {
+                         ts[1] = now;
+                     }
+                     else
+#endif
+                     if (to_set & FUSE_SET_ATTR_MTIME)
+                     {
+                         ts[1] = attr->st_mtim;
+                     }
+
+                     ll.fs_.utimens(id,
+                                    ts);
+                 }
+
+                 ll.getattr_(id,
+                             st);
+             });
+
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         std::move(fun));
+    if (ret == 0)
+    {
+        fuse_reply_attr(req, &st, attr_timeout);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::mknod(fuse_req_t req,
+                             fuse_ino_t parent,
+                             const char* name,
+                             mode_t mode,
+                             dev_t rdev)
+{
+    LOG_TRACE(parent << "/" << name << ": dev_t " << rdev << ", mode " <<
+              std::oct << mode);
+
+    FuseLowLevelInterface& ll = get_(req);
+    const fuse_ctx* ctx = fuse_req_ctx(req);
+    VERIFY(ctx);
+
+    fuse_entry_param e;
+
+    const int ret = FuseInterface::errno_from_exceptions(parent,
+                                                         [&]
+                                                         {
+                                                             const ObjectId id(ll.object_id_(parent));
+                                                             ll.fs_.mknod(id,
+                                                                          name,
+                                                                          UserId(ctx->uid),
+                                                                          GroupId(ctx->gid),
+                                                                          Permissions(mode));
+                                                             ll.lookup_(id,
+                                                                        name,
+                                                                        e);
+                                                         });
+    if (ret == 0)
+    {
+        fuse_reply_entry(req, &e);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::mkdir(fuse_req_t req,
+                             fuse_ino_t parent,
+                             const char* name,
+                             mode_t mode)
+{
+    LOG_TRACE(parent << "/" << name << ": mode " << std::oct << mode);
+
+    FuseLowLevelInterface& ll = get_(req);
+    const fuse_ctx* ctx = fuse_req_ctx(req);
+    VERIFY(ctx);
+
+    fuse_entry_param e;
+
+    const int ret = FuseInterface::errno_from_exceptions(parent,
+                                                         [&]
+                                                         {
+                                                             const ObjectId id(ll.object_id_(parent));
+                                                             ll.fs_.mkdir(id,
+                                                                          name,
+                                                                          UserId(ctx->uid),
+                                                                          GroupId(ctx->gid),
+                                                                          Permissions(mode));
+                                                             ll.lookup_(id,
+                                                                        name,
+                                                                        e);
+                                                         });
+    if (ret == 0)
+    {
+        fuse_reply_entry(req, &e);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::unlink(fuse_req_t req,
+                              fuse_ino_t parent,
+                              const char* name)
+{
+    FuseLowLevelInterface& ll = get_(req);
+
+    reply_err(req,
+              FuseInterface::errno_from_exceptions(parent,
+                                                   [&]
+                                                   {
+                                                       ll.fs_.unlink(ll.object_id_(parent),
+                                                                     name);
+                                                   }));
+}
+
+void
+FuseLowLevelInterface::rmdir(fuse_req_t req,
+                             fuse_ino_t parent,
+                             const char* name)
+{
+    FuseLowLevelInterface& ll = get_(req);
+
+    reply_err(req,
+              FuseInterface::errno_from_exceptions(parent,
+                                                   [&]
+                                                   {
+                                                       const ObjectId id(ll.object_id_(parent));
+                                                       ll.fs_.rmdir(FrontendPath(ll.fs_.find_path(id) / name));
+                                                   }));
+}
+
+void
+FuseLowLevelInterface::rename(fuse_req_t req,
+                              fuse_ino_t parent,
+                              const char* name,
+                              fuse_ino_t newparent,
+                              const char* newname,
+                              unsigned flags)
+{
+    FuseLowLevelInterface& ll = get_(req);
+
+    reply_err(req,
+              FuseInterface::errno_from_exceptions(parent,
+                                                   [&]
+                                                   {
+                                                       ll.fs_.rename(ll.object_id_(parent),
+                                                                     name,
+                                                                     ll.object_id_(newparent),
+                                                                     newname,
+                                                                     static_cast<FileSystem::RenameFlags>(flags));
+                                                   }));
+}
+
+void
+FuseLowLevelInterface::create(fuse_req_t req,
+                              fuse_ino_t parent,
+                              const char* name,
+                              mode_t mode,
+                              fuse_file_info* fi)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    const fuse_ctx* ctx = fuse_req_ctx(req);
+    VERIFY(ctx);
+
+    fuse_entry_param e;
+    Handle::Ptr h;
+
+    const int ret = FuseInterface::errno_from_exceptions(parent,
+                                                         [&]
+                                                         {
+                                                             ll.create_(ll.object_id_(parent),
+                                                                        name,
+                                                                        UserId(ctx->uid),
+                                                                        GroupId(ctx->gid),
+                                                                        Permissions(mode),
+                                                                        fi->flags,
+                                                                        e,
+                                                                        h);
+                                                         });
+    if (ret == 0)
+    {
+        set_handle(*fi,
+                   std::move(h));
+        if (fuse_reply_create(req, &e, fi) != 0)
+        {
+            // interrupted - nobody's going to release it nor forget the
+            // lookup
+            ll.forget_(e.ino,
+                       1);
+            Handle::Ptr p(get_handle(*fi));
+            fi->fh = 0;
+            ll.fs_.release(std::move(p));
+        }
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::open(fuse_req_t req,
+                            fuse_ino_t ino,
+                            fuse_file_info* fi)
+{
+    FuseLowLevelInterface& ll = get_(req);
+
+    if (ll.writeback_cache_)
+    {
+        // With writeback caching the kernel might need to read (parts of)
+        // pages of files opened write only, and it takes care of O_APPEND
+        // itself.
+        if ((fi->flags & O_ACCMODE) == O_WRONLY)
+        {
+            fi->flags &= ~O_ACCMODE;
+            fi->flags |= O_RDWR;
+        }
+
+        fi->flags &= ~O_APPEND;
+    }
+
+    Handle::Ptr h;
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         [&]
+                                                         {
+                                                             ll.fs_.open(ll.object_id_(ino),
+                                                                         fi->flags,
+                                                                         h);
+                                                         });
+    if (ret == 0)
+    {
+        set_handle(*fi,
+                   std::move(h));
+        if (fuse_reply_open(req, fi) != 0)
+        {
+            Handle::Ptr p(get_handle(*fi));
+            fi->fh = 0;
+            ll.fs_.release(std::move(p));
+        }
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::release(fuse_req_t req,
+                               fuse_ino_t ino,
+                               fuse_file_info* fi)
+{
+    Handle::Ptr h(get_handle(*fi));
+    fi->fh = 0;
+
+    FuseLowLevelInterface& ll = get_(req);
+    reply_err(req,
+              FuseInterface::errno_from_exceptions(ino,
+                                                   [&]
+                                                   {
+                                                       ll.fs_.release(std::move(h));
+                                                   }));
+}
+
+void
+FuseLowLevelInterface::read(fuse_req_t req,
+                            fuse_ino_t ino,
+                            size_t size,
+                            off_t off,
+                            fuse_file_info* fi)
+{
+    Handle* h = get_handle(*fi);
+    FuseLowLevelInterface& ll = get_(req);
+
+    std::vector<char>& buf = read_buffer(size);
+    bool eof = false;
+
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         [&]
+                                                         {
+                                                             ll.fs_.read(*h,
+                                                                         size,
+                                                                         buf.data(),
+                                                                         off,
+                                                                         eof);
+                                                         });
+    if (ret == 0)
+    {
+        // A plain memory buffer, i.e. FUSE copies it into the reply (or a
+        // pipe with FUSE_CAP_SPLICE_WRITE) - no zero copy here.
+        fuse_bufvec bufv = FUSE_BUFVEC_INIT(size);
+        bufv.buf[0].mem = buf.data();
+
+        fuse_reply_data(req,
+                        &bufv,
+                        static_cast<fuse_buf_copy_flags>(0));
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::write_buf(fuse_req_t req,
+                                 fuse_ino_t ino,
+                                 fuse_bufvec* in_bufv,
+                                 off_t off,
+                                 fuse_file_info* fi)
+{
+    Handle* h = get_handle(*fi);
+    FuseLowLevelInterface& ll = get_(req);
+
+    VERIFY(in_bufv);
+
+    size_t size = fuse_buf_size(in_bufv);
+    const char* data = nullptr;
+    std::vector<char> tmp;
+
+    if (in_bufv->count == 1 and
+        not (in_bufv->buf[0].flags & FUSE_BUF_IS_FD))
+    {
+        // plain memory (no splice): use it in place
+        data = static_cast<const char*>(in_bufv->buf[0].mem) + in_bufv->off;
+    }
+    else
+    {
+        // spliced from /dev/fuse into a pipe: move it straight into the
+        // buffer we hand to the volume, without FUSE copying it first.
+        tmp.resize(size);
+
+        fuse_bufvec out_bufv = FUSE_BUFVEC_INIT(size);
+        out_bufv.buf[0].mem = tmp.data();
+
+        const ssize_t res = fuse_buf_copy(&out_bufv,
+                                          in_bufv,
+                                          FUSE_BUF_SPLICE_NONBLOCK);
+        if (res < 0)
+        {
+            LOG_ERROR(ino << ": failed to copy write buffer: " <<
+                      strerror(-res));
+            reply_err(req, res);
+            return;
+        }
+
+        size = res;
+        data = tmp.data();
+    }
+
+    // Like the high level frontend we ignore the sync hint.
+    bool sync = false;
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         [&]
+                                                         {
+                                                             ll.fs_.write(*h,
+                                                                          size,
+                                                                          data,
+                                                                          off,
+                                                                          sync);
+                                                         });
+    if (ret == 0)
+    {
+        fuse_reply_write(req, size);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::fsync(fuse_req_t req,
+                             fuse_ino_t ino,
+                             int datasync,
+                             fuse_file_info* fi)
+{
+    Handle* h = get_handle(*fi);
+    FuseLowLevelInterface& ll = get_(req);
+
+    reply_err(req,
+              FuseInterface::errno_from_exceptions(ino,
+                                                   [&]
+                                                   {
+                                                       ll.fs_.fsync(*h,
+                                                                    datasync);
+                                                   }));
+}
+
+void
+FuseLowLevelInterface::opendir(fuse_req_t req,
+                               fuse_ino_t ino,
+                               fuse_file_info* fi)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    Handle::Ptr h;
+
+    fi->fh = 0;
+
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         [&]
+                                                         {
+                                                             ll.fs_.opendir(ll.fs_.find_path(ll.object_id_(ino)),
+                                                                            h);
+                                                         });
+    if (ret == 0)
+    {
+        set_handle(*fi,
+                   std::move(h));
+        if (fuse_reply_open(req, fi) != 0)
+        {
+            Handle::Ptr p(get_handle(*fi));
+            fi->fh = 0;
+            ll.fs_.release(std::move(p));
+        }
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::readdir(fuse_req_t req,
+                               fuse_ino_t ino,
+                               size_t size,
+                               off_t off,
+                               fuse_file_info* fi)
+{
+    Handle* h = get_handle(*fi);
+    FuseLowLevelInterface& ll = get_(req);
+
+    std::vector<char> buf(size);
+    size_t pos = 0;
+
+    // Offsets 0 and 1 are "." and "..", the entries follow.
+    auto add([&](const char* name,
+                 const struct stat& st,
+                 off_t next) -> bool
+             {
+                 const size_t len = fuse_add_direntry(req,
+                                                      buf.data() + pos,
+                                                      size - pos,
+                                                      name,
+                                                      &st,
+                                                      next);
+                 if (len > size - pos)
+                 {
+                     return false;
+                 }
+
+                 pos += len;
+                 return true;
+             });
+
+    auto fun([&]
+             {
+                 struct stat st;
+                 memset(&st, 0x0, sizeof(st));
+                 st.st_mode = S_IFDIR;
+
+                 if (off == 0)
+                 {
+                     st.st_ino = ino;
+                     if (not add(".", st, ++off))
+                     {
+                         return;
+                     }
+                 }
+
+                 if (off == 1)
+                 {
+                     // like the high level frontend does for all entries
+                     st.st_ino = 0;
+                     if (not add("..", st, ++off))
+                     {
+                         return;
+                     }
+                 }
+
+                 std::vector<std::string> l;
+                 ll.fs_.read_dirents(h->path(),
+                                     l,
+                                     off - 2);
+
+                 for (const auto& e : l)
+                 {
+                     // readdir only needs the inode and the type
+                     try
+                     {
+                         ll.fs_.getattr(FrontendPath(h->path() / e),
+                                        st);
+                     }
+                     catch (GetAttrOnInexistentPath&)
+                     {
+                         // removed in the meantime
+                         ++off;
+                         continue;
+                     }
+
+                     if (not add(e.c_str(), st, off + 1))
+                     {
+                         break;
+                     }
+                     ++off;
+                 }
+             });
+
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         std::move(fun));
+    if (ret == 0)
+    {
+        fuse_reply_buf(req,
+                       buf.data(),
+                       pos);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+void
+FuseLowLevelInterface::releasedir(fuse_req_t req,
+                                  fuse_ino_t ino,
+                                  fuse_file_info* fi)
+{
+    Handle::Ptr h(get_handle(*fi));
+    fi->fh = 0;
+
+    FuseLowLevelInterface& ll = get_(req);
+    const FrontendPath p(h->path());
+
+    reply_err(req,
+              FuseInterface::errno_from_exceptions(ino,
+                                                   [&]
+                                                   {
+                                                       ll.fs_.releasedir(p,
+                                                                         std::move(h));
+                                                   }));
+}
+
+void
+FuseLowLevelInterface::statfs(fuse_req_t req,
+                              fuse_ino_t ino)
+{
+    FuseLowLevelInterface& ll = get_(req);
+    struct statvfs st;
+
+    const int ret = FuseInterface::errno_from_exceptions(ino,
+                                                         [&]
+                                                         {
+                                                             ll.fs_.statfs(ll.object_id_(ino),
+                                                                           st);
+                                                         });
+    if (ret == 0)
+    {
+        fuse_reply_statfs(req, &st);
+    }
+    else
+    {
+        reply_err(req, ret);
+    }
+}
+
+}
@@ -0,0 +1,264 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VFS_FUSE_LOWLEVEL_INTERFACE_H_
+#define VFS_FUSE_LOWLEVEL_INTERFACE_H_
+
+#include "FileSystem.h"
+#include "Object.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <youtils/Logging.h>
+
+#ifndef FUSE_USE_VERSION
+#define FUSE_USE_VERSION 30
+#endif
+#include <fuse3/fuse_lowlevel.h>
+
+namespace volumedriverfstest
+{
+class FuseLowLevelInterfaceTest;
+}
+
+namespace volumedriverfs
+{
+
+// Alternative FUSE frontend on top of the low level (inode based) API: the
+// kernel refers to entities by the inode number of their DirectoryEntry, so
+// instead of resolving every request by path we only need a path lookup on
+// LOOKUP / CREATE and can use the ObjectId based FileSystem calls afterwards.
+// Writes are passed in as fuse_bufs which allows FUSE to splice them from
+// /dev/fuse instead of copying them through its own buffers first.
+class FuseLowLevelInterface
+{
+    friend class volumedriverfstest::FuseLowLevelInterfaceTest;
+
+public:
+    FuseLowLevelInterface(FileSystem& fs,
+                          uint32_t max_write,
+                          bool writeback_cache);
+
+    ~FuseLowLevelInterface();
+
+    FuseLowLevelInterface(const FuseLowLevelInterface&) = delete;
+
+    FuseLowLevelInterface&
+    operator=(const FuseLowLevelInterface&) = delete;
+
+    // Parses the args and mounts - errors are reported to the caller (cf.
+    // fuse_setup in FuseInterface.cpp). Returns whether the session is to
+    // be run multithreaded.
+    bool
+    mount(std::vector<char*>& argv);
+
+    void
+    run(bool multithreaded);
+
+    void
+    unmount();
+
+    // exposed for testing
+    size_t
+    known_inodes() const
+    {
+        std::lock_guard<decltype(inodes_lock_)> g(inodes_lock_);
+        return inodes_.size();
+    }
+
+private:
+    DECLARE_LOGGER("FuseLowLevelInterface");
+
+    struct InodeEntry
+    {
+        ObjectId id;
+        uint64_t nlookup;
+    };
+
+    FileSystem& fs_;
+    const uint32_t max_write_;
+    const bool writeback_cache_;
+
+    mutable std::mutex inodes_lock_;
+    std::unordered_map<fuse_ino_t, InodeEntry> inodes_;
+    ObjectId root_id_;
+
+    fuse_session* session_;
+    fuse_chan* chan_;
+    char* mountpoint_;
+
+    static void
+    init_ops_(fuse_lowlevel_ops& ops);
+
+    static FuseLowLevelInterface&
+    get_(fuse_req_t req);
+
+    ObjectId
+    object_id_(fuse_ino_t ino) const;
+
+    fuse_ino_t
+    inode_(const ObjectId& id,
+           const struct stat& st) const;
+
+    void
+    lookup_(const ObjectId& parent_id,
+            const std::string& name,
+            fuse_entry_param& e);
+
+    void
+    forget_(fuse_ino_t ino,
+            uint64_t nlookup);
+
+    void
+    create_(const ObjectId& parent_id,
+            const std::string& name,
+            UserId uid,
+            GroupId gid,
+            Permissions pms,
+            int flags,
+            fuse_entry_param& e,
+            Handle::Ptr& h);
+
+    void
+    getattr_(const ObjectId& id,
+             struct stat& st);
+
+    static void
+    init(void* userdata,
+         fuse_conn_info* conn);
+
+    static void
+    lookup(fuse_req_t req,
+           fuse_ino_t parent,
+           const char* name);
+
+    static void
+    forget(fuse_req_t req,
+           fuse_ino_t ino,
+           uint64_t nlookup);
+
+    static void
+    forget_multi(fuse_req_t req,
+                 size_t count,
+                 fuse_forget_data* forgets);
+
+    static void
+    getattr(fuse_req_t req,
+            fuse_ino_t ino,
+            fuse_file_info* fi);
+
+    static void
+    setattr(fuse_req_t req,
+            fuse_ino_t ino,
+            struct stat* attr,
+            int to_set,
+            fuse_file_info* fi);
+
+    static void
+    mknod(fuse_req_t req,
+          fuse_ino_t parent,
+          const char* name,
+          mode_t mode,
+          dev_t rdev);
+
+    static void
+    mkdir(fuse_req_t req,
+          fuse_ino_t parent,
+          const char* name,
+          mode_t mode);
+
+    static void
+    unlink(fuse_req_t req,
+           fuse_ino_t parent,
+           const char* name);
+
+    static void
+    rmdir(fuse_req_t req,
+          fuse_ino_t parent,
+          const char* name);
+
+    static void
+    rename(fuse_req_t req,
+           fuse_ino_t parent,
+           const char* name,
+           fuse_ino_t newparent,
+           const char* newname,
+           unsigned flags);
+
+    static void
+    create(fuse_req_t req,
+           fuse_ino_t parent,
+           const char* name,
+           mode_t mode,
+           fuse_file_info* fi);
+
+    static void
+    open(fuse_req_t req,
+         fuse_ino_t ino,
+         fuse_file_info* fi);
+
+    static void
+    release(fuse_req_t req,
+            fuse_ino_t ino,
+            fuse_file_info* fi);
+
+    static void
+    read(fuse_req_t req,
+         fuse_ino_t ino,
+         size_t size,
+         off_t off,
+         fuse_file_info* fi);
+
+    static void
+    write_buf(fuse_req_t req,
+              fuse_ino_t ino,
+              fuse_bufvec* bufv,
+              off_t off,
+              fuse_file_info* fi);
+
+    static void
+    fsync(fuse_req_t req,
+          fuse_ino_t ino,
+          int datasync,
+          fuse_file_info* fi);
+
+    static void
+    opendir(fuse_req_t req,
+            fuse_ino_t ino,
+            fuse_file_info* fi);
+
+    static void
+    readdir(fuse_req_t req,
+            fuse_ino_t ino,
+            size_t size,
+            off_t off,
+            fuse_file_info* fi);
+
+    static void
+    releasedir(fuse_req_t req,
+               fuse_ino_t ino,
+               fuse_file_info* fi);
+
+    static void
+    statfs(fuse_req_t req,
+           fuse_ino_t ino);
+};
+
+}
+
+#endif // !VFS_FUSE_LOWLEVEL_INTERFACE_H_
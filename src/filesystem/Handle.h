@@ -20,6 +20,7 @@
 #include "FastPathCookie.h"
 #include "FrontendPath.h"
 #include "Object.h"
+#include "StreamDetector.h"
 
 #include <boost/make_shared.hpp>
 
@@ -74,6 +75,12 @@ public:
         cookie_ = c;
     }
 
+    StreamDetector&
+    stream_detector()
+    {
+        return stream_detector_;
+    }
+
 private:
     DECLARE_LOGGER("VFSHandle");
 
@@ -82,6 +89,8 @@ private:
 
     mutable fungi::SpinLock cookie_lock_;
     FastPathCookie cookie_;
+
+    StreamDetector stream_detector_;
 };
 
 }
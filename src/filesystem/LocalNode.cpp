@@ -60,9 +60,6 @@ using Clock = bc::steady_clock;
 #define LOCKVD()                                                        \
     std::lock_guard<fungi::Mutex> vdg__(api::getManagementMutex())
 
-#define LOCK_LOCKS()                                                    \
-    std::lock_guard<decltype(object_lock_map_lock_)> vlmlg_(object_lock_map_lock_)
-
 namespace
 {
 
@@ -108,6 +105,9 @@ LocalNode::LocalNode(ObjectRouter& router,
     , vrouter_backend_sync_check_interval_ms(pt)
     , scrub_manager_interval(pt)
     , scrub_manager_sync_wait_secs(pt)
+    , vrouter_read_ahead_threads(pt)
+    , read_ahead_stop_(false)
+    , read_ahead_dropped_(0)
 {
     LOG_TRACE("Initializing volumedriver");
 
@@ -137,10 +137,13 @@ LocalNode::LocalNode(ObjectRouter& router,
                                        std::bind(&LocalNode::collect_scrub_garbage_,
                                                  this,
                                                  ph::_1));
+
+    start_read_ahead_();
 }
 
 LocalNode::~LocalNode()
 {
+    stop_read_ahead_();
     scrub_manager_ = nullptr;
     api::Exit();
 }
@@ -205,6 +208,7 @@ LocalNode::update_config(const bpt::ptree& pt,
     U(vrouter_backend_sync_check_interval_ms);
     U(scrub_manager_interval);
     U(scrub_manager_sync_wait_secs);
+    U(vrouter_read_ahead_threads);
 
 #undef U
 }
@@ -222,6 +226,7 @@ LocalNode::persist_config(bpt::ptree& pt,
     P(vrouter_backend_sync_check_interval_ms)
     P(scrub_manager_interval);
     P(scrub_manager_sync_wait_secs);
+    P(vrouter_read_ahead_threads);
 
 #undef P
 }
@@ -240,37 +245,49 @@ LocalNode::reset_lock_reaper_()
 void
 LocalNode::reap_locks_()
 {
-    LOCK_LOCKS();
     LOG_TRACE("dropping unused locks");
 
-    // instead of messing with possibly invalid iterators, we simply swap
-    ObjectLockMap vlm;
-
-    for (auto& v : object_lock_map_)
+    for (auto& shard : object_lock_shards_)
     {
-        if (v.second.use_count() > 1)
+        std::lock_guard<decltype(shard.lock)> g(shard.lock);
+
+        // instead of messing with possibly invalid iterators, we simply swap
+        ObjectLockMap vlm;
+
+        for (auto& v : shard.map)
         {
-            vlm.insert(v);
+            if (v.second.use_count() > 1)
+            {
+                vlm.insert(v);
+            }
         }
+
+        std::swap(vlm, shard.map);
     }
+}
 
-    std::swap(vlm, object_lock_map_);
+LocalNode::ObjectLockShard&
+LocalNode::object_lock_shard_(const ObjectId& id)
+{
+    return object_lock_shards_[std::hash<std::string>()(id.str()) %
+                               object_lock_shards_.size()];
 }
 
 LocalNode::RWLockPtr
 LocalNode::get_lock_(const ObjectId& id)
 {
-    LOCK_LOCKS();
+    ObjectLockShard& shard = object_lock_shard_(id);
+    std::lock_guard<decltype(shard.lock)> g(shard.lock);
 
-    auto it = object_lock_map_.find(id);
-    if (it != object_lock_map_.end())
+    auto it = shard.map.find(id);
+    if (it != shard.map.end())
     {
         return it->second;
     }
     else
     {
         RWLockPtr l(new fungi::RWLock(id.str()));
-        object_lock_map_[id] = l;
+        shard.map[id] = l;
         return l;
     }
 }
@@ -425,8 +442,8 @@ LocalNode::read(const FastPathCookie& cookie,
 						  std::uncaught_exception());
 				     }));
 
-    RWLockPtr l(get_lock_(id));
-    fungi::ScopedReadLock rg(*l);
+    ASSERT(cookie->lock);
+    fungi::ScopedReadLock rg(*cookie->lock);
 
     vd::SharedVolumePtr vol(cookie->volume.lock());
 
@@ -446,6 +463,142 @@ LocalNode::read(const FastPathCookie& cookie,
     }
 }
 
+void
+LocalNode::start_read_ahead_()
+{
+    const uint32_t nthreads = vrouter_read_ahead_threads.value();
+    read_ahead_threads_.reserve(nthreads);
+
+    for (uint32_t i = 0; i < nthreads; ++i)
+    {
+        read_ahead_threads_.emplace_back([this]
+                                         {
+                                             read_ahead_work_();
+                                         });
+    }
+}
+
+void
+LocalNode::stop_read_ahead_()
+{
+    {
+        std::lock_guard<decltype(read_ahead_lock_)> g(read_ahead_lock_);
+        read_ahead_stop_ = true;
+        read_ahead_queue_.clear();
+    }
+
+    read_ahead_cond_.notify_all();
+
+    for (auto& t : read_ahead_threads_)
+    {
+        t.join();
+    }
+
+    read_ahead_threads_.clear();
+
+    LOG_INFO("read ahead stopped, " << read_ahead_dropped_ <<
+             " requests were dropped");
+}
+
+void
+LocalNode::read_ahead(const Object& obj,
+                      const off_t off,
+                      const size_t size)
+{
+    if (read_ahead_threads_.empty())
+    {
+        return;
+    }
+
+    // Don't let a backlog build up: by the time it'd be worked off the
+    // reader has caught up anyway.
+    const size_t max_queued = 16 * read_ahead_threads_.size();
+
+    {
+        std::lock_guard<decltype(read_ahead_lock_)> g(read_ahead_lock_);
+        if (read_ahead_stop_)
+        {
+            return;
+        }
+
+        if (read_ahead_queue_.size() >= max_queued)
+        {
+            ++read_ahead_dropped_;
+            LOG_TRACE(obj << ": dropping read ahead request, off " << off <<
+                      ", size " << size);
+            return;
+        }
+
+        read_ahead_queue_.push_back(ReadAheadRequest{ obj,
+                                                      off,
+                                                      size });
+    }
+
+    read_ahead_cond_.notify_one();
+}
+
+void
+LocalNode::read_ahead_work_()
+{
+    // Bounds the memory used per thread - bigger requests are carried out
+    // piecemeal.
+    static const size_t chunk_size = 1ULL << 20;
+    std::vector<uint8_t> buf;
+
+    while (true)
+    {
+        std::unique_lock<decltype(read_ahead_lock_)> u(read_ahead_lock_);
+        read_ahead_cond_.wait(u,
+                              [&]
+                              {
+                                  return read_ahead_stop_ or
+                                      not read_ahead_queue_.empty();
+                              });
+
+        if (read_ahead_stop_)
+        {
+            return;
+        }
+
+        const ReadAheadRequest req(read_ahead_queue_.front());
+        read_ahead_queue_.pop_front();
+        u.unlock();
+
+        LOG_TRACE(req.obj << ": read ahead, off " << req.off << ", size " <<
+                  req.size);
+
+        try
+        {
+            off_t off = req.off;
+            size_t left = req.size;
+
+            while (left > 0)
+            {
+                size_t size = std::min(left,
+                                       chunk_size);
+                buf.resize(size);
+
+                read(req.obj,
+                     buf.data(),
+                     &size,
+                     off);
+
+                if (size == 0 or read_ahead_stop_)
+                {
+                    break;
+                }
+
+                off += size;
+                left -= std::min(left,
+                                 size);
+            }
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_WARN(req.obj << ": read ahead failed: " << EWHAT);
+            });
+    }
+}
+
 // TODO: align I/O to cluster instead of LBA size to avoid the volumedriver lib
 // having to do it internally.
 void
@@ -594,12 +747,13 @@ LocalNode::write(const FastPathCookie& cookie,
 						  std::uncaught_exception());
 				     }));
 
-    RWLockPtr l(get_lock_(id));
+    ASSERT(cookie->lock);
+    fungi::RWLock& l = *cookie->lock;
 
     if (is_unaligned(*size,
                      off))
     {
-        fungi::ScopedWriteLock wg(*l);
+        fungi::ScopedWriteLock wg(l);
         return write_(cookie,
                       id,
                       buf,
@@ -608,7 +762,7 @@ LocalNode::write(const FastPathCookie& cookie,
     }
     else
     {
-        fungi::ScopedReadLock rg(*l);
+        fungi::ScopedReadLock rg(l);
         return write_(cookie,
                       id,
                       buf,
@@ -747,8 +901,8 @@ LocalNode::sync(const FastPathCookie& cookie,
 						  std::uncaught_exception());
 				     }));
 
-    RWLockPtr l(get_lock_(id));
-    fungi::ScopedReadLock rg(*l);
+    ASSERT(cookie->lock);
+    fungi::ScopedReadLock rg(*cookie->lock);
 
     vd::SharedVolumePtr vol(cookie->volume.lock());
 
@@ -1971,12 +2125,15 @@ LocalNode::fast_path_cookie(const Object& obj)
     }
     else
     {
+        RWLockPtr l(get_lock_(obj.id));
+
         LOCKVD();
         boost::optional<vd::WeakVolumePtr>
             maybe_vol(api::get_volume_pointer_no_throw(static_cast<vd::VolumeId>(obj.id)));
         if (maybe_vol)
         {
-            return std::make_shared<LocalVolumeCookie>(*maybe_vol);
+            return std::make_shared<LocalVolumeCookie>(*maybe_vol,
+                                                       std::move(l));
         }
         else
         {
@@ -24,6 +24,11 @@
 #include "ForceRestart.h"
 #include "NodeId.h"
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+
 #include <boost/property_tree/ptree_fwd.hpp>
 
 #include <youtils/ArakoonInterface.h>
@@ -95,6 +100,14 @@ public:
           size_t* size,
           const off_t off) override final;
 
+    // Asynchronously reads [off, off + size) to pull it into the caches
+    // (SCO cache, and the cluster cache if the volume's behaviour permits).
+    // Merely a hint: dropped if the read ahead threads are busy.
+    void
+    read_ahead(const Object& obj,
+               const off_t off,
+               const size_t size);
+
     virtual void
     sync(const Object& obj) override final;
 
@@ -257,6 +270,7 @@ private:
     DECLARE_PARAMETER(vrouter_backend_sync_check_interval_ms);
     DECLARE_PARAMETER(scrub_manager_interval);
     DECLARE_PARAMETER(scrub_manager_sync_wait_secs);
+    DECLARE_PARAMETER(vrouter_read_ahead_threads);
 
     std::unique_ptr<filedriver::ContainerManager> fdriver_;
 
@@ -268,15 +282,22 @@ private:
     // .
     // During all other calls shared mode (R) is preferrable to allow concurrent I/O.
     //
-    // The object_lock_map_lock_ is unsurprisingly only used to protect the
-    // object_lock_map_.
+    // The locks live in a table that is sharded by the hash of the ObjectId so
+    // lookups on different objects don't serialize on a single mutex; each
+    // shard's mutex is only used to protect its map. The fast path does not
+    // even look at the table as the FastPathCookie holds on to the lock.
     // Lock order: per-object lock before VolumeDriver management lock.
     typedef std::shared_ptr<fungi::RWLock> RWLockPtr;
     typedef std::map<ObjectId, RWLockPtr> ObjectLockMap;
-    ObjectLockMap object_lock_map_;
 
-    // make it a RWLock (again) if profiling shows its a bottleneck
-    mutable std::mutex object_lock_map_lock_;
+    struct ObjectLockShard
+    {
+        mutable std::mutex lock;
+        ObjectLockMap map;
+    };
+
+    static constexpr size_t object_lock_shards = 64;
+    std::array<ObjectLockShard, object_lock_shards> object_lock_shards_;
 
     // A unique_ptr so it can be reset if the interval - which is typically very big -
     // is updated.
@@ -285,12 +306,38 @@ private:
 
     std::unique_ptr<ScrubManager> scrub_manager_;
 
+    struct ReadAheadRequest
+    {
+        Object obj;
+        off_t off;
+        size_t size;
+    };
+
+    std::mutex read_ahead_lock_;
+    std::condition_variable read_ahead_cond_;
+    std::deque<ReadAheadRequest> read_ahead_queue_;
+    std::atomic<bool> read_ahead_stop_;
+    std::vector<boost::thread> read_ahead_threads_;
+    std::atomic<uint64_t> read_ahead_dropped_;
+
     void
     reset_lock_reaper_();
 
+    void
+    start_read_ahead_();
+
+    void
+    stop_read_ahead_();
+
+    void
+    read_ahead_work_();
+
     void
     reap_locks_();
 
+    ObjectLockShard&
+    object_lock_shard_(const ObjectId& id);
+
     RWLockPtr
     get_lock_(const ObjectId& id);
 
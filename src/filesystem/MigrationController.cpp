@@ -0,0 +1,424 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "MigrationController.h"
+
+#include <ctime>
+#include <iostream>
+
+#include <boost/lexical_cast.hpp>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+
+namespace volumedriverfs
+{
+
+namespace bc = boost::chrono;
+
+namespace
+{
+
+// weight of the history in the decayed averages
+const double decay = 0.5;
+
+// forget about objects that were not redirected to for that long
+const uint32_t max_idle_periods = 8;
+
+}
+
+std::ostream&
+operator<<(std::ostream& os,
+           MigrationVerdict v)
+{
+    switch (v)
+    {
+    case MigrationVerdict::Sustaining:
+        return os << "Sustaining";
+    case MigrationVerdict::NoCapacity:
+        return os << "NoCapacity";
+    case MigrationVerdict::HoldOff:
+        return os << "HoldOff";
+    case MigrationVerdict::Migrate:
+        return os << "Migrate";
+    case MigrationVerdict::MigrationFailed:
+        return os << "MigrationFailed";
+    }
+
+    return os << "(unknown MigrationVerdict)";
+}
+
+constexpr size_t MigrationController::max_decisions;
+
+MigrationController::MigrationController(EstimateCostFun estimate_cost,
+                                         MigrateFun migrate)
+    : estimate_cost_(std::move(estimate_cost))
+    , migrate_(std::move(migrate))
+    , last_run_(Clock::now())
+{
+    VERIFY(estimate_cost_);
+    VERIFY(migrate_);
+}
+
+MigrationController::Stats&
+MigrationController::get_stats_(const ObjectId& id,
+                                ObjectType type,
+                                const NodeId& owner)
+{
+    auto it = stats_.find(id);
+    if (it == stats_.end())
+    {
+        it = stats_.emplace(id,
+                            Stats(type,
+                                  owner)).first;
+    }
+    else
+    {
+        it->second.owner = owner;
+    }
+
+    return it->second;
+}
+
+void
+MigrationController::record_read(const ObjectId& id,
+                                 ObjectType type,
+                                 const NodeId& owner,
+                                 size_t bytes,
+                                 const Clock::duration& latency)
+{
+    std::lock_guard<decltype(lock_)> g(lock_);
+
+    Stats& s = get_stats_(id,
+                          type,
+                          owner);
+    ++s.reads;
+    ++s.requests;
+    s.read_bytes += bytes;
+    s.latency += latency;
+}
+
+void
+MigrationController::record_write(const ObjectId& id,
+                                  ObjectType type,
+                                  const NodeId& owner,
+                                  size_t bytes,
+                                  const Clock::duration& latency)
+{
+    std::lock_guard<decltype(lock_)> g(lock_);
+
+    Stats& s = get_stats_(id,
+                          type,
+                          owner);
+    ++s.writes;
+    ++s.requests;
+    s.write_bytes += bytes;
+    s.latency += latency;
+}
+
+void
+MigrationController::started_here(const ObjectId& id)
+{
+    std::lock_guard<decltype(lock_)> g(lock_);
+
+    stats_.erase(id);
+    started_here_[id] = Clock::now();
+}
+
+void
+MigrationController::run(const Policy& policy)
+{
+    run(policy,
+        Clock::now());
+}
+
+void
+MigrationController::run(const Policy& policy,
+                         const Clock::time_point& now)
+{
+    std::vector<Candidate> candidates;
+
+    {
+        std::lock_guard<decltype(lock_)> g(lock_);
+
+        const double period_secs =
+            std::max(bc::duration<double>(now - last_run_).count(),
+                     0.001);
+        last_run_ = now;
+
+        for (auto it = started_here_.begin(); it != started_here_.end();)
+        {
+            if (now - it->second >= policy.holdoff)
+            {
+                it = started_here_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        for (auto it = stats_.begin(); it != stats_.end();)
+        {
+            auto c(evaluate_(it->first,
+                             it->second,
+                             policy,
+                             now,
+                             period_secs));
+            if (c)
+            {
+                candidates.emplace_back(std::move(*c));
+            }
+
+            if (it->second.idle_periods >= max_idle_periods)
+            {
+                LOG_TRACE(it->first << ": no longer tracked as it's idle");
+                it = stats_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    // Off the lock as estimating the cost and migrating can take a while.
+    for (auto& c : candidates)
+    {
+        decide_(c,
+                policy);
+    }
+}
+
+boost::optional<MigrationController::Candidate>
+MigrationController::evaluate_(const ObjectId& id,
+                               Stats& s,
+                               const Policy& policy,
+                               const Clock::time_point& now,
+                               double period_secs)
+{
+    s.read_bytes_per_sec = decay * s.read_bytes_per_sec +
+        (1 - decay) * s.read_bytes / period_secs;
+    s.write_bytes_per_sec = decay * s.write_bytes_per_sec +
+        (1 - decay) * s.write_bytes / period_secs;
+    s.remote_time_share = decay * s.remote_time_share +
+        (1 - decay) * bc::duration<double>(s.latency).count() / period_secs;
+
+    if (s.requests == 0)
+    {
+        ++s.idle_periods;
+    }
+    else
+    {
+        s.idle_periods = 0;
+    }
+
+    s.read_bytes = 0;
+    s.write_bytes = 0;
+    s.requests = 0;
+    s.latency = Clock::duration::zero();
+
+    const bool is_file = s.type == ObjectType::File;
+    const uint64_t rthresh = is_file ?
+        policy.file_read_threshold :
+        policy.volume_read_threshold;
+    const uint64_t wthresh = is_file ?
+        policy.file_write_threshold :
+        policy.volume_write_threshold;
+
+    const bool enough_requests =
+        (rthresh > 0 and s.reads >= rthresh) or
+        (wthresh > 0 and s.writes >= wthresh);
+
+    const double bytes_per_sec = s.read_bytes_per_sec + s.write_bytes_per_sec;
+    const bool enough_bytes =
+        bytes_per_sec > 0 and
+        bytes_per_sec >= 1024.0 * policy.min_kib_per_sec;
+
+    const bool enough_time =
+        policy.min_remote_time_percent > 0 and
+        100 * s.remote_time_share >= policy.min_remote_time_percent;
+
+    LOG_TRACE(id << ": reads " << s.reads <<
+              ", writes " << s.writes <<
+              ", bytes/s " << bytes_per_sec <<
+              ", remote time share " << s.remote_time_share);
+
+    if (not enough_requests or not (enough_bytes or enough_time))
+    {
+        s.hot_periods = 0;
+        return boost::none;
+    }
+
+    ++s.hot_periods;
+
+    Candidate c;
+    c.id = id;
+    c.check_cost =
+        not is_file and
+        (s.cost == boost::none or
+         ((s.hot_periods - 1) % std::max<uint64_t>(policy.cost_check_periods,
+                                                   1)) == 0);
+
+    MigrationDecision& d = c.decision;
+    d.object_id = id;
+    d.owner_id = s.owner;
+    d.read_kib_per_sec = s.read_bytes_per_sec / 1024;
+    d.write_kib_per_sec = s.write_bytes_per_sec / 1024;
+    d.remote_time_percent = 100 * s.remote_time_share;
+    d.hot_periods = s.hot_periods;
+    d.required_periods = policy.sustain_periods;
+
+    auto it = started_here_.find(id);
+    if (it != started_here_.end() and now - it->second < policy.holdoff)
+    {
+        log_decision_(d,
+                      MigrationVerdict::HoldOff);
+        return boost::none;
+    }
+
+    if (not is_file and not c.check_cost)
+    {
+        VERIFY(s.cost);
+        if (s.cost->volume_potential == 0)
+        {
+            log_decision_(d,
+                          MigrationVerdict::NoCapacity);
+            return boost::none;
+        }
+
+        d.required_periods *= 1 +
+            (s.cost->volume_potential <= 1 ? 1 : 0) +
+            (s.cost->loses_dtl ? 1 : 0);
+    }
+
+    if (not c.check_cost and d.hot_periods < d.required_periods)
+    {
+        log_decision_(d,
+                      MigrationVerdict::Sustaining);
+        return boost::none;
+    }
+
+    return c;
+}
+
+void
+MigrationController::decide_(Candidate& c,
+                             const Policy& policy)
+{
+    MigrationDecision& d = c.decision;
+
+    if (c.check_cost)
+    {
+        LOG_INFO(c.id << ": estimating the cost of migrating it here");
+
+        boost::optional<MigrationCost> cost;
+
+        try
+        {
+            cost = estimate_cost_(c.id);
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_ERROR(c.id <<
+                          ": failed to estimate migration cost: " <<
+                          EWHAT << " - let's rather not migrate here");
+            });
+
+        {
+            std::lock_guard<decltype(lock_)> g(lock_);
+
+            auto it = stats_.find(c.id);
+            if (it != stats_.end())
+            {
+                it->second.cost = cost;
+            }
+
+            if (cost == boost::none or cost->volume_potential == 0)
+            {
+                log_decision_(d,
+                              MigrationVerdict::NoCapacity);
+                return;
+            }
+        }
+
+        d.required_periods = policy.sustain_periods *
+            (1 +
+             (cost->volume_potential <= 1 ? 1 : 0) +
+             (cost->loses_dtl ? 1 : 0));
+
+        if (d.hot_periods < d.required_periods)
+        {
+            std::lock_guard<decltype(lock_)> g(lock_);
+            log_decision_(d,
+                          MigrationVerdict::Sustaining);
+            return;
+        }
+    }
+
+    LOG_INFO(c.id << ": attempting auto migration from " << d.owner_id <<
+             " after " << d.hot_periods << " periods, read KiB/s " <<
+             d.read_kib_per_sec << ", write KiB/s " << d.write_kib_per_sec <<
+             ", remote time " << d.remote_time_percent << "%");
+
+    MigrationVerdict verdict = MigrationVerdict::MigrationFailed;
+
+    try
+    {
+        migrate_(c.id);
+        verdict = MigrationVerdict::Migrate;
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_WARN(c.id << ": failed to auto migrate from " <<
+                     d.owner_id << ": " << EWHAT);
+        });
+
+    std::lock_guard<decltype(lock_)> g(lock_);
+    log_decision_(d,
+                  verdict);
+}
+
+void
+MigrationController::log_decision_(MigrationDecision& d,
+                                   MigrationVerdict v)
+{
+    LOG_DEBUG(d.object_id << ": " << v << ", hot for " << d.hot_periods <<
+              " out of " << d.required_periods << " periods");
+
+    d.verdict = boost::lexical_cast<std::string>(v);
+    d.timestamp = ::time(nullptr);
+
+    decisions_.push_back(d);
+    while (decisions_.size() > max_decisions)
+    {
+        decisions_.pop_front();
+    }
+}
+
+std::vector<MigrationDecision>
+MigrationController::decisions() const
+{
+    std::lock_guard<decltype(lock_)> g(lock_);
+    return std::vector<MigrationDecision>(decisions_.begin(),
+                                          decisions_.end());
+}
+
+size_t
+MigrationController::tracked_objects() const
+{
+    std::lock_guard<decltype(lock_)> g(lock_);
+    return stats_.size();
+}
+
+}
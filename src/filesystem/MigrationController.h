@@ -0,0 +1,220 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VFS_MIGRATION_CONTROLLER_H_
+#define VFS_MIGRATION_CONTROLLER_H_
+
+#include "MigrationDecision.h"
+#include "NodeId.h"
+#include "Object.h"
+
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/optional.hpp>
+
+#include <youtils/Logging.h>
+
+namespace volumedriverfs
+{
+
+enum class MigrationVerdict
+{
+    // worth migrating, but not for long enough yet
+    Sustaining,
+    // no room for it on this node
+    NoCapacity,
+    // it was running here not long ago
+    HoldOff,
+    Migrate,
+    MigrationFailed,
+};
+
+std::ostream&
+operator<<(std::ostream&,
+           MigrationVerdict);
+
+// Decides whether objects that are accessed through redirection should be
+// migrated to this node. The I/O path only records the redirected requests
+// (bytes and latency); the decisions are taken once per control period by
+// run(), which is meant to be driven by a PeriodicAction:
+// * per object, decaying averages of the redirected bytes/s and of the share
+//   of time spent waiting for redirected requests are maintained
+// * an object is "hot" if it saw at least the configured number of redirected
+//   reads or writes (the vrouter_{volume,file}_{read,write}_threshold) and
+//   either the rate or the time share exceeds its minimum
+// * it needs to stay hot for a number of consecutive periods which grows with
+//   the estimated cost of migrating it here (little room left in the SCO
+//   cache / metadata budget, losing the DTL), and objects that ran here
+//   recently are held off to avoid ping-ponging.
+class MigrationController
+{
+public:
+    using Clock = boost::chrono::steady_clock;
+
+    struct Policy
+    {
+        // 0 disables auto migration for the respective kind of request
+        uint64_t volume_read_threshold = 0;
+        uint64_t volume_write_threshold = 0;
+        uint64_t file_read_threshold = 0;
+        uint64_t file_write_threshold = 0;
+        // 0: any rate will do
+        uint64_t min_kib_per_sec = 0;
+        // 0: not taken into account
+        uint32_t min_remote_time_percent = 0;
+        uint32_t sustain_periods = 1;
+        // recheck the cost estimate of a hot volume every n periods
+        uint64_t cost_check_periods = 1;
+        boost::chrono::seconds holdoff = boost::chrono::seconds(0);
+    };
+
+    struct MigrationCost
+    {
+        // number of additional volumes this node could host
+        uint64_t volume_potential;
+        // the volume would end up without a DTL here
+        bool loses_dtl;
+    };
+
+    using EstimateCostFun = std::function<MigrationCost(const ObjectId&)>;
+    // throws if the migration failed
+    using MigrateFun = std::function<void(const ObjectId&)>;
+
+    static constexpr size_t max_decisions = 128;
+
+    MigrationController(EstimateCostFun estimate_cost,
+                        MigrateFun migrate);
+
+    ~MigrationController() = default;
+
+    MigrationController(const MigrationController&) = delete;
+
+    MigrationController&
+    operator=(const MigrationController&) = delete;
+
+    // I/O path.
+    void
+    record_read(const ObjectId&,
+                ObjectType,
+                const NodeId& owner,
+                size_t bytes,
+                const Clock::duration& latency);
+
+    void
+    record_write(const ObjectId&,
+                 ObjectType,
+                 const NodeId& owner,
+                 size_t bytes,
+                 const Clock::duration& latency);
+
+    // The object was (re)started on this node.
+    void
+    started_here(const ObjectId&);
+
+    // One control period.
+    void
+    run(const Policy&);
+
+    void
+    run(const Policy&,
+        const Clock::time_point& now);
+
+    // Most recent last.
+    std::vector<MigrationDecision>
+    decisions() const;
+
+    size_t
+    tracked_objects() const;
+
+private:
+    DECLARE_LOGGER("MigrationController");
+
+    struct Stats
+    {
+        ObjectType type;
+        NodeId owner;
+
+        // since the last start of the object here (or since it was last idle)
+        uint64_t reads = 0;
+        uint64_t writes = 0;
+
+        // current period
+        uint64_t read_bytes = 0;
+        uint64_t write_bytes = 0;
+        uint64_t requests = 0;
+        Clock::duration latency = Clock::duration::zero();
+
+        // decayed
+        double read_bytes_per_sec = 0;
+        double write_bytes_per_sec = 0;
+        double remote_time_share = 0;
+
+        uint32_t hot_periods = 0;
+        uint32_t idle_periods = 0;
+        boost::optional<MigrationCost> cost;
+
+        Stats(ObjectType t,
+              const NodeId& o)
+            : type(t)
+            , owner(o)
+        {}
+    };
+
+    struct Candidate
+    {
+        ObjectId id;
+        bool check_cost;
+        MigrationDecision decision;
+    };
+
+    const EstimateCostFun estimate_cost_;
+    const MigrateFun migrate_;
+
+    mutable std::mutex lock_;
+    std::unordered_map<ObjectId, Stats> stats_;
+    std::unordered_map<ObjectId, Clock::time_point> started_here_;
+    std::deque<MigrationDecision> decisions_;
+    Clock::time_point last_run_;
+
+    Stats&
+    get_stats_(const ObjectId&,
+               ObjectType,
+               const NodeId&);
+
+    boost::optional<Candidate>
+    evaluate_(const ObjectId&,
+              Stats&,
+              const Policy&,
+              const Clock::time_point& now,
+              double period_secs);
+
+    void
+    decide_(Candidate&,
+            const Policy&);
+
+    void
+    log_decision_(MigrationDecision&,
+                  MigrationVerdict);
+};
+
+}
+
+#endif // !VFS_MIGRATION_CONTROLLER_H_
@@ -0,0 +1,93 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VFS_MIGRATION_DECISION_H_
+#define VFS_MIGRATION_DECISION_H_
+
+#include "NodeId.h"
+#include "Object.h"
+
+#include <boost/archive/xml_iarchive.hpp>
+#include <boost/archive/xml_oarchive.hpp>
+
+#include <youtils/Serialization.h>
+
+namespace volumedriverfs
+{
+
+// What the MigrationController made of an object that is accessed through
+// redirection at the end of a control period - retrievable via XMLRPC.
+struct MigrationDecision
+{
+    typedef boost::archive::xml_oarchive oarchive_type;
+    typedef boost::archive::xml_iarchive iarchive_type;
+
+    ObjectId object_id;
+    NodeId owner_id;
+    // decayed rates of redirected I/O
+    uint64_t read_kib_per_sec;
+    uint64_t write_kib_per_sec;
+    // share of wall clock time spent waiting for redirected I/O
+    uint32_t remote_time_percent;
+    // consecutive periods the object was found to be worth migrating ...
+    uint32_t hot_periods;
+    // ... and how many are required given the (estimated) migration cost
+    uint32_t required_periods;
+    std::string verdict;
+    // seconds since the epoch
+    uint64_t timestamp;
+
+    MigrationDecision()
+        : read_kib_per_sec(0)
+        , write_kib_per_sec(0)
+        , remote_time_percent(0)
+        , hot_periods(0)
+        , required_periods(0)
+        , timestamp(0)
+    {}
+
+    template<typename Archive>
+    void
+    serialize(Archive& ar, const unsigned int /*version*/)
+    {
+        ar & BOOST_SERIALIZATION_NVP(object_id);
+        ar & BOOST_SERIALIZATION_NVP(owner_id);
+        ar & BOOST_SERIALIZATION_NVP(read_kib_per_sec);
+        ar & BOOST_SERIALIZATION_NVP(write_kib_per_sec);
+        ar & BOOST_SERIALIZATION_NVP(remote_time_percent);
+        ar & BOOST_SERIALIZATION_NVP(hot_periods);
+        ar & BOOST_SERIALIZATION_NVP(required_periods);
+        ar & BOOST_SERIALIZATION_NVP(verdict);
+        ar & BOOST_SERIALIZATION_NVP(timestamp);
+    }
+
+    static constexpr const char* serialization_name = "MigrationDecision";
+
+    std::string
+    str() const
+    {
+        std::stringstream ss;
+        youtils::Serialization::serializeNVPAndFlush<oarchive_type>(ss,
+                                                                    serialization_name,
+                                                                    *this);
+        return ss.str();
+    }
+};
+
+}
+
+BOOST_CLASS_VERSION(volumedriverfs::MigrationDecision, 1);
+
+#endif // !VFS_MIGRATION_DECISION_H_
@@ -860,7 +860,34 @@ NetworkXioIOHandler::handle_request(NetworkXioRequest *req)
     req->work.func = std::bind(&NetworkXioIOHandler::process_request,
                                this,
                                req);
-    wq_->work_schedule(req);
+    req->work.cancel = std::bind(&NetworkXioIOHandler::cancel_request,
+                                 this,
+                                 req);
+    wq_->work_schedule(req,
+                       cq_);
+}
+
+void
+NetworkXioIOHandler::cancel_request(NetworkXioRequest *req)
+{
+    xio_msg *xio_req = req->xio_req;
+
+    // only needed for the opaque so the client can match the reply
+    NetworkXioMsg i_msg(NetworkXioMsgOpcode::Noop);
+    try
+    {
+        i_msg.unpack_msg(static_cast<char*>(xio_req->in.header.iov_base),
+                         xio_req->in.header.iov_len);
+    }
+    catch (...)
+    {
+        LOG_ERROR("cannot unpack message");
+    }
+
+    req->opaque = i_msg.opaque();
+    handle_error(req,
+                 NetworkXioMsgOpcode::ErrorRsp,
+                 ESHUTDOWN);
 }
 
 } //namespace volumedriverfs
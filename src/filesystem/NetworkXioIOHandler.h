@@ -29,9 +29,11 @@ class NetworkXioIOHandler
 public:
     NetworkXioIOHandler(FileSystem& fs,
                         NetworkXioWorkQueuePtr wq,
+                        NetworkXioCompletionQueue& cq,
                         NetworkXioClientData* cd)
     : fs_(fs)
     , wq_(wq)
+    , cq_(cq)
     , cd_(cd)
     {}
 
@@ -54,6 +56,9 @@ public:
     void
     handle_request(NetworkXioRequest* req);
 
+    void
+    cancel_request(NetworkXioRequest* req);
+
     void
     update_fs_client_info(const std::string& volume_name);
 
@@ -124,6 +129,7 @@ private:
 
     FileSystem& fs_;
     NetworkXioWorkQueuePtr wq_;
+    NetworkXioCompletionQueue& cq_;
     NetworkXioClientData *cd_;
 
     std::string volume_name_;
@@ -59,6 +59,9 @@ NetworkXioInterface::update(const bpt::ptree& pt,
     U(network_uri);
     U(network_snd_rcv_queue_depth);
     U(network_workqueue_max_threads);
+    U(network_portals);
+    U(network_portal_address);
+    U(network_portal_base_port);
 #undef U
 }
 
@@ -71,6 +74,9 @@ NetworkXioInterface::persist(bpt::ptree& pt,
     P(network_uri);
     P(network_snd_rcv_queue_depth);
     P(network_workqueue_max_threads);
+    P(network_portals);
+    P(network_portal_address);
+    P(network_portal_base_port);
 #undef P
 }
 
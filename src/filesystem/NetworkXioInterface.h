@@ -39,11 +39,17 @@ public:
     , network_uri(pt)
     , network_snd_rcv_queue_depth(pt)
     , network_workqueue_max_threads(pt)
+    , network_portals(pt)
+    , network_portal_address(pt)
+    , network_portal_base_port(pt)
     , fs_(fs)
     , xio_server_(fs_,
                   uri(),
                   snd_rcv_queue_depth(),
-                  wq_max_threads())
+                  wq_max_threads(),
+                  network_portals.value(),
+                  network_portal_address.value(),
+                  network_portal_base_port.value())
     {}
 
     ~NetworkXioInterface()
@@ -91,12 +97,34 @@ public:
     {
         return network_workqueue_max_threads.value();
     }
+
+    // might be less than configured, cf. NetworkXioServer
+    unsigned int
+    portals() const
+    {
+        return xio_server_.portals();
+    }
+
+    std::vector<uint64_t>
+    portal_requests() const
+    {
+        return xio_server_.portal_requests();
+    }
+
+    NetworkXioWorkQueue::Stats
+    workqueue_stats() const
+    {
+        return xio_server_.workqueue_stats();
+    }
 private:
     DECLARE_LOGGER("NetworkXioInterface");
 
     DECLARE_PARAMETER(network_uri);
     DECLARE_PARAMETER(network_snd_rcv_queue_depth);
     DECLARE_PARAMETER(network_workqueue_max_threads);
+    DECLARE_PARAMETER(network_portals);
+    DECLARE_PARAMETER(network_portal_address);
+    DECLARE_PARAMETER(network_portal_base_port);
 
     FileSystem& fs_;
     NetworkXioServer xio_server_;
@@ -56,6 +56,7 @@ struct NetworkXioRequest
 
 class NetworkXioServer;
 class NetworkXioIOHandler;
+struct NetworkXioPortal;
 
 struct NetworkXioClientData
 {
@@ -66,6 +67,7 @@ struct NetworkXioClientData
     std::atomic<bool> connection_closed;
     std::atomic<uint64_t> refcnt;
     NetworkXioServer *server;
+    NetworkXioPortal *portal;
     NetworkXioIOHandler *ioh;
     std::list<NetworkXioRequest*> done_reqs;
     ClientInfoTag tag;
@@ -21,6 +21,11 @@
 #include <youtils/Assert.h>
 #include <youtils/System.h>
 
+#include <limits>
+
+#include <pthread.h>
+#include <sched.h>
+
 #define POLLING_TIME_USEC   20
 
 namespace yt = youtils;
@@ -30,6 +35,36 @@ namespace volumedriverfs
 
 namespace yt = youtils;
 
+namespace
+{
+
+// Clients are redirected to the additional portals, so they need an address
+// that is reachable from the outside.
+boost::optional<std::string>
+make_portal_host(const yt::Uri& uri,
+                 const std::string& portal_address)
+{
+    if (not portal_address.empty())
+    {
+        return portal_address;
+    }
+
+    const boost::optional<std::string>& host = uri.host();
+    if (host == boost::none or
+        host->empty() or
+        *host == "0.0.0.0" or
+        *host == "::" or
+        *host == "[::]" or
+        *host == "*")
+    {
+        return boost::none;
+    }
+
+    return host;
+}
+
+}
+
 template<class T>
 static int
 static_on_request(xio_session *session,
@@ -114,16 +149,51 @@ static_evfd_stop_loop(int fd, int events, void *data)
 NetworkXioServer::NetworkXioServer(FileSystem& fs,
                                    const yt::Uri& uri,
                                    size_t snd_rcv_queue_depth,
-                                   unsigned int workqueue_max_threads)
+                                   unsigned int workqueue_max_threads,
+                                   unsigned int portals,
+                                   const std::string& portal_address,
+                                   uint16_t portal_base_port)
     : fs_(fs)
     , uri_(uri)
-    , stopping(false)
     , stopped(true)
-    , evfd()
     , queue_depth(snd_rcv_queue_depth)
     , wq_max_threads(workqueue_max_threads)
+    , portal_host_(make_portal_host(uri,
+                                    portal_address))
+    , portal_base_port_(portal_base_port)
+    , nr_portals(check_portals_(portals,
+                                portal_host_,
+                                portal_base_port_))
 {}
 
+unsigned int
+NetworkXioServer::check_portals_(unsigned int portals,
+                                 const boost::optional<std::string>& host,
+                                 uint16_t base_port)
+{
+    if (portals > 1)
+    {
+        if (host == boost::none)
+        {
+            LOG_ERROR(portals <<
+                      " portals requested but there's no routable address to redirect clients to (network_portal_address) - using a single portal");
+            return 1;
+        }
+
+        if (base_port == 0 or
+            static_cast<uint32_t>(base_port) + portals - 2 >
+            std::numeric_limits<uint16_t>::max())
+        {
+            LOG_ERROR(portals <<
+                      " portals requested but no (valid) port range configured (network_portal_base_port: " <<
+                      base_port << ") - using a single portal");
+            return 1;
+        }
+    }
+
+    return std::max(1U, portals);
+}
+
 void
 NetworkXioServer::xio_destroy_ctx_shutdown(xio_context *ctx)
 {
@@ -136,13 +206,217 @@ NetworkXioServer::~NetworkXioServer()
     shutdown();
 }
 
+int
+NetworkXioPortal::on_session_event(xio_session *session,
+                                   xio_session_event_data *event_data)
+{
+    return server.on_session_event(*this,
+                                   session,
+                                   event_data);
+}
+
+int
+NetworkXioPortal::on_new_session(xio_session *session,
+                                 xio_new_session_req *req)
+{
+    return server.on_new_session(session,
+                                 req);
+}
+
 void
-NetworkXioServer::evfd_stop_loop(int /*fd*/, int /*events*/, void * /*data*/)
+NetworkXioPortal::evfd_stop_loop(int /*fd*/, int /*events*/, void * /*data*/)
 {
     evfd.readfd();
     xio_context_stop_loop(ctx.get());
 }
 
+std::vector<uint64_t>
+NetworkXioServer::portal_requests() const
+{
+    std::lock_guard<std::mutex> lock_(mutex_);
+    std::vector<uint64_t> reqs;
+    reqs.reserve(portals_.size());
+    for (const auto& portal : portals_)
+    {
+        reqs.push_back(portal->requests);
+    }
+    return reqs;
+}
+
+NetworkXioWorkQueue::Stats
+NetworkXioServer::workqueue_stats() const
+{
+    std::lock_guard<std::mutex> lock_(mutex_);
+    if (wq_)
+    {
+        return wq_->stats();
+    }
+    else
+    {
+        return NetworkXioWorkQueue::Stats{0, 0, 0, 0, 0, 0};
+    }
+}
+
+void
+NetworkXioServer::setup_portal(NetworkXioPortal& portal,
+                               const yt::Uri& uri)
+{
+    // Runs on the thread that will run the portal's event loop.
+    if (portal.cpu >= 0)
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(portal.cpu, &cpu_set);
+        int ret = pthread_setaffinity_np(pthread_self(),
+                                         sizeof(cpu_set),
+                                         &cpu_set);
+        if (ret != 0)
+        {
+            LOG_WARN("portal " << portal.id << ": failed to pin to CPU " <<
+                     portal.cpu << ": " << strerror(ret));
+        }
+    }
+
+    // xio_shutdown() has to come after all other contexts are gone, so
+    // leave it to portal 0 which is torn down last.
+    void (*ctx_deleter)(xio_context*) = portal.id == 0 ?
+        xio_destroy_ctx_shutdown :
+        xio_context_destroy;
+
+    portal.ctx = std::shared_ptr<xio_context>(xio_context_create(NULL,
+                                                                 POLLING_TIME_USEC,
+                                                                 portal.cpu),
+                                              ctx_deleter);
+
+    if (portal.ctx == nullptr)
+    {
+        LOG_FATAL("failed to create XIO context");
+        throw FailedCreateXioContext("failed to create XIO context");
+    }
+
+    xio_session_ops xio_s_ops;
+    xio_s_ops.on_session_event = static_on_session_event<NetworkXioPortal>;
+    xio_s_ops.on_new_session = static_on_new_session<NetworkXioPortal>;
+    xio_s_ops.on_msg_send_complete = static_on_msg_send_complete<NetworkXioClientData>;
+    xio_s_ops.on_msg = static_on_request<NetworkXioClientData>;
+    xio_s_ops.assign_data_in_buf = NULL;
+    xio_s_ops.on_msg_error = NULL;
+
+    uint16_t src_port = 0;
+    portal.xserver = std::shared_ptr<xio_server>(xio_bind(portal.ctx.get(),
+                                                          &xio_s_ops,
+                                                          boost::lexical_cast<std::string>(uri).c_str(),
+                                                          &src_port,
+                                                          0,
+                                                          &portal),
+                                                 xio_unbind);
+    if (portal.xserver == nullptr)
+    {
+        LOG_FATAL("failed to bind XIO server to '" << uri << "'");
+        throw FailedBindXioServer("failed to bind XIO server");
+    }
+
+    yt::Uri bound(uri);
+    bound.port(src_port);
+    if (portal_host_)
+    {
+        bound.host(*portal_host_);
+    }
+    portal.uri = boost::lexical_cast<std::string>(bound);
+    LOG_INFO("portal " << portal.id << " bound to '" << portal.uri << "'");
+
+    if(xio_context_add_ev_handler(portal.ctx.get(),
+                                  portal.evfd,
+                                  XIO_POLLIN,
+                                  static_evfd_stop_loop<NetworkXioPortal>,
+                                  &portal))
+    {
+        LOG_FATAL("failed to register event handler");
+        throw FailedRegisterEventHandler("failed to register event handler");
+    }
+
+    portal.mpool = std::shared_ptr<xio_mempool>(
+            xio_mempool_create(-1, XIO_MEMPOOL_FLAG_REG_MR),
+            xio_mempool_destroy);
+    if (portal.mpool == nullptr)
+    {
+        LOG_FATAL("failed to create XIO memory pool");
+        xio_context_del_ev_handler(portal.ctx.get(), portal.evfd);
+        throw FailedCreateXioMempool("failed to create XIO memory pool");
+    }
+    (void) xio_mempool_add_slab(portal.mpool.get(),
+                                4096,
+                                0,
+                                queue_depth,
+                                32,
+                                0);
+    (void) xio_mempool_add_slab(portal.mpool.get(),
+                                32768,
+                                0,
+                                queue_depth,
+                                32,
+                                0);
+    (void) xio_mempool_add_slab(portal.mpool.get(),
+                                65536,
+                                0,
+                                queue_depth,
+                                32,
+                                0);
+    (void) xio_mempool_add_slab(portal.mpool.get(),
+                                131072,
+                                0,
+                                256,
+                                32,
+                                0);
+    (void) xio_mempool_add_slab(portal.mpool.get(),
+                                1048576,
+                                0,
+                                32,
+                                4,
+                                0);
+}
+
+void
+NetworkXioServer::run_portal(NetworkXioPortal& portal)
+{
+    while (not portal.stopping)
+    {
+        int ret = xio_context_run_loop(portal.ctx.get(), XIO_INFINITE);
+        VERIFY(ret == 0);
+        while (not portal.cq.is_finished_empty())
+        {
+            xio_send_reply(portal.cq.get_finished());
+        }
+    }
+}
+
+void
+NetworkXioServer::teardown_portal(NetworkXioPortal& portal)
+{
+    portal.xserver.reset();
+    if (portal.ctx)
+    {
+        xio_context_del_ev_handler(portal.ctx.get(), portal.evfd);
+    }
+    portal.ctx.reset();
+    portal.mpool.reset();
+}
+
+void
+NetworkXioServer::stop_portals()
+{
+    for (size_t i = 1; i < portals_.size(); ++i)
+    {
+        NetworkXioPortal& portal = *portals_[i];
+        if (portal.thread.joinable())
+        {
+            portal.stopping = true;
+            portal.evfd.writefd();
+            portal.thread.join();
+        }
+    }
+}
+
 void
 NetworkXioServer::run(std::promise<void> promise)
 {
@@ -192,130 +466,138 @@ NetworkXioServer::run(std::promise<void> promise)
                 &ka,
                 sizeof(ka));
 
-    ctx = std::shared_ptr<xio_context>(xio_context_create(NULL,
-                                                          POLLING_TIME_USEC,
-                                                          -1),
-                                       xio_destroy_ctx_shutdown);
-
-    if (ctx == nullptr)
-    {
-        LOG_FATAL("failed to create XIO context");
-        throw FailedCreateXioContext("failed to create XIO context");
-    }
-
-    xio_session_ops xio_s_ops;
-    xio_s_ops.on_session_event = static_on_session_event<NetworkXioServer>;
-    xio_s_ops.on_new_session = static_on_new_session<NetworkXioServer>;
-    xio_s_ops.on_msg_send_complete = static_on_msg_send_complete<NetworkXioClientData>;
-    xio_s_ops.on_msg = static_on_request<NetworkXioClientData>;
-    xio_s_ops.assign_data_in_buf = NULL;
-    xio_s_ops.on_msg_error = NULL;
-
-    LOG_INFO("bind XIO server to '" << uri_ << "'");
-    server = std::shared_ptr<xio_server>(xio_bind(ctx.get(),
-                                                  &xio_s_ops,
-                                                  boost::lexical_cast<std::string>(uri_).c_str(),
-                                                  NULL,
-                                                  0,
-                                                  this),
-                                         xio_unbind);
-    if (server == nullptr)
-    {
-        LOG_FATAL("failed to bind XIO server to '" << uri_ << "'");
-        throw FailedBindXioServer("failed to bind XIO server");
-    }
-
-    if(xio_context_add_ev_handler(ctx.get(),
-                                  evfd,
-                                  XIO_POLLIN,
-                                  static_evfd_stop_loop<NetworkXioServer>,
-                                  this))
     {
-        LOG_FATAL("failed to register event handler");
-        throw FailedRegisterEventHandler("failed to register event handler");
+        // Only pin the event loops if there's more than one of them.
+        const unsigned int ncpus = std::max(1U,
+                                            std::thread::hardware_concurrency());
+        std::lock_guard<std::mutex> lock_(mutex_);
+        portals_.clear();
+        portal_uris_.clear();
+        for (unsigned int i = 0; i < nr_portals; ++i)
+        {
+            portals_.emplace_back(std::make_unique<NetworkXioPortal>(*this,
+                                                                     i,
+                                                                     nr_portals > 1 ?
+                                                                     static_cast<int>(i % ncpus) :
+                                                                     -1));
+        }
     }
 
     try
     {
-        wq_ = std::make_shared<NetworkXioWorkQueue>("ovs_xio_wq",
-                                                    evfd,
-                                                    wq_max_threads);
+        auto wq(std::make_shared<NetworkXioWorkQueue>("ovs_xio_wq",
+                                                      wq_max_threads));
+        std::lock_guard<std::mutex> lock_(mutex_);
+        wq_ = wq;
     }
     catch (const WorkQueueThreadsException&)
     {
         LOG_FATAL("failed to create workqueue thread pool");
-        xio_context_del_ev_handler(ctx.get(), evfd);
         throw;
     }
     catch (const std::bad_alloc&)
     {
         LOG_FATAL("failed to allocate requested storage space for workqueue");
-        xio_context_del_ev_handler(ctx.get(), evfd);
         throw;
     }
 
-    xio_mpool = std::shared_ptr<xio_mempool>(
-            xio_mempool_create(-1, XIO_MEMPOOL_FLAG_REG_MR),
-            xio_mempool_destroy);
-    if (xio_mpool == nullptr)
+    NetworkXioPortal& primary = *portals_[0];
+    LOG_INFO("bind XIO server to '" << uri_ << "', " << nr_portals <<
+             " portal(s)");
+
+    try
     {
-        LOG_FATAL("failed to create XIO memory pool");
-        xio_context_del_ev_handler(ctx.get(), evfd);
-        throw FailedCreateXioMempool("failed to create XIO memory pool");
+        setup_portal(primary,
+                     uri_);
+
+        // The other portals listen on the configured port range of the same
+        // address; clients are redirected to them (at portal_host_) by
+        // xio_accept.
+        for (size_t i = 1; i < portals_.size(); ++i)
+        {
+            NetworkXioPortal& portal = *portals_[i];
+            yt::Uri portal_uri(uri_);
+            portal_uri.port(static_cast<uint16_t>(portal_base_port_ + i - 1));
+
+            std::promise<void> started;
+            std::future<void> future(started.get_future());
+
+            portal.thread = std::thread([this,
+                                         &portal,
+                                         portal_uri,
+                                         started = std::move(started)]() mutable
+                                        {
+                                            pthread_setname_np(pthread_self(),
+                                                               ("ovs_xio_" +
+                                                                boost::lexical_cast<std::string>(portal.id)).c_str());
+                                            try
+                                            {
+                                                setup_portal(portal,
+                                                             portal_uri);
+                                            }
+                                            catch (...)
+                                            {
+                                                teardown_portal(portal);
+                                                started.set_exception(std::current_exception());
+                                                return;
+                                            }
+
+                                            started.set_value();
+                                            run_portal(portal);
+                                            teardown_portal(portal);
+                                        });
+
+            future.get();
+        }
     }
-    (void) xio_mempool_add_slab(xio_mpool.get(),
-                                4096,
-                                0,
-                                queue_depth,
-                                32,
-                                0);
-    (void) xio_mempool_add_slab(xio_mpool.get(),
-                                32768,
-                                0,
-                                queue_depth,
-                                32,
-                                0);
-    (void) xio_mempool_add_slab(xio_mpool.get(),
-                                65536,
-                                0,
-                                queue_depth,
-                                32,
-                                0);
-    (void) xio_mempool_add_slab(xio_mpool.get(),
-                                131072,
-                                0,
-                                256,
-                                32,
-                                0);
-    (void) xio_mempool_add_slab(xio_mpool.get(),
-                                1048576,
-                                0,
-                                32,
-                                4,
-                                0);
-    stopped = false;
-    promise.set_value();
-    while (not stopping)
+    catch (...)
     {
-        int ret = xio_context_run_loop(ctx.get(), XIO_INFINITE);
-        VERIFY(ret == 0);
-        while (not wq_->is_finished_empty())
+        wq_->shutdown();
+        stop_portals();
+        teardown_portal(primary);
+        throw;
+    }
+
+    if (nr_portals > 1)
+    {
+        for (const auto& portal : portals_)
         {
-            xio_send_reply(wq_->get_finished());
+            portal_uris_.push_back(portal->uri.c_str());
         }
     }
-    server.reset();
+
+    stopped = false;
+    promise.set_value();
+
+    run_portal(primary);
+
+    // Stop the workers first: the ones still busy complete to their
+    // portal's completion queue, which has to be around for that.
     wq_->shutdown();
-    xio_context_del_ev_handler(ctx.get(), evfd);
-    ctx.reset();
-    xio_mpool.reset();
+    stop_portals();
+    for (const auto& portal : portals_)
+    {
+        LOG_INFO("portal " << portal->id << " handled " << portal->requests <<
+                 " requests");
+    }
+
+    const NetworkXioWorkQueue::Stats st(wq_->stats());
+    LOG_INFO("workqueue: " << st.threads << " threads, " <<
+             st.scheduled << " requests scheduled, " <<
+             st.stolen << " stolen, " <<
+             st.parked << " parks, dispatch latency avg " <<
+             (st.scheduled ? st.dispatch_usecs_total / st.scheduled : 0) <<
+             " us, max " << st.dispatch_usecs_max << " us");
+
+    teardown_portal(primary);
+
     std::lock_guard<std::mutex> lock_(mutex_);
     stopped = true;
     cv_.notify_one();
 }
 
 NetworkXioClientData*
-NetworkXioServer::allocate_client_data()
+NetworkXioServer::allocate_client_data(NetworkXioPortal& portal)
 {
     try
     {
@@ -323,8 +605,9 @@ NetworkXioServer::allocate_client_data()
         cd->disconnected = false;
         cd->connection_closed = false;
         cd->refcnt = 0;
-        cd->mpool = xio_mpool.get();
+        cd->mpool = portal.mpool.get();
         cd->server = this;
+        cd->portal = &portal;
         return cd;
     }
     catch (const std::bad_alloc&)
@@ -345,16 +628,18 @@ NetworkXioServer::clear_done_reqs(NetworkXioClientData *cd)
 }
 
 int
-NetworkXioServer::create_session_connection(xio_session *session,
+NetworkXioServer::create_session_connection(NetworkXioPortal& portal,
+                                            xio_session *session,
                                             xio_session_event_data *evdata)
 {
-    NetworkXioClientData *cd = allocate_client_data();
+    NetworkXioClientData *cd = allocate_client_data(portal);
     if (cd)
     {
         try
         {
             NetworkXioIOHandler *ioh_ptr = new NetworkXioIOHandler(fs_,
                                                                    wq_,
+                                                                   portal.cq,
                                                                    cd);
             cd->ioh = ioh_ptr;
             cd->session = session;
@@ -421,7 +706,13 @@ int
 NetworkXioServer::on_new_session(xio_session *session,
                                  xio_new_session_req * /*req*/)
 {
-    if (xio_accept(session, NULL, 0, NULL, 0) < 0)
+    // portal_uris_ is empty if there's only a single portal, in which case
+    // the connections stay on the listening context.
+    if (xio_accept(session,
+                   portal_uris_.empty() ? NULL : portal_uris_.data(),
+                   portal_uris_.size(),
+                   NULL,
+                   0) < 0)
     {
         LOG_ERROR("cannot accept new session, error: "
                   << xio_strerror(xio_errno()));
@@ -430,13 +721,14 @@ NetworkXioServer::on_new_session(xio_session *session,
 }
 
 int
-NetworkXioServer::on_session_event(xio_session *session,
+NetworkXioServer::on_session_event(NetworkXioPortal& portal,
+                                   xio_session *session,
                                    xio_session_event_data *event_data)
 {
     switch (event_data->event)
     {
     case XIO_SESSION_NEW_CONNECTION_EVENT:
-        create_session_connection(session, event_data);
+        create_session_connection(portal, session, event_data);
         break;
     case XIO_SESSION_CONNECTION_CLOSED_EVENT:
         if (event_data->reason == XIO_E_TIMEOUT)
@@ -586,6 +878,7 @@ NetworkXioServer::on_request(xio_session *session ATTR_UNUSED,
                              void *cb_user_ctx)
 {
     auto cd = static_cast<NetworkXioClientData*>(cb_user_ctx);
+    cd->portal->requests++;
     NetworkXioRequest *req = allocate_request(cd, xio_req);
     if (req)
     {
@@ -605,8 +898,9 @@ NetworkXioServer::shutdown()
 {
     if (not stopped)
     {
-        stopping = true;
-        xio_context_stop_loop(ctx.get());
+        NetworkXioPortal& primary = *portals_[0];
+        primary.stopping = true;
+        primary.evfd.writefd();
         {
             std::unique_lock<std::mutex> lock_(mutex_);
             cv_.wait(lock_, [&]{return stopped == true;});
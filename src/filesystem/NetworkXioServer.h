@@ -21,17 +21,17 @@
 #include "NetworkXioRequest.h"
 #include "NetworkXioWorkQueue.h"
 
+#include <atomic>
 #include <map>
 #include <tuple>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <libxio.h>
 
-#include <youtils/Uri.h>
+#include <boost/optional.hpp>
 
-#include <map>
-#include <tuple>
-#include <memory>
-#include <libxio.h>
+#include <youtils/Uri.h>
 
 namespace volumedriverfs
 {
@@ -42,13 +42,75 @@ MAKE_EXCEPTION(FailedCreateXioMempool, fungi::IOException);
 MAKE_EXCEPTION(FailedCreateEventfd, fungi::IOException);
 MAKE_EXCEPTION(FailedRegisterEventHandler, fungi::IOException);
 
+class NetworkXioServer;
+
+// An XIO context with its own event loop thread, completion queue, eventfd
+// and memory pool. Portal 0 listens on the configured URI and spreads the
+// connections of new sessions over all portals; a connection's requests are
+// then received, handled and completed on the portal (and hence the core)
+// it was assigned to.
+struct NetworkXioPortal
+{
+    NetworkXioPortal(NetworkXioServer& srv,
+                     unsigned int portal_id,
+                     int portal_cpu)
+        : server(srv)
+        , id(portal_id)
+        , cpu(portal_cpu)
+        , stopping(false)
+        , evfd()
+        // the event loops are only pinned if there's more than one portal,
+        // and only then it makes sense to keep requests on a worker per portal
+        , cq(evfd,
+             portal_cpu >= 0 ?
+             boost::optional<unsigned int>(portal_id) :
+             boost::none)
+        , requests(0)
+    {}
+
+    ~NetworkXioPortal() = default;
+
+    NetworkXioPortal(const NetworkXioPortal&) = delete;
+
+    NetworkXioPortal&
+    operator=(const NetworkXioPortal&) = delete;
+
+    int
+    on_session_event(xio_session *session,
+                     xio_session_event_data *event_data);
+
+    int
+    on_new_session(xio_session *session,
+                   xio_new_session_req *req);
+
+    void
+    evfd_stop_loop(int fd, int events, void *data);
+
+    NetworkXioServer& server;
+    const unsigned int id;
+    // -1: don't pin the event loop to a CPU
+    const int cpu;
+    std::string uri;
+    std::atomic<bool> stopping;
+    EventFD evfd;
+    NetworkXioCompletionQueue cq;
+    std::shared_ptr<xio_context> ctx;
+    std::shared_ptr<xio_server> xserver;
+    std::shared_ptr<xio_mempool> mpool;
+    std::thread thread;
+    std::atomic<uint64_t> requests;
+};
+
 class NetworkXioServer
 {
 public:
     NetworkXioServer(FileSystem&,
                      const youtils::Uri&,
                      size_t snd_rcv_queue_depth,
-                     unsigned int workqueue_max_threads);
+                     unsigned int workqueue_max_threads,
+                     unsigned int portals,
+                     const std::string& portal_address,
+                     uint16_t portal_base_port);
 
     ~NetworkXioServer();
 
@@ -64,7 +126,8 @@ public:
                void *cb_user_context);
 
     int
-    on_session_event(xio_session *session,
+    on_session_event(NetworkXioPortal& portal,
+                     xio_session *session,
                      xio_session_event_data *event_data);
 
     int
@@ -91,33 +154,67 @@ public:
     void
     xio_send_reply(NetworkXioRequest *req);
 
-    void
-    evfd_stop_loop(int fd, int events, void *data);
-
     static void
     xio_destroy_ctx_shutdown(xio_context *ctx);
+
+    unsigned int
+    portals() const
+    {
+        return nr_portals;
+    }
+
+    // Number of requests received per portal since startup; sample it
+    // periodically to get the per-portal IOPS.
+    std::vector<uint64_t>
+    portal_requests() const;
+
+    NetworkXioWorkQueue::Stats
+    workqueue_stats() const;
 private:
     DECLARE_LOGGER("NetworkXioServer");
 
     FileSystem& fs_;
     youtils::Uri uri_;
-    bool stopping;
 
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
     std::condition_variable cv_;
     bool stopped;
-    EventFD evfd;
     int queue_depth;
     unsigned int wq_max_threads;
+    // address and first port of the additional portals clients are
+    // redirected to
+    const boost::optional<std::string> portal_host_;
+    const uint16_t portal_base_port_;
+    const unsigned int nr_portals;
 
     NetworkXioWorkQueuePtr wq_;
 
-    std::shared_ptr<xio_context> ctx;
-    std::shared_ptr<xio_server> server;
-    std::shared_ptr<xio_mempool> xio_mpool;
+    // Only modified by run(): the portals are created before the promise is
+    // fulfilled and destroyed after the loop of portal 0 has exited.
+    std::vector<std::unique_ptr<NetworkXioPortal>> portals_;
+    std::vector<const char*> portal_uris_;
+
+    static unsigned int
+    check_portals_(unsigned int portals,
+                   const boost::optional<std::string>& host,
+                   uint16_t base_port);
+
+    void
+    setup_portal(NetworkXioPortal& portal,
+                 const youtils::Uri& uri);
+
+    void
+    run_portal(NetworkXioPortal& portal);
+
+    void
+    teardown_portal(NetworkXioPortal& portal);
+
+    void
+    stop_portals();
 
     int
-    create_session_connection(xio_session *session,
+    create_session_connection(NetworkXioPortal& portal,
+                              xio_session *session,
                               xio_session_event_data *event_data);
 
     void
@@ -145,7 +242,7 @@ private:
     clear_done_reqs(NetworkXioClientData *cd);
 
     NetworkXioClientData*
-    allocate_client_data();
+    allocate_client_data(NetworkXioPortal& portal);
 };
 
 } //namespace
@@ -29,6 +29,9 @@ typedef std::function<void(Work*)> workitem_func_t;
 struct Work
 {
     workitem_func_t func;
+    // completes the request with an error instead of processing it, for
+    // requests the workqueue won't get to anymore
+    workitem_func_t cancel;
 };
 
 } //namespace
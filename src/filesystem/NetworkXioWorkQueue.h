@@ -18,41 +18,145 @@
 
 #include "NetworkXioRequest.h"
 
+#include <boost/intrusive/list.hpp>
 #include <boost/thread/lock_guard.hpp>
+#include <boost/optional.hpp>
 #include <youtils/SpinLock.h>
 #include <youtils/IOException.h>
+#include <youtils/Logging.h>
 
 #include <mutex>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <atomic>
 #include <thread>
 #include <chrono>
+#include <vector>
 
 namespace volumedriverfs
 {
 
 MAKE_EXCEPTION(WorkQueueThreadsException, Exception);
 
+// Finished requests on their way back to the event loop that received them:
+// the workqueue pushes them here and kicks the event loop's eventfd.
+class NetworkXioCompletionQueue
+{
+public:
+    NetworkXioCompletionQueue(EventFD& evfd_,
+                              const boost::optional<unsigned int>& affinity)
+    : evfd(evfd_)
+    , affinity_(affinity)
+    {}
+
+    ~NetworkXioCompletionQueue() = default;
+
+    NetworkXioCompletionQueue(const NetworkXioCompletionQueue&) = delete;
+
+    NetworkXioCompletionQueue&
+    operator=(const NetworkXioCompletionQueue&) = delete;
+
+    void
+    push(NetworkXioRequest *req)
+    {
+        {
+            boost::lock_guard<decltype(finished_lock)> lock_(finished_lock);
+            finished_list.push_back(*req);
+        }
+        evfd.writefd();
+    }
+
+    NetworkXioRequest*
+    get_finished()
+    {
+        boost::lock_guard<decltype(finished_lock)> lock_(finished_lock);
+        NetworkXioRequest *req = &finished_list.front();
+        finished_list.pop_front();
+        return req;
+    }
+
+    bool
+    is_finished_empty()
+    {
+        boost::lock_guard<decltype(finished_lock)> lock_(finished_lock);
+        return finished_list.empty();
+    }
+
+    // Hint for the workqueue: requests completing here preferably run on
+    // the same worker so they keep hitting the same caches. None if there's
+    // no point in it, e.g. as this is the only queue.
+    const boost::optional<unsigned int>&
+    affinity() const
+    {
+        return affinity_;
+    }
+
+private:
+    mutable fungi::SpinLock finished_lock;
+    boost::intrusive::list<NetworkXioRequest> finished_list;
+    EventFD& evfd;
+    const boost::optional<unsigned int> affinity_;
+};
+
+// Fixed size pool of workers shared by all XIO connections. Each worker has
+// its own deque; requests are queued to the worker picked by the completion
+// queue's affinity (or round robin if it has none), idle workers steal from
+// the others and park once there's nothing left to steal.
 class NetworkXioWorkQueue
 {
 public:
+    struct Stats
+    {
+        unsigned int threads;
+        uint64_t scheduled;
+        uint64_t stolen;
+        uint64_t parked;
+        uint64_t cancelled;
+        // time between work_schedule() and a worker picking the request up
+        uint64_t dispatch_usecs_total;
+        uint64_t dispatch_usecs_max;
+    };
+
     NetworkXioWorkQueue(const std::string& name,
-                        EventFD& evfd_,
-                        unsigned int wq_max_threads)
+                        unsigned int nr_threads)
     : name_(name)
-    , nr_threads_(0)
-    , nr_queued_work(0)
-    , protection_period_(5000)
     , stopping(false)
-    , stopped(false)
-    , evfd(evfd_)
-    , max_threads(wq_max_threads)
+    , nr_parked_(0)
+    , scheduled_(0)
+    , stolen_(0)
+    , parked_(0)
+    , cancelled_(0)
+    , next_worker_(0)
+    , dispatch_usecs_total_(0)
+    , dispatch_usecs_max_(0)
     {
-        int ret = create_workqueue_threads(1);
-        if (ret < 0)
+        const unsigned int n = std::max(1U, nr_threads);
+        workers_.reserve(n);
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            workers_.emplace_back(std::make_unique<Worker>());
+        }
+
+        for (unsigned int i = 0; i < n; ++i)
         {
-            throw WorkQueueThreadsException("cannot create worker thread");
+            try
+            {
+                workers_[i]->thread = std::thread([this, i]
+                                                  {
+                                                      const std::string tname((name_ + "_" +
+                                                                               std::to_string(i)).substr(0, 15));
+                                                      pthread_setname_np(pthread_self(),
+                                                                         tname.c_str());
+                                                      worker_routine(i);
+                                                  });
+            }
+            catch (const std::system_error&)
+            {
+                LOG_ERROR("cannot create worker thread");
+                shutdown();
+                throw WorkQueueThreadsException("cannot create worker thread");
+            }
         }
     }
 
@@ -61,189 +165,309 @@ public:
         shutdown();
     }
 
+    NetworkXioWorkQueue(const NetworkXioWorkQueue&) = delete;
+
+    NetworkXioWorkQueue&
+    operator=(const NetworkXioWorkQueue&) = delete;
+
+    // The requests being processed are completed as usual; the ones that are
+    // still queued and the ones scheduled after shutdown are cancelled, i.e.
+    // completed with an error.
     void
     shutdown()
     {
-        if (not stopped)
+        if (not stopping.exchange(true))
         {
-            stopping = true;
-            while (nr_threads_)
+            for (auto& w : workers_)
+            {
+                unpark(*w);
+            }
+
+            for (auto& w : workers_)
             {
-                inflight_cond.notify_all();
-                ::usleep(500);
+                if (w->thread.joinable())
+                {
+                    w->thread.join();
+                }
+            }
+
+            size_t cancelled = 0;
+            for (auto& w : workers_)
+            {
+                std::deque<Item> items;
+                {
+                    boost::lock_guard<decltype(w->lock)> lock_(w->lock);
+                    items.swap(w->deque);
+                }
+
+                for (const auto& item : items)
+                {
+                    cancel(item);
+                }
+
+                cancelled += items.size();
+            }
+
+            if (cancelled)
+            {
+                LOG_WARN(name_ << ": cancelled " << cancelled <<
+                         " queued requests on shutdown");
             }
-            stopped = true;
         }
     }
 
     void
-    work_schedule(NetworkXioRequest *req)
+    work_schedule(NetworkXioRequest *req,
+                  NetworkXioCompletionQueue& cq)
     {
-        queued_work_inc();
-        inflight_lock.lock();
-        if (need_to_grow())
+        // Without affinity (e.g. a single portal) everything would end up with
+        // one worker and the others would only get to work by stealing from
+        // it, all through the same lock.
+        const size_t idx = (cq.affinity() ?
+                            *cq.affinity() :
+                            next_worker_++) % workers_.size();
+        Worker& w = *workers_[idx];
+
         {
-            create_workqueue_threads(nr_threads_ * 2);
+            // stopping is checked under the lock so shutdown() cannot miss
+            // an item pushed after it drained the deque
+            boost::lock_guard<decltype(w.lock)> lock_(w.lock);
+            if (not stopping)
+            {
+                w.deque.push_back(Item(req,
+                                       &cq));
+                req = nullptr;
+            }
         }
-        inflight_queue.push(req);
-        inflight_lock.unlock();
-        inflight_cond.notify_one();
-    }
 
-    void
-    queued_work_inc()
-    {
-        nr_queued_work++;
-    }
+        if (req)
+        {
+            cancel(Item(req,
+                        &cq));
+            return;
+        }
 
-    void
-    queued_work_dec()
-    {
-        nr_queued_work--;
-    }
+        scheduled_++;
 
-    NetworkXioRequest*
-    get_finished()
-    {
-        boost::lock_guard<decltype(finished_lock)> lock_(finished_lock);
-        NetworkXioRequest *req = &finished_list.front();
-        finished_list.pop_front();
-        return req;
+        // pairs with the fence in worker_routine: either the parking worker
+        // sees the new item or we see it parked
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (nr_parked_.load(std::memory_order_relaxed) != 0)
+        {
+            if (not unpark(w))
+            {
+                unpark_one(idx);
+            }
+        }
     }
 
-    bool
-    is_finished_empty()
+    Stats
+    stats() const
     {
-        boost::lock_guard<decltype(finished_lock)> lock_(finished_lock);
-        return finished_list.empty();
+        Stats s;
+        s.threads = workers_.size();
+        s.scheduled = scheduled_;
+        s.stolen = stolen_;
+        s.parked = parked_;
+        s.cancelled = cancelled_;
+        s.dispatch_usecs_total = dispatch_usecs_total_;
+        s.dispatch_usecs_max = dispatch_usecs_max_;
+        return s;
     }
+
 private:
     DECLARE_LOGGER("NetworkXioWorkQueue");
 
-    std::string name_;
-    std::atomic<size_t> nr_threads_;
+    using Clock = std::chrono::steady_clock;
 
-    std::condition_variable inflight_cond;
-    std::mutex inflight_lock;
-    std::queue<NetworkXioRequest*> inflight_queue;
+    struct Item
+    {
+        Item(NetworkXioRequest *r,
+             NetworkXioCompletionQueue *q)
+            : req(r)
+            , cq(q)
+            , queued(Clock::now())
+        {}
 
-    mutable fungi::SpinLock finished_lock;
-    boost::intrusive::list<NetworkXioRequest> finished_list;
+        NetworkXioRequest *req;
+        NetworkXioCompletionQueue *cq;
+        Clock::time_point queued;
+    };
 
-    std::atomic<size_t> nr_queued_work;
+    struct Worker
+    {
+        fungi::SpinLock lock;
+        std::deque<Item> deque;
 
-    std::chrono::steady_clock::time_point thread_life_period_;
-    uint64_t protection_period_;
+        std::mutex park_lock;
+        std::condition_variable park_cond;
+        bool parked = false;
 
-    bool stopping;
-    bool stopped;
-    EventFD& evfd;
-    unsigned int max_threads;
+        std::thread thread;
+    };
 
-    void xstop_loop()
-    {
-        evfd.writefd();
-    }
+    std::string name_;
+    std::atomic<bool> stopping;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<unsigned int> nr_parked_;
+
+    std::atomic<uint64_t> scheduled_;
+    std::atomic<uint64_t> stolen_;
+    std::atomic<uint64_t> parked_;
+    std::atomic<uint64_t> cancelled_;
+    std::atomic<unsigned int> next_worker_;
+    std::atomic<uint64_t> dispatch_usecs_total_;
+    std::atomic<uint64_t> dispatch_usecs_max_;
 
-    std::chrono::steady_clock::time_point
-    get_time_point()
+    bool
+    pop_own(Worker& w,
+            Item& item)
     {
-        return std::chrono::steady_clock::now();
+        boost::lock_guard<decltype(w.lock)> lock_(w.lock);
+        if (w.deque.empty())
+        {
+            return false;
+        }
+        item = w.deque.front();
+        w.deque.pop_front();
+        return true;
     }
 
-    unsigned int
-    get_max_wq_depth()
+    // Victims are robbed from the back so their owner keeps going FIFO.
+    bool
+    steal(size_t idx,
+          Item& item)
     {
-        return std::min(max_threads,
-                        std::thread::hardware_concurrency());
+        for (size_t i = 1; i < workers_.size(); ++i)
+        {
+            Worker& v = *workers_[(idx + i) % workers_.size()];
+            boost::lock_guard<decltype(v.lock)> lock_(v.lock);
+            if (not v.deque.empty())
+            {
+                item = v.deque.back();
+                v.deque.pop_back();
+                stolen_++;
+                return true;
+            }
+        }
+        return false;
     }
 
     bool
-    need_to_grow()
+    have_work() const
     {
-        if ((nr_threads_ < nr_queued_work) &&
-                (nr_threads_ * 2 <= get_max_wq_depth()))
+        for (const auto& w : workers_)
         {
-            thread_life_period_ = get_time_point() +
-                std::chrono::milliseconds(protection_period_);
-            return true;
+            boost::lock_guard<decltype(w->lock)> lock_(w->lock);
+            if (not w->deque.empty())
+            {
+                return true;
+            }
         }
         return false;
     }
 
     bool
-    need_to_shrink()
+    unpark(Worker& w)
     {
-        if (nr_queued_work < nr_threads_ / 2)
+        std::lock_guard<std::mutex> lock_(w.park_lock);
+        if (w.parked)
         {
-            return thread_life_period_ <= get_time_point();
+            w.parked = false;
+            nr_parked_--;
+            w.park_cond.notify_one();
+            return true;
         }
-        thread_life_period_ = get_time_point() +
-            std::chrono::milliseconds(protection_period_);
         return false;
     }
 
-    int
-    create_workqueue_threads(size_t nr_threads)
+    void
+    unpark_one(size_t idx)
     {
-        while (nr_threads_ < nr_threads)
+        for (size_t i = 1; i < workers_.size(); ++i)
         {
-            try
-            {
-                std::thread thr([&](){
-                    auto fp = std::bind(&NetworkXioWorkQueue::worker_routine,
-                                        this);
-                    pthread_setname_np(pthread_self(), name_.c_str());
-                    fp();
-                });
-                thr.detach();
-                nr_threads_++;
-            }
-            catch (const std::system_error&)
+            if (unpark(*workers_[(idx + i) % workers_.size()]))
             {
-                LOG_ERROR("cannot create worker thread");
-                return -1;
+                return;
             }
         }
-        return 0;
     }
 
     void
-    worker_routine()
+    park(Worker& w)
     {
-        NetworkXioRequest *req;
-        while (true)
+        std::unique_lock<std::mutex> lock_(w.park_lock);
+        w.parked = true;
+        nr_parked_++;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (stopping or have_work())
         {
-            std::unique_lock<std::mutex> lock_(inflight_lock);
-            if (need_to_shrink())
-            {
-                nr_threads_--;
-                lock_.unlock();
-                break;
-            }
-retry:
-            if (inflight_queue.empty())
+            w.parked = false;
+            nr_parked_--;
+            return;
+        }
+
+        parked_++;
+        w.park_cond.wait(lock_,
+                         [&]
+                         {
+                             return not w.parked;
+                         });
+    }
+
+    void
+    account_dispatch(const Item& item)
+    {
+        const uint64_t usecs =
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() -
+                                                                  item.queued).count();
+        dispatch_usecs_total_ += usecs;
+
+        uint64_t max = dispatch_usecs_max_;
+        while (usecs > max and
+               not dispatch_usecs_max_.compare_exchange_weak(max,
+                                                             usecs))
+        {
+        }
+    }
+
+    void
+    cancel(const Item& item)
+    {
+        cancelled_++;
+
+        NetworkXioRequest *req = item.req;
+        if (req->work.cancel)
+        {
+            req->work.cancel(&req->work);
+        }
+        item.cq->push(req);
+    }
+
+    void
+    worker_routine(size_t idx)
+    {
+        Worker& w = *workers_[idx];
+        Item item(nullptr,
+                  nullptr);
+
+        while (not stopping)
+        {
+            if (pop_own(w, item) or steal(idx, item))
             {
-                inflight_cond.wait(lock_);
-                if (stopping)
+                account_dispatch(item);
+                NetworkXioRequest *req = item.req;
+                if (req->work.func)
                 {
-                    nr_threads_--;
-                    break;
+                    req->work.func(&req->work);
                 }
-                goto retry;
+                item.cq->push(req);
             }
-            req = inflight_queue.front();
-            inflight_queue.pop();
-            lock_.unlock();
-            queued_work_dec();
-            if (req->work.func)
+            else
             {
-                req->work.func(&req->work);
+                park(w);
             }
-            finished_lock.lock();
-            finished_list.push_back(*req);
-            finished_lock.unlock();
-            xstop_loop();
         }
     }
 };
@@ -52,9 +52,6 @@ using namespace std::literals::string_literals;
 #define RLOCK_NODES()                                   \
     fungi::ScopedReadLock nmlrg__(node_map_lock_)
 
-#define LOCK_REDIRECTS()                                \
-    std::lock_guard<decltype(redirects_lock_)> rlg__(redirects_lock_)
-
 namespace ara = arakoon;
 namespace be = backend;
 namespace bpt = boost::property_tree;
@@ -76,10 +73,16 @@ ObjectRouter::ObjectRouter(const bpt::ptree& pt,
     , vrouter_file_read_threshold(pt)
     , vrouter_file_write_threshold(pt)
     , vrouter_check_local_volume_potential_period(pt)
+    , vrouter_migrate_check_interval_secs(pt)
+    , vrouter_migrate_min_redirect_kib_per_sec(pt)
+    , vrouter_migrate_min_remote_time_percent(pt)
+    , vrouter_migrate_sustain_periods(pt)
+    , vrouter_migrate_holdoff_secs(pt)
     , vrouter_backend_sync_timeout_ms(pt)
     , vrouter_migrate_timeout_ms(pt)
     , vrouter_redirect_timeout_ms(pt)
     , vrouter_redirect_retries(pt)
+    , vrouter_redirect_max_inflight(pt)
     , vrouter_routing_retries(pt)
     , vrouter_id(pt)
     , vrouter_cluster_id(pt)
@@ -99,6 +102,14 @@ ObjectRouter::ObjectRouter(const bpt::ptree& pt,
     , foc_config_mode_(foc_config_mode)
     , foc_mode_(foc_mode)
     , foc_config_(foc_config)
+    , migration_controller_(new MigrationController([this](const ObjectId& id)
+                                                    {
+                                                        return estimate_migration_cost_(id);
+                                                    },
+                                                    [this](const ObjectId& id)
+                                                    {
+                                                        auto_migrate_(id);
+                                                    }))
 {
     LOG_TRACE("setting up");
 
@@ -124,10 +135,21 @@ ObjectRouter::ObjectRouter(const bpt::ptree& pt,
                                        },
                                        vrouter_min_workers.value(),
                                        vrouter_max_workers.value()));
+
+    migration_action_ =
+        std::make_unique<yt::PeriodicAction>("MigrationController",
+                                             [this]
+                                             {
+                                                 check_migrations_();
+                                             },
+                                             vrouter_migrate_check_interval_secs.value());
 }
 
 ObjectRouter::~ObjectRouter()
 {
+    // stop auto migrations before tearing down the nodes they'd need
+    migration_action_.reset();
+
     // ZMQ teardown
     // (1) destruct (close) all req sockets and all shared_ptrs to the ztx_
     node_map_.clear();
@@ -562,8 +584,7 @@ ObjectRouter::backend_restart_(const Object& obj,
     local_node_()->backend_restart(obj,
                                    force,
                                    std::move(prep_restart_fun));
-    LOCK_REDIRECTS();
-    redirects_.erase(obj.id);
+    migration_controller_->started_here(obj.id);
 }
 
 bool
@@ -741,14 +762,14 @@ ObjectRouter::route_(R (ClusterNode::*fn)(const Object&,
 }
 
 // TODO: It'd be nice to make this work with arbitrary return types.
-template<typename P,
+template<typename R,
          typename... A>
 FastPathCookie
-ObjectRouter::maybe_migrate_(P&& migrate_pred,
-                             void (ClusterNode::*fn)(const Object&,
-                                                     A... args),
-                             const ObjectId& id,
-                             A... args)
+ObjectRouter::route_and_record_redirect_(R&& on_redirect,
+                                         void (ClusterNode::*fn)(const Object&,
+                                                                 A... args),
+                                         const ObjectId& id,
+                                         A... args)
 {
     ObjectRegistrationPtr reg(object_registry_->find_throw(id,
                                                            IgnoreCache::F));
@@ -756,6 +777,8 @@ ObjectRouter::maybe_migrate_(P&& migrate_pred,
     IsRemoteNode remote = IsRemoteNode::F;
     FastPathCookie cookie;
 
+    const auto start(MigrationController::Clock::now());
+
     do_route_(fn,
               remote,
               AttemptTheft::T,
@@ -763,63 +786,104 @@ ObjectRouter::maybe_migrate_(P&& migrate_pred,
               cookie,
               std::forward<A>(args)...);
 
-    if (remote == IsRemoteNode::T and migrate_pred(reg->volume_id,
-                                                   reg->treeconfig.object_type))
+    if (remote == IsRemoteNode::T)
+    {
+        on_redirect(*reg,
+                    MigrationController::Clock::now() - start);
+    }
+
+    return cookie;
+}
+
+MigrationController::Policy
+ObjectRouter::migration_policy_() const
+{
+    MigrationController::Policy p;
+
+    p.volume_read_threshold = vrouter_volume_read_threshold.value();
+    p.volume_write_threshold = vrouter_volume_write_threshold.value();
+    p.file_read_threshold = vrouter_file_read_threshold.value();
+    p.file_write_threshold = vrouter_file_write_threshold.value();
+    p.min_kib_per_sec = vrouter_migrate_min_redirect_kib_per_sec.value();
+    p.min_remote_time_percent = vrouter_migrate_min_remote_time_percent.value();
+    p.sustain_periods = vrouter_migrate_sustain_periods.value();
+    p.cost_check_periods = vrouter_check_local_volume_potential_period.value();
+    p.holdoff = boost::chrono::seconds(vrouter_migrate_holdoff_secs.value());
+
+    return p;
+}
+
+void
+ObjectRouter::check_migrations_()
+{
+    migration_controller_->run(migration_policy_());
+}
+
+std::vector<MigrationDecision>
+ObjectRouter::migration_decisions() const
+{
+    return migration_controller_->decisions();
+}
+
+MigrationController::MigrationCost
+ObjectRouter::estimate_migration_cost_(const ObjectId& id)
+{
+    MigrationController::MigrationCost cost;
+
+    // takes the SCO cache and the metadata cache budget into account
+    cost.volume_potential = local_node_()->volume_potential(id);
+
+    // with a manually configured DTL the volume keeps it
+    const ObjectRegistrationPtr reg(object_registry_->find_throw(id,
+                                                                 IgnoreCache::F));
+    cost.loses_dtl =
+        reg->foc_config_mode == FailOverCacheConfigMode::Automatic and
+        failoverconfig_as_it_should_be() == boost::none;
+
+    return cost;
+}
+
+void
+ObjectRouter::auto_migrate_(const ObjectId& id)
+{
+    // Don't reuse a previously retrieved ObjectRegistration as it was cached
+    // and possibly outdated or could have changed in the mean time.
+    ObjectRegistrationPtr reg(object_registry_->find_throw(id,
+                                                           IgnoreCache::T));
+    if (reg->node_id == node_id())
+    {
+        LOG_INFO(id << ": already migrated here in the mean time");
+        return;
+    }
+
+    LOG_INFO(id << ": attempting auto migration from " << reg->node_id);
+
+    try
+    {
+        // ForceRestart::T: it's ok to ignore the FOC in this case (and
+        // ForceRestart should probably be renamed to make its semantics
+        // clear(er)) as the remote first has to write out all pending data
+        // to the backend before we do a restart here, so the FOC will be
+        // empty anyway.
+        migrate_(*reg,
+                 OnlyStealFromOfflineNode::T,
+                 ForceRestart::T);
+        LOG_INFO(id << ": auto migration from " << reg->node_id << " done");
+    }
+    catch (...)
     {
-        LOG_INFO(id << ": investigating auto migration");
-
-        // Don't reuse the previously retrieved ObjectRegistration as it was cached
-        // and possibly outdated or could have changed in the mean time.
-        // Don't bother with possibly outdated registrations in the cache.
-        reg = object_registry_->find_throw(id,
-                                           IgnoreCache::T);
-        if (reg->node_id == node_id())
+        reg = object_registry_->find(id,
+                                     IgnoreCache::T);
+        if (reg and reg->node_id == node_id())
         {
             LOG_INFO(id <<
-                     ": already migrated here while we were trying remote");
+                     ": already migrated here while we were trying to do that ourselves");
         }
         else
         {
-            LOG_INFO(id << ": attempting auto migration from " << reg->node_id);
-
-            try
-            {
-                // ForceRestart::T: it's ok to ignore the FOC in this case (and
-                // ForceRestart should probably be renamed to make its semantics
-                // clear(er)) as the remote first has to write out all pending data
-                // to the backend before we do a restart here, so the FOC will be
-                // empty anyway.
-                migrate_(*reg,
-                         OnlyStealFromOfflineNode::T,
-                         ForceRestart::T);
-                LOG_INFO(id << ": auto migration from " << reg->node_id << " done");
-            }
-            catch (RemoteTimeoutException&)
-            {
-                LOG_WARN(id << ": remote node reported timeout");
-            }
-            CATCH_STD_ALL_EWHAT({
-                    reg = object_registry_->find(id,
-                                                 IgnoreCache::T);
-                    if (reg and reg->node_id == node_id())
-                    {
-                        LOG_INFO(id <<
-                                 ": already migrated here while we were trying to do that ourselves");
-                    }
-                    else
-                    {
-                        LOG_WARN("Failed to automigrate " <<
-                                 id << " from " <<
-                                 (reg ?
-                                  reg->node_id :
-                                  NodeId("(unknown source)")) <<
-                                  ": " << EWHAT);
-                    }
-                });
+            throw;
         }
     }
-
-    return cookie;
 }
 
 zmq::message_t
@@ -849,59 +913,6 @@ ObjectRouter::ping(const NodeId& node)
     }
 }
 
-bool
-ObjectRouter::migrate_pred_helper_(const char* desc,
-                                   const ObjectId& id,
-                                   bool is_volume,
-                                   uint64_t thresh,
-                                   uint64_t& counter) const
-{
-    ++counter;
-
-    LOG_TRACE(id << ": " <<
-              (is_volume ? "volume" : "file") << " " <<
-              desc << " threshold: " << thresh <<
-              ", redirects so far: " << counter);
-
-    if (thresh > 0 and counter >= thresh)
-    {
-        if (is_volume)
-        {
-            const uint64_t p = vrouter_check_local_volume_potential_period.value();
-            VERIFY(p);
-
-            if (((counter - thresh) % p) == 0)
-            {
-                LOG_INFO(id << ": checking volume potential of local node");
-
-                try
-                {
-                    return local_node_()->volume_potential(id) > 0;
-                }
-                CATCH_STD_ALL_EWHAT({
-                        LOG_ERROR(id <<
-                                  ": failed to determine volume potential of local node: " <<
-                                  EWHAT << " - let's rather not migrate here");
-                        return false;
-                    });
-            }
-            else
-            {
-                LOG_TRACE(id << ": not checking volume potential of local node");
-                return false;
-            }
-        }
-        else
-        {
-            return true;
-        }
-    }
-    else
-    {
-        return false;
-    }
-}
-
 template<typename... Args>
 FastPathCookie
 ObjectRouter::select_path_(const FastPathCookie& cookie,
@@ -952,27 +963,22 @@ ObjectRouter::write_(const ObjectId& id,
 {
     LOG_TRACE(id << ": size " << *size << ", off " << off);
 
-    auto pred([this](const ObjectId& id,
-                     const ObjectType tp)
-              {
-                  LOCK_REDIRECTS();
-
-                  return migrate_pred_helper_("write",
-                                              id,
-                                              tp != ObjectType::File,
-                                              tp == ObjectType::File ?
-                                              vrouter_file_write_threshold.value() :
-                                              vrouter_volume_write_threshold.value(),
-                                              redirects_[id].writes);
-              });
-
-    return maybe_migrate_(std::move(pred),
-                          &ClusterNode::write,
-                          id,
-                          buf,
-                          size,
-                          off);
+    auto on_redirect([&](const ObjectRegistration& reg,
+                         const MigrationController::Clock::duration& latency)
+                     {
+                         migration_controller_->record_write(id,
+                                                            reg.treeconfig.object_type,
+                                                            reg.node_id,
+                                                            *size,
+                                                            latency);
+                     });
 
+    return route_and_record_redirect_(std::move(on_redirect),
+                                      &ClusterNode::write,
+                                      id,
+                                      buf,
+                                      size,
+                                      off);
 }
 
 namespace
@@ -1034,26 +1040,37 @@ ObjectRouter::read_(const ObjectId& id,
 {
     LOG_TRACE(id << ": size " << size << ", off " << off);
 
-    auto pred([this](const ObjectId& id,
-                     const ObjectType tp)
-              {
-                  LOCK_REDIRECTS();
+    auto on_redirect([&](const ObjectRegistration& reg,
+                         const MigrationController::Clock::duration& latency)
+                     {
+                         migration_controller_->record_read(id,
+                                                           reg.treeconfig.object_type,
+                                                           reg.node_id,
+                                                           *size,
+                                                           latency);
+                     });
 
-                  return migrate_pred_helper_("read",
-                                              id,
-                                              tp != ObjectType::File,
-                                              tp == ObjectType::File ?
-                                              vrouter_file_read_threshold.value() :
-                                              vrouter_volume_read_threshold.value(),
-                                              redirects_[id].reads);
-              });
+    return route_and_record_redirect_(std::move(on_redirect),
+                                      &ClusterNode::read,
+                                      id,
+                                      buf,
+                                      size,
+                                      off);
+}
 
-    return maybe_migrate_(std::move(pred),
-                          &ClusterNode::read,
-                          id,
-                          buf,
-                          size,
-                          off);
+void
+ObjectRouter::read_ahead(const ObjectId& id,
+                         off_t off,
+                         size_t size)
+{
+    ObjectRegistrationPtr reg(object_registry_->find(id,
+                                                     IgnoreCache::F));
+    if (reg and reg->node_id == node_id())
+    {
+        local_node_()->read_ahead(reg->object(),
+                                  off,
+                                  size);
+    }
 }
 
 namespace
@@ -1592,11 +1609,17 @@ ObjectRouter::update(const bpt::ptree& pt,
     U(vrouter_file_read_threshold);
     U(vrouter_file_write_threshold);
     U(vrouter_check_local_volume_potential_period);
+    U(vrouter_migrate_check_interval_secs);
+    U(vrouter_migrate_min_redirect_kib_per_sec);
+    U(vrouter_migrate_min_remote_time_percent);
+    U(vrouter_migrate_sustain_periods);
+    U(vrouter_migrate_holdoff_secs);
     U(vrouter_backend_sync_timeout_ms);
     U(vrouter_migrate_timeout_ms);
     U(vrouter_redirect_timeout_ms);
     U(vrouter_routing_retries);
     U(vrouter_redirect_retries);
+    U(vrouter_redirect_max_inflight);
     U(vrouter_id);
     U(vrouter_cluster_id);
     U(vrouter_registry_cache_capacity);
@@ -1644,10 +1667,16 @@ ObjectRouter::persist(bpt::ptree& pt,
     P(vrouter_file_read_threshold);
     P(vrouter_file_write_threshold);
     P(vrouter_check_local_volume_potential_period);
+    P(vrouter_migrate_check_interval_secs);
+    P(vrouter_migrate_min_redirect_kib_per_sec);
+    P(vrouter_migrate_min_remote_time_percent);
+    P(vrouter_migrate_sustain_periods);
+    P(vrouter_migrate_holdoff_secs);
     P(vrouter_backend_sync_timeout_ms);
     P(vrouter_migrate_timeout_ms);
     P(vrouter_redirect_timeout_ms);
     P(vrouter_redirect_retries);
+    P(vrouter_redirect_max_inflight);
     P(vrouter_routing_retries);
     P(vrouter_id);
     P(vrouter_cluster_id);
@@ -23,6 +23,7 @@
 #include "FileSystemParameters.h"
 #include "ForceRestart.h"
 #include "LocalNode.h"
+#include "MigrationController.h"
 #include "Object.h"
 #include "ZWorkerPool.h"
 
@@ -40,6 +41,7 @@
 #include <youtils/BooleanEnum.h>
 #include <youtils/InitializedParam.h>
 #include <youtils/Logging.h>
+#include <youtils/PeriodicAction.h>
 #include <youtils/VolumeDriverComponent.h>
 
 #include <volumedriver/Api.h>
@@ -113,7 +115,8 @@ MAKE_EXCEPTION(ObjectStillHasChildrenException, Exception);
 // Volume migration is the act of sending a Transfer message to a remote node and
 // restarting the volume on the local node. It can be  kicked off either
 // * externally (through a management call)
-// * internally, if the read/write threshold is exceeded
+// * internally, by the MigrationController which periodically looks at the
+//   redirected I/O recorded per object
 // .
 //
 // ZMQ details:
@@ -178,6 +181,13 @@ public:
          size_t& size,
          off_t off);
 
+    // Hint that [off, off + size) is going to be read soon. Only acted upon
+    // for objects running on this node - remote nodes see the actual reads.
+    void
+    read_ahead(const ObjectId&,
+               off_t off,
+               size_t size);
+
     FastPathCookie
     sync(const FastPathCookie&,
          const ObjectId&);
@@ -348,6 +358,12 @@ public:
         return boost::chrono::milliseconds(vrouter_redirect_timeout_ms.value());
     }
 
+    uint32_t
+    redirect_max_inflight() const
+    {
+        return vrouter_redirect_max_inflight.value();
+    }
+
     boost::chrono::milliseconds
     backend_sync_timeout() const
     {
@@ -387,6 +403,9 @@ public:
     std::unique_ptr<PythonClient>
     xmlrpc_client();
 
+    std::vector<MigrationDecision>
+    migration_decisions() const;
+
 private:
     DECLARE_LOGGER("VFSObjectRouter");
 
@@ -400,10 +419,16 @@ private:
     DECLARE_PARAMETER(vrouter_file_read_threshold);
     DECLARE_PARAMETER(vrouter_file_write_threshold);
     DECLARE_PARAMETER(vrouter_check_local_volume_potential_period);
+    DECLARE_PARAMETER(vrouter_migrate_check_interval_secs);
+    DECLARE_PARAMETER(vrouter_migrate_min_redirect_kib_per_sec);
+    DECLARE_PARAMETER(vrouter_migrate_min_remote_time_percent);
+    DECLARE_PARAMETER(vrouter_migrate_sustain_periods);
+    DECLARE_PARAMETER(vrouter_migrate_holdoff_secs);
     DECLARE_PARAMETER(vrouter_backend_sync_timeout_ms);
     DECLARE_PARAMETER(vrouter_migrate_timeout_ms);
     DECLARE_PARAMETER(vrouter_redirect_timeout_ms);
     DECLARE_PARAMETER(vrouter_redirect_retries);
+    DECLARE_PARAMETER(vrouter_redirect_max_inflight);
     DECLARE_PARAMETER(vrouter_routing_retries);
     DECLARE_PARAMETER(vrouter_id);
     DECLARE_PARAMETER(vrouter_cluster_id);
@@ -424,20 +449,8 @@ private:
     volumedriver::FailOverCacheMode foc_mode_;
     boost::optional<volumedriver::FailOverCacheConfig> foc_config_;
 
-    struct RedirectCounter
-    {
-        RedirectCounter()
-            : reads(0)
-            , writes(0)
-        {}
-
-        uint64_t reads;
-        uint64_t writes;
-    };
-
-    std::map<ObjectId, RedirectCounter> redirects_;
-
-    mutable std::mutex redirects_lock_;
+    std::unique_ptr<MigrationController> migration_controller_;
+    std::unique_ptr<youtils::PeriodicAction> migration_action_;
 
     void
     update_node_map_(const boost::optional<const boost::property_tree::ptree&>& pt);
@@ -500,26 +513,31 @@ private:
            FastPathCookie&,
            Args...);
 
-    bool
-    migrate_pred_helper_(const char* desc,
-                         const ObjectId& id,
-                         bool is_volume,
-                         uint64_t thresh,
-                         uint64_t& counter) const;
-
-    // migrate_pred needs to have the following signature:
-    // bool(const ObjectId&, ObjectType).
+    // on_redirect needs to have the following signature:
+    // void(const ObjectRegistration&, MigrationController::Clock::duration).
     // We're not using a std::function here as that ends up allocating memory
     // which we want to avoid. We could pass function pointers / references but that
     // limits its flexibility.
-    template<typename MigratePred,
+    template<typename OnRedirect,
              typename... Args>
     FastPathCookie
-    maybe_migrate_(MigratePred&& ,
-                   void (ClusterNode::*fn)(const Object&,
-                                           Args...),
-                   const ObjectId&,
-                   Args...);
+    route_and_record_redirect_(OnRedirect&&,
+                               void (ClusterNode::*fn)(const Object&,
+                                                       Args...),
+                               const ObjectId&,
+                               Args...);
+
+    MigrationController::Policy
+    migration_policy_() const;
+
+    void
+    check_migrations_();
+
+    MigrationController::MigrationCost
+    estimate_migration_cost_(const ObjectId&);
+
+    void
+    auto_migrate_(const ObjectId&);
 
     void
     handle_message_(zmq::socket_t& router_sock);
@@ -492,6 +492,22 @@ PythonClient::list_client_connections(const std::string& node_id)
     return info;
 }
 
+std::vector<MigrationDecision>
+PythonClient::list_migration_decisions(const std::string& node_id)
+{
+    XmlRpc::XmlRpcValue req;
+    req[XMLRPCKeys::vrouter_id] = node_id;
+
+    auto rsp(call(ListMigrationDecisions::method_name(), req));
+
+    std::vector<MigrationDecision> decisions;
+    for (auto i = 0; i < rsp.size(); ++i)
+    {
+        decisions.push_back(XMLRPCStructs::deserialize_from_xmlrpc_value<MigrationDecision>(rsp[i]));
+    }
+    return decisions;
+}
+
 XMLRPCSnapshotInfo
 PythonClient::info_snapshot(const std::string& volume_id,
                             const std::string& snapshot_id)
@@ -22,6 +22,7 @@
 #include "XMLRPCStructs.h"
 #include "CloneFileFlags.h"
 #include "ClientInfo.h"
+#include "MigrationDecision.h"
 
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
@@ -331,6 +332,9 @@ public:
     std::vector<ClientInfo>
     list_client_connections(const std::string& node_id);
 
+    std::vector<MigrationDecision>
+    list_migration_decisions(const std::string& node_id);
+
     const MaybeSeconds&
     timeout() const
     {
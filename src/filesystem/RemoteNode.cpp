@@ -19,10 +19,18 @@
 #include "ObjectRouter.h"
 #include "ZUtils.h"
 
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+
+#include <boost/chrono.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <youtils/Assert.h>
 #include <youtils/Catchers.h>
+#include <youtils/ScopeExit.h>
 
 // XXX: needed as we throw VolManager::VolumeDoesNotExistException.
 // This needs to be redone, we don't want to know about VolManager
@@ -33,66 +41,459 @@ namespace volumedriverfs
 {
 
 namespace vd = volumedriver;
+namespace yt = youtils;
 
 #define LOCK()                                  \
-    std::lock_guard<lock_type> lg__(lock_)
+    std::unique_lock<lock_type> lg__(lock_)
 
 RemoteNode::RemoteNode(ObjectRouter& vrouter,
                        const ClusterNodeConfig& cfg,
                        std::shared_ptr<zmq::context_t> ztx)
     : ClusterNode(vrouter, cfg)
     , ztx_(ztx)
+    , stop_(false)
+    , next_tag_(0)
+    , event_fd_(eventfd(0, EFD_NONBLOCK bitor EFD_CLOEXEC))
 {
-    LOCK();
-    init_zock_();
+    VERIFY(ztx_ != nullptr);
+
+    if (event_fd_ < 0)
+    {
+        const int err = errno;
+        LOG_ERROR("Failed to create eventfd: " << strerror(err));
+        throw fungi::IOException("Failed to create eventfd",
+                                 config.vrouter_id.c_str(),
+                                 err);
+    }
+
+    try
+    {
+        auto initialized(std::make_shared<std::promise<bool>>());
+        std::future<bool> future(initialized->get_future());
+
+        io_thread_ = boost::thread([this, initialized]
+                                   {
+                                       work_(*initialized);
+                                   });
+
+        try
+        {
+            future.get();
+        }
+        catch (...)
+        {
+            io_thread_.join();
+            throw;
+        }
+    }
+    catch (...)
+    {
+        close(event_fd_);
+        throw;
+    }
 }
 
-void
-RemoteNode::init_zock_()
+RemoteNode::~RemoteNode()
 {
-    VERIFY(ztx_ != nullptr);
-    ASSERT_LOCKABLE_LOCKED(lock_);
+    {
+        LOCK();
+        stop_ = true;
+        inflight_cond_.notify_all();
+    }
 
+    try
+    {
+        wake_io_thread_();
+        io_thread_.join();
+    }
+    CATCH_STD_ALL_LOG_IGNORE("Failed to stop I/O thread for remote node " <<
+                             config.vrouter_id);
+
+    close(event_fd_);
+}
+
+std::unique_ptr<zmq::socket_t>
+RemoteNode::make_zock_()
+{
     const std::string rport(boost::lexical_cast<std::string>(config.message_port));
-    zock_.reset(new zmq::socket_t(*ztx_, ZMQ_REQ));
+    std::unique_ptr<zmq::socket_t> zock(new zmq::socket_t(*ztx_, ZMQ_DEALER));
 
     const std::string tcp_addr("tcp://" + config.host + std::string(":") + rport);
-    ZUtils::socket_no_linger(*zock_);
+    ZUtils::socket_no_linger(*zock);
 
     LOG_INFO("Connecting to " << tcp_addr);
-    zock_->connect(tcp_addr.c_str());
+    zock->connect(tcp_addr.c_str());
+
+    return zock;
+}
+
+// Retries with backoff as exceptions must not escape from the I/O thread.
+// Returns nullptr if we're asked to stop in the mean time.
+std::unique_ptr<zmq::socket_t>
+RemoteNode::reconnect_()
+{
+    const boost::chrono::milliseconds max_backoff(5000);
+    boost::chrono::milliseconds backoff(100);
+
+    while (true)
+    {
+        try
+        {
+            return make_zock_();
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_ERROR("Failed to reconnect to " << config.vrouter_id <<
+                          ": " << EWHAT << " - retrying in " << backoff);
+            });
+
+        LOCK();
+        if (inflight_cond_.wait_for(lg__,
+                                    std::chrono::milliseconds(backoff.count()),
+                                    [&]() -> bool
+                                    {
+                                        return stop_;
+                                    }))
+        {
+            return nullptr;
+        }
+
+        backoff = std::min(2 * backoff,
+                           max_backoff);
+    }
 }
 
 void
-RemoteNode::wait_for_remote_(const boost::chrono::milliseconds& timeout_ms)
+RemoteNode::wake_io_thread_()
 {
-    ASSERT_LOCKABLE_LOCKED(lock_);
+    const uint64_t val = 1;
+    const ssize_t ret = ::write(event_fd_, &val, sizeof(val));
+    // EAGAIN: the counter is saturated which means a wakeup is pending anyway
+    if (ret != sizeof(val) and errno != EAGAIN)
+    {
+        const int err = errno;
+        LOG_ERROR("Failed to signal eventfd: " << strerror(err));
+        throw fungi::IOException("Failed to signal eventfd",
+                                 config.vrouter_id.c_str(),
+                                 err);
+    }
+}
 
-    LOG_TRACE("waiting for response from remote " << config.vrouter_id <<
-              ", timeout: " << timeout_ms << " ms");
+void
+RemoteNode::work_(std::promise<bool>& initialized)
+{
+    std::unique_ptr<zmq::socket_t> zock;
 
-    ASSERT(zock_ != nullptr);
+    try
+    {
+        zock = make_zock_();
+        initialized.set_value(true);
+    }
+    catch (...)
+    {
+        initialized.set_exception(std::current_exception());
+        return;
+    }
 
-    zmq::pollitem_t item;
-    item.socket = *zock_;
-    item.events = ZMQ_POLLIN;
+    LOG_INFO("I/O thread for remote node " << config.vrouter_id << " started");
 
-    // TODO: ZMQ exceptions are passed on - are there cases where we don't
-    // want that, e.g. EINTR?
-    const int ret = zmq::poll(&item,
-                              1,
-                              timeout_ms.count() == 0 ?
-                              - 1 :
-                              timeout_ms.count());
-    THROW_WHEN(ret < 0);
+    // the socket is full - wait for it to become writable again
+    bool send_blocked = false;
 
-    if (ret == 0)
+    while (true)
     {
-        LOG_INFO("Remote did not respond within " << timeout_ms <<
-                 " milliseconds - giving up");
+        bool reconnect = false;
 
-        init_zock_();
-        throw RequestTimeoutException("request to remote node timed out");
+        try
+        {
+            std::array<zmq::pollitem_t, 2> items;
+
+            items[0].socket = *zock;
+            items[0].fd = -1;
+            items[0].events = send_blocked ?
+                ZMQ_POLLIN bitor ZMQ_POLLOUT :
+                ZMQ_POLLIN;
+
+            items[1].socket = nullptr;
+            items[1].fd = event_fd_;
+            items[1].events = ZMQ_POLLIN;
+
+            zmq::poll(items.data(),
+                      items.size(),
+                      -1);
+
+            if (items[1].revents bitand ZMQ_POLLIN)
+            {
+                uint64_t val;
+                const ssize_t ret = ::read(event_fd_, &val, sizeof(val));
+                if (ret < 0 and errno != EAGAIN)
+                {
+                    const int err = errno;
+                    LOG_ERROR("Failed to read from eventfd: " << strerror(err));
+                    throw fungi::IOException("Failed to read from eventfd",
+                                             config.vrouter_id.c_str(),
+                                             err);
+                }
+
+                {
+                    LOCK();
+                    if (stop_)
+                    {
+                        break;
+                    }
+                }
+
+                send_blocked = send_queued_(*zock);
+            }
+            else if (items[0].revents bitand ZMQ_POLLOUT)
+            {
+                send_blocked = send_queued_(*zock);
+            }
+
+            if (items[0].revents bitand ZMQ_POLLIN)
+            {
+                recv_responses_(*zock);
+            }
+        }
+        catch (zmq::error_t& e)
+        {
+            if (e.num() == ETERM)
+            {
+                LOG_INFO("ZMQ context terminated, stopping I/O thread for " <<
+                         config.vrouter_id);
+                break;
+            }
+            else
+            {
+                LOG_ERROR("Caught ZMQ error talking to " << config.vrouter_id <<
+                          ": " << e.what() << " - reconnecting");
+                fail_pending_(std::current_exception());
+                reconnect = true;
+            }
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_ERROR("Error talking to " << config.vrouter_id <<
+                          ": " << EWHAT << " - reconnecting");
+                fail_pending_(std::current_exception());
+                reconnect = true;
+            });
+
+        if (reconnect)
+        {
+            send_blocked = false;
+            zock = reconnect_();
+            if (zock == nullptr)
+            {
+                break;
+            }
+        }
+    }
+
+    {
+        LOCK();
+        stop_ = true;
+        inflight_cond_.notify_all();
+    }
+
+    fail_pending_(std::make_exception_ptr(fungi::IOException("Connection to remote node shut down",
+                                                             config.vrouter_id.c_str())));
+
+    LOG_INFO("I/O thread for remote node " << config.vrouter_id << " exiting");
+}
+
+// Never blocks, as a slow or dead peer must not hold up the responses to the
+// other requests (or the shutdown). Returns true if the socket is full and the
+// rest of the queue has to wait for it to become writable again.
+bool
+RemoteNode::send_queued_(zmq::socket_t& zock)
+{
+    while (true)
+    {
+        std::pair<vfsprotocol::Tag, MessageParts> req;
+
+        {
+            LOCK();
+            if (send_queue_.empty())
+            {
+                return false;
+            }
+
+            req = std::move(send_queue_.front());
+            send_queue_.pop_front();
+        }
+
+        MessageParts& parts = req.second;
+        ASSERT(not parts.empty());
+
+        // empty delimiter frame, as expected by the REP side behind the ROUTER
+        zmq::message_t delim;
+        if (not zock.send(delim, ZMQ_SNDMORE bitor ZMQ_DONTWAIT))
+        {
+            LOCK();
+            // unless it was given up on in the mean time
+            if (pending_.find(req.first) != pending_.end())
+            {
+                send_queue_.emplace_front(std::move(req));
+            }
+
+            return true;
+        }
+
+        // the high water mark only applies to the first part of a message, so
+        // the remaining ones don't block either
+        for (size_t i = 0; i < parts.size(); ++i)
+        {
+            zock.send(parts[i],
+                      (i + 1 < parts.size()) ? ZMQ_SNDMORE : 0);
+        }
+    }
+}
+
+void
+RemoteNode::recv_responses_(zmq::socket_t& zock)
+{
+    while (true)
+    {
+        MessageParts parts;
+
+        do
+        {
+            parts.emplace_back();
+            if (not zock.recv(&parts.back(), ZMQ_DONTWAIT))
+            {
+                // nothing (more) to read - but we never leave a partial
+                // message behind as zmq delivers them atomically.
+                VERIFY(parts.size() == 1);
+                return;
+            }
+        }
+        while (ZUtils::more_message_parts(zock));
+
+        // [delimiter, response type, tag, (extra)]
+        if (parts.size() < 3 or parts[0].size() != 0)
+        {
+            LOG_ERROR("Dropping malformed response with " << parts.size() <<
+                      " parts from " << config.vrouter_id);
+            continue;
+        }
+
+        vfsprotocol::Tag tag;
+        ZUtils::deserialize_from_message(parts[2], tag);
+
+        parts.erase(parts.begin());
+
+        std::promise<MessageParts> promise;
+
+        {
+            LOCK();
+            auto it = pending_.find(tag);
+            if (it == pending_.end())
+            {
+                LOG_WARN("Dropping response with unknown tag " << tag <<
+                         " from " << config.vrouter_id <<
+                         " - the request probably timed out");
+                continue;
+            }
+
+            promise = std::move(it->second);
+            pending_.erase(it);
+            inflight_cond_.notify_one();
+        }
+
+        promise.set_value(std::move(parts));
+    }
+}
+
+void
+RemoteNode::fail_pending_(std::exception_ptr ep)
+{
+    std::map<vfsprotocol::Tag, std::promise<MessageParts>> pending;
+
+    {
+        LOCK();
+        std::swap(pending, pending_);
+        send_queue_.clear();
+        inflight_cond_.notify_all();
+    }
+
+    for (auto& p : pending)
+    {
+        p.second.set_exception(ep);
+    }
+}
+
+std::future<RemoteNode::MessageParts>
+RemoteNode::submit_(const vfsprotocol::Tag tag,
+                    MessageParts parts,
+                    const Deadline& deadline)
+{
+    std::future<MessageParts> future;
+
+    {
+        LOCK();
+
+        auto ready([&]() -> bool
+                   {
+                       const size_t max =
+                           std::max<uint32_t>(1,
+                                              vrouter_.redirect_max_inflight());
+                       return stop_ or pending_.size() < max;
+                   });
+
+        if (deadline)
+        {
+            if (not inflight_cond_.wait_until(lg__,
+                                              *deadline,
+                                              ready))
+            {
+                LOG_INFO("No request slot to " << config.vrouter_id <<
+                         " became available in time - giving up");
+                throw RequestTimeoutException("request to remote node timed out");
+            }
+        }
+        else
+        {
+            inflight_cond_.wait(lg__,
+                                ready);
+        }
+
+        if (stop_)
+        {
+            throw fungi::IOException("Connection to remote node shut down",
+                                     config.vrouter_id.c_str());
+        }
+
+        auto res(pending_.emplace(tag,
+                                  std::promise<MessageParts>()));
+        VERIFY(res.second);
+
+        future = res.first->second.get_future();
+        send_queue_.emplace_back(tag,
+                                 std::move(parts));
+    }
+
+    wake_io_thread_();
+    return future;
+}
+
+void
+RemoteNode::forget_(const vfsprotocol::Tag tag)
+{
+    LOCK();
+    if (pending_.erase(tag) != 0)
+    {
+        inflight_cond_.notify_one();
+
+        // don't bother sending it if it's still queued
+        auto it = std::find_if(send_queue_.begin(),
+                               send_queue_.end(),
+                               [&](const std::pair<vfsprotocol::Tag, MessageParts>& p)
+                               {
+                                   return p.first == tag;
+                               });
+        if (it != send_queue_.end())
+        {
+            send_queue_.erase(it);
+        }
     }
 }
 
@@ -109,95 +510,115 @@ RemoteNode::handle_(const Request& req,
     const char* req_desc = vfsprotocol::request_type_to_string(req_type);
     LOG_TRACE(req_desc);
 
-    LOCK();
-
-    ASSERT(zock_ != nullptr);
-
-    ZUtils::serialize_to_socket(*zock_, req_type, MoreMessageParts::T);
-
-    vfsprotocol::Tag req_tag(reinterpret_cast<uint64_t>(&req));
-    ZUtils::serialize_to_socket(*zock_, req_tag, MoreMessageParts::T);
+    const vfsprotocol::Tag req_tag(++next_tag_);
 
-    ZUtils::serialize_to_socket(*zock_,
-                                req,
-                                (send_extra != nullptr) ?
-                                MoreMessageParts::T :
-                                MoreMessageParts::F);
+    MessageParts parts;
+    parts.reserve(send_extra != nullptr ? 4 : 3);
+    parts.emplace_back(ZUtils::serialize_to_message(req_type));
+    parts.emplace_back(ZUtils::serialize_to_message(req_tag));
+    parts.emplace_back(ZUtils::serialize_to_message(req));
 
     if (send_extra != nullptr)
     {
-        (*send_extra)();
+        parts.emplace_back((*send_extra)());
     }
 
+    const Deadline deadline(timeout_ms.count() != 0 ?
+                            Deadline(std::chrono::steady_clock::now() +
+                                     std::chrono::milliseconds(timeout_ms.count())) :
+                            boost::none);
+
+    std::future<MessageParts> future(submit_(req_tag,
+                                             std::move(parts),
+                                             deadline));
+
+    // in case we bail out before the response arrives
+    auto on_exit(yt::make_scope_exit([&]
+                                     {
+                                         forget_(req_tag);
+                                     }));
+
     LOG_TRACE("sent " << req_desc << ", tag " << req_tag <<
               ", extra: " << (send_extra != nullptr) << ", timeout ms: " << timeout_ms);
 
-    wait_for_remote_(timeout_ms);
+    if (deadline and
+        future.wait_until(*deadline) == std::future_status::timeout)
+    {
+        // Only this request is given up on (on_exit forgets about it, a late
+        // response is dropped as its tag is unknown) - other requests to the
+        // node, e.g. long running transfers, are not affected.
+        LOG_INFO("Remote did not respond within " << timeout_ms <<
+                 " milliseconds - giving up");
 
-    vfsprotocol::ResponseType rsp_type;
-    ZUtils::deserialize_from_socket(*zock_, rsp_type);
+        throw RequestTimeoutException("request to remote node timed out");
+    }
 
-    ZEXPECT_MORE(*zock_, "response tag");
+    const MessageParts rsp(future.get());
+    // [response type, tag, (extra)] - checked by recv_responses_
+    ASSERT(rsp.size() >= 2);
 
-    vfsprotocol::Tag rsp_tag;
-    ZUtils::deserialize_from_socket(*zock_, rsp_tag);
+    vfsprotocol::ResponseType rsp_type;
+    ZUtils::deserialize_from_message(rsp[0], rsp_type);
 
     const char* rsp_desc = vfsprotocol::response_type_to_string(rsp_type);
-    LOG_TRACE("recv'd " << rsp_desc << ", tag " << rsp_tag);
+    LOG_TRACE("recv'd " << rsp_desc << ", tag " << req_tag);
 
-    if (rsp_tag != req_tag)
-    {
-        LOG_ERROR("req " << req_desc << ", rsp " << rsp_desc <<
-                  ": expected tag " << req_tag << ", got " << rsp_tag);
-        throw ProtocolError("Wrong tag in response");
+#define EXPECT_PARTS(n)                                                 \
+    if (rsp.size() != n)                                                \
+    {                                                                   \
+        throw ProtocolError("Unexpected number of message parts in response", \
+                            req_desc);                                  \
     }
 
-    try
+    switch (rsp_type)
     {
-        switch (rsp_type)
+    case vfsprotocol::ResponseType::Ok:
+        if (recv_extra != nullptr)
         {
-        case vfsprotocol::ResponseType::Ok:
-            if (recv_extra != nullptr)
+            if (rsp.size() < 3)
             {
-                (*recv_extra)();
+                throw ProtocolError("Expected extra response data, got nothing",
+                                    req_desc);
             }
-            ZEXPECT_NOTHING_MORE(*zock_);
-            break;
-        case vfsprotocol::ResponseType::ObjectNotRunningHere:
-            ZEXPECT_NOTHING_MORE(*zock_);
-            LOG_INFO("volume not present on node " << config.vrouter_id);
-
-            throw vd::VolManager::VolumeDoesNotExistException("volume not present on node",
-                                                              req_desc);
-            break;
-        case vfsprotocol::ResponseType::UnknownRequest:
-            ZEXPECT_NOTHING_MORE(*zock_);
-            LOG_WARN("got an UnknownRequest response status in response to " <<
-                     req_desc);
-            // handle differently once we need to take care of backward compatibility.
-            throw ProtocolError("Remote sent UnknownRequest response status",
-                                req_desc);
-            break;
-        case vfsprotocol::ResponseType::Timeout:
-            ZEXPECT_NOTHING_MORE(*zock_);
-            LOG_ERROR("got a Timeout response status in response to " <<
-                      req_desc);
-            throw RemoteTimeoutException("Remote sent timeout status",
-                                         req_desc);
-            break;
-        default:
-            ZEXPECT_NOTHING_MORE(*zock_);
-            LOG_ERROR(req_desc << " failed, remote returned status " <<
-                      rsp_desc << " (" << static_cast<uint32_t>(rsp_type) << ")");
-            throw fungi::IOException("Remote operation failed",
-                                     req_desc);
+            (*recv_extra)(rsp[2]);
+            EXPECT_PARTS(3);
         }
+        else
+        {
+            EXPECT_PARTS(2);
+        }
+        break;
+    case vfsprotocol::ResponseType::ObjectNotRunningHere:
+        EXPECT_PARTS(2);
+        LOG_INFO("volume not present on node " << config.vrouter_id);
+
+        throw vd::VolManager::VolumeDoesNotExistException("volume not present on node",
+                                                          req_desc);
+        break;
+    case vfsprotocol::ResponseType::UnknownRequest:
+        EXPECT_PARTS(2);
+        LOG_WARN("got an UnknownRequest response status in response to " <<
+                 req_desc);
+        // handle differently once we need to take care of backward compatibility.
+        throw ProtocolError("Remote sent UnknownRequest response status",
+                            req_desc);
+        break;
+    case vfsprotocol::ResponseType::Timeout:
+        EXPECT_PARTS(2);
+        LOG_ERROR("got a Timeout response status in response to " <<
+                  req_desc);
+        throw RemoteTimeoutException("Remote sent timeout status",
+                                     req_desc);
+        break;
+    default:
+        EXPECT_PARTS(2);
+        LOG_ERROR(req_desc << " failed, remote returned status " <<
+                  rsp_desc << " (" << static_cast<uint32_t>(rsp_type) << ")");
+        throw fungi::IOException("Remote operation failed",
+                                 req_desc);
     }
-    catch (...)
-    {
-        ZUtils::drop_remaining_message_parts(*zock_);
-        throw;
-    }
+
+#undef EXPECT_PARTS
 }
 
 void
@@ -213,13 +634,8 @@ RemoteNode::read(const Object& obj,
 
     const auto req(vfsprotocol::MessageUtils::create_read_request(obj, *size, off));
 
-    ExtraRecvFun recv_data([&]
+    ExtraRecvFun recv_data([&](const zmq::message_t& msg)
                            {
-                               ZEXPECT_MORE(*zock_, "read data");
-
-                               zmq::message_t msg;
-                               zock_->recv(&msg);
-
                                if (msg.size() > *size)
                                {
                                    LOG_ERROR("Read " << msg.size() << " > expected " <<
@@ -255,15 +671,13 @@ RemoteNode::write(const Object& obj,
                            {
                                zmq::message_t msg(*size);
                                memcpy(msg.data(), buf, *size);
-                               zock_->send(msg, 0);
+                               return msg;
                            });
 
-    ExtraRecvFun get_size([&]
+    ExtraRecvFun get_size([&](const zmq::message_t& msg)
                           {
-                              ZEXPECT_MORE(*zock_, "WriteResponse");
-
                               vfsprotocol::WriteResponse rsp;
-                              ZUtils::deserialize_from_socket(*zock_, rsp);
+                              ZUtils::deserialize_from_message(msg, rsp);
 
                               rsp.CheckInitialized();
                               *size = rsp.size();
@@ -292,12 +706,10 @@ RemoteNode::get_size(const Object& obj)
     LOG_TRACE(obj.id);
 
     uint64_t size = 0;
-    ExtraRecvFun get_size([&]
+    ExtraRecvFun get_size([&](const zmq::message_t& msg)
                           {
-                              ZEXPECT_MORE(*zock_, "GetSizeResponse");
-
                               vfsprotocol::GetSizeResponse rsp;
-                              ZUtils::deserialize_from_socket(*zock_, rsp);
+                              ZUtils::deserialize_from_message(msg, rsp);
 
                               rsp.CheckInitialized();
                               size = rsp.size();
@@ -360,11 +772,10 @@ RemoteNode::ping()
     LOG_TRACE("ping requested");
     const auto req(vfsprotocol::MessageUtils::create_ping_message(vrouter_.node_id()));
 
-    ExtraRecvFun handle_pong([&]
+    ExtraRecvFun handle_pong([&](const zmq::message_t& msg)
                              {
-                                 ZEXPECT_MORE(*zock_, "PingMessage");
                                  vfsprotocol::PingMessage rsp;
-                                 ZUtils::deserialize_from_socket(*zock_, rsp);
+                                 ZUtils::deserialize_from_message(msg, rsp);
 
                                  rsp.CheckInitialized();
                                  LOG_TRACE("got pong from " << rsp.sender_id());
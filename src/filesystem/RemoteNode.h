@@ -20,9 +20,20 @@
 #include "ClusterNodeConfig.h"
 #include "Messages.pb.h"
 #include "NodeId.h"
-
+#include "Protocol.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/thread.hpp>
 
 #include <cppzmq/zmq.hpp>
 
@@ -31,6 +42,11 @@
 namespace volumedriverfs
 {
 
+// Requests to a remote node are tagged and sent over a single DEALER socket
+// which is owned by an I/O thread. Callers (fuse threads) hand their requests
+// to that thread and wait for the response with the matching tag, so up to
+// vrouter_redirect_max_inflight requests can be outstanding per remote node
+// and redirected I/O is not serialized behind the round trip time.
 class RemoteNode final
     : public ClusterNode
 {
@@ -39,6 +55,8 @@ public:
                const ClusterNodeConfig& cfg,
                std::shared_ptr<zmq::context_t> ztx);
 
+    ~RemoteNode();
+
     RemoteNode(const RemoteNode&) = delete;
 
     RemoteNode&
@@ -78,24 +96,62 @@ public:
 private:
     DECLARE_LOGGER("VFSRemoteNode");
 
+    using MessageParts = std::vector<zmq::message_t>;
+
     std::shared_ptr<zmq::context_t> ztx_;
-    std::unique_ptr<zmq::socket_t> zock_;
 
-    // Protects the zock_ as it's accessed from different (fuse)
-    // threads concurrently.
-    // Not exactly the recommended way of using ZMQ (which would be
-    // a socket per thread).
+    // Protects the members below; the socket itself is only ever touched
+    // by io_thread_.
     typedef std::mutex lock_type;
     mutable lock_type lock_;
 
+    std::condition_variable inflight_cond_;
+    std::map<vfsprotocol::Tag, std::promise<MessageParts>> pending_;
+    // requests that were not handed to the socket yet, e.g. as the peer
+    // reached the high water mark
+    std::deque<std::pair<vfsprotocol::Tag, MessageParts>> send_queue_;
+    bool stop_;
+
+    std::atomic<uint64_t> next_tag_;
+
+    // used to wake up the io_thread_ if there's something to send
+    int event_fd_;
+
+    boost::thread io_thread_;
+
     void
-    init_zock_();
+    work_(std::promise<bool>& initialized);
+
+    std::unique_ptr<zmq::socket_t>
+    make_zock_();
+
+    std::unique_ptr<zmq::socket_t>
+    reconnect_();
+
+    void
+    wake_io_thread_();
+
+    bool
+    send_queued_(zmq::socket_t&);
+
+    void
+    recv_responses_(zmq::socket_t&);
+
+    void
+    fail_pending_(std::exception_ptr);
+
+    using Deadline = boost::optional<std::chrono::steady_clock::time_point>;
+
+    std::future<MessageParts>
+    submit_(const vfsprotocol::Tag,
+            MessageParts,
+            const Deadline&);
 
     void
-    wait_for_remote_(const boost::chrono::milliseconds& timeout_ms);
+    forget_(const vfsprotocol::Tag);
 
-    typedef std::function<void()> ExtraSendFun;
-    typedef std::function<void()> ExtraRecvFun;
+    typedef std::function<zmq::message_t()> ExtraSendFun;
+    typedef std::function<void(const zmq::message_t&)> ExtraRecvFun;
 
     template<typename Request>
     void
@@ -95,10 +95,8 @@ public:
         shm_servers_.emplace(volume_name,
                              std::unique_ptr<ServerType>(new ServerType(std::move(h))));
 
-        create_result->writerequest_uuid = shm_servers_[volume_name]->writerequest_uuid().str().c_str();
-        create_result->writereply_uuid = shm_servers_[volume_name]->writereply_uuid().str().c_str();
-        create_result->readrequest_uuid = shm_servers_[volume_name]->readrequest_uuid().str().c_str();
-        create_result->readreply_uuid = shm_servers_[volume_name]->readreply_uuid().str().c_str();
+        create_result->ring_uuid = shm_servers_[volume_name]->uuid().str().c_str();
+        create_result->protocol_version = shm_protocol_version;
         return create_result._retn();
     }
 
@@ -139,7 +137,7 @@ public:
         auto it = shm_servers_.find(volume_name);
         if (it != shm_servers_.end())
         {
-            if (it->second->writerequest_uuid().str() == key)
+            if (it->second->uuid().str() == key)
             {
                 return true;
             }
@@ -16,8 +16,15 @@
 #ifndef __SHM_PROTOCOL_H_
 #define __SHM_PROTOCOL_H_
 
+#include "ShmRing.h"
+
 #include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+
 #include <cstdint>
+#include <new>
+#include <stdexcept>
 
 namespace volumedriverfs
 {
@@ -27,51 +34,183 @@ const std::string vd_context_kind("storage");
 const std::string vd_object_name("volumedriver_shm_interface");
 const std::string vd_object_kind("storage");
 
-const uint64_t max_write_queue_size = 128;
-const uint64_t max_read_queue_size = 128;
-const uint64_t max_reply_queue_size = 128;
+// Version 2: submission / completion rings in shared memory instead of
+// boost::interprocess::message_queues.
+const uint32_t shm_protocol_version = 2;
 
-struct ShmWriteRequest
+// Entries per submission / completion ring.
+const uint32_t shm_ring_size = 256;
+
+enum class ShmRequestType : uint32_t
 {
-    bool stop = false;
-    uint64_t offset_in_bytes = 0;
-    size_t  size_in_bytes = 0;
-    uintptr_t opaque;
-    boost::interprocess::managed_shared_memory::handle_t handle;
+    Read,
+    Write,
+    Flush,
 };
 
-static const uint64_t writerequest_size = sizeof(ShmWriteRequest);
-
-struct ShmReadRequest
+struct ShmRequest
 {
-    bool stop = false;
+    ShmRequestType type = ShmRequestType::Read;
     uint64_t offset_in_bytes = 0;
     size_t  size_in_bytes = 0;
-    uintptr_t opaque;
-    boost::interprocess::managed_shared_memory::handle_t handle;
+    uintptr_t opaque = 0;
+    boost::interprocess::managed_shared_memory::handle_t handle = 0;
 };
 
-static const uint64_t readrequest_size = sizeof(ShmReadRequest);
-
-struct ShmReadReply
+struct ShmReply
 {
-    bool stop = false;
     bool failed = false;
-    uintptr_t opaque;
+    uintptr_t opaque = 0;
     size_t  size_in_bytes = 0;
 };
 
-static const uint64_t readreply_size = sizeof(ShmReadReply);
+// One submission (client -> server) and one completion (server -> client)
+// ring. Each is single producer / single consumer: the server runs one
+// thread per queue pair and the client serializes submissions / reaping
+// per queue pair in-process.
+struct ShmQueuePair
+{
+    ShmRing<ShmRequest, shm_ring_size> sq;
+    ShmRing<ShmReply, shm_ring_size> cq;
+};
 
-struct ShmWriteReply
+struct alignas(64) ShmRingsHeader
 {
-    bool stop = false;
-    bool failed = false;
-    uintptr_t opaque;
-    size_t size_in_bytes = 0;
+    uint32_t version;
+    uint32_t nqueues;
+    std::atomic<uint32_t> stop;
 };
 
-static const uint64_t writereply_size = sizeof(ShmWriteReply);
+// The shared region of a volume's shm interface: a header followed by
+// nqueues queue pairs. Created (and removed again) by the server, opened
+// by the client.
+class ShmRings
+{
+public:
+    ShmRings(const std::string& name,
+             const uint32_t nqueues)
+        : name_(name)
+        , owner_(true)
+    {
+        if (nqueues == 0)
+        {
+            throw std::invalid_argument("shm rings need at least one queue pair");
+        }
+
+        shm_ = boost::interprocess::shared_memory_object(boost::interprocess::create_only,
+                                                         name_.c_str(),
+                                                         boost::interprocess::read_write);
+        try
+        {
+            shm_.truncate(region_size(nqueues));
+            region_ = boost::interprocess::mapped_region(shm_,
+                                                         boost::interprocess::read_write);
+
+            header_ = new (region_.get_address()) ShmRingsHeader();
+            header_->version = shm_protocol_version;
+            header_->nqueues = nqueues;
+            header_->stop = 0;
+
+            queues_ = reinterpret_cast<ShmQueuePair*>(header_ + 1);
+            for (uint32_t i = 0; i < nqueues; ++i)
+            {
+                new (queues_ + i) ShmQueuePair();
+            }
+        }
+        catch (...)
+        {
+            boost::interprocess::shared_memory_object::remove(name_.c_str());
+            throw;
+        }
+    }
+
+    explicit ShmRings(const std::string& name)
+        : name_(name)
+        , owner_(false)
+        , shm_(boost::interprocess::open_only,
+               name_.c_str(),
+               boost::interprocess::read_write)
+        , region_(shm_,
+                  boost::interprocess::read_write)
+        , header_(static_cast<ShmRingsHeader*>(region_.get_address()))
+        , queues_(reinterpret_cast<ShmQueuePair*>(header_ + 1))
+    {
+        if (region_.get_size() < sizeof(ShmRingsHeader) or
+            header_->version != shm_protocol_version)
+        {
+            throw std::runtime_error("shm protocol version mismatch");
+        }
+
+        if (header_->nqueues == 0 or
+            region_.get_size() < region_size(header_->nqueues))
+        {
+            throw std::runtime_error("shm rings region too small");
+        }
+    }
+
+    ~ShmRings()
+    {
+        if (owner_)
+        {
+            region_ = boost::interprocess::mapped_region();
+            boost::interprocess::shared_memory_object::remove(name_.c_str());
+        }
+    }
+
+    ShmRings(const ShmRings&) = delete;
+
+    ShmRings&
+    operator=(const ShmRings&) = delete;
+
+    uint32_t
+    nqueues() const
+    {
+        return header_->nqueues;
+    }
+
+    ShmQueuePair&
+    queue(const uint32_t i)
+    {
+        return queues_[i];
+    }
+
+    bool
+    stopped() const
+    {
+        return header_->stop.load() != 0;
+    }
+
+    void
+    stop()
+    {
+        header_->stop = 1;
+        wake_all();
+    }
+
+    void
+    wake_all()
+    {
+        for (uint32_t i = 0; i < nqueues(); ++i)
+        {
+            queues_[i].sq.wake_all();
+            queues_[i].cq.wake_all();
+        }
+    }
+
+    static size_t
+    region_size(const uint32_t nqueues)
+    {
+        return sizeof(ShmRingsHeader) + nqueues * sizeof(ShmQueuePair);
+    }
+
+private:
+    const std::string name_;
+    const bool owner_;
+    boost::interprocess::shared_memory_object shm_;
+    boost::interprocess::mapped_region region_;
+    ShmRingsHeader* header_;
+    ShmQueuePair* queues_;
+};
 
 }
 
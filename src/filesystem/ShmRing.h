@@ -0,0 +1,356 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef __SHM_RING_H_
+#define __SHM_RING_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <type_traits>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace volumedriverfs
+{
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "the shm rings need lock free atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+              "the shm doorbell needs to be usable as a futex");
+
+// Wakeup mechanism shared between processes: a futex word living in the
+// shared region. Ringing it is free if nobody sleeps on it, so producers can
+// publish a whole batch and ring once.
+struct ShmDoorbell
+{
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> sleepers;
+
+    ShmDoorbell()
+        : seq(0)
+        , sleepers(0)
+    {}
+
+    ShmDoorbell(const ShmDoorbell&) = delete;
+
+    ShmDoorbell&
+    operator=(const ShmDoorbell&) = delete;
+
+    // Must be followed by either wait() or cancel_wait(), and the caller
+    // must recheck its condition in between.
+    uint32_t
+    prepare_wait()
+    {
+        sleepers.fetch_add(1);
+        return seq.load();
+    }
+
+    void
+    cancel_wait()
+    {
+        sleepers.fetch_sub(1);
+    }
+
+    void
+    wait(const uint32_t old_seq,
+         const struct timespec* timeout)
+    {
+        // Not FUTEX_PRIVATE: the other side is a different process.
+        ::syscall(SYS_futex,
+                  reinterpret_cast<uint32_t*>(&seq),
+                  FUTEX_WAIT,
+                  old_seq,
+                  timeout,
+                  nullptr,
+                  0);
+        sleepers.fetch_sub(1);
+    }
+
+    void
+    ring()
+    {
+        // pairs with the fetch_add in prepare_wait: either the sleeper sees
+        // the published data or we see the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) != 0)
+        {
+            seq.fetch_add(1);
+            ::syscall(SYS_futex,
+                      reinterpret_cast<uint32_t*>(&seq),
+                      FUTEX_WAKE,
+                      INT_MAX,
+                      nullptr,
+                      nullptr,
+                      0);
+        }
+    }
+};
+
+// Process local state of a poller: spin for up to budget() before going to
+// sleep on a doorbell. The budget grows while work keeps showing up during
+// the spin and shrinks when we end up sleeping anyway, so busy queues don't
+// pay the wakeup latency and idle ones don't burn a CPU.
+class ShmAdaptiveSpin
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ShmAdaptiveSpin(const std::chrono::microseconds max_budget)
+        : max_(max_budget)
+        , budget_(max_budget / 4)
+    {}
+
+    ~ShmAdaptiveSpin() = default;
+
+    template<typename Pred>
+    bool
+    spin(Pred&& pred)
+    {
+        if (budget_.count() == 0)
+        {
+            if (pred())
+            {
+                hit_();
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        const Clock::time_point start = Clock::now();
+
+        do
+        {
+            if (pred())
+            {
+                hit_();
+                return true;
+            }
+
+            relax_();
+        }
+        while (Clock::now() - start < budget_);
+
+        budget_ /= 2;
+        return false;
+    }
+
+    std::chrono::microseconds
+    budget() const
+    {
+        return budget_;
+    }
+
+private:
+    const std::chrono::microseconds max_;
+    std::chrono::microseconds budget_;
+
+    void
+    hit_()
+    {
+        budget_ = std::min(max_,
+                           std::max(std::chrono::microseconds(1),
+                                    budget_ * 2));
+    }
+
+    static void
+    relax_()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+};
+
+// Single-producer / single-consumer ring, placed in a shared memory region.
+// head_ is only written by the producer and tail_ only by the consumer, so
+// neither side ever takes a lock; batches are published with one store.
+template<typename T, uint32_t N>
+class ShmRing
+{
+    static_assert(N != 0 and (N & (N - 1)) == 0,
+                  "ring size must be a power of 2");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "ring entries are copied across processes");
+
+public:
+    static constexpr uint32_t capacity = N;
+
+    ShmRing()
+        : head_(0)
+        , tail_(0)
+    {}
+
+    ~ShmRing() = default;
+
+    ShmRing(const ShmRing&) = delete;
+
+    ShmRing&
+    operator=(const ShmRing&) = delete;
+
+    // Producer side. Returns the number of entries actually pushed.
+    size_t
+    push(const T* ts,
+         const size_t n)
+    {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        const uint64_t tail = tail_.load(std::memory_order_acquire);
+        const size_t count = std::min<size_t>(n,
+                                              N - (head - tail));
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            slots_[(head + i) & (N - 1)] = ts[i];
+        }
+
+        if (count != 0)
+        {
+            head_.store(head + count,
+                        std::memory_order_release);
+            not_empty_.ring();
+        }
+
+        return count;
+    }
+
+    // Consumer side. Returns the number of entries actually popped.
+    size_t
+    pop(T* ts,
+        const size_t n)
+    {
+        const uint64_t tail = tail_.load(std::memory_order_relaxed);
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const size_t count = std::min<size_t>(n,
+                                              head - tail);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            ts[i] = slots_[(tail + i) & (N - 1)];
+        }
+
+        if (count != 0)
+        {
+            tail_.store(tail + count,
+                        std::memory_order_release);
+            not_full_.ring();
+        }
+
+        return count;
+    }
+
+    size_t
+    size() const
+    {
+        return head_.load(std::memory_order_acquire) -
+            tail_.load(std::memory_order_acquire);
+    }
+
+    bool
+    empty() const
+    {
+        return size() == 0;
+    }
+
+    bool
+    full() const
+    {
+        return size() == N;
+    }
+
+    // Consumer side: returns false if the ring is still empty after the
+    // timeout (or a spurious / shutdown wakeup).
+    bool
+    wait_not_empty(ShmAdaptiveSpin& spin,
+                   const struct timespec* timeout)
+    {
+        return wait_(not_empty_,
+                     spin,
+                     timeout,
+                     [&]
+                     {
+                         return not empty();
+                     });
+    }
+
+    // Producer side.
+    bool
+    wait_not_full(ShmAdaptiveSpin& spin,
+                  const struct timespec* timeout)
+    {
+        return wait_(not_full_,
+                     spin,
+                     timeout,
+                     [&]
+                     {
+                         return not full();
+                     });
+    }
+
+    // Kick both sides, e.g. to make them notice a shutdown.
+    void
+    wake_all()
+    {
+        not_empty_.ring();
+        not_full_.ring();
+    }
+
+private:
+    alignas(64) std::atomic<uint64_t> head_;
+    ShmDoorbell not_empty_;
+
+    alignas(64) std::atomic<uint64_t> tail_;
+    ShmDoorbell not_full_;
+
+    alignas(64) T slots_[N];
+
+    template<typename Pred>
+    static bool
+    wait_(ShmDoorbell& doorbell,
+          ShmAdaptiveSpin& spin,
+          const struct timespec* timeout,
+          Pred&& pred)
+    {
+        if (spin.spin(pred))
+        {
+            return true;
+        }
+
+        const uint32_t seq = doorbell.prepare_wait();
+        if (pred())
+        {
+            doorbell.cancel_wait();
+            return true;
+        }
+
+        doorbell.wait(seq,
+                      timeout);
+        return pred();
+    }
+};
+
+template<typename T, uint32_t N>
+constexpr uint32_t ShmRing<T, N>::capacity;
+
+}
+
+#endif // __SHM_RING_H_
@@ -18,9 +18,8 @@
 
 #include "ShmProtocol.h"
 
-#include <boost/interprocess/ipc/message_queue.hpp>
-#include <boost/date_time/posix_time/posix_time_types.hpp>
-#include <boost/asio.hpp>
+#include <array>
+
 #include <boost/thread.hpp>
 
 #include <youtils/UUID.h>
@@ -31,155 +30,55 @@
 namespace volumedriverfs
 {
 
-namespace ipc = boost::interprocess;
 namespace yt = youtils;
 
+// Serves a volume over a set of shared memory queue pairs (cf. ShmProtocol.h),
+// one thread per queue pair. Each thread busy-polls its submission ring for
+// a while (adaptively, see ShmAdaptiveSpin) before going to sleep on the
+// ring's doorbell, handles the requests it finds in one go and publishes
+// the batch of replies on the completion ring with a single doorbell.
 template<typename Handler>
 class ShmServer
 {
 public:
     ShmServer(std::unique_ptr<Handler> handler)
-        : writerequest_msg_(new ShmWriteRequest())
-        , writereply_msg_(new ShmWriteReply())
-        , readrequest_msg_(new ShmReadRequest())
-        , readreply_msg_(new ShmReadReply())
-        , handler_(std::move(handler))
+        : handler_(std::move(handler))
     {
-        VERIFY(not writerequest_mq_uuid_.isNull());
-
-        writerequest_mq_.reset(new ipc::message_queue(ipc::create_only,
-                                                      writerequest_mq_uuid_.str().c_str(),
-                                                      max_write_queue_size,
-                                                      writerequest_size));
-
-        writereply_mq_.reset(new ipc::message_queue(ipc::create_only,
-                                                     writereply_mq_uuid_.str().c_str(),
-                                                     max_write_queue_size,
-                                                     writereply_size));
-
-        readrequest_mq_.reset(new ipc::message_queue(ipc::create_only,
-                                                     readrequest_mq_uuid_.str().c_str(),
-                                                     max_read_queue_size,
-                                                     readrequest_size));
-
-        readreply_mq_.reset(new ipc::message_queue(ipc::create_only,
-                                                   readreply_mq_uuid_.str().c_str(),
-                                                   max_reply_queue_size,
-                                                   readreply_size));
+        VERIFY(not uuid_.isNull());
 
+        // at least 2 queue pairs by default so reads are not stuck behind
+        // writes / flushes, as with the former dedicated read and write threads
         const std::string shm_server_env_var("SHM_SERVER_THREAD_POOL_SIZE");
-        thread_pool_size_ =
-            yt::System::get_env_with_default<int>(shm_server_env_var, 1);
-
-        for (int i = 0; i < thread_pool_size_; i++)
-        {
-            read_group_.create_thread(boost::bind(&ShmServer::handle_reads,
-                                                  this));
-            write_group_.create_thread(boost::bind(&ShmServer::handle_writes,
-                                                  this));
-        }
-    }
-
-    ~ShmServer()
-    {
-        for (int i = 0; i < thread_pool_size_; i++)
-        {
-            writerequest_mq_->send(getStopRequest<ShmWriteRequest>(),
-                                   writerequest_size,
-                                   0);
-        }
-        {
-            unsigned int priority;
-            ipc::message_queue::size_type received_size;
-            ShmWriteReply write_reply_;
-
-            while (writereply_mq_->try_receive(&write_reply_,
-                                               writereply_size,
-                                               received_size,
-                                               priority))
-            {
-                if (not write_reply_.stop)
-                {
-                    LOG_INFO("writereply queue is not empty, client error?");
-                    break;
-                }
-            }
-        }
-
-        for (int i = 0; i < thread_pool_size_; i++)
-        {
-            readrequest_mq_->send(getStopRequest<ShmReadRequest>(),
-                                  readrequest_size,
-                                  0);
-        }
-        {
-            unsigned int priority;
-            ipc::message_queue::size_type received_size;
-            ShmReadReply read_reply_;
-
-            while (readreply_mq_->try_receive(&read_reply_,
-                                              readreply_size,
-                                              received_size,
-                                              priority))
-            {
-                if (not read_reply_.stop)
-                {
-                    LOG_INFO("readreply queue is not empty, client error?");
-                    break;
-                }
-            }
-        }
-
-        write_group_.join_all();
-        read_group_.join_all();
-        writerequest_mq_.reset();
-        writereply_mq_.reset();
-        readrequest_mq_.reset();
-        readreply_mq_.reset();
+        const int nqueues =
+            yt::System::get_env_with_default<int>(shm_server_env_var, 2);
 
-        if (not ipc::message_queue::remove(writerequest_mq_uuid_.str().c_str()))
-        {
-            LOG_INFO("Cannot remove writerequest queue, client still active?");
-        }
-
-        if (not ipc::message_queue::remove(writereply_mq_uuid_.str().c_str()))
-        {
-            LOG_INFO("Cannot remove writereply queue, client still active?");
-        }
+        const std::string spin_env_var("SHM_SERVER_MAX_SPIN_USECS");
+        max_spin_ =
+            std::chrono::microseconds(yt::System::get_env_with_default<uint64_t>(spin_env_var,
+                                                                                  50));
 
-        if (not ipc::message_queue::remove(readrequest_mq_uuid_.str().c_str()))
-        {
-            LOG_INFO("Cannot remove readrequest queue, client still active?");
-        }
+        rings_.reset(new ShmRings(uuid_.str(),
+                                  std::max(1, nqueues)));
 
-        if (not ipc::message_queue::remove(readreply_mq_uuid_.str().c_str()))
+        for (uint32_t i = 0; i < rings_->nqueues(); i++)
         {
-            LOG_INFO("Cannot remove readreply queue, client still active?");
+            group_.create_thread(boost::bind(&ShmServer::handle_queue,
+                                             this,
+                                             i));
         }
     }
 
-    const youtils::UUID&
-    writerequest_uuid()
-    {
-        return writerequest_mq_uuid_;
-    }
-
-    const youtils::UUID&
-    writereply_uuid()
-    {
-        return writereply_mq_uuid_;
-    }
-
-    const youtils::UUID&
-    readrequest_uuid()
+    ~ShmServer()
     {
-        return readrequest_mq_uuid_;
+        rings_->stop();
+        group_.join_all();
+        rings_.reset();
     }
 
     const youtils::UUID&
-    readreply_uuid()
+    uuid() const
     {
-        return readreply_mq_uuid_;
+        return uuid_;
     }
 
     uint64_t
@@ -191,98 +90,87 @@ public:
 private:
     DECLARE_LOGGER("ShmServer");
 
-    template<typename T>
-    static T*
-    getStopRequest()
-    {
-        static std::unique_ptr<T> val(new T);
-        val->stop = true;
-        return val.get();
-    }
+    static constexpr size_t batch_size = 32;
 
     void
-    handle_writes()
+    handle_queue(const uint32_t idx)
     {
-        unsigned int priority;
-        ipc::message_queue::size_type received_size;
-        while (true)
+        ShmQueuePair& q = rings_->queue(idx);
+        ShmAdaptiveSpin spin(max_spin_);
+        // we need to notice a stop request even if the client is gone
+        const struct timespec timeout = { 1, 0 };
+
+        std::array<ShmRequest, batch_size> reqs;
+        std::array<ShmReply, batch_size> replies;
+
+        while (not rings_->stopped())
         {
-            writerequest_mq_->receive(writerequest_msg_.get(),
-                                      writerequest_size,
-                                      received_size,
-                                      priority);
-            VERIFY(received_size == writerequest_size);
-            writereply_msg_->opaque = writerequest_msg_->opaque;
-            if (writerequest_msg_->stop)
+            if (not q.sq.wait_not_empty(spin,
+                                        &timeout))
             {
-                break;
+                continue;
             }
-            else if (writerequest_msg_->size_in_bytes == 0)
+
+            const size_t count = q.sq.pop(reqs.data(),
+                                          reqs.size());
+            for (size_t i = 0; i < count; ++i)
             {
-                writereply_msg_->failed = handler_->flush() ? false : true;
-                writereply_msg_->size_in_bytes = 0;
-                writereply_mq_->send(writereply_msg_.get(),
-                                     writereply_size,
-                                     0);
+                handle_request(reqs[i],
+                               replies[i]);
             }
-            else
+
+            size_t sent = 0;
+            while (sent < count)
             {
-                handler_->write(writerequest_msg_.get(),
-                                writereply_msg_.get());
-                writereply_mq_->send(writereply_msg_.get(),
-                                     writereply_size,
-                                     0);
+                sent += q.cq.push(replies.data() + sent,
+                                  count - sent);
+                if (sent < count and
+                    not q.cq.wait_not_full(spin,
+                                           &timeout) and
+                    rings_->stopped())
+                {
+                    LOG_INFO("completion ring " << idx <<
+                             " is full and we're stopping, client error?");
+                    return;
+                }
             }
         }
     }
 
     void
-    handle_reads()
+    handle_request(const ShmRequest& req,
+                   ShmReply& reply)
     {
-        unsigned int priority;
-        ipc::message_queue::size_type received_size;
-        while (true)
+        switch (req.type)
         {
-            readrequest_mq_->receive(readrequest_msg_.get(),
-                                     readrequest_size,
-                                     received_size,
-                                     priority);
-            VERIFY(received_size == readrequest_size);
-            if (readrequest_msg_->stop)
-            {
-                break;
-            }
-            {
-                readreply_msg_->opaque = readrequest_msg_->opaque;
-                handler_->read(readrequest_msg_.get(),
-                               readreply_msg_.get());
-                readreply_mq_->send(readreply_msg_.get(),
-                                    readreply_size,
-                                    0);
-            }
+        case ShmRequestType::Read:
+            handler_->read(&req,
+                           &reply);
+            break;
+        case ShmRequestType::Write:
+            handler_->write(&req,
+                            &reply);
+            break;
+        case ShmRequestType::Flush:
+            reply.opaque = req.opaque;
+            reply.failed = handler_->flush() ? false : true;
+            reply.size_in_bytes = 0;
+            break;
+        default:
+            LOG_ERROR("unknown request type " << static_cast<uint32_t>(req.type));
+            reply.opaque = req.opaque;
+            reply.failed = true;
+            reply.size_in_bytes = 0;
+            break;
         }
     }
 
-    boost::thread_group read_group_;
-    boost::thread_group write_group_;
-    int thread_pool_size_;
-
-    youtils::UUID writerequest_mq_uuid_;
-    std::unique_ptr<ipc::message_queue> writerequest_mq_;
-
-    youtils::UUID writereply_mq_uuid_;
-    std::unique_ptr<ipc::message_queue> writereply_mq_;
-
-    youtils::UUID readrequest_mq_uuid_;
-    std::unique_ptr<ipc::message_queue> readrequest_mq_;
+    boost::thread_group group_;
+    std::chrono::microseconds max_spin_;
 
-    youtils::UUID readreply_mq_uuid_;
-    std::unique_ptr<ipc::message_queue> readreply_mq_;
+    youtils::UUID uuid_;
+    std::unique_ptr<ShmRings> rings_;
 
-    std::unique_ptr<ShmWriteRequest> writerequest_msg_;
-    std::unique_ptr<ShmWriteReply> writereply_msg_;
-    std::unique_ptr<ShmReadRequest> readrequest_msg_;
-    std::unique_ptr<ShmReadReply> readreply_msg_;
     std::unique_ptr<Handler> handler_;
 };
 
@@ -66,8 +66,8 @@ public:
     }
 
     void
-    write(const ShmWriteRequest* request,
-          ShmWriteReply* reply)
+    write(const ShmRequest* request,
+          ShmReply* reply)
     {
         VERIFY(handle_);
 
@@ -115,8 +115,8 @@ public:
     }
 
     void
-    read(const ShmReadRequest* request,
-         ShmReadReply* reply)
+    read(const ShmRequest* request,
+         ShmReply* reply)
     {
         VERIFY(handle_);
 
@@ -0,0 +1,190 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VFS_STREAM_DETECTOR_H_
+#define VFS_STREAM_DETECTOR_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+#include <sys/types.h>
+
+#include <boost/optional.hpp>
+
+namespace volumedriverfs
+{
+
+// Per handle detection of sequential readers. Up to max_streams interleaved
+// streams (e.g. several threads of a backup job each streaming a part of the
+// same vdisk) are tracked; once a stream was seen advancing a read ahead
+// range is suggested each time it consumed half of what was read ahead so
+// far, with the window doubling up to the given maximum.
+// Requests of the same stream are allowed to arrive slightly out of order
+// as the frontends (FUSE, NFS) process them with several threads.
+class StreamDetector
+{
+public:
+    static constexpr size_t max_streams = 8;
+
+    // Number of requests a stream has to see before read ahead kicks in.
+    static constexpr uint32_t min_hits = 2;
+
+    struct ReadAhead
+    {
+        off_t off;
+        size_t size;
+    };
+
+    StreamDetector()
+        : clock_(0)
+    {}
+
+    ~StreamDetector() = default;
+
+    StreamDetector(const StreamDetector&) = delete;
+
+    StreamDetector&
+    operator=(const StreamDetector&) = delete;
+
+    boost::optional<ReadAhead>
+    observe(const off_t off,
+            const size_t size,
+            const size_t max_window)
+    {
+        if (max_window == 0 or size == 0)
+        {
+            return boost::none;
+        }
+
+        std::lock_guard<decltype(lock_)> g(lock_);
+
+        ++clock_;
+
+        Stream* victim = &streams_[0];
+
+        for (auto& s : streams_)
+        {
+            if (s.window != 0 and matches_(s, off, size))
+            {
+                return advance_(s,
+                                off,
+                                size,
+                                max_window);
+            }
+
+            if (s.last_use < victim->last_use)
+            {
+                victim = &s;
+            }
+        }
+
+        const off_t end = off + size;
+
+        victim->next = end;
+        victim->ra_end = end;
+        victim->window = std::min(max_window,
+                                  4 * size);
+        victim->request_size = size;
+        victim->hits = 1;
+        victim->last_use = clock_;
+
+        return boost::none;
+    }
+
+    size_t
+    active_streams() const
+    {
+        std::lock_guard<decltype(lock_)> g(lock_);
+        return std::count_if(streams_.begin(),
+                             streams_.end(),
+                             [](const Stream& s)
+                             {
+                                 return s.window != 0;
+                             });
+    }
+
+private:
+    struct Stream
+    {
+        off_t next = 0;
+        off_t ra_end = 0;
+        size_t window = 0;
+        size_t request_size = 0;
+        uint32_t hits = 0;
+        uint64_t last_use = 0;
+    };
+
+    mutable std::mutex lock_;
+    std::array<Stream, max_streams> streams_;
+    uint64_t clock_;
+
+    static bool
+    matches_(const Stream& s,
+             const off_t off,
+             const size_t size)
+    {
+        const off_t slack = 4 * std::max(s.request_size,
+                                         size);
+        return off + slack >= s.next and
+            off <= s.next + slack;
+    }
+
+    boost::optional<ReadAhead>
+    advance_(Stream& s,
+             const off_t off,
+             const size_t size,
+             const size_t max_window)
+    {
+        s.next = std::max<off_t>(s.next,
+                                 off + size);
+        s.request_size = size;
+        s.last_use = clock_;
+
+        if (++s.hits < min_hits)
+        {
+            return boost::none;
+        }
+
+        s.ra_end = std::max(s.ra_end,
+                            s.next);
+
+        // not yet consumed half of the read ahead range
+        if (s.ra_end - s.next > static_cast<off_t>(s.window / 2))
+        {
+            return boost::none;
+        }
+
+        s.window = std::min(max_window,
+                            2 * s.window);
+
+        const off_t target = s.next + s.window;
+        if (target <= s.ra_end)
+        {
+            return boost::none;
+        }
+
+        const ReadAhead ra{ s.ra_end,
+                            static_cast<size_t>(target - s.ra_end) };
+        s.ra_end = target;
+
+        return ra;
+    }
+};
+
+}
+
+#endif // !VFS_STREAM_DETECTOR_H_
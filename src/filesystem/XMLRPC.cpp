@@ -896,6 +896,8 @@ VolumeInfo::execute_internal(::XmlRpc::XmlRpcValue& params,
             maybe_focconfig->port : 0;
         volume_info.halted = api::getHalted(vol_id);
         volume_info.footprint = stats.used_clusters * cfg.cluster_mult_ * cfg.lba_size_;
+        volume_info.metadata_cache_pages = stats.max_pages;
+        volume_info.metadata_cache_used_pages = stats.cached_pages;
         volume_info.stored = api::getStored(vol_id);
 
         vd::SharedVolumePtr v(api::getVolumePointer(vol_id));
@@ -1897,6 +1899,20 @@ ListClientConnections::execute_internal(::XmlRpc::XmlRpcValue& /*params*/,
     }
 }
 
+void
+ListMigrationDecisions::execute_internal(::XmlRpc::XmlRpcValue& /*params*/,
+                                         ::XmlRpc::XmlRpcValue& result)
+{
+    result.clear();
+    result.setSize(0);
+
+    int k = 0;
+    for (const auto& d : fs_.object_router().migration_decisions())
+    {
+        result[k++] = XMLRPCStructs::serialize_to_xmlrpc_value(d);
+    }
+}
+
 void
 GetFailOverCacheConfigMode::execute_internal(::XmlRpc::XmlRpcValue& params,
                                              ::XmlRpc::XmlRpcValue& result)
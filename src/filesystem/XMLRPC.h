@@ -486,6 +486,11 @@ REGISTER_XMLRPC(XMLRPCCallTimingRedirect,
                 "ListClientConnections",
                 "List client connections");
 
+REGISTER_XMLRPC(XMLRPCCallTimingRedirect,
+                ListMigrationDecisions,
+                "listMigrationDecisions",
+                "List the most recent auto-migration decisions");
+
 // ================== NOT EXPOSED, NOT TESTED   ==================
 
 REGISTER_XMLRPC(XMLRPCCallTimingLock,
@@ -698,7 +703,7 @@ REGISTER_XMLRPC(XMLRPCCallTimingRedirectLock,
                 "getMetaDataCacheCapacity",
                 "get capacity of the metadata cache (in pages)");
 
-typedef LOKI_TYPELIST_86(
+typedef LOKI_TYPELIST_87(
 // ================== EXPOSED IN XMLRPC CLIENT ===================
                          VolumeCreate,
                          VolumesList,
@@ -765,6 +770,7 @@ typedef LOKI_TYPELIST_86(
                          ScheduleBackendSync,
                          VAAICopy,
                          ListClientConnections,
+                         ListMigrationDecisions,
                          ResizeObject,
                          // ================== NOT EXPOSED, NOT TESTED   ==================
                          GetFailOverMode,
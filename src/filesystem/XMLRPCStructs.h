@@ -104,6 +104,10 @@ struct XMLRPCVolumeInfo
     volumedriver::ClusterCacheHandle cluster_cache_handle =
         volumedriver::ClusterCacheHandle(0);
     boost::optional<volumedriver::ClusterCount> cluster_cache_limit;
+    // current share of the metadata cache (pages), which changes over time
+    // if a node-wide metadata_cache_budget is used
+    uint64_t metadata_cache_pages = 0;
+    uint64_t metadata_cache_used_pages = 0;
 
     bool
     operator==(const XMLRPCVolumeInfo& other) const
@@ -135,7 +139,9 @@ struct XMLRPCVolumeInfo
             EQ(metadata_backend_config) and
             EQ(owner_tag) and
             EQ(cluster_cache_handle) and
-            EQ(cluster_cache_limit);
+            EQ(cluster_cache_limit) and
+            EQ(metadata_cache_pages) and
+            EQ(metadata_cache_used_pages);
 
 #undef EQ
     }
@@ -175,6 +181,12 @@ struct XMLRPCVolumeInfo
             ar & BOOST_SERIALIZATION_NVP(cluster_cache_handle);
             ar & BOOST_SERIALIZATION_NVP(cluster_cache_limit);
         }
+
+        if (version > 2)
+        {
+            ar & BOOST_SERIALIZATION_NVP(metadata_cache_pages);
+            ar & BOOST_SERIALIZATION_NVP(metadata_cache_used_pages);
+        }
     }
 
     static constexpr const char* serialization_name =  "XMLRPCVolumeInfo";
@@ -397,7 +409,7 @@ struct XMLRPCClusterCacheHandleInfo
 
 }
 
-BOOST_CLASS_VERSION(volumedriverfs::XMLRPCVolumeInfo, 2);
+BOOST_CLASS_VERSION(volumedriverfs::XMLRPCVolumeInfo, 3);
 BOOST_CLASS_VERSION(volumedriverfs::XMLRPCStatistics, 2);
 BOOST_CLASS_VERSION(volumedriverfs::XMLRPCSnapshotInfo, 2);
 BOOST_CLASS_VERSION(volumedriverfs::XMLRPCClusterCacheHandleInfo, 1);
@@ -0,0 +1,117 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "AioQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+void
+ovs_aio_queue::submitted(size_t count)
+{
+    std::lock_guard<std::mutex> g(mutex_);
+    inflight_ += count;
+}
+
+void
+ovs_aio_queue::not_submitted(size_t count)
+{
+    std::lock_guard<std::mutex> g(mutex_);
+    inflight_ -= count;
+}
+
+void
+ovs_aio_queue::complete(struct ovs_aiocb *aiocbp,
+                        ssize_t rv,
+                        int err)
+{
+    std::lock_guard<std::mutex> g(mutex_);
+
+    events_.push_back(ovs_aio_event{aiocbp, rv, err});
+    --inflight_;
+
+    if (not signaled_)
+    {
+        evfd_.writefd();
+        signaled_ = true;
+    }
+
+    if (waiters_ != 0 and events_.size() >= wanted_)
+    {
+        cv_.notify_all();
+    }
+}
+
+size_t
+ovs_aio_queue::reap(struct ovs_aio_event *evs,
+                    size_t min_nr,
+                    size_t max_nr,
+                    const struct timespec *timeout)
+{
+    std::unique_lock<std::mutex> u(mutex_);
+
+    auto ready([&]() -> bool
+               {
+                   return events_.size() >= min_nr;
+               });
+
+    if (not ready())
+    {
+        wanted_ = waiters_ == 0 ? min_nr : std::min(wanted_, min_nr);
+        ++waiters_;
+
+        if (timeout)
+        {
+            cv_.wait_for(u,
+                         std::chrono::seconds(timeout->tv_sec) +
+                         std::chrono::nanoseconds(timeout->tv_nsec),
+                         ready);
+        }
+        else
+        {
+            cv_.wait(u,
+                     ready);
+        }
+
+        if (--waiters_ == 0)
+        {
+            wanted_ = std::numeric_limits<size_t>::max();
+        }
+    }
+
+    const size_t count = std::min(max_nr,
+                                  events_.size());
+    std::copy(events_.begin(),
+              events_.begin() + count,
+              evs);
+    events_.erase(events_.begin(),
+                  events_.begin() + count);
+
+    if (events_.empty() and signaled_)
+    {
+        evfd_.readfd();
+        signaled_ = false;
+    }
+
+    return count;
+}
+
+bool
+ovs_aio_queue::idle() const
+{
+    std::lock_guard<std::mutex> g(mutex_);
+    return inflight_ == 0;
+}
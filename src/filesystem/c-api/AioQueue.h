@@ -0,0 +1,94 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef __AIO_QUEUE_H
+#define __AIO_QUEUE_H
+
+#include "volumedriver.h"
+#include "../NetworkXioCommon.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Completion queue of ovs_aio_submitv'd requests. Completions are appended
+// by the transports' reaper threads and handed out in batches by
+// ovs_aio_getevents. The eventfd is only written on the transition from
+// empty to non-empty and reset once the queue was drained, i.e. there's one
+// write per batch of completions rather than one per request.
+struct ovs_aio_queue
+{
+    explicit ovs_aio_queue(ovs_ctx_t *ctx)
+    : ctx_(ctx)
+    {}
+
+    ~ovs_aio_queue() = default;
+
+    ovs_aio_queue(const ovs_aio_queue&) = delete;
+    ovs_aio_queue& operator=(const ovs_aio_queue&) = delete;
+
+    ovs_ctx_t*
+    ctx() const
+    {
+        return ctx_;
+    }
+
+    int
+    eventfd() const
+    {
+        return evfd_;
+    }
+
+    // Submission side: account for requests before handing them to the
+    // transport (they might complete before the submitter returns) and
+    // for the ones the transport did not take after all.
+    void
+    submitted(size_t count);
+
+    void
+    not_submitted(size_t count);
+
+    // Reaper side.
+    void
+    complete(struct ovs_aiocb *aiocbp,
+             ssize_t rv,
+             int err);
+
+    // Returns the number of events copied to evs - less than min_nr on
+    // timeout.
+    size_t
+    reap(struct ovs_aio_event *evs,
+         size_t min_nr,
+         size_t max_nr,
+         const struct timespec *timeout);
+
+    // Returns false if there are still requests in flight.
+    bool
+    idle() const;
+
+private:
+    ovs_ctx_t *ctx_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<ovs_aio_event> events_;
+    size_t inflight_ = 0;
+    // number of threads in reap() and the smallest min_nr they wait for
+    size_t waiters_ = 0;
+    size_t wanted_ = 0;
+    bool signaled_ = false;
+    volumedriverfs::EventFD evfd_;
+};
+
+#endif //__AIO_QUEUE_H
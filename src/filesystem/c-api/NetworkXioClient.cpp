@@ -21,7 +21,10 @@
 #include <future>
 #include <functional>
 #include <atomic>
+#include <memory>
+#include <stdexcept>
 #include <system_error>
+#include <vector>
 
 #define POLLING_TIME_USEC   20
 
@@ -352,6 +355,17 @@ NetworkXioClient::push_request(xio_msg_s *req)
     inflight_reqs.push(req);
 }
 
+void
+NetworkXioClient::push_requests(xio_msg_s **reqs,
+                                const size_t count)
+{
+    boost::lock_guard<decltype(inflight_lock)> lock_(inflight_lock);
+    for (size_t i = 0; i < count; ++i)
+    {
+        inflight_reqs.push(reqs[i]);
+    }
+}
+
 void
 NetworkXioClient::xstop_loop()
 {
@@ -493,12 +507,32 @@ NetworkXioClient::req_queue_wait_until(xio_msg_s *xmsg)
     }
 }
 
+size_t
+NetworkXioClient::req_queue_reserve(const size_t count)
+{
+    using namespace std::chrono_literals;
+    std::unique_lock<std::mutex> l_(req_queue_lock);
+    if (not req_queue_cond.wait_until(l_,
+                                      std::chrono::steady_clock::now() +
+                                      60s,
+                                      [&]{return nr_req_queue > 0;}))
+    {
+        throw XioClientQueueIsBusyException("request queue is busy");
+    }
+    const size_t reserved = std::min<int64_t>(count,
+                                              nr_req_queue);
+    nr_req_queue -= reserved;
+    return reserved;
+}
+
 void
 NetworkXioClient::req_queue_release()
 {
     std::lock_guard<std::mutex> l_(req_queue_lock);
     nr_req_queue++;
-    req_queue_cond.notify_one();
+    // single requests and batches wait for different conditions, so the one
+    // woken up by notify_one() might not be the one that can proceed
+    req_queue_cond.notify_all();
 }
 
 void
@@ -517,11 +551,11 @@ NetworkXioClient::xio_send_open_request(const std::string& volname,
     xstop_loop();
 }
 
-void
-NetworkXioClient::xio_send_read_request(void *buf,
-                                        const uint64_t size_in_bytes,
-                                        const uint64_t offset_in_bytes,
-                                        const void *opaque)
+NetworkXioClient::xio_msg_s*
+NetworkXioClient::xio_prepare_read_msg(void *buf,
+                                       const uint64_t size_in_bytes,
+                                       const uint64_t offset_in_bytes,
+                                       const void *opaque)
 {
     xio_msg_s *xmsg = new xio_msg_s;
     xmsg->opaque = opaque;
@@ -535,16 +569,14 @@ NetworkXioClient::xio_send_read_request(void *buf,
     vmsg_sglist_set_nents(&xmsg->xreq.in, 1);
     xmsg->xreq.in.data_iov.sglist[0].iov_base = buf;
     xmsg->xreq.in.data_iov.sglist[0].iov_len = size_in_bytes;
-    req_queue_wait_until(xmsg);
-    push_request(xmsg);
-    xstop_loop();
+    return xmsg;
 }
 
-void
-NetworkXioClient::xio_send_write_request(const void *buf,
-                                         const uint64_t size_in_bytes,
-                                         const uint64_t offset_in_bytes,
-                                         const void *opaque)
+NetworkXioClient::xio_msg_s*
+NetworkXioClient::xio_prepare_write_msg(const void *buf,
+                                        const uint64_t size_in_bytes,
+                                        const uint64_t offset_in_bytes,
+                                        const void *opaque)
 {
     xio_msg_s *xmsg = new xio_msg_s;
     xmsg->opaque = opaque;
@@ -558,13 +590,11 @@ NetworkXioClient::xio_send_write_request(const void *buf,
     vmsg_sglist_set_nents(&xmsg->xreq.out, 1);
     xmsg->xreq.out.data_iov.sglist[0].iov_base = const_cast<void*>(buf);
     xmsg->xreq.out.data_iov.sglist[0].iov_len = size_in_bytes;
-    req_queue_wait_until(xmsg);
-    push_request(xmsg);
-    xstop_loop();
+    return xmsg;
 }
 
-void
-NetworkXioClient::xio_send_flush_request(const void *opaque)
+NetworkXioClient::xio_msg_s*
+NetworkXioClient::xio_prepare_flush_msg(const void *opaque)
 {
     xio_msg_s *xmsg = new xio_msg_s;
     xmsg->opaque = opaque;
@@ -572,11 +602,119 @@ NetworkXioClient::xio_send_flush_request(const void *opaque)
     xmsg->msg.opaque((uintptr_t)xmsg);
 
     xio_msg_prepare(xmsg);
+    return xmsg;
+}
+
+void
+NetworkXioClient::xio_send_read_request(void *buf,
+                                        const uint64_t size_in_bytes,
+                                        const uint64_t offset_in_bytes,
+                                        const void *opaque)
+{
+    xio_msg_s *xmsg = xio_prepare_read_msg(buf,
+                                           size_in_bytes,
+                                           offset_in_bytes,
+                                           opaque);
+    req_queue_wait_until(xmsg);
+    push_request(xmsg);
+    xstop_loop();
+}
+
+void
+NetworkXioClient::xio_send_write_request(const void *buf,
+                                         const uint64_t size_in_bytes,
+                                         const uint64_t offset_in_bytes,
+                                         const void *opaque)
+{
+    xio_msg_s *xmsg = xio_prepare_write_msg(buf,
+                                            size_in_bytes,
+                                            offset_in_bytes,
+                                            opaque);
     req_queue_wait_until(xmsg);
     push_request(xmsg);
     xstop_loop();
 }
 
+void
+NetworkXioClient::xio_send_flush_request(const void *opaque)
+{
+    xio_msg_s *xmsg = xio_prepare_flush_msg(opaque);
+    req_queue_wait_until(xmsg);
+    push_request(xmsg);
+    xstop_loop();
+}
+
+size_t
+NetworkXioClient::xio_send_requests(ovs_aio_request **requests,
+                                    const size_t count)
+{
+    std::vector<std::unique_ptr<xio_msg_s>> xmsgs;
+    xmsgs.reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ovs_aio_request *request = requests[i];
+        struct ovs_aiocb *aiocbp = request->get_aio();
+
+        switch (request->_op)
+        {
+        case RequestOp::Read:
+            xmsgs.emplace_back(xio_prepare_read_msg(aiocbp->aio_buf,
+                                                    aiocbp->aio_nbytes,
+                                                    aiocbp->aio_offset,
+                                                    request));
+            break;
+        case RequestOp::Write:
+            xmsgs.emplace_back(xio_prepare_write_msg(aiocbp->aio_buf,
+                                                     aiocbp->aio_nbytes,
+                                                     aiocbp->aio_offset,
+                                                     request));
+            break;
+        case RequestOp::Flush:
+        case RequestOp::AsyncFlush:
+            xmsgs.emplace_back(xio_prepare_flush_msg(request));
+            break;
+        default:
+            throw std::invalid_argument("unsupported request op");
+        }
+    }
+
+    std::vector<xio_msg_s*> batch;
+    batch.reserve(count);
+    size_t sent = 0;
+
+    while (sent < count)
+    {
+        size_t reserved;
+        try
+        {
+            reserved = req_queue_reserve(count - sent);
+        }
+        catch (const XioClientQueueIsBusyException&)
+        {
+            if (sent == 0)
+            {
+                throw;
+            }
+            errno = EBUSY;
+            break;
+        }
+
+        batch.clear();
+        for (size_t i = sent; i < sent + reserved; ++i)
+        {
+            batch.push_back(xmsgs[i].release());
+        }
+
+        push_requests(batch.data(),
+                      batch.size());
+        xstop_loop();
+        sent += reserved;
+    }
+
+    return sent;
+}
+
 void
 NetworkXioClient::xio_send_close_request(const void *opaque)
 {
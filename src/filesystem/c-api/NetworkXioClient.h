@@ -90,6 +90,14 @@ public:
     void
     xio_send_flush_request(const void *opaque);
 
+    // Submits a batch of read / write / flush requests with one queue
+    // depth reservation, one push to the inflight queue and one wakeup of
+    // the event loop (unless the queue depth forces splitting it up).
+    // Returns the number of requests submitted, throws if none could be.
+    size_t
+    xio_send_requests(ovs_aio_request **requests,
+                      const size_t count);
+
     int
     allocate(xio_reg_mem *mem,
              const uint64_t size);
@@ -127,6 +135,10 @@ public:
     void
     push_request(xio_msg_s *req);
 
+    void
+    push_requests(xio_msg_s **reqs,
+                  const size_t count);
+
     void
     xstop_loop();
 
@@ -231,6 +243,9 @@ private:
     void
     req_queue_wait_until(xio_msg_s *xmsg);
 
+    size_t
+    req_queue_reserve(const size_t count);
+
     void
     req_queue_release();
 
@@ -270,6 +285,21 @@ private:
     static void
     xio_msg_prepare(xio_msg_s *xmsg);
 
+    static xio_msg_s*
+    xio_prepare_read_msg(void *buf,
+                         const uint64_t size_in_bytes,
+                         const uint64_t offset_in_bytes,
+                         const void *opaque);
+
+    static xio_msg_s*
+    xio_prepare_write_msg(const void *buf,
+                          const uint64_t size_in_bytes,
+                          const uint64_t offset_in_bytes,
+                          const void *opaque);
+
+    static xio_msg_s*
+    xio_prepare_flush_msg(const void *opaque);
+
     static void
     handle_list_volumes(xio_ctl_s *xctl,
                         xio_iovec_ex *sglist,
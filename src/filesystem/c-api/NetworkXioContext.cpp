@@ -516,6 +516,31 @@ NetworkXioContext::send_flush_request(ovs_aio_request *request)
     return r;
 }
 
+int
+NetworkXioContext::send_requests(ovs_aio_request **requests,
+                                 size_t count)
+{
+    int r = 0;
+    try
+    {
+        r = net_client_->xio_send_requests(requests,
+                                           count);
+    }
+    catch (const volumedriverfs::XioClientQueueIsBusyException&)
+    {
+        errno = EBUSY;  r = -1;
+    }
+    catch (const std::bad_alloc&)
+    {
+        errno = ENOMEM; r = -1;
+    }
+    catch (...)
+    {
+        errno = EIO; r = -1;
+    }
+    return r;
+}
+
 int
 NetworkXioContext::stat_volume(struct stat *st)
 {
@@ -95,6 +95,10 @@ struct NetworkXioContext : public ovs_context_t
     int
     send_flush_request(ovs_aio_request *request);
 
+    int
+    send_requests(ovs_aio_request **requests,
+                  size_t count);
+
     int
     stat_volume(struct stat *st);
 
@@ -0,0 +1,225 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "ReadCache.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+constexpr size_t ReadCache::cluster_size;
+
+ReadCache::ReadCache(uint64_t capacity_bytes)
+    : capacity_(capacity_bytes / cluster_size)
+    , generation_(0)
+    , writes_in_flight_(0)
+    , hits_(0)
+    , misses_(0)
+{}
+
+bool
+ReadCache::read(void *buf,
+                size_t size,
+                off_t off)
+{
+    const uint64_t first = off / cluster_size;
+    const uint64_t last = (off + size - 1) / cluster_size;
+
+    std::lock_guard<std::mutex> g(lock_);
+
+    for (uint64_t c = first; c <= last; ++c)
+    {
+        if (map_.find(c) == map_.end())
+        {
+            ++misses_;
+            return false;
+        }
+    }
+
+    uint8_t *dst = static_cast<uint8_t*>(buf);
+    for (uint64_t c = first; c <= last; ++c)
+    {
+        auto it = map_[c];
+        const off_t start = std::max<off_t>(off,
+                                            c * cluster_size);
+        const off_t end = std::min<off_t>(off + size,
+                                          (c + 1) * cluster_size);
+        memcpy(dst + (start - off),
+               it->data.get() + (start - c * cluster_size),
+               end - start);
+        lru_.splice(lru_.begin(),
+                    lru_,
+                    it);
+    }
+
+    ++hits_;
+    return true;
+}
+
+uint64_t
+ReadCache::generation() const
+{
+    std::lock_guard<std::mutex> g(lock_);
+    return generation_;
+}
+
+void
+ReadCache::insert(uint64_t gen,
+                  const void *buf,
+                  size_t size,
+                  off_t off)
+{
+    std::lock_guard<std::mutex> g(lock_);
+
+    if (gen == generation_ and writes_in_flight_ == 0)
+    {
+        insert_locked_(buf,
+                       size,
+                       off);
+    }
+}
+
+void
+ReadCache::insert_locked_(const void *buf,
+                          size_t size,
+                          off_t off)
+{
+    const uint64_t first = (off + cluster_size - 1) / cluster_size;
+    const uint64_t end = (off + size) / cluster_size;
+    const uint8_t *src = static_cast<const uint8_t*>(buf);
+
+    if (capacity_ == 0)
+    {
+        return;
+    }
+
+    for (uint64_t c = first; c < end; ++c)
+    {
+        const uint8_t *data = src + (c * cluster_size - off);
+
+        auto it = map_.find(c);
+        if (it != map_.end())
+        {
+            memcpy(it->second->data.get(),
+                   data,
+                   cluster_size);
+            lru_.splice(lru_.begin(),
+                        lru_,
+                        it->second);
+            continue;
+        }
+
+        if (map_.size() < capacity_)
+        {
+            lru_.push_front(Entry{c,
+                                  std::make_unique<uint8_t[]>(cluster_size)});
+        }
+        else
+        {
+            // recycle the least recently used entry
+            map_.erase(lru_.back().cluster);
+            lru_.splice(lru_.begin(),
+                        lru_,
+                        std::prev(lru_.end()));
+            lru_.front().cluster = c;
+        }
+
+        memcpy(lru_.front().data.get(),
+               data,
+               cluster_size);
+        map_.emplace(c,
+                     lru_.begin());
+    }
+}
+
+uint64_t
+ReadCache::begin_write(size_t size,
+                       off_t off)
+{
+    const uint64_t first = off / cluster_size;
+    const uint64_t last = (off + size - 1) / cluster_size;
+
+    std::lock_guard<std::mutex> g(lock_);
+
+    if (map_.size() < last - first + 1)
+    {
+        for (auto it = lru_.begin(); it != lru_.end();)
+        {
+            if (it->cluster >= first and it->cluster <= last)
+            {
+                map_.erase(it->cluster);
+                it = lru_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    else
+    {
+        for (uint64_t c = first; c <= last; ++c)
+        {
+            auto it = map_.find(c);
+            if (it != map_.end())
+            {
+                lru_.erase(it->second);
+                map_.erase(it);
+            }
+        }
+    }
+
+    ++writes_in_flight_;
+    return ++generation_;
+}
+
+void
+ReadCache::end_write(uint64_t gen,
+                     const void *buf,
+                     size_t size,
+                     off_t off)
+{
+    std::lock_guard<std::mutex> g(lock_);
+
+    --writes_in_flight_;
+
+    if (buf and gen == generation_ and writes_in_flight_ == 0)
+    {
+        insert_locked_(buf,
+                       size,
+                       off);
+    }
+
+    ++generation_;
+}
+
+void
+ReadCache::drop()
+{
+    std::lock_guard<std::mutex> g(lock_);
+    map_.clear();
+    lru_.clear();
+    ++generation_;
+}
+
+void
+ReadCache::stats(struct ovs_read_cache_stats& st) const
+{
+    std::lock_guard<std::mutex> g(lock_);
+    st.hits = hits_;
+    st.misses = misses_;
+    st.size = map_.size() * cluster_size;
+    st.capacity = capacity_ * cluster_size;
+}
@@ -0,0 +1,107 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef __READ_CACHE_H
+#define __READ_CACHE_H
+
+#include "volumedriver.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Optional process local cache of the volume's clusters, filled by the
+// synchronous reads of a context. Writes through the context invalidate the
+// affected clusters when they're submitted and update the fully covered ones
+// once they succeeded (write-through). Data is only cached if no write was
+// in flight while it was read / written: a generation counter is bumped on
+// every write submission and completion, and insertions are refused while
+// writes are in flight or if the generation changed in the mean time.
+class ReadCache
+{
+public:
+    static constexpr size_t cluster_size = 4096;
+
+    explicit ReadCache(uint64_t capacity_bytes);
+
+    ~ReadCache() = default;
+
+    ReadCache(const ReadCache&) = delete;
+    ReadCache& operator=(const ReadCache&) = delete;
+
+    // Copies the range to buf and returns true if all of its clusters are
+    // cached.
+    bool
+    read(void *buf,
+         size_t size,
+         off_t off);
+
+    uint64_t
+    generation() const;
+
+    // Caches the clusters fully covered by the range read after gen was
+    // obtained, unless a write interfered.
+    void
+    insert(uint64_t gen,
+           const void *buf,
+           size_t size,
+           off_t off);
+
+    // A write of the range is about to be submitted - returns the
+    // generation to pass to end_write.
+    uint64_t
+    begin_write(size_t size,
+                off_t off);
+
+    // The write finished - buf is nullptr if it failed.
+    void
+    end_write(uint64_t gen,
+              const void *buf,
+              size_t size,
+              off_t off);
+
+    void
+    drop();
+
+    void
+    stats(struct ovs_read_cache_stats& st) const;
+
+private:
+    struct Entry
+    {
+        uint64_t cluster;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    typedef std::list<Entry> LRU;
+
+    void
+    insert_locked_(const void *buf,
+                   size_t size,
+                   off_t off);
+
+    const size_t capacity_;
+    mutable std::mutex lock_;
+    // most recently used first
+    LRU lru_;
+    std::unordered_map<uint64_t, LRU::iterator> map_;
+    uint64_t generation_;
+    uint64_t writes_in_flight_;
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+#endif //__READ_CACHE_H
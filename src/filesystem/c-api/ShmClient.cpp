@@ -19,6 +19,7 @@
 #include <youtils/Assert.h>
 #include <youtils/UUID.h>
 #include <youtils/OrbHelper.h>
+#include <youtils/System.h>
 
 namespace volumedriverfs
 {
@@ -83,6 +84,9 @@ ShmClient::ShmClient(const std::string& volume_name,
     : volume_name_(volume_name)
     , shm_segment_(new ipc::managed_shared_memory(ipc::open_only,
                                                   ShmSegmentDetails::Name()))
+    , max_spin_(yt::System::get_env_with_default<uint64_t>("LIBOVSVOLUMEDRIVER_MAX_SPIN_USECS",
+                                                           50))
+    , next_queue_(0)
 {
     CORBA::Object_var obj = orb_helper().getObjectReference(vd_context_name,
                                                             vd_context_kind,
@@ -98,20 +102,22 @@ ShmClient::ShmClient(const std::string& volume_name,
 
     create_result.reset(volumefactory_ref_->create_shm_interface(createArguments));
 
-    assert(youtils::UUID::isUUIDString(create_result->writerequest_uuid));
-    assert(youtils::UUID::isUUIDString(create_result->writereply_uuid));
-    assert(youtils::UUID::isUUIDString(create_result->readrequest_uuid));
-    assert(youtils::UUID::isUUIDString(create_result->readreply_uuid));
-
-    writerequest_mq_.reset(new ipc::message_queue(ipc::open_only,
-                                                  create_result->writerequest_uuid));
-    writereply_mq_.reset(new ipc::message_queue(ipc::open_only,
-                                                create_result->writereply_uuid));
-    readrequest_mq_.reset(new ipc::message_queue(ipc::open_only,
-                                                 create_result->readrequest_uuid));
-    readreply_mq_.reset(new ipc::message_queue(ipc::open_only,
-                                               create_result->readreply_uuid));
-    key_ = create_result->writerequest_uuid;
+    if (create_result->protocol_version != shm_protocol_version)
+    {
+        throw std::runtime_error("shm protocol version mismatch");
+    }
+
+    assert(youtils::UUID::isUUIDString(create_result->ring_uuid));
+
+    rings_.reset(new ShmRings(std::string(create_result->ring_uuid.in())));
+    sq_locks_.reset(new std::mutex[rings_->nqueues()]);
+    cq_spins_.reserve(rings_->nqueues());
+    for (uint32_t i = 0; i < rings_->nqueues(); ++i)
+    {
+        cq_spins_.emplace_back(max_spin_);
+    }
+
+    key_ = create_result->ring_uuid;
 }
 
 ShmClient::~ShmClient()
@@ -168,136 +174,61 @@ ShmClient::get_handle_from_address(void *shptr)
     return shm_segment_->get_handle_from_address(shptr);
 }
 
-int
-ShmClient::send_write_request(const void *buf,
-                              const uint64_t size_in_bytes,
-                              const uint64_t offset_in_bytes,
-                              const void *opaque)
+size_t
+ShmClient::send_requests(const ShmRequest* reqs,
+                         const size_t count)
 {
-    ShmWriteRequest writerequest_;
-    writerequest_.size_in_bytes = size_in_bytes;
-    writerequest_.offset_in_bytes = offset_in_bytes;
-    writerequest_.handle = shm_segment_->get_handle_from_address(buf);
-    writerequest_.opaque = reinterpret_cast<uintptr_t>(opaque);
+    const uint32_t idx = next_queue_++ % rings_->nqueues();
+    ShmQueuePair& q = rings_->queue(idx);
+    const struct timespec timeout = { 1, 0 };
+    size_t sent = 0;
 
-    try
-    {
-        writerequest_mq_->send(&writerequest_,
-                               writerequest_size,
-                               0);
-    }
-    catch (...)
-    {
-        errno = EIO;
-        return -1;
-    }
-    return 0;
-}
-
-int
-ShmClient::timed_send_write_request(const void *buf,
-                                    const uint64_t size_in_bytes,
-                                    const uint64_t offset_in_bytes,
-                                    const void *opaque,
-                                    const struct timespec* timeout)
-{
-    ShmWriteRequest writerequest_;
-    writerequest_.size_in_bytes = size_in_bytes;
-    writerequest_.offset_in_bytes = offset_in_bytes;
-    writerequest_.handle = shm_segment_->get_handle_from_address(buf);
-    writerequest_.opaque = reinterpret_cast<uintptr_t>(opaque);
-    boost::posix_time::time_duration delay(boost::posix_time::seconds(timeout->tv_sec));
-    boost::posix_time::ptime ptimeout =
-        boost::posix_time::ptime(boost::posix_time::second_clock::universal_time());
-    ptimeout += delay;
+    std::lock_guard<std::mutex> g(sq_locks_[idx]);
 
-    try
+    while (sent < count)
     {
-        int ret = writerequest_mq_->timed_send(&writerequest_,
-                                               writerequest_size,
-                                               0,
-                                               ptimeout);
-        if (not ret)
+        const size_t n = q.sq.push(reqs + sent,
+                                   count - sent);
+        sent += n;
+
+        if (n == 0)
         {
-            errno = ETIMEDOUT;
-            return -1;
+            if (rings_->stopped())
+            {
+                errno = EIO;
+                break;
+            }
+
+            ShmAdaptiveSpin spin(max_spin_);
+            q.sq.wait_not_full(spin,
+                               &timeout);
         }
     }
-    catch (...)
-    {
-        errno = EIO;
-        return -1;
-    }
-    return 0;
+
+    return sent;
 }
 
-bool
-ShmClient::receive_write_reply(size_t& size_in_bytes,
-                               void **opaque)
+int
+ShmClient::send_request_(const ShmRequest& req)
 {
-    ShmWriteReply writereply_;
-    unsigned int priority;
-    ipc::message_queue::size_type received_size;
-
-    try
-    {
-        writereply_mq_->receive(&writereply_,
-                                writereply_size,
-                                received_size,
-                                priority);
-        assert(received_size == writereply_size);
-        *opaque = reinterpret_cast<void*>(writereply_.opaque);
-    }
-    catch (...)
-    {
-        *opaque = NULL;
-        errno = EIO;
-        return true;
-    }
-    size_in_bytes = writereply_.size_in_bytes;
-    return writereply_.failed;
+    return send_requests(&req,
+                         1) == 1 ? 0 : -1;
 }
 
-bool
-ShmClient::timed_receive_write_reply(size_t& size_in_bytes,
-                                     void **opaque,
-                                     const struct timespec* timeout)
+int
+ShmClient::send_write_request(const void *buf,
+                              const uint64_t size_in_bytes,
+                              const uint64_t offset_in_bytes,
+                              const void *opaque)
 {
-    ShmWriteReply writereply_;
-    unsigned int priority;
-    ipc::message_queue::size_type received_size;
-    boost::posix_time::time_duration delay(boost::posix_time::seconds(timeout->tv_sec));
-    boost::posix_time::ptime ptimeout =
-        boost::posix_time::ptime(boost::posix_time::second_clock::universal_time());
-    ptimeout += delay;
-
-    try
-    {
-        int ret = writereply_mq_->timed_receive(&writereply_,
-                                                writereply_size,
-                                                received_size,
-                                                priority,
-                                                ptimeout);
-        if (ret)
-        {
-            assert(received_size == writereply_size);
-            *opaque = reinterpret_cast<void*>(writereply_.opaque);
-        }
-        else
-        {
-            *opaque = NULL;
-            errno = ETIMEDOUT;
-            return true;
-        }
-    }
-    catch (...)
-    {
-        *opaque = NULL;
-        errno = EIO;
-        return true;
-    }
-    size_in_bytes = writereply_.size_in_bytes;
-    return writereply_.failed;
+    ShmRequest req;
+    req.type = ShmRequestType::Write;
+    req.size_in_bytes = size_in_bytes;
+    req.offset_in_bytes = offset_in_bytes;
+    req.handle = shm_segment_->get_handle_from_address(buf);
+    req.opaque = reinterpret_cast<uintptr_t>(opaque);
+
+    return send_request_(req);
 }
 
 int
@@ -306,165 +237,54 @@ ShmClient::send_read_request(const void *buf,
                              const uint64_t offset_in_bytes,
                              const void *opaque)
 {
-    ShmReadRequest readrequest_;
-    readrequest_.size_in_bytes = size_in_bytes;
-    readrequest_.offset_in_bytes = offset_in_bytes;
-    readrequest_.handle = shm_segment_->get_handle_from_address(buf);
-    readrequest_.opaque = reinterpret_cast<uintptr_t>(opaque);
-
-    try
-    {
-        readrequest_mq_->send(&readrequest_,
-                              readrequest_size,
-                              0);
-    }
-    catch (...)
-    {
-        errno = EIO;
-        return -1;
-    }
-    return 0;
+    ShmRequest req;
+    req.type = ShmRequestType::Read;
+    req.size_in_bytes = size_in_bytes;
+    req.offset_in_bytes = offset_in_bytes;
+    req.handle = shm_segment_->get_handle_from_address(buf);
+    req.opaque = reinterpret_cast<uintptr_t>(opaque);
+
+    return send_request_(req);
 }
 
 int
-ShmClient::timed_send_read_request(const void *buf,
-                                   const uint64_t size_in_bytes,
-                                   const uint64_t offset_in_bytes,
-                                   const void *opaque,
-                                   const struct timespec* timeout)
+ShmClient::send_flush_request(const void *opaque)
 {
-    ShmReadRequest readrequest_;
-    readrequest_.size_in_bytes = size_in_bytes;
-    readrequest_.offset_in_bytes = offset_in_bytes;
-    readrequest_.handle = shm_segment_->get_handle_from_address(buf);
-    readrequest_.opaque = reinterpret_cast<uintptr_t>(opaque);
-    boost::posix_time::time_duration delay(boost::posix_time::seconds(timeout->tv_sec));
-    boost::posix_time::ptime ptimeout =
-        boost::posix_time::ptime(boost::posix_time::second_clock::universal_time());
-    ptimeout += delay;
+    ShmRequest req;
+    req.type = ShmRequestType::Flush;
+    req.opaque = reinterpret_cast<uintptr_t>(opaque);
 
-    try
-    {
-        int ret = readrequest_mq_->timed_send(&readrequest_,
-                                              readrequest_size,
-                                              0,
-                                              ptimeout);
-        if (not ret)
-        {
-            errno = ETIMEDOUT;
-            return -1;
-        }
-    }
-    catch (...)
-    {
-        errno = EIO;
-        return -1;
-    }
-    return 0;
+    return send_request_(req);
 }
 
-bool
-ShmClient::receive_read_reply(size_t& size_in_bytes,
-                              void **opaque)
+size_t
+ShmClient::timed_receive_replies(const uint32_t idx,
+                                 ShmReply* replies,
+                                 const size_t max,
+                                 const struct timespec* timeout)
 {
-    ShmReadReply readreply_;
-    unsigned int priority;
-    ipc::message_queue::size_type received_size;
-
-    try
+    assert(idx < rings_->nqueues());
+    ShmQueuePair& q = rings_->queue(idx);
+
+    size_t count = q.cq.pop(replies,
+                            max);
+    if (count == 0 and
+        q.cq.wait_not_empty(cq_spins_[idx],
+                            timeout))
     {
-        readreply_mq_->receive(&readreply_,
-                               readreply_size,
-                               received_size,
-                               priority);
-        assert(received_size == readreply_size);
-        *opaque = reinterpret_cast<void*>(readreply_.opaque);
+        count = q.cq.pop(replies,
+                         max);
     }
-    catch (...)
-    {
-        *opaque = NULL;
-        errno = EIO;
-        return true;
-    }
-    size_in_bytes = readreply_.size_in_bytes;
-    return readreply_.failed;
-}
 
-bool
-ShmClient::timed_receive_read_reply(size_t& size_in_bytes,
-                                    void **opaque,
-                                    const struct timespec* timeout)
-{
-    ShmReadReply readreply_;
-    unsigned int priority;
-    ipc::message_queue::size_type received_size;
-    boost::posix_time::time_duration delay(boost::posix_time::seconds(timeout->tv_sec));
-    boost::posix_time::ptime ptimeout =
-        boost::posix_time::ptime(boost::posix_time::second_clock::universal_time());
-    ptimeout += delay;
-
-    try
-    {
-        int ret = readreply_mq_->timed_receive(&readreply_,
-                                               readreply_size,
-                                               received_size,
-                                               priority,
-                                               ptimeout);
-        if (ret)
-        {
-            assert(received_size == readreply_size);
-            *opaque = reinterpret_cast<void*>(readreply_.opaque);
-        }
-        else
-        {
-            *opaque = NULL;
-            errno = ETIMEDOUT;
-            return true;
-        }
-    }
-    catch (...)
-    {
-        *opaque = NULL;
-        errno = EIO;
-        return true;
-    }
-    size_in_bytes = readreply_.size_in_bytes;
-    return readreply_.failed;
+    return count;
 }
 
 void
-ShmClient::stop_reply_queues(int n)
+ShmClient::wake_reapers()
 {
-    ShmReadReply readreply_;
-    readreply_.opaque = 0;
-    readreply_.stop = true;
-
-    for (int i = 0; i < n; i++)
-    {
-        try
-        {
-            readreply_mq_->send(&readreply_,
-                                readreply_size,
-                                0);
-        }
-        catch (...)
-        {}
-    }
-
-    ShmWriteReply writereply_;
-    writereply_.opaque = 0;
-    writereply_.stop = true;
-
-    for (int i = 0; i < n; i++)
+    for (uint32_t i = 0; i < rings_->nqueues(); ++i)
     {
-        try
-        {
-            writereply_mq_->send(&writereply_,
-                                 writereply_size,
-                                 0);
-        }
-        catch (...)
-        {}
+        rings_->queue(i).cq.wake_all();
     }
 }
 
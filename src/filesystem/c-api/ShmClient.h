@@ -19,7 +19,11 @@
 #include "../ShmProtocol.h"
 #include "../ShmIdlInterface.h"
 
-#include <boost/interprocess/ipc/message_queue.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
 #include <boost/interprocess/managed_shared_memory.hpp>
 #include <boost/interprocess/errors.hpp>
 #include <youtils/Logging.h>
@@ -53,43 +57,40 @@ public:
                       const void *opaque);
 
     int
-    timed_send_read_request(const void *buf,
-                            const uint64_t size_in_bytes,
-                            const uint64_t offset_in_bytes,
-                            const void *opaque,
-                            const struct timespec* timeout);
-
-    bool
-    receive_read_reply(size_t& size_in_bytes,
-                       void **opaque);
-
-    bool
-    timed_receive_read_reply(size_t& size_in_bytes,
-                             void **opaque,
-                             const struct timespec* timeout);
-
-    int send_write_request(const void* buf,
-                           const uint64_t size_in_bytes,
-                           const uint64_t offset_in_bytes,
-                           const void *opaque);
-
-    int timed_send_write_request(const void* buf,
-                                 const uint64_t size_in_bytes,
-                                 const uint64_t offset_in_bytes,
-                                 const void *opaque,
-                                 const struct timespec* timeout);
-
-    bool
-    receive_write_reply(size_t& size_in_bytes,
-                        void **opaque);
-
-    bool
-    timed_receive_write_reply(size_t& size_in_bytes,
-                              void **opaque,
-                              const struct timespec* timeout);
+    send_write_request(const void* buf,
+                       const uint64_t size_in_bytes,
+                       const uint64_t offset_in_bytes,
+                       const void *opaque);
+
+    int
+    send_flush_request(const void *opaque);
+
+    // Submit a batch of requests to one queue pair, taking its lock once
+    // and pushing as many requests per ring update (and doorbell) as fit.
+    // Returns the number of requests submitted - errno is set if that's
+    // less than count.
+    size_t
+    send_requests(const ShmRequest* reqs,
+                  const size_t count);
+
+    uint32_t
+    queue_pairs() const
+    {
+        return rings_->nqueues();
+    }
+
+    // Reap up to max replies from the completion ring of the given queue
+    // pair, waiting for at most timeout. Returns the number of replies, 0 on
+    // timeout or if woken up by wake_reapers(). There must be only one
+    // thread reaping a given queue pair.
+    size_t
+    timed_receive_replies(const uint32_t queue,
+                          ShmReply* replies,
+                          const size_t max,
+                          const struct timespec* timeout);
 
     void
-    stop_reply_queues(int n);
+    wake_reapers();
 
     int
     stat(const std::string& volume_name,
@@ -161,10 +162,6 @@ private:
     static youtils::OrbHelper&
     orb_helper();
 
-    std::unique_ptr<ipc::message_queue> writerequest_mq_;
-    std::unique_ptr<ipc::message_queue> writereply_mq_;
-    std::unique_ptr<ipc::message_queue> readrequest_mq_;
-    std::unique_ptr<ipc::message_queue> readreply_mq_;
 
     ShmIdlInterface::VolumeFactory_var volumefactory_ref_;
 
@@ -174,6 +171,20 @@ private:
     std::unique_ptr<ShmIdlInterface::CreateResult> create_result;
 
     std::unique_ptr<ipc::managed_shared_memory> shm_segment_;
+
+    std::unique_ptr<ShmRings> rings_;
+    std::chrono::microseconds max_spin_;
+
+    // The rings are single producer / single consumer - serialize the
+    // submitting threads per queue pair.
+    std::unique_ptr<std::mutex[]> sq_locks_;
+    std::atomic<uint32_t> next_queue_;
+
+    // only touched by the (single) reaper of the respective queue pair
+    std::vector<ShmAdaptiveSpin> cq_spins_;
+
+    int
+    send_request_(const ShmRequest& req);
 };
 
 typedef std::shared_ptr<ShmClient> ShmClientPtr;
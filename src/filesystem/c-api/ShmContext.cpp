@@ -15,6 +15,8 @@
 
 #include "ShmContext.h"
 
+#include <vector>
+
 namespace vfs = volumedriverfs;
 
 ShmContext::ShmContext()
@@ -301,11 +303,48 @@ ShmContext::send_write_request(struct ovs_aiocb *ovs_aiocbp,
 int
 ShmContext::send_flush_request(ovs_aio_request *request)
 {
-    struct ovs_aiocb *ovs_aiocbp = request->ovs_aiocbp;
-    return shm_ctx_->shm_client_->send_write_request(ovs_aiocbp->aio_buf,
-                                                     ovs_aiocbp->aio_nbytes,
-                                                     ovs_aiocbp->aio_offset,
-                                                     reinterpret_cast<void*>(request));
+    return shm_ctx_->shm_client_->send_flush_request(reinterpret_cast<void*>(request));
+}
+
+int
+ShmContext::send_requests(ovs_aio_request **requests,
+                          size_t count)
+{
+    vfs::ShmClientPtr& client = shm_ctx_->shm_client_;
+    std::vector<vfs::ShmRequest> reqs(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ovs_aio_request *request = requests[i];
+        struct ovs_aiocb *aiocbp = request->get_aio();
+        vfs::ShmRequest& req = reqs[i];
+
+        switch (request->_op)
+        {
+        case RequestOp::Read:
+        case RequestOp::Write:
+            req.type = request->_op == RequestOp::Read ?
+                vfs::ShmRequestType::Read :
+                vfs::ShmRequestType::Write;
+            req.size_in_bytes = aiocbp->aio_nbytes;
+            req.offset_in_bytes = aiocbp->aio_offset;
+            req.handle = client->get_handle_from_address(aiocbp->aio_buf);
+            break;
+        case RequestOp::Flush:
+        case RequestOp::AsyncFlush:
+            req.type = vfs::ShmRequestType::Flush;
+            break;
+        default:
+            errno = EINVAL;
+            return -1;
+        }
+
+        req.opaque = reinterpret_cast<uintptr_t>(request);
+    }
+
+    const size_t sent = client->send_requests(reqs.data(),
+                                              count);
+    return sent == 0 and count != 0 ? -1 : sent;
 }
 
 int
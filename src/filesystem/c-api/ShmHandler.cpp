@@ -15,13 +15,12 @@
 
 #include "ShmHandler.h"
 
+#include <array>
+
 ovs_shm_context::ovs_shm_context(const std::string& volume_name,
                                  int flag)
     : oflag(flag)
 {
-    const std::string io_env_var("LIBOVSVOLUMEDRIVER_IO_THREADS_POOL_SIZE");
-    io_threads_pool_size_ =
-    youtils::System::get_env_with_default<int>(io_env_var, 1);
     shm_client_ = std::make_shared<volumedriverfs::ShmClient>(volume_name);
     try
     {
@@ -82,61 +81,33 @@ ovs_shm_context::~ovs_shm_context()
 }
 
 void
-ovs_shm_context::close_rr_iothreads()
-{
-    for (auto& x: rr_iothreads)
-    {
-        x->reset_iothread();
-    }
-    rr_iothreads.clear();
-}
-
-void
-ovs_shm_context::close_wr_iothreads()
+ovs_shm_context::close_iothreads()
 {
-    for (auto& x: wr_iothreads)
+    for (auto& x: iothreads)
     {
         x->reset_iothread();
     }
-    wr_iothreads.clear();
+    iothreads.clear();
 }
 
 void
 ovs_shm_context::ovs_aio_init()
 {
-    for (int i = 0; i < io_threads_pool_size_; i++)
+    for (uint32_t i = 0; i < shm_client_->queue_pairs(); i++)
     {
         IOThreadPtr iot;
         try
         {
             iot = std::make_unique<IOThread>();
-            iot->iothread_ = std::thread(&ovs_shm_context::rr_handler,
+            iot->iothread_ = std::thread(&ovs_shm_context::cq_handler,
                                          this,
-                                         (void*)iot.get());
-            rr_iothreads.push_back(std::move(iot));
+                                         (void*)iot.get(),
+                                         i);
+            iothreads.push_back(std::move(iot));
         }
         catch (...)
         {
-            close_rr_iothreads();
-            throw;
-        }
-    }
-
-    for (int i = 0; i < io_threads_pool_size_; i++)
-    {
-        IOThreadPtr iot;
-        try
-        {
-            iot = std::make_unique<IOThread>();
-            iot->iothread_ = std::thread(&ovs_shm_context::wr_handler,
-                                         this,
-                                         (void*)iot.get());
-            wr_iothreads.push_back(std::move(iot));
-        }
-        catch (...)
-        {
-            close_wr_iothreads();
-            close_rr_iothreads();
+            close_iothreads();
             throw;
         }
     }
@@ -145,69 +116,41 @@ ovs_shm_context::ovs_aio_init()
 void
 ovs_shm_context::ovs_aio_destroy()
 {
-    for (auto& iot: rr_iothreads)
-    {
-        iot->stop();
-    }
-    for (auto& iot: wr_iothreads)
+    for (auto& iot: iothreads)
     {
         iot->stop();
     }
 
     /* noexcept */
-    if (ctl_client_->is_connected())
-    {
-        shm_client_->stop_reply_queues(io_threads_pool_size_);
-    }
-    close_wr_iothreads();
-    close_rr_iothreads();
+    shm_client_->wake_reapers();
+    close_iothreads();
 }
 
 void
-ovs_shm_context::rr_handler(void *arg)
+ovs_shm_context::cq_handler(void *arg,
+                            uint32_t queue)
 {
     IOThread *iothread = (IOThread*) arg;
     const struct timespec timeout = {2, 0};
-    size_t size_in_bytes;
-    bool failed;
-    //cnanakos: stop thread by sending a stop request?
-    while (not iothread->stopping)
-    {
-        ovs_aio_request *request;
-        failed = shm_client_->timed_receive_read_reply(size_in_bytes,
-                                                       reinterpret_cast<void**>(&request),
-                                                       &timeout);
-        if (request)
-        {
-            ovs_aio_request::handle_shm_request(request,
-                                                size_in_bytes,
-                                                failed);
-        }
-    }
-    std::lock_guard<std::mutex> lock_(iothread->mutex_);
-    iothread->stopped = true;
-    iothread->cv_.notify_all();
-}
+    std::array<volumedriverfs::ShmReply, 32> replies;
 
-void
-ovs_shm_context::wr_handler(void *arg)
-{
-    IOThread *iothread = (IOThread*) arg;
-    const struct timespec timeout = {2, 0};
-    size_t size_in_bytes;
-    bool failed;
-    //cnanakos: stop thread by sending a stop request?
     while (not iothread->stopping)
     {
-        ovs_aio_request *request;
-        failed = shm_client_->timed_receive_write_reply(size_in_bytes,
-                                                        reinterpret_cast<void**>(&request),
-                                                        &timeout);
-        if (request)
+        const size_t count =
+            shm_client_->timed_receive_replies(queue,
+                                               replies.data(),
+                                               replies.size(),
+                                               &timeout);
+        for (size_t i = 0; i < count; ++i)
         {
-            ovs_aio_request::handle_shm_request(request,
-                                                size_in_bytes,
-                                                failed);
+            ovs_aio_request *request =
+                reinterpret_cast<ovs_aio_request*>(replies[i].opaque);
+            if (request)
+            {
+                ovs_aio_request::handle_shm_request(request,
+                                                    replies[i].size_in_bytes,
+                                                    replies[i].failed);
+            }
         }
     }
     std::lock_guard<std::mutex> lock_(iothread->mutex_);
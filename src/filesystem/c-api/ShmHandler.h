@@ -28,10 +28,7 @@ struct ovs_shm_context
     ~ovs_shm_context();
 
     void
-    close_rr_iothreads();
-
-    void
-    close_wr_iothreads();
+    close_iothreads();
 
     void
     ovs_aio_init();
@@ -39,17 +36,14 @@ struct ovs_shm_context
     void
     ovs_aio_destroy();
 
+    // reaps the completion ring of one queue pair
     void
-    rr_handler(void *arg);
-
-    void
-    wr_handler(void *arg);
+    cq_handler(void *arg,
+               uint32_t queue);
 
     int oflag;
-    int io_threads_pool_size_;
     volumedriverfs::ShmClientPtr shm_client_;
-    std::vector<IOThreadPtr> rr_iothreads;
-    std::vector<IOThreadPtr> wr_iothreads;
+    std::vector<IOThreadPtr> iothreads;
     VolumeCacheHandlerPtr cache_;
     ShmControlChannelClientPtr ctl_client_;
 };
@@ -46,6 +46,7 @@ struct ovs_context_attr_t
     std::string host;
     int port;
     uint64_t network_qdepth;
+    uint64_t read_cache_size;
 };
 
 struct ovs_buffer
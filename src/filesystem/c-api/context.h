@@ -17,13 +17,16 @@
 #define __CONTEXT_H
 
 #include "common.h"
+#include "ReadCache.h"
 
+#include <memory>
 #include <vector>
 
 struct ovs_context_t
 {
     TransportType transport;
     int oflag;
+    std::unique_ptr<ReadCache> read_cache;
 
     virtual ~ovs_context_t() {};
 
@@ -65,6 +68,12 @@ struct ovs_context_t
 
     virtual int send_flush_request(ovs_aio_request *request) = 0;
 
+    /* Submit a batch of read / write / flush requests (as per their op).
+     * Returns the number of requests submitted - errno is set if that's
+     * less than count - or -1 if none was. */
+    virtual int send_requests(ovs_aio_request **requests,
+                              size_t count) = 0;
+
     virtual int stat_volume(struct stat *st) = 0;
 
     virtual ovs_buffer_t* allocate(size_t size) = 0;
@@ -19,11 +19,16 @@
 #include "volumedriver.h"
 #include "common.h"
 #include "AioCompletion.h"
+#include "AioQueue.h"
+#include "ReadCache.h"
 
 struct ovs_aio_request
 {
     struct ovs_aiocb *ovs_aiocbp;
     ovs_completion_t *_completion;
+    ovs_aio_queue_t *_queue;
+    ReadCache *_read_cache;
+    uint64_t _read_cache_gen;
     RequestOp _op;
     bool _on_suspend;
     bool _canceled;
@@ -37,9 +42,13 @@ struct ovs_aio_request
 
     ovs_aio_request(RequestOp op,
                     struct ovs_aiocb *aio,
-                    ovs_completion_t* comp)
+                    ovs_completion_t* comp,
+                    ovs_aio_queue_t *queue = nullptr)
     : ovs_aiocbp(aio)
     , _completion(comp)
+    , _queue(queue)
+    , _read_cache(nullptr)
+    , _read_cache_gen(0)
     , _op(op)
     {
         /*cnanakos TODO: err handling */
@@ -106,6 +115,32 @@ struct ovs_aio_request
         }
     }
 
+    // Writes are bracketed by ReadCache::begin_write / end_write; the latter
+    // has to happen before the caller learns about the completion as it
+    // might reuse the buffer right away.
+    void
+    begin_read_cache_write(ReadCache *cache)
+    {
+        _read_cache = cache;
+        _read_cache_gen = cache->begin_write(ovs_aiocbp->aio_nbytes,
+                                             ovs_aiocbp->aio_offset);
+    }
+
+    void
+    end_read_cache_write(ssize_t retval)
+    {
+        if (_read_cache)
+        {
+            const bool succeeded = retval >= 0 and
+                static_cast<size_t>(retval) == ovs_aiocbp->aio_nbytes;
+            _read_cache->end_write(_read_cache_gen,
+                                   succeeded ? ovs_aiocbp->aio_buf : nullptr,
+                                   ovs_aiocbp->aio_nbytes,
+                                   ovs_aiocbp->aio_offset);
+            _read_cache = nullptr;
+        }
+    }
+
     void
     set_completion()
     {
@@ -138,11 +173,37 @@ struct ovs_aio_request
         return ovs_aiocbp;
     }
 
+    // Requests submitted through ovs_aio_submitv are done with once their
+    // event is queued - the aiocb is the caller's again from then on.
+    static void
+    handle_queued_request(ovs_aio_request *request,
+                          ssize_t retval,
+                          int errval)
+    {
+        ovs_aio_queue_t *queue = request->_queue;
+        struct ovs_aiocb *aiocbp = request->get_aio();
+        aiocbp->request_ = nullptr;
+        delete request;
+        queue->complete(aiocbp,
+                        retval,
+                        retval < 0 ? (errval ? errval : EIO) : 0);
+    }
+
     static void
     handle_shm_request(ovs_aio_request *request,
                       size_t ret,
                       bool failed)
     {
+        request->end_read_cache_write(failed ? -1 : ret);
+
+        if (request->_queue)
+        {
+            handle_queued_request(request,
+                                  failed ? -1 : ret,
+                                  EIO);
+            return;
+        }
+
         struct ovs_aiocb *aiocbp = request->get_aio();
         ovs_completion_t *completion = request->get_completion();
         request->shm_complete(errno,
@@ -165,6 +226,16 @@ struct ovs_aio_request
                        ssize_t retval,
                        int errval)
     {
+        request->end_read_cache_write(retval);
+
+        if (request->_queue)
+        {
+            handle_queued_request(request,
+                                  retval,
+                                  errval);
+            return;
+        }
+
         ovs_completion_t *completion = request->get_completion();
         struct ovs_aiocb *aiocbp = request->get_aio();
         request->xio_complete(retval,
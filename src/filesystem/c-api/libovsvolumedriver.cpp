@@ -31,6 +31,7 @@
 
 #include <vector>
 #include <cerrno>
+#include <cstring>
 #include <map>
 
 #ifdef __GNUC__
@@ -41,6 +42,15 @@
 #define unlikely(x)     (x)
 #endif
 
+static inline void
+_ovs_drop_read_cache(ovs_ctx_t *ctx)
+{
+    if (ctx->read_cache)
+    {
+        ctx->read_cache->drop();
+    }
+}
+
 ovs_ctx_attr_t*
 ovs_ctx_attr_new()
 {
@@ -50,6 +60,7 @@ ovs_ctx_attr_new()
         attr->transport = TransportType::Error;
         attr->port = 0;
         attr->network_qdepth = 256;
+        attr->read_cache_size = 0;
         return attr;
     }
     catch (const std::bad_alloc&)
@@ -122,6 +133,24 @@ ovs_ctx_attr_set_network_qdepth(ovs_ctx_attr_t *attr,
     return 0;
 }
 
+int
+ovs_ctx_attr_set_read_cache_size(ovs_ctx_attr_t *attr,
+                                 const uint64_t size)
+{
+    if (attr == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if (size != 0 && size < ReadCache::cluster_size)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    attr->read_cache_size = size;
+    return 0;
+}
+
 ovs_ctx_t*
 ovs_ctx_new(const ovs_ctx_attr_t *attr)
 {
@@ -175,9 +204,15 @@ ovs_ctx_new(const ovs_ctx_attr_t *attr)
         }
         ctx->transport = attr->transport;
         ctx->oflag = 0;
+        if (attr->read_cache_size)
+        {
+            ctx->read_cache =
+                std::make_unique<ReadCache>(attr->read_cache_size);
+        }
     }
     catch (const std::bad_alloc&)
     {
+        delete ctx;
         errno = ENOMEM;
         return NULL;
     }
@@ -323,7 +358,9 @@ ovs_truncate_volume(ovs_ctx_t *ctx,
         errno = EINVAL;
         return (r = -1);
     }
-    return (r = ctx->truncate_volume(volume_name, length));
+    r = ctx->truncate_volume(volume_name, length);
+    _ovs_drop_read_cache(ctx);
+    return r;
 }
 
 int
@@ -387,7 +424,9 @@ ovs_snapshot_rollback(ovs_ctx_t *ctx,
         errno = EINVAL;
         return (r = -1);
     }
-    return (r = ctx->snapshot_rollback(volume_name, snapshot_name));
+    r = ctx->snapshot_rollback(volume_name, snapshot_name);
+    _ovs_drop_read_cache(ctx);
+    return r;
 }
 
 int
@@ -646,79 +685,71 @@ ovs_list_volumes(ovs_ctx_t *ctx,
 }
 
 static int
-_ovs_submit_aio_request(ovs_ctx_t *ctx,
-                        struct ovs_aiocb *ovs_aiocbp,
-                        ovs_completion_t *completion,
-                        const RequestOp& op)
+_ovs_check_aio_request(ovs_ctx_t *ctx,
+                       struct ovs_aiocb *ovs_aiocbp,
+                       const RequestOp& op)
 {
-    int r = 0, accmode;
-
-    ovs_submit_aio_request_tracepoint_enter(op,
-                                            ctx,
-                                            ovs_aiocbp,
-                                            completion);
-
     if (ctx == NULL || ovs_aiocbp == NULL)
     {
-        ovs_submit_aio_request_tracepoint_exit(op,
-                                               ctx,
-                                               ovs_aiocbp,
-                                               completion,
-                                               -1,
-                                               EINVAL);
-        errno = EINVAL;
-        return -1;
+        return EINVAL;
     }
 
     if ((ovs_aiocbp->aio_nbytes <= 0 ||
          ovs_aiocbp->aio_offset < 0) &&
          op != RequestOp::Flush && op != RequestOp::AsyncFlush)
     {
-        ovs_submit_aio_request_tracepoint_exit(op,
-                                               ctx,
-                                               ovs_aiocbp,
-                                               completion,
-                                               -1,
-                                               EINVAL);
-        errno = EINVAL;
-        return -1;
+        return EINVAL;
     }
 
-    accmode = ctx->oflag & O_ACCMODE;
+    const int accmode = ctx->oflag & O_ACCMODE;
     switch (op)
     {
     case RequestOp::Read:
         if (accmode == O_WRONLY)
         {
-            ovs_submit_aio_request_tracepoint_exit(op,
-                                                   ctx,
-                                                   ovs_aiocbp,
-                                                   completion,
-                                                   -1,
-                                                   EBADF);
-            errno = EBADF;
-            return -1;
+            return EBADF;
         }
         break;
     case RequestOp::Write:
     case RequestOp::Flush:
     case RequestOp::AsyncFlush:
-    {
         if (accmode == O_RDONLY)
         {
-            ovs_submit_aio_request_tracepoint_exit(op,
-                                                   ctx,
-                                                   ovs_aiocbp,
-                                                   completion,
-                                                   -1,
-                                                   EBADF);
-            errno = EBADF;
-            return -1;
+            return EBADF;
         }
-    }
         break;
     default:
-        errno = EBADF;
+        return EBADF;
+    }
+
+    return 0;
+}
+
+static int
+_ovs_submit_aio_request(ovs_ctx_t *ctx,
+                        struct ovs_aiocb *ovs_aiocbp,
+                        ovs_completion_t *completion,
+                        const RequestOp& op)
+{
+    int r = 0;
+
+    ovs_submit_aio_request_tracepoint_enter(op,
+                                            ctx,
+                                            ovs_aiocbp,
+                                            completion);
+
+    const int err = _ovs_check_aio_request(ctx,
+                                           ovs_aiocbp,
+                                           op);
+    if (err != 0)
+    {
+        ovs_submit_aio_request_tracepoint_exit(op,
+                                               ctx,
+                                               ovs_aiocbp,
+                                               completion,
+                                               -1,
+                                               err);
+        errno = err;
         return -1;
     }
 
@@ -741,6 +772,11 @@ _ovs_submit_aio_request(ovs_ctx_t *ctx,
         return -1;
     }
 
+    if (op == RequestOp::Write && ctx->read_cache)
+    {
+        request->begin_read_cache_write(ctx->read_cache.get());
+    }
+
     switch (op)
     {
     case RequestOp::Read:
@@ -769,7 +805,10 @@ _ovs_submit_aio_request(ovs_ctx_t *ctx,
     }
     if (r < 0)
     {
+        int saved_errno = errno;
+        request->end_read_cache_write(-1);
         delete request;
+        errno = saved_errno;
     }
     int saved_errno = errno;
     ovs_submit_aio_request_tracepoint_exit(op,
@@ -966,6 +1005,234 @@ ovs_aio_suspend(ovs_ctx_t *ctx,
     return r;
 }
 
+ovs_aio_queue_t*
+ovs_aio_queue_create(ovs_ctx_t *ctx)
+{
+    ovs_aio_queue_t *queue = NULL;
+
+    auto on_exit(youtils::make_scope_exit([&]
+                {
+                    safe_errno_tracepoint(openvstorage_libovsvolumedriver,
+                                          ovs_aio_queue_create,
+                                          ctx,
+                                          queue);
+                }));
+
+    if (ctx == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    try
+    {
+        queue = new ovs_aio_queue_t(ctx);
+    }
+    catch (const std::bad_alloc&)
+    {
+        errno = ENOMEM;
+    }
+    catch (...)
+    {
+        /* eventfd creation failed */
+        errno = EMFILE;
+    }
+    return queue;
+}
+
+int
+ovs_aio_queue_destroy(ovs_aio_queue_t *queue)
+{
+    tracepoint(openvstorage_libovsvolumedriver,
+               ovs_aio_queue_destroy,
+               queue);
+
+    if (queue == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (not queue->idle())
+    {
+        errno = EBUSY;
+        return -1;
+    }
+
+    delete queue;
+    return 0;
+}
+
+int
+ovs_aio_queue_eventfd(ovs_aio_queue_t *queue)
+{
+    if (queue == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return queue->eventfd();
+}
+
+static RequestOp
+_ovs_aio_opcode_to_request_op(int opcode)
+{
+    switch (opcode)
+    {
+    case OVS_AIO_READ:
+        return RequestOp::Read;
+    case OVS_AIO_WRITE:
+        return RequestOp::Write;
+    case OVS_AIO_FLUSH:
+        return RequestOp::Flush;
+    default:
+        return RequestOp::Noop;
+    }
+}
+
+int
+ovs_aio_submitv(ovs_ctx_t *ctx,
+                ovs_aio_queue_t *queue,
+                struct ovs_aiocb **ovs_aiocbpv,
+                int nr)
+{
+    int r = 0;
+
+    tracepoint(openvstorage_libovsvolumedriver,
+               ovs_aio_submitv_enter,
+               ctx,
+               queue,
+               nr);
+
+    auto on_exit(youtils::make_scope_exit([&]
+                {
+                    safe_errno_tracepoint(openvstorage_libovsvolumedriver,
+                                          ovs_aio_submitv_exit,
+                                          ctx,
+                                          queue,
+                                          nr,
+                                          r,
+                                          errno);
+                }));
+
+    if (ctx == NULL || queue == NULL || queue->ctx() != ctx ||
+        ovs_aiocbpv == NULL || nr < 0)
+    {
+        errno = EINVAL;
+        return (r = -1);
+    }
+
+    std::vector<ovs_aio_request*> requests;
+    int err = 0;
+
+    try
+    {
+        requests.reserve(nr);
+        for (int i = 0; i < nr; ++i)
+        {
+            struct ovs_aiocb *aiocbp = ovs_aiocbpv[i];
+            const RequestOp op =
+                aiocbp ? _ovs_aio_opcode_to_request_op(aiocbp->aio_opcode) :
+                RequestOp::Noop;
+
+            /* like io_submit, submit everything up to the first
+             * invalid aiocb */
+            err = _ovs_check_aio_request(ctx,
+                                         aiocbp,
+                                         op);
+            if (err != 0)
+            {
+                break;
+            }
+
+            requests.push_back(new ovs_aio_request(op,
+                                                   aiocbp,
+                                                   nullptr,
+                                                   queue));
+            if (op == RequestOp::Write && ctx->read_cache)
+            {
+                requests.back()->begin_read_cache_write(ctx->read_cache.get());
+            }
+        }
+    }
+    catch (const std::bad_alloc&)
+    {
+        err = ENOMEM;
+    }
+
+    if (requests.empty())
+    {
+        if (err != 0)
+        {
+            errno = err;
+            r = -1;
+        }
+        return r;
+    }
+
+    queue->submitted(requests.size());
+
+    const int sent = ctx->send_requests(requests.data(),
+                                        requests.size());
+    const size_t done = sent < 0 ? 0 : sent;
+    if (done < requests.size())
+    {
+        err = errno;
+        queue->not_submitted(requests.size() - done);
+        for (size_t i = done; i < requests.size(); ++i)
+        {
+            requests[i]->end_read_cache_write(-1);
+            requests[i]->get_aio()->request_ = nullptr;
+            delete requests[i];
+        }
+    }
+
+    if (done == 0)
+    {
+        errno = err;
+        return (r = -1);
+    }
+    return (r = done);
+}
+
+int
+ovs_aio_getevents(ovs_aio_queue_t *queue,
+                  int min_nr,
+                  int max_nr,
+                  struct ovs_aio_event *events,
+                  const struct timespec *timeout)
+{
+    int r = 0;
+
+    tracepoint(openvstorage_libovsvolumedriver,
+               ovs_aio_getevents_enter,
+               queue,
+               min_nr,
+               max_nr,
+               timeout);
+
+    auto on_exit(youtils::make_scope_exit([&]
+                {
+                    safe_errno_tracepoint(openvstorage_libovsvolumedriver,
+                                          ovs_aio_getevents_exit,
+                                          queue,
+                                          r,
+                                          errno);
+                }));
+
+    if (queue == NULL || events == NULL || min_nr < 0 || max_nr < 0 ||
+        min_nr > max_nr)
+    {
+        errno = EINVAL;
+        return (r = -1);
+    }
+
+    return (r = queue->reap(events,
+                            min_nr,
+                            max_nr,
+                            timeout));
+}
+
 int
 ovs_aio_cancel(ovs_ctx_t * /*ctx*/,
                struct ovs_aiocb * /*ovs_aiocbp*/)
@@ -1321,6 +1588,19 @@ ovs_read(ovs_ctx_t *ctx,
         return (r = -1);
     }
 
+    uint64_t cache_gen = 0;
+    if (ctx->read_cache && nbytes > 0 && offset >= 0 &&
+        (ctx->oflag & O_ACCMODE) != O_WRONLY)
+    {
+        if (ctx->read_cache->read(buf,
+                                  nbytes,
+                                  offset))
+        {
+            return (r = nbytes);
+        }
+        cache_gen = ctx->read_cache->generation();
+    }
+
     if ((r = ovs_aio_read(ctx, &aio)) < 0)
     {
         return r;
@@ -1337,6 +1617,13 @@ ovs_read(ovs_ctx_t *ctx,
     {
         r = -1;
     }
+    else if (r > 0 && ctx->read_cache)
+    {
+        ctx->read_cache->insert(cache_gen,
+                                buf,
+                                r,
+                                offset);
+    }
     return r;
 }
 
@@ -1426,6 +1713,29 @@ ovs_stat(ovs_ctx_t *ctx, struct stat *st)
     return r;
 }
 
+int
+ovs_read_cache_stat(ovs_ctx_t *ctx,
+                    struct ovs_read_cache_stats *stats)
+{
+    if (ctx == NULL || stats == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (ctx->read_cache)
+    {
+        ctx->read_cache->stats(*stats);
+    }
+    else
+    {
+        memset(stats,
+               0,
+               sizeof(*stats));
+    }
+    return 0;
+}
+
 int
 ovs_flush(ovs_ctx_t *ctx)
 {
@@ -1450,6 +1760,8 @@ ovs_flush(ovs_ctx_t *ctx)
         return (r = -1);
     }
 
+    _ovs_drop_read_cache(ctx);
+
     struct ovs_aiocb aio;
     aio.aio_nbytes = 0;
     aio.aio_offset = 0;
@@ -1507,5 +1819,7 @@ ovs_truncate(ovs_ctx_t *ctx,
         errno = EBADF;
         return -1;
     }
-    return (r = ctx->truncate(length));
+    r = ctx->truncate(length);
+    _ovs_drop_read_cache(ctx);
+    return r;
 }
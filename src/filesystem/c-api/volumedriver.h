@@ -34,14 +34,43 @@ typedef struct ovs_context_attr_t ovs_ctx_attr_t;
 typedef struct ovs_snapshot_info ovs_snapshot_info_t;
 typedef struct ovs_aio_request ovs_aio_request;
 typedef struct ovs_completion ovs_completion_t;
+typedef struct ovs_aio_queue ovs_aio_queue_t;
 typedef void (*ovs_callback_t)(ovs_completion_t *cb, void *arg);
 
+enum ovs_aio_opcode
+{
+    OVS_AIO_READ,
+    OVS_AIO_WRITE,
+    OVS_AIO_FLUSH,
+};
+
 struct ovs_aiocb
 {
     void *aio_buf;
     off_t aio_offset;
     size_t aio_nbytes;
     ovs_aio_request *request_;
+    /* only used by ovs_aio_submitv */
+    enum ovs_aio_opcode aio_opcode;
+};
+
+struct ovs_aio_event
+{
+    struct ovs_aiocb *aiocbp;
+    /* number of bytes read / written, -1 on fail */
+    ssize_t rv;
+    /* errno value if rv is -1 */
+    int err;
+};
+
+struct ovs_read_cache_stats
+{
+    /* number of reads served from / missing the cache */
+    uint64_t hits;
+    uint64_t misses;
+    /* bytes cached / cache capacity in bytes */
+    uint64_t size;
+    uint64_t capacity;
 };
 
 struct ovs_snapshot_info
@@ -91,6 +120,20 @@ int
 ovs_ctx_attr_set_network_qdepth(ovs_ctx_attr_t *attr,
                                 const uint64_t qdepth);
 
+/*
+ * Enable the process local read cache of the context
+ * Synchronous reads (ovs_read) are served from / populate the cache.
+ * Writes through the context keep it consistent, it is dropped on
+ * ovs_flush, snapshot rollback and truncate. Writes from other
+ * contexts or clients are not seen by it.
+ * param attr: Context attributes object
+ * param size: Cache size in bytes (at least 4096), 0 to disable it
+ * return: 0 on success, -1 on fail
+ */
+int
+ovs_ctx_attr_set_read_cache_size(ovs_ctx_attr_t *attr,
+                                 const uint64_t size);
+
 /*
  * Create Open vStorage context
  * param attr: Context attributes object
@@ -327,6 +370,17 @@ int
 ovs_truncate(ovs_ctx_t *ctx,
              uint64_t length);
 
+/*
+ * Get read cache statistics
+ * param ctx: Open vStorage context
+ * param stats: Pointer to a read cache stats structure (all zero if the
+ * read cache is disabled)
+ * return: 0 on success, -1 on fail
+ */
+int
+ovs_read_cache_stat(ovs_ctx_t *ctx,
+                    struct ovs_read_cache_stats *stats);
+
 /*
  * Suspend until asynchronous I/O operation or timeout complete
  * param ctx: Open vStorage context
@@ -399,6 +453,75 @@ int
 ovs_aio_write(ovs_ctx_t *ctx,
               struct ovs_aiocb *ovs_aiocbp);
 
+/*
+ * Create a completion queue for asynchronous I/O operations submitted
+ * with ovs_aio_submitv
+ * param ctx: Open vStorage context
+ * return: Completion queue on success, or NULL on fail
+ */
+ovs_aio_queue_t*
+ovs_aio_queue_create(ovs_ctx_t *ctx);
+
+/*
+ * Destroy a completion queue
+ * The queue must not have any operations in flight anymore, unreaped
+ * events are discarded.
+ * param queue: Completion queue
+ * return: 0 on success, -1 on fail (errno is set to EBUSY if
+ * operations are still in flight)
+ */
+int
+ovs_aio_queue_destroy(ovs_aio_queue_t *queue);
+
+/*
+ * Retrieve the eventfd of a completion queue
+ * The eventfd becomes readable when events are available and is reset
+ * once ovs_aio_getevents reaped all of them. It is meant to be added to
+ * the caller's event loop (poll, epoll, ...) - it must neither be read
+ * nor closed by the caller.
+ * param queue: Completion queue
+ * return: eventfd on success, -1 on fail
+ */
+int
+ovs_aio_queue_eventfd(ovs_aio_queue_t *queue);
+
+/*
+ * Submit a batch of asynchronous I/O operations
+ * The operation is selected by the aio_opcode of each AIO Control Block.
+ * The batch is handed to the transport in one go, the results are
+ * retrieved with ovs_aio_getevents - the AIO Control Blocks must not
+ * be passed to ovs_aio_suspend, ovs_aio_return or ovs_aio_finish.
+ * param ctx: Open vStorage context
+ * param queue: Completion queue (created for ctx)
+ * param ovs_aiocbpv: Array of pointers to AIO Control Block structures
+ * param nr: Number of AIO Control Blocks in ovs_aiocbpv
+ * return: Number of operations submitted, which is less than nr if
+ * submitting one of them failed, -1 if none could be submitted
+ */
+int
+ovs_aio_submitv(ovs_ctx_t *ctx,
+                ovs_aio_queue_t *queue,
+                struct ovs_aiocb **ovs_aiocbpv,
+                int nr);
+
+/*
+ * Reap completed asynchronous I/O operations from a completion queue
+ * param queue: Completion queue
+ * param min_nr: Minimum number of events to wait for, 0 to poll
+ * param max_nr: Maximum number of events to return
+ * param events: Array of at least max_nr event structures
+ * param timeout: Pointer to a timespec structure with a relative
+ * timeout, NULL to wait until min_nr events are available
+ * return: Number of events returned (less than min_nr on timeout),
+ * -1 on fail
+ */
+int
+ovs_aio_getevents(ovs_aio_queue_t *queue,
+                  int min_nr,
+                  int max_nr,
+                  struct ovs_aio_event *events,
+                  const struct timespec *timeout);
+
 /*
  * Asynchronous read from a volume with completion
  * param ctx: Open vStorage context
@@ -1042,6 +1042,15 @@ FileSystemTestBase::set_file_read_threshold(uint64_t rthresh)
     EXPECT_EQ(1U, urep.update_size()) << "fix yer test";
 }
 
+void
+FileSystemTestBase::check_migrations()
+{
+    for (size_t i = 0; i < 3; ++i)
+    {
+        fs_->object_router().check_migrations_();
+    }
+}
+
 void
 FileSystemTestBase::set_backend_sync_timeout(const boost::chrono::milliseconds& ms)
 {
@@ -428,6 +428,11 @@ protected:
     void
     set_file_read_threshold(uint64_t rthresh);
 
+    // Runs the MigrationController for as many periods as auto migration of
+    // a costly volume takes with the test config.
+    void
+    check_migrations();
+
     void
     set_backend_sync_timeout(const boost::chrono::milliseconds& ms);
 
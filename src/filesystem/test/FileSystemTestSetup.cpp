@@ -80,6 +80,7 @@ FileSystemTestSetup::FileSystemTestSetup(const FileSystemTestSetupParameters& pa
     , redirect_timeout_ms_(params.redirect_timeout_ms_)
     , redirect_retries_(params.redirect_retries_)
     , scrub_manager_interval_secs_(params.scrub_manager_interval_secs_)
+    , fuse_use_lowlevel_api_(params.fuse_use_lowlevel_api_)
     , fdriver_namespace_("ovs-fdnspc-fstest-"s + yt::UUID().str())
     , arakoon_test_setup_(std::make_shared<ara::ArakoonTestSetup>(topdir_ / "arakoon"))
     , client_(vrouter_cluster_id(),
@@ -251,6 +252,7 @@ FileSystemTestSetup::make_mdstore_config_(bpt::ptree& pt) const
         }
     case vd::MetaDataBackendType::RocksDB:
     case vd::MetaDataBackendType::TCBT:
+    case vd::MetaDataBackendType::MMap:
         break;
     }
 
@@ -339,6 +341,7 @@ FileSystemTestSetup::make_config_(bpt::ptree& pt,
         ip::PARAMETER_TYPE(fs_cache_dentries)(true).persist(pt);
         ip::PARAMETER_TYPE(fs_enable_shm_interface)(true).persist(pt);
         ip::PARAMETER_TYPE(fs_enable_network_interface)(true).persist(pt);
+        ip::PARAMETER_TYPE(fuse_use_lowlevel_api)(fuse_use_lowlevel_api_).persist(pt);
 
         make_mdstore_config_(pt);
     }
@@ -349,6 +352,10 @@ FileSystemTestSetup::make_config_(bpt::ptree& pt,
         ip::PARAMETER_TYPE(vrouter_migrate_timeout_ms)(migrate_timeout_ms_).persist(pt);
         ip::PARAMETER_TYPE(vrouter_redirect_timeout_ms)(redirect_timeout_ms_).persist(pt);
         ip::PARAMETER_TYPE(vrouter_redirect_retries)(redirect_retries_).persist(pt);
+        // auto migration is driven explicitly by the tests
+        ip::PARAMETER_TYPE(vrouter_migrate_check_interval_secs)(3600).persist(pt);
+        ip::PARAMETER_TYPE(vrouter_migrate_sustain_periods)(1).persist(pt);
+        ip::PARAMETER_TYPE(vrouter_migrate_holdoff_secs)(0).persist(pt);
         ip::PARAMETER_TYPE(vrouter_id)(vrouter_id).persist(pt);
         ip::PARAMETER_TYPE(scrub_manager_interval)(scrub_manager_interval_secs_).persist(pt);
     }
@@ -81,6 +81,7 @@ struct FileSystemTestSetupParameters
     PARAM(uint64_t, redirect_timeout_ms) = 0;
     PARAM(uint64_t, redirect_retries) = 2;
     PARAM(uint64_t, scrub_manager_interval_secs) = 1;
+    PARAM(bool, fuse_use_lowlevel_api) = false;
 
 #undef PARAM
 };
@@ -300,6 +301,13 @@ protected:
         return port_base() + 8;
     }
 
+    // first port of the additional network portals of the local node
+    static uint16_t
+    local_edge_portal_base_port()
+    {
+        return port_base() + 9;
+    }
+
     static volumedriverfs::ClusterNodeConfigs
     cluster_node_configs()
     {
@@ -340,6 +348,7 @@ protected:
     uint64_t redirect_timeout_ms_;
     uint32_t redirect_retries_;
     uint64_t scrub_manager_interval_secs_;
+    const bool fuse_use_lowlevel_api_;
 
     const backend::Namespace fdriver_namespace_;
 
@@ -0,0 +1,192 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "FileSystemTestBase.h"
+
+#include "../FuseLowLevelInterface.h"
+
+namespace volumedriverfstest
+{
+
+namespace vfs = volumedriverfs;
+
+// The parts of the low level frontend that don't need a FUSE session - the
+// I/O paths are covered by FuseLowLevelRemoteTest.
+class FuseLowLevelInterfaceTest
+    : public FileSystemTestBase
+{
+public:
+    FuseLowLevelInterfaceTest()
+        : FileSystemTestBase(FileSystemTestSetupParameters("FuseLowLevelInterfaceTest"))
+    {}
+
+    virtual void
+    SetUp()
+    {
+        FileSystemTestBase::SetUp();
+        ll_ = std::make_unique<vfs::FuseLowLevelInterface>(*fs_,
+                                                           128ULL << 10,
+                                                           false);
+    }
+
+    virtual void
+    TearDown()
+    {
+        ll_.reset();
+        FileSystemTestBase::TearDown();
+    }
+
+    void
+    lookup(const vfs::ObjectId& parent_id,
+           const std::string& name,
+           fuse_entry_param& e)
+    {
+        ll_->lookup_(parent_id,
+                     name,
+                     e);
+    }
+
+    void
+    forget(fuse_ino_t ino,
+           uint64_t nlookup)
+    {
+        ll_->forget_(ino,
+                     nlookup);
+    }
+
+    void
+    create(const vfs::ObjectId& parent_id,
+           const std::string& name,
+           int flags,
+           fuse_entry_param& e,
+           vfs::Handle::Ptr& h)
+    {
+        ll_->create_(parent_id,
+                     name,
+                     vfs::UserId(::getuid()),
+                     vfs::GroupId(::getgid()),
+                     vfs::Permissions(S_IWUSR bitor S_IRUSR),
+                     flags,
+                     e,
+                     h);
+    }
+
+    vfs::ObjectId
+    root_id()
+    {
+        return *find_object(vfs::FrontendPath("/"));
+    }
+
+protected:
+    std::unique_ptr<vfs::FuseLowLevelInterface> ll_;
+};
+
+TEST_F(FuseLowLevelInterfaceTest, lookup_and_forget)
+{
+    // the root
+    EXPECT_EQ(1U,
+              ll_->known_inodes());
+
+    const std::string name("some.file");
+    create_file(root_id(),
+                name);
+
+    fuse_entry_param e;
+    lookup(root_id(),
+           name,
+           e);
+    EXPECT_EQ(2U,
+              ll_->known_inodes());
+
+    fuse_entry_param f;
+    lookup(root_id(),
+           name,
+           f);
+    EXPECT_EQ(e.ino,
+              f.ino);
+    EXPECT_EQ(2U,
+              ll_->known_inodes());
+
+    forget(e.ino,
+           1);
+    EXPECT_EQ(2U,
+              ll_->known_inodes());
+
+    forget(e.ino,
+           1);
+    EXPECT_EQ(1U,
+              ll_->known_inodes());
+
+    fuse_entry_param g;
+    EXPECT_THROW(lookup(root_id(),
+                        "some.other.file",
+                        g),
+                 std::exception);
+    EXPECT_EQ(1U,
+              ll_->known_inodes());
+
+    // the root is never forgotten
+    forget(FUSE_ROOT_ID,
+           1);
+    EXPECT_EQ(1U,
+              ll_->known_inodes());
+}
+
+TEST_F(FuseLowLevelInterfaceTest, create)
+{
+    const std::string name("some.file");
+
+    fuse_entry_param e;
+    vfs::Handle::Ptr h;
+
+    create(root_id(),
+           name,
+           O_RDWR,
+           e,
+           h);
+
+    ASSERT_TRUE(h != nullptr);
+    EXPECT_EQ(2U,
+              ll_->known_inodes());
+
+    const vfs::FrontendPath path("/" + name);
+    check_stat(path,
+               0);
+
+    EXPECT_EQ(0,
+              release(std::move(h)));
+
+    forget(e.ino,
+           1);
+    EXPECT_EQ(1U,
+              ll_->known_inodes());
+
+    // a failed create must not leave an inode reference behind
+    fuse_entry_param f;
+    vfs::Handle::Ptr g;
+
+    EXPECT_THROW(create(root_id(),
+                        name,
+                        O_RDWR,
+                        f,
+                        g),
+                 std::exception);
+
+    EXPECT_TRUE(g == nullptr);
+    EXPECT_EQ(1U,
+              ll_->known_inodes());
+}
+
+}
@@ -22,9 +22,6 @@ namespace volumedriverfstest
 
 namespace vfs = volumedriverfs;
 
-#define LOCK_LOCKS(lnode)                            \
-    std::lock_guard<decltype(vfs::LocalNode::object_lock_map_lock_)> g((lnode).object_lock_map_lock_)
-
 class LocalNodeTest
     : public FileSystemTestBase
 {
@@ -33,6 +30,15 @@ protected:
         : FileSystemTestBase(FileSystemTestSetupParameters("LocalNodeTest"))
     {}
 
+    bool
+    has_object_lock(vfs::LocalNode& lnode,
+                    const vfs::ObjectId& id)
+    {
+        vfs::LocalNode::ObjectLockShard& shard = lnode.object_lock_shard_(id);
+        std::lock_guard<decltype(shard.lock)> g(shard.lock);
+        return shard.map.find(id) != shard.map.end();
+    }
+
     void
     test_lock_reaping()
     {
@@ -44,25 +50,52 @@ protected:
 
         vfs::LocalNode& lnode = *local_node(fs_->object_router());
 
-        {
-            LOCK_LOCKS(lnode);
-            EXPECT_TRUE(lnode.object_lock_map_.find(vname) != lnode.object_lock_map_.end());
-        }
+        EXPECT_TRUE(has_object_lock(lnode,
+                                    vname));
 
         EXPECT_EQ(0, unlink(fname));
 
-        {
-            LOCK_LOCKS(lnode);
-            EXPECT_TRUE(lnode.object_lock_map_.find(vname) != lnode.object_lock_map_.end());
-        }
+        EXPECT_TRUE(has_object_lock(lnode,
+                                    vname));
 
         set_lock_reaper_interval(1);
         std::this_thread::sleep_for(std::chrono::seconds(2));
 
-        {
-            LOCK_LOCKS(lnode);
-            EXPECT_TRUE(lnode.object_lock_map_.find(vname) == lnode.object_lock_map_.end());
-        }
+        EXPECT_FALSE(has_object_lock(lnode,
+                                     vname));
+    }
+
+    void
+    test_fast_path_cookie_lock()
+    {
+        const uint64_t vsize = 10ULL << 20;
+        const vfs::FrontendPath fname(make_volume_name("/some-volume"));
+        const auto vname(create_file(fname, vsize));
+
+        set_lock_reaper_interval(1);
+
+        vfs::LocalNode& lnode = *local_node(fs_->object_router());
+        const vfs::Object obj(vfs::ObjectType::Volume,
+                              vname);
+
+        vfs::FastPathCookie cookie(lnode.fast_path_cookie(obj));
+        ASSERT_TRUE(cookie != nullptr);
+        ASSERT_TRUE(cookie->lock != nullptr);
+
+        // the cookie keeps the lock from being reaped, so exclusive users
+        // (destruction, rollback, ...) still get the very same lock
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        EXPECT_TRUE(has_object_lock(lnode,
+                                    vname));
+        EXPECT_EQ(cookie->lock,
+                  lnode.get_lock_(vname));
+
+        cookie.reset();
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        EXPECT_FALSE(has_object_lock(lnode,
+                                     vname));
+
+        EXPECT_EQ(0, unlink(fname));
     }
 };
 
@@ -71,4 +104,9 @@ TEST_F(LocalNodeTest, lock_reaping)
     test_lock_reaping();
 }
 
+TEST_F(LocalNodeTest, fast_path_cookie_carries_object_lock)
+{
+    test_fast_path_cookie_lock();
+}
+
 }
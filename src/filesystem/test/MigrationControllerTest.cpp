@@ -0,0 +1,356 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../MigrationController.h"
+
+namespace volumedriverfstest
+{
+
+namespace bc = boost::chrono;
+namespace vfs = volumedriverfs;
+
+using Clock = vfs::MigrationController::Clock;
+
+class MigrationControllerTest
+    : public testing::Test
+{
+protected:
+    MigrationControllerTest()
+        : id_("some-object")
+        , owner_("some-node")
+        , now_(Clock::now())
+        , ctrl_([this](const vfs::ObjectId& id)
+                {
+                    cost_checks_.push_back(id);
+                    return cost_;
+                },
+                [this](const vfs::ObjectId& id)
+                {
+                    migrations_.push_back(id);
+                    if (fail_migration_)
+                    {
+                        throw std::runtime_error("migration failed");
+                    }
+                    ctrl_.started_here(id);
+                })
+    {
+        policy_.volume_read_threshold = 10;
+        policy_.volume_write_threshold = 10;
+        policy_.file_read_threshold = 10;
+        policy_.file_write_threshold = 10;
+        policy_.sustain_periods = 3;
+        policy_.holdoff = bc::seconds(60);
+
+        cost_.volume_potential = 10;
+        cost_.loses_dtl = false;
+    }
+
+    // one period (1s) with count reads of size bytes, each taking latency
+    void
+    period(size_t count,
+           size_t size = 4096,
+           const Clock::duration& latency = bc::microseconds(100),
+           vfs::ObjectType type = vfs::ObjectType::Volume)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            ctrl_.record_read(id_,
+                              type,
+                              owner_,
+                              size,
+                              latency);
+        }
+
+        now_ += bc::seconds(1);
+        ctrl_.run(policy_,
+                  now_);
+    }
+
+    std::string
+    last_verdict() const
+    {
+        const auto v(ctrl_.decisions());
+        return v.empty() ? std::string() : v.back().verdict;
+    }
+
+    const vfs::ObjectId id_;
+    const vfs::NodeId owner_;
+    Clock::time_point now_;
+    vfs::MigrationController::Policy policy_;
+    vfs::MigrationController::MigrationCost cost_;
+    bool fail_migration_ = false;
+    std::vector<vfs::ObjectId> cost_checks_;
+    std::vector<vfs::ObjectId> migrations_;
+    vfs::MigrationController ctrl_;
+};
+
+TEST_F(MigrationControllerTest, too_few_requests)
+{
+    period(policy_.volume_read_threshold - 1);
+
+    for (size_t i = 0; i < 2 * policy_.sustain_periods; ++i)
+    {
+        period(0);
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+    EXPECT_TRUE(ctrl_.decisions().empty());
+    EXPECT_TRUE(cost_checks_.empty());
+}
+
+TEST_F(MigrationControllerTest, disabled)
+{
+    policy_.volume_read_threshold = 0;
+
+    for (size_t i = 0; i < 2 * policy_.sustain_periods; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+    EXPECT_TRUE(ctrl_.decisions().empty());
+}
+
+TEST_F(MigrationControllerTest, sustained)
+{
+    for (size_t i = 0; i < policy_.sustain_periods - 1; ++i)
+    {
+        period(100);
+        EXPECT_TRUE(migrations_.empty());
+        EXPECT_EQ("Sustaining", last_verdict());
+    }
+
+    period(100);
+
+    ASSERT_EQ(1U, migrations_.size());
+    EXPECT_EQ(id_, migrations_[0]);
+
+    const auto v(ctrl_.decisions());
+    ASSERT_EQ(policy_.sustain_periods, v.size());
+
+    const vfs::MigrationDecision& d = v.back();
+    EXPECT_EQ("Migrate", d.verdict);
+    EXPECT_EQ(id_, d.object_id);
+    EXPECT_EQ(owner_, d.owner_id);
+    EXPECT_EQ(policy_.sustain_periods, d.hot_periods);
+    EXPECT_EQ(policy_.sustain_periods, d.required_periods);
+    EXPECT_LT(0U, d.read_kib_per_sec);
+    EXPECT_EQ(0U, d.write_kib_per_sec);
+
+    // started here -> no longer tracked
+    EXPECT_EQ(0U, ctrl_.tracked_objects());
+}
+
+TEST_F(MigrationControllerTest, hysteresis)
+{
+    // 1 MiB/s
+    policy_.min_kib_per_sec = 1024;
+    const size_t size = 64ULL << 10;
+
+    for (size_t i = 0; i < 4 * policy_.sustain_periods; ++i)
+    {
+        // a burst every other period does not add up to a sustained rate
+        period(i % 2 ? 0 : 20,
+               size);
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+
+    // the decayed rate needs a while to catch up
+    for (size_t i = 0; i < policy_.sustain_periods + 2; ++i)
+    {
+        period(20,
+               size);
+    }
+
+    EXPECT_EQ(1U, migrations_.size());
+}
+
+TEST_F(MigrationControllerTest, remote_time)
+{
+    // the rate is too low ...
+    policy_.min_kib_per_sec = 1024;
+    // ... but the time spent waiting is not
+    policy_.min_remote_time_percent = 50;
+
+    for (size_t i = 0; i < policy_.sustain_periods; ++i)
+    {
+        period(10,
+               512,
+               bc::milliseconds(10));
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+
+    for (size_t i = 0; i < policy_.sustain_periods + 1; ++i)
+    {
+        period(10,
+               512,
+               bc::milliseconds(100));
+    }
+
+    EXPECT_EQ(1U, migrations_.size());
+}
+
+TEST_F(MigrationControllerTest, no_capacity)
+{
+    cost_.volume_potential = 0;
+
+    for (size_t i = 0; i < 2 * policy_.sustain_periods; ++i)
+    {
+        period(100);
+        EXPECT_EQ("NoCapacity", last_verdict());
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+    // cost_check_periods = 1
+    EXPECT_EQ(2 * policy_.sustain_periods, cost_checks_.size());
+}
+
+TEST_F(MigrationControllerTest, cost_check_period)
+{
+    cost_.volume_potential = 0;
+    policy_.cost_check_periods = 4;
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_EQ(2U, cost_checks_.size());
+
+    cost_.volume_potential = 10;
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_EQ(3U, cost_checks_.size());
+    EXPECT_EQ(1U, migrations_.size());
+}
+
+TEST_F(MigrationControllerTest, costly_migration)
+{
+    cost_.volume_potential = 1;
+    cost_.loses_dtl = true;
+
+    const size_t required = 3 * policy_.sustain_periods;
+
+    for (size_t i = 0; i < required - 1; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+    EXPECT_EQ(required, ctrl_.decisions().back().required_periods);
+
+    period(100);
+
+    EXPECT_EQ(1U, migrations_.size());
+}
+
+TEST_F(MigrationControllerTest, files)
+{
+    for (size_t i = 0; i < policy_.sustain_periods; ++i)
+    {
+        period(100,
+               4096,
+               bc::microseconds(100),
+               vfs::ObjectType::File);
+    }
+
+    EXPECT_EQ(1U, migrations_.size());
+    EXPECT_TRUE(cost_checks_.empty());
+}
+
+TEST_F(MigrationControllerTest, holdoff)
+{
+    ctrl_.started_here(id_);
+
+    // it moved away again in the mean time
+    for (size_t i = 0; i < 2 * policy_.sustain_periods; ++i)
+    {
+        period(100);
+        EXPECT_EQ("HoldOff", last_verdict());
+    }
+
+    EXPECT_TRUE(migrations_.empty());
+
+    now_ += policy_.holdoff;
+
+    for (size_t i = 0; i < policy_.sustain_periods; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_EQ(1U, migrations_.size());
+}
+
+TEST_F(MigrationControllerTest, failed_migration)
+{
+    fail_migration_ = true;
+
+    for (size_t i = 0; i < policy_.sustain_periods; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_EQ(1U, migrations_.size());
+    EXPECT_EQ("MigrationFailed", last_verdict());
+
+    // retried in the next period
+    fail_migration_ = false;
+    period(100);
+
+    EXPECT_EQ(2U, migrations_.size());
+    EXPECT_EQ("Migrate", last_verdict());
+}
+
+TEST_F(MigrationControllerTest, idle_objects_are_forgotten)
+{
+    period(policy_.volume_read_threshold - 1);
+    EXPECT_EQ(1U, ctrl_.tracked_objects());
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        period(0);
+    }
+
+    EXPECT_EQ(0U, ctrl_.tracked_objects());
+
+    // the count starts over
+    period(1);
+    EXPECT_TRUE(ctrl_.decisions().empty());
+}
+
+TEST_F(MigrationControllerTest, bounded_decisions)
+{
+    cost_.volume_potential = 0;
+
+    for (size_t i = 0; i < 2 * vfs::MigrationController::max_decisions; ++i)
+    {
+        period(100);
+    }
+
+    EXPECT_EQ(vfs::MigrationController::max_decisions,
+              ctrl_.decisions().size());
+}
+
+}
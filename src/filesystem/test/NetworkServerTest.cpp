@@ -18,6 +18,8 @@
 #include "../PythonClient.h"
 #include "../NetworkXioInterface.h"
 
+#include <poll.h>
+
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -100,6 +102,8 @@ public:
     {
         FileSystemTestBase::SetUp();
         bpt::ptree pt;
+        initialized_params::PARAMETER_TYPE(network_portals)(2).persist(pt);
+        initialized_params::PARAMETER_TYPE(network_portal_base_port)(FileSystemTestSetup::local_edge_portal_base_port()).persist(pt);
 
         net_xio_server_ = std::make_unique<NetworkXioInterface>(pt,
                                                                 RegisterComponent::F,
@@ -990,6 +994,234 @@ TEST_F(NetworkServerTest, write_flush_read)
               ovs_ctx_attr_destroy(ctx_attr));
 }
 
+TEST_F(NetworkServerTest, aio_submitv_getevents)
+{
+    uint64_t volume_size = 1 << 30;
+    ovs_ctx_attr_t *ctx_attr = ovs_ctx_attr_new();
+    ASSERT_TRUE(ctx_attr != nullptr);
+    EXPECT_EQ(0,
+              ovs_ctx_attr_set_transport(ctx_attr,
+                                         FileSystemTestSetup::edge_transport().c_str(),
+                                         FileSystemTestSetup::address().c_str(),
+                                         FileSystemTestSetup::local_edge_port()));
+    ovs_ctx_t *ctx = ovs_ctx_new(ctx_attr);
+    ASSERT_TRUE(ctx != nullptr);
+    EXPECT_EQ(0,
+              ovs_create_volume(ctx,
+                                "volume",
+                                volume_size));
+    ASSERT_EQ(0,
+              ovs_ctx_init(ctx,
+                           "volume",
+                           O_RDWR));
+
+    ovs_aio_queue_t *queue = ovs_aio_queue_create(ctx);
+    ASSERT_TRUE(queue != nullptr);
+
+    const int efd = ovs_aio_queue_eventfd(queue);
+    ASSERT_LE(0, efd);
+
+    const size_t nr = 32;
+    const size_t bsize = 4096;
+
+    std::vector<std::unique_ptr<uint8_t[]>> bufs(nr);
+    std::vector<struct ovs_aiocb> aios(nr);
+    std::vector<struct ovs_aiocb*> aiops(nr);
+    std::vector<struct ovs_aio_event> events(nr);
+
+    auto reap_all([&]
+                  {
+                      size_t count = 0;
+                      while (count < nr)
+                      {
+                          struct pollfd pfd = { efd, POLLIN, 0 };
+                          ASSERT_EQ(1,
+                                    poll(&pfd,
+                                         1,
+                                         -1));
+                          const int r = ovs_aio_getevents(queue,
+                                                          0,
+                                                          nr - count,
+                                                          events.data() + count,
+                                                          NULL);
+                          ASSERT_LE(0, r);
+                          count += r;
+                      }
+
+                      for (const auto& ev : events)
+                      {
+                          EXPECT_EQ(static_cast<ssize_t>(bsize), ev.rv);
+                          EXPECT_EQ(0, ev.err);
+                          EXPECT_TRUE(ev.aiocbp->request_ == nullptr);
+                      }
+
+                      // drained -> the eventfd was reset
+                      struct pollfd pfd = { efd, POLLIN, 0 };
+                      EXPECT_EQ(0,
+                                poll(&pfd,
+                                     1,
+                                     0));
+                  });
+
+    for (size_t i = 0; i < nr; ++i)
+    {
+        bufs[i] = std::make_unique<uint8_t[]>(bsize);
+        memset(bufs[i].get(),
+               'a' + i % 26,
+               bsize);
+
+        aios[i].aio_buf = bufs[i].get();
+        aios[i].aio_nbytes = bsize;
+        aios[i].aio_offset = i * bsize;
+        aios[i].aio_opcode = OVS_AIO_WRITE;
+        aiops[i] = &aios[i];
+    }
+
+    ASSERT_EQ(static_cast<int>(nr),
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data(),
+                              nr));
+    reap_all();
+
+    for (size_t i = 0; i < nr; ++i)
+    {
+        memset(bufs[i].get(),
+               0,
+               bsize);
+        aios[i].aio_opcode = OVS_AIO_READ;
+    }
+
+    ASSERT_EQ(static_cast<int>(nr),
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data(),
+                              nr));
+    reap_all();
+
+    for (size_t i = 0; i < nr; ++i)
+    {
+        const std::vector<char> ref(bsize, 'a' + i % 26);
+        EXPECT_EQ(0,
+                  memcmp(bufs[i].get(),
+                         ref.data(),
+                         bsize));
+    }
+
+    // everything up to the first invalid aiocb is submitted
+    aios[0].aio_opcode = OVS_AIO_FLUSH;
+    aios[1].aio_nbytes = 0;
+
+    EXPECT_EQ(1,
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data(),
+                              2));
+    EXPECT_EQ(1,
+              ovs_aio_getevents(queue,
+                                1,
+                                nr,
+                                events.data(),
+                                NULL));
+    EXPECT_EQ(&aios[0], events[0].aiocbp);
+    EXPECT_EQ(0, events[0].err);
+
+    EXPECT_EQ(-1,
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data() + 1,
+                              1));
+    EXPECT_EQ(EINVAL, errno);
+
+    const struct timespec timeout = { 0, 1000000 };
+    EXPECT_EQ(0,
+              ovs_aio_getevents(queue,
+                                1,
+                                nr,
+                                events.data(),
+                                &timeout));
+
+    EXPECT_EQ(0,
+              ovs_aio_queue_destroy(queue));
+
+    EXPECT_EQ(0,
+              ovs_ctx_destroy(ctx));
+    EXPECT_EQ(0,
+              ovs_ctx_attr_destroy(ctx_attr));
+}
+
+TEST_F(NetworkServerTest, portal_request_counters)
+{
+    const std::vector<uint64_t> before(net_xio_server_->portal_requests());
+    ASSERT_EQ(std::max(1U, net_xio_server_->portals()),
+              before.size());
+
+    uint64_t volume_size = 1 << 30;
+    ovs_ctx_attr_t *ctx_attr = ovs_ctx_attr_new();
+    ASSERT_TRUE(ctx_attr != nullptr);
+    EXPECT_EQ(0,
+              ovs_ctx_attr_set_transport(ctx_attr,
+                                         FileSystemTestSetup::edge_transport().c_str(),
+                                         FileSystemTestSetup::address().c_str(),
+                                         FileSystemTestSetup::local_edge_port()));
+
+    const size_t nctxs = 2 * before.size();
+    std::vector<ovs_ctx_t*> ctxs;
+
+    for (size_t i = 0; i < nctxs; ++i)
+    {
+        ovs_ctx_t *ctx = ovs_ctx_new(ctx_attr);
+        ASSERT_TRUE(ctx != nullptr);
+        ctxs.push_back(ctx);
+    }
+
+    EXPECT_EQ(0,
+              ovs_create_volume(ctxs[0],
+                                "volume",
+                                volume_size));
+
+    const std::string pattern("openvstorage1");
+    const size_t nwrites = 4;
+
+    for (auto ctx : ctxs)
+    {
+        ASSERT_EQ(0,
+                  ovs_ctx_init(ctx,
+                               "volume",
+                               O_RDWR));
+        for (size_t i = 0; i < nwrites; ++i)
+        {
+            EXPECT_EQ(pattern.length(),
+                      ovs_write(ctx,
+                                pattern.c_str(),
+                                pattern.length(),
+                                i * 4096));
+        }
+    }
+
+    const std::vector<uint64_t> after(net_xio_server_->portal_requests());
+    ASSERT_EQ(before.size(),
+              after.size());
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < after.size(); ++i)
+    {
+        EXPECT_LE(before[i], after[i]);
+        total += after[i] - before[i];
+    }
+
+    EXPECT_LE(nctxs * nwrites, total);
+
+    for (auto ctx : ctxs)
+    {
+        EXPECT_EQ(0,
+                  ovs_ctx_destroy(ctx));
+    }
+
+    EXPECT_EQ(0,
+              ovs_ctx_attr_destroy(ctx_attr));
+}
+
 TEST_F(NetworkServerTest, create_rollback_list_remove_snapshot_local)
 {
     test_snapshot_ops(false);
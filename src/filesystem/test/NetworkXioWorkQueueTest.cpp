@@ -0,0 +1,311 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+
+#include <gtest/gtest.h>
+
+#include "../NetworkXioWorkQueue.h"
+
+namespace volumedriverfstest
+{
+
+namespace vfs = volumedriverfs;
+
+class NetworkXioWorkQueueTest
+    : public testing::Test
+{
+protected:
+    // Reaps the completion queues until `count` requests came back;
+    // returns the number of completions per queue.
+    std::vector<size_t>
+    reap(std::vector<std::unique_ptr<vfs::EventFD>>& evfds,
+         std::vector<std::unique_ptr<vfs::NetworkXioCompletionQueue>>& cqs,
+         const size_t count)
+    {
+        std::vector<size_t> done(cqs.size(), 0);
+        size_t total = 0;
+
+        while (total < count)
+        {
+            std::vector<pollfd> fds(evfds.size());
+            for (size_t i = 0; i < evfds.size(); ++i)
+            {
+                fds[i].fd = *evfds[i];
+                fds[i].events = POLLIN;
+                fds[i].revents = 0;
+            }
+
+            EXPECT_LT(0, ::poll(fds.data(), fds.size(), 10000));
+
+            for (size_t i = 0; i < cqs.size(); ++i)
+            {
+                evfds[i]->readfd();
+                while (not cqs[i]->is_finished_empty())
+                {
+                    delete cqs[i]->get_finished();
+                    ++done[i];
+                    ++total;
+                }
+            }
+        }
+
+        return done;
+    }
+
+    void
+    make_queues(const size_t n,
+                std::vector<std::unique_ptr<vfs::EventFD>>& evfds,
+                std::vector<std::unique_ptr<vfs::NetworkXioCompletionQueue>>& cqs,
+                bool affinity = true)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            evfds.emplace_back(std::make_unique<vfs::EventFD>());
+            cqs.emplace_back(std::make_unique<vfs::NetworkXioCompletionQueue>(*evfds.back(),
+                                                                              affinity ?
+                                                                              boost::optional<unsigned int>(i) :
+                                                                              boost::none));
+        }
+    }
+
+    vfs::NetworkXioRequest*
+    make_request(std::function<void()> fun,
+                 std::function<void()> cancel_fun = nullptr)
+    {
+        auto req = new vfs::NetworkXioRequest();
+        req->work.func = [fun](vfs::Work*)
+            {
+                fun();
+            };
+        if (cancel_fun)
+        {
+            req->work.cancel = [cancel_fun](vfs::Work*)
+                {
+                    cancel_fun();
+                };
+        }
+        return req;
+    }
+};
+
+TEST_F(NetworkXioWorkQueueTest, completions_go_to_their_queue)
+{
+    const size_t nqueues = 3;
+    const size_t nsubmitters = nqueues;
+    const size_t count = 1000;
+
+    std::vector<std::unique_ptr<vfs::EventFD>> evfds;
+    std::vector<std::unique_ptr<vfs::NetworkXioCompletionQueue>> cqs;
+    make_queues(nqueues, evfds, cqs);
+
+    vfs::NetworkXioWorkQueue wq("test_wq",
+                                4);
+    std::atomic<size_t> processed(0);
+
+    std::vector<std::thread> submitters;
+    for (size_t i = 0; i < nsubmitters; ++i)
+    {
+        submitters.emplace_back([&, i]
+                                {
+                                    for (size_t j = 0; j < count; ++j)
+                                    {
+                                        wq.work_schedule(make_request([&]
+                                                                      {
+                                                                          ++processed;
+                                                                      }),
+                                                         *cqs[i]);
+                                    }
+                                });
+    }
+
+    const std::vector<size_t> done(reap(evfds,
+                                        cqs,
+                                        nsubmitters * count));
+
+    for (auto& t : submitters)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(nsubmitters * count, processed);
+    for (const auto& d : done)
+    {
+        EXPECT_EQ(count, d);
+    }
+
+    const vfs::NetworkXioWorkQueue::Stats stats(wq.stats());
+    EXPECT_EQ(4U, stats.threads);
+    EXPECT_EQ(nsubmitters * count, stats.scheduled);
+    EXPECT_LE(stats.dispatch_usecs_max,
+              stats.dispatch_usecs_total);
+}
+
+TEST_F(NetworkXioWorkQueueTest, idle_workers_steal)
+{
+    std::vector<std::unique_ptr<vfs::EventFD>> evfds;
+    std::vector<std::unique_ptr<vfs::NetworkXioCompletionQueue>> cqs;
+    make_queues(1, evfds, cqs);
+
+    vfs::NetworkXioWorkQueue wq("test_wq",
+                                4);
+
+    const size_t count = 64;
+    std::atomic<size_t> processed(0);
+
+    // everything is queued to the same worker
+    for (size_t i = 0; i < count; ++i)
+    {
+        wq.work_schedule(make_request([&]
+                                      {
+                                          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                          ++processed;
+                                      }),
+                         *cqs[0]);
+    }
+
+    reap(evfds,
+         cqs,
+         count);
+
+    EXPECT_EQ(count, processed);
+    EXPECT_LT(0U, wq.stats().stolen);
+}
+
+TEST_F(NetworkXioWorkQueueTest, round_robin_without_affinity)
+{
+    std::vector<std::unique_ptr<vfs::EventFD>> evfds;
+    std::vector<std::unique_ptr<vfs::NetworkXioCompletionQueue>> cqs;
+    make_queues(1, evfds, cqs, false);
+
+    vfs::NetworkXioWorkQueue wq("test_wq",
+                                4);
+
+    const size_t count = 1000;
+    std::atomic<size_t> processed(0);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        wq.work_schedule(make_request([&]
+                                      {
+                                          ++processed;
+                                      }),
+                         *cqs[0]);
+    }
+
+    reap(evfds,
+         cqs,
+         count);
+
+    EXPECT_EQ(count, processed);
+    EXPECT_EQ(count, wq.stats().scheduled);
+}
+
+TEST_F(NetworkXioWorkQueueTest, shutdown_cancels_queued_requests)
+{
+    std::vector<std::unique_ptr<vfs::EventFD>> evfds;
+    std::vector<std::unique_ptr<vfs::NetworkXioCompletionQueue>> cqs;
+    make_queues(1, evfds, cqs);
+
+    vfs::NetworkXioWorkQueue wq("test_wq",
+                                1);
+
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> released(release.get_future().share());
+
+    std::atomic<size_t> processed(0);
+    std::atomic<size_t> cancelled(0);
+
+    // keeps the only worker busy
+    wq.work_schedule(make_request([&]
+                                  {
+                                      started.set_value();
+                                      released.wait();
+                                      ++processed;
+                                  },
+                                  [&]
+                                  {
+                                      ++cancelled;
+                                  }),
+                     *cqs[0]);
+
+    started.get_future().wait();
+
+    auto schedule([&]
+                  {
+                      wq.work_schedule(make_request([&]
+                                                    {
+                                                        ++processed;
+                                                    },
+                                                    [&]
+                                                    {
+                                                        ++cancelled;
+                                                    }),
+                                       *cqs[0]);
+                  });
+
+    const size_t queued = 16;
+    for (size_t i = 0; i < queued; ++i)
+    {
+        schedule();
+    }
+
+    EXPECT_EQ(0U, cancelled);
+
+    std::thread stopper([&]
+                        {
+                            wq.shutdown();
+                        });
+
+    // Requests scheduled once shutdown is under way are cancelled right
+    // away - keep going until that happens to be sure the worker will not
+    // pick up anything after the one it's busy with.
+    size_t late = 0;
+    while (cancelled == 0)
+    {
+        schedule();
+        ++late;
+    }
+
+    release.set_value();
+    stopper.join();
+
+    reap(evfds,
+         cqs,
+         1 + queued + late);
+
+    EXPECT_EQ(1U, processed);
+    EXPECT_EQ(queued + late, cancelled);
+    EXPECT_EQ(queued + late, wq.stats().cancelled);
+}
+
+TEST_F(NetworkXioWorkQueueTest, shutdown_with_parked_workers)
+{
+    for (size_t i = 0; i < 10; ++i)
+    {
+        vfs::NetworkXioWorkQueue wq("test_wq",
+                                    8);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        wq.shutdown();
+    }
+}
+
+}
@@ -71,15 +71,28 @@ class RemoteTest
 {
 public:
     RemoteTest()
-        : FileSystemTestBase(FileSystemTestSetupParameters("RemoteTest")
-                             .redirect_timeout_ms(10000)
-                             .backend_sync_timeout_ms(9500)
-                             .migrate_timeout_ms(500)
-                             .redirect_retries(1)
-                             .scrub_manager_interval_secs(3600))
+        : RemoteTest(params_("RemoteTest"))
+    {}
+
+    static FileSystemTestSetupParameters
+    params_(const std::string& name)
+    {
+        return FileSystemTestSetupParameters(name)
+            .redirect_timeout_ms(10000)
+            .backend_sync_timeout_ms(9500)
+            .migrate_timeout_ms(500)
+            .redirect_retries(1)
+            .scrub_manager_interval_secs(3600);
+    }
+
+protected:
+    explicit RemoteTest(const FileSystemTestSetupParameters& params)
+        : FileSystemTestBase(params)
         , remote_root_(mount_dir(remote_dir(topdir_)))
     {}
 
+public:
+
     virtual void
     SetUp()
     {
@@ -339,11 +352,13 @@ public:
         for (uint64_t i = 0; i < wthresh - 1; ++i)
         {
             write_to_file(fname, pattern.c_str(), pattern.size(), off);
+            check_migrations();
             verify_registration(*maybe_id, remote_node_id());
         }
 
         write_to_file(fname, pattern.c_str(), pattern.size(), off);
 
+        check_migrations();
         verify_registration(*maybe_id, local_node_id());
 
         check_file(fname, pattern, pattern.size(), off);
@@ -380,6 +395,7 @@ public:
             EXPECT_EQ(static_cast<ssize_t>(rbuf.size()), r);
             EXPECT_EQ(0, memcmp(&rbuf[0], &ref[0], rbuf.size()));
 
+            check_migrations();
             verify_registration(*maybe_id, remote_node_id());
         }
 
@@ -392,6 +408,7 @@ public:
         EXPECT_EQ(static_cast<ssize_t>(rbuf.size()), r);
         EXPECT_EQ(0, memcmp(&rbuf[0], &ref[0], rbuf.size()));
 
+        check_migrations();
         verify_registration(*maybe_id, local_node_id());
     }
 
@@ -671,6 +688,58 @@ TEST_F(RemoteTest, file_read_write)
     test_read_write(false);
 }
 
+// Several fuse threads redirecting I/O to the same remote concurrently - their
+// requests are multiplexed over one connection and the responses need to find
+// their way back to the right caller.
+TEST_F(RemoteTest, concurrent_redirected_io)
+{
+    const vfs::FrontendPath fname(make_volume_name("/some-volume"));
+    const uint64_t size = 10ULL << 20;
+    const auto rpath(make_remote_file(fname, size));
+
+    const size_t nworkers = 8;
+    const size_t iterations = 64;
+    const size_t chunk = 4096;
+
+    std::vector<std::thread> workers;
+    workers.reserve(nworkers);
+
+    for (size_t i = 0; i < nworkers; ++i)
+    {
+        workers.emplace_back([&, i]
+                             {
+                                 const std::string pattern("worker-" +
+                                                           boost::lexical_cast<std::string>(i));
+                                 for (size_t j = 0; j < iterations; ++j)
+                                 {
+                                     const uint64_t off = (j * nworkers + i) * chunk;
+                                     write_to_file(fname,
+                                                   pattern,
+                                                   pattern.size(),
+                                                   off);
+                                     check_file(fname,
+                                                pattern,
+                                                pattern.size(),
+                                                off);
+                                 }
+                             });
+    }
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+
+    for (size_t i = 0; i < nworkers; ++i)
+    {
+        const std::string pattern("worker-" +
+                                  boost::lexical_cast<std::string>(i));
+        check_remote_file(rpath,
+                          pattern,
+                          i * chunk);
+    }
+}
+
 TEST_F(RemoteTest, stale_volume_registration)
 {
     test_stale_registration(vfs::FrontendPath(make_volume_name("/some-volume")));
@@ -1367,6 +1436,7 @@ TEST_F(RemoteTest, volume_migrate_timeout)
                   s);
     }
 
+    check_migrations();
     verify_registration(*maybe_id,
                         local_node_id());
 }
@@ -1484,6 +1554,7 @@ TEST_F(RemoteTest, auto_migration_without_foc)
                             ref.size()));
     }
 
+    check_migrations();
     verify_registration(*maybe_id, local_node_id());
 }
 
@@ -1559,4 +1630,70 @@ TEST_F(RemoteTest, DISABLED_setup_remote_hack)
     sleep(1000000);
 }
 
+// Same as above but with the remote instance using the FUSE low level API.
+class FuseLowLevelRemoteTest
+    : public RemoteTest
+{
+public:
+    FuseLowLevelRemoteTest()
+        : RemoteTest(params_("FuseLowLevelRemoteTest")
+                     .fuse_use_lowlevel_api(true))
+    {}
+};
+
+TEST_F(FuseLowLevelRemoteTest, volume_create_and_destroy)
+{
+    test_create_and_destroy(true);
+}
+
+TEST_F(FuseLowLevelRemoteTest, file_create_and_destroy)
+{
+    test_create_and_destroy(false);
+}
+
+TEST_F(FuseLowLevelRemoteTest, volume_read_write)
+{
+    test_read_write(true);
+}
+
+TEST_F(FuseLowLevelRemoteTest, file_read_write)
+{
+    test_read_write(false);
+}
+
+TEST_F(FuseLowLevelRemoteTest, file_rename)
+{
+    const vfs::FrontendPath fname1("/some-file");
+    const auto rpath1(make_remote_file(fname1, 0));
+
+    const fs::path fname2("/some-other-file");
+    const auto rpath2(make_remote_file(fname2, 0));
+
+    const std::string pattern("written before rename");
+    write_to_remote_file(rpath2, pattern, 0);
+    fs::rename(rpath2, rpath1);
+
+    check_remote_file(rpath1, pattern, 0);
+    check_file(fname1, pattern, pattern.size(), 0);
+}
+
+TEST_F(FuseLowLevelRemoteTest, unlink_open_directory)
+{
+    const fs::path rdir(remote_root_ / "directory");
+    fs::create_directories(rdir);
+    ASSERT_TRUE(fs::exists(rdir));
+
+    const int fd = ::open(rdir.string().c_str(),
+                          O_RDONLY);
+    ASSERT_LE(0, fd);
+
+    auto on_exit(yt::make_scope_exit([fd]
+                                     {
+                                         ::close(fd);
+                                     }));
+
+    fs::remove_all(rdir);
+    EXPECT_FALSE(fs::exists(rdir));
+}
+
 }
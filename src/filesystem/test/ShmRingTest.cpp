@@ -0,0 +1,187 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <youtils/UUID.h>
+
+#include "../ShmProtocol.h"
+#include "../ShmRing.h"
+
+namespace volumedriverfstest
+{
+
+namespace vfs = volumedriverfs;
+namespace yt = youtils;
+
+class ShmRingTest
+    : public testing::Test
+{
+protected:
+    using Ring = vfs::ShmRing<uint64_t, 16>;
+
+    const std::chrono::microseconds max_spin_ = std::chrono::microseconds(20);
+};
+
+TEST_F(ShmRingTest, push_and_pop)
+{
+    Ring ring;
+    EXPECT_TRUE(ring.empty());
+
+    std::vector<uint64_t> in(Ring::capacity + 5);
+    for (size_t i = 0; i < in.size(); ++i)
+    {
+        in[i] = i;
+    }
+
+    EXPECT_EQ(Ring::capacity,
+              ring.push(in.data(),
+                        in.size()));
+    EXPECT_TRUE(ring.full());
+    EXPECT_EQ(0U,
+              ring.push(in.data(),
+                        1));
+
+    std::vector<uint64_t> out(in.size());
+    EXPECT_EQ(5U,
+              ring.pop(out.data(),
+                       5));
+    EXPECT_EQ(5U,
+              ring.push(in.data() + Ring::capacity,
+                        5));
+
+    EXPECT_EQ(Ring::capacity,
+              ring.pop(out.data() + 5,
+                       out.size() - 5));
+    EXPECT_TRUE(ring.empty());
+
+    for (size_t i = 0; i < Ring::capacity + 5; ++i)
+    {
+        EXPECT_EQ(i, out[i]);
+    }
+}
+
+TEST_F(ShmRingTest, wait_timeout)
+{
+    Ring ring;
+    vfs::ShmAdaptiveSpin spin(max_spin_);
+    const struct timespec timeout = { 0, 10000000 };
+
+    EXPECT_FALSE(ring.wait_not_empty(spin,
+                                     &timeout));
+    // we ended up sleeping, so we should spin less next time
+    EXPECT_GT(max_spin_, spin.budget());
+
+    const uint64_t val = 42;
+    EXPECT_EQ(1U, ring.push(&val, 1));
+    EXPECT_TRUE(ring.wait_not_empty(spin,
+                                    &timeout));
+}
+
+TEST_F(ShmRingTest, producer_consumer)
+{
+    Ring ring;
+    const uint64_t count = 100000;
+    const struct timespec timeout = { 1, 0 };
+
+    std::thread producer([&]
+                         {
+                             vfs::ShmAdaptiveSpin spin(max_spin_);
+                             uint64_t next = 0;
+                             std::vector<uint64_t> batch(7);
+
+                             while (next < count)
+                             {
+                                 const size_t n = std::min<uint64_t>(batch.size(),
+                                                                     count - next);
+                                 for (size_t i = 0; i < n; ++i)
+                                 {
+                                     batch[i] = next + i;
+                                 }
+
+                                 const size_t pushed = ring.push(batch.data(),
+                                                                 n);
+                                 next += pushed;
+                                 if (pushed < n)
+                                 {
+                                     ring.wait_not_full(spin,
+                                                        &timeout);
+                                 }
+                             }
+                         });
+
+    vfs::ShmAdaptiveSpin spin(max_spin_);
+    std::vector<uint64_t> batch(5);
+    uint64_t expected = 0;
+
+    while (expected < count)
+    {
+        const size_t n = ring.pop(batch.data(),
+                                  batch.size());
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ(expected++, batch[i]);
+        }
+
+        if (n == 0)
+        {
+            ring.wait_not_empty(spin,
+                                &timeout);
+        }
+    }
+
+    producer.join();
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST_F(ShmRingTest, shared_region)
+{
+    const std::string name(yt::UUID().str());
+    const uint32_t nqueues = 3;
+
+    vfs::ShmRings server(name,
+                         nqueues);
+    vfs::ShmRings client(name);
+
+    ASSERT_EQ(nqueues, client.nqueues());
+
+    for (uint32_t i = 0; i < nqueues; ++i)
+    {
+        vfs::ShmRequest req;
+        req.type = vfs::ShmRequestType::Flush;
+        req.opaque = i;
+        EXPECT_EQ(1U, client.queue(i).sq.push(&req, 1));
+    }
+
+    for (uint32_t i = 0; i < nqueues; ++i)
+    {
+        vfs::ShmRequest req;
+        ASSERT_EQ(1U, server.queue(i).sq.pop(&req, 1));
+        EXPECT_EQ(vfs::ShmRequestType::Flush, req.type);
+        EXPECT_EQ(i, req.opaque);
+    }
+
+    EXPECT_FALSE(client.stopped());
+    server.stop();
+    EXPECT_TRUE(client.stopped());
+
+    EXPECT_THROW(vfs::ShmRings(yt::UUID().str()),
+                 std::exception);
+}
+
+}
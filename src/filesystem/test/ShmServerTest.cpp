@@ -18,6 +18,8 @@
 #include "../PythonClient.h"
 #include "../ShmOrbInterface.h"
 
+#include <poll.h>
+
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/property_tree/json_parser.hpp>
@@ -932,6 +934,294 @@ TEST_F(ShmServerTest, ovs_write_flush_read)
               ovs_ctx_attr_destroy(ctx_attr));
 }
 
+TEST_F(ShmServerTest, ovs_aio_submitv_getevents)
+{
+    uint64_t volume_size = 1 << 30;
+    ovs_ctx_attr_t *ctx_attr = ovs_ctx_attr_new();
+    ASSERT_TRUE(ctx_attr != nullptr);
+    EXPECT_EQ(0,
+              ovs_ctx_attr_set_transport(ctx_attr,
+                                         "shm",
+                                         NULL,
+                                         0));
+    ovs_ctx_t *ctx = ovs_ctx_new(ctx_attr);
+    ASSERT_TRUE(ctx != nullptr);
+    EXPECT_EQ(0,
+              ovs_create_volume(ctx,
+                                "volume",
+                                volume_size));
+    ASSERT_EQ(0,
+              ovs_ctx_init(ctx,
+                           "volume",
+                           O_RDWR));
+
+    ovs_aio_queue_t *queue = ovs_aio_queue_create(ctx);
+    ASSERT_TRUE(queue != nullptr);
+
+    const int efd = ovs_aio_queue_eventfd(queue);
+    ASSERT_LE(0, efd);
+
+    const size_t nr = 32;
+    const size_t bsize = 4096;
+
+    std::vector<ovs_buffer_t*> bufs(nr);
+    std::vector<struct ovs_aiocb> aios(nr);
+    std::vector<struct ovs_aiocb*> aiops(nr);
+    std::vector<struct ovs_aio_event> events(nr);
+
+    auto reap_all([&]
+                  {
+                      size_t count = 0;
+                      while (count < nr)
+                      {
+                          struct pollfd pfd = { efd, POLLIN, 0 };
+                          ASSERT_EQ(1,
+                                    poll(&pfd,
+                                         1,
+                                         -1));
+                          const int r = ovs_aio_getevents(queue,
+                                                          0,
+                                                          nr - count,
+                                                          events.data() + count,
+                                                          NULL);
+                          ASSERT_LE(0, r);
+                          count += r;
+                      }
+
+                      for (const auto& ev : events)
+                      {
+                          EXPECT_EQ(static_cast<ssize_t>(bsize), ev.rv);
+                          EXPECT_EQ(0, ev.err);
+                          EXPECT_TRUE(ev.aiocbp->request_ == nullptr);
+                      }
+
+                      // drained -> the eventfd was reset
+                      struct pollfd pfd = { efd, POLLIN, 0 };
+                      EXPECT_EQ(0,
+                                poll(&pfd,
+                                     1,
+                                     0));
+                  });
+
+    for (size_t i = 0; i < nr; ++i)
+    {
+        bufs[i] = ovs_allocate(ctx,
+                               bsize);
+        ASSERT_TRUE(bufs[i] != nullptr);
+        memset(ovs_buffer_data(bufs[i]),
+               'a' + i % 26,
+               bsize);
+
+        aios[i].aio_buf = ovs_buffer_data(bufs[i]);
+        aios[i].aio_nbytes = bsize;
+        aios[i].aio_offset = i * bsize;
+        aios[i].aio_opcode = OVS_AIO_WRITE;
+        aiops[i] = &aios[i];
+    }
+
+    ASSERT_EQ(static_cast<int>(nr),
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data(),
+                              nr));
+    reap_all();
+
+    for (size_t i = 0; i < nr; ++i)
+    {
+        memset(ovs_buffer_data(bufs[i]),
+               0,
+               bsize);
+        aios[i].aio_opcode = OVS_AIO_READ;
+    }
+
+    ASSERT_EQ(static_cast<int>(nr),
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data(),
+                              nr));
+    reap_all();
+
+    for (size_t i = 0; i < nr; ++i)
+    {
+        const std::vector<char> ref(bsize, 'a' + i % 26);
+        EXPECT_EQ(0,
+                  memcmp(ovs_buffer_data(bufs[i]),
+                         ref.data(),
+                         bsize));
+    }
+
+    // everything up to the first invalid aiocb is submitted
+    aios[0].aio_opcode = OVS_AIO_FLUSH;
+    aios[1].aio_nbytes = 0;
+
+    EXPECT_EQ(1,
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data(),
+                              2));
+    EXPECT_EQ(1,
+              ovs_aio_getevents(queue,
+                                1,
+                                nr,
+                                events.data(),
+                                NULL));
+    EXPECT_EQ(&aios[0], events[0].aiocbp);
+    EXPECT_EQ(0, events[0].err);
+
+    EXPECT_EQ(-1,
+              ovs_aio_submitv(ctx,
+                              queue,
+                              aiops.data() + 1,
+                              1));
+    EXPECT_EQ(EINVAL, errno);
+
+    const struct timespec timeout = { 0, 1000000 };
+    EXPECT_EQ(0,
+              ovs_aio_getevents(queue,
+                                1,
+                                nr,
+                                events.data(),
+                                &timeout));
+
+    EXPECT_EQ(0,
+              ovs_aio_queue_destroy(queue));
+
+    for (auto& b : bufs)
+    {
+        EXPECT_EQ(0,
+                  ovs_deallocate(ctx,
+                                 b));
+    }
+
+    EXPECT_EQ(0,
+              ovs_ctx_destroy(ctx));
+    EXPECT_EQ(0,
+              ovs_ctx_attr_destroy(ctx_attr));
+}
+
+TEST_F(ShmServerTest, ovs_read_cache)
+{
+    uint64_t volume_size = 1 << 30;
+    ovs_ctx_attr_t *ctx_attr = ovs_ctx_attr_new();
+    ASSERT_TRUE(ctx_attr != nullptr);
+    EXPECT_EQ(0,
+              ovs_ctx_attr_set_transport(ctx_attr,
+                                         "shm",
+                                         NULL,
+                                         0));
+    EXPECT_EQ(-1,
+              ovs_ctx_attr_set_read_cache_size(ctx_attr,
+                                               512));
+    EXPECT_EQ(EINVAL, errno);
+    EXPECT_EQ(0,
+              ovs_ctx_attr_set_read_cache_size(ctx_attr,
+                                               1 << 20));
+    ovs_ctx_t *ctx = ovs_ctx_new(ctx_attr);
+    ASSERT_TRUE(ctx != nullptr);
+    EXPECT_EQ(0,
+              ovs_create_volume(ctx,
+                                "volume",
+                                volume_size));
+    ASSERT_EQ(0,
+              ovs_ctx_init(ctx,
+                           "volume",
+                           O_RDWR));
+
+    const size_t size = 8192;
+    ovs_buffer_t *buf = ovs_allocate(ctx,
+                                     size);
+    ASSERT_TRUE(buf != nullptr);
+    char *data = static_cast<char*>(ovs_buffer_data(buf));
+
+    memset(data,
+           'a',
+           size);
+    EXPECT_EQ(static_cast<ssize_t>(size),
+              ovs_write(ctx,
+                        data,
+                        size,
+                        0));
+
+    struct ovs_read_cache_stats stats;
+    ASSERT_EQ(0,
+              ovs_read_cache_stat(ctx,
+                                  &stats));
+    EXPECT_EQ(1U << 20, stats.capacity);
+    // write-through
+    EXPECT_EQ(size, stats.size);
+
+    auto check_read([&](char c,
+                        size_t len,
+                        off_t off)
+                    {
+                        memset(data,
+                               0,
+                               size);
+                        EXPECT_EQ(static_cast<ssize_t>(len),
+                                  ovs_read(ctx,
+                                           data,
+                                           len,
+                                           off));
+                        const std::vector<char> ref(len, c);
+                        EXPECT_EQ(0,
+                                  memcmp(data,
+                                         ref.data(),
+                                         len));
+                    });
+
+    check_read('a', size, 0);
+    check_read('a', 100, 4000);
+
+    ASSERT_EQ(0,
+              ovs_read_cache_stat(ctx,
+                                  &stats));
+    EXPECT_EQ(2U, stats.hits);
+    EXPECT_EQ(0U, stats.misses);
+
+    memset(data,
+           'b',
+           size);
+    EXPECT_EQ(4096,
+              ovs_write(ctx,
+                        data,
+                        4096,
+                        4096));
+    check_read('b', 4096, 4096);
+
+    // a partially overwritten cluster is no longer cached
+    memset(data,
+           'c',
+           size);
+    EXPECT_EQ(512,
+              ovs_write(ctx,
+                        data,
+                        512,
+                        0));
+    check_read('c', 512, 0);
+    check_read('a', 512, 512);
+
+    ASSERT_EQ(0,
+              ovs_read_cache_stat(ctx,
+                                  &stats));
+    EXPECT_EQ(3U, stats.hits);
+    EXPECT_EQ(2U, stats.misses);
+
+    EXPECT_EQ(0, ovs_flush(ctx));
+
+    ASSERT_EQ(0,
+              ovs_read_cache_stat(ctx,
+                                  &stats));
+    EXPECT_EQ(0U, stats.size);
+
+    EXPECT_EQ(0,
+              ovs_deallocate(ctx,
+                             buf));
+    EXPECT_EQ(0,
+              ovs_ctx_destroy(ctx));
+    EXPECT_EQ(0,
+              ovs_ctx_attr_destroy(ctx_attr));
+}
+
 TEST_F(ShmServerTest, ovs_create_truncate_volume)
 {
     uint64_t volume_size = 1 << 20;
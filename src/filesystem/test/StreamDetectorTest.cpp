@@ -0,0 +1,181 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../StreamDetector.h"
+
+namespace volumedriverfstest
+{
+
+namespace vfs = volumedriverfs;
+
+class StreamDetectorTest
+    : public testing::Test
+{
+protected:
+    const size_t rsize_ = 64ULL << 10;
+    const size_t max_window_ = 4ULL << 20;
+
+    // Feeds a sequential stream starting at off and checks that read ahead
+    // stays ahead of the reader, is contiguous and within the window.
+    void
+    check_stream(vfs::StreamDetector& d,
+                 const off_t start,
+                 const size_t count,
+                 off_t& ra_end,
+                 size_t& max_ra)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const off_t off = start + i * rsize_;
+            const auto ra(d.observe(off,
+                                    rsize_,
+                                    max_window_));
+            if (ra)
+            {
+                if (ra_end != 0)
+                {
+                    EXPECT_EQ(ra_end, ra->off);
+                }
+
+                EXPECT_GE(ra->off, static_cast<off_t>(off + rsize_));
+                EXPECT_LE(ra->off + ra->size, off + rsize_ + max_window_);
+
+                ra_end = ra->off + ra->size;
+                max_ra = std::max(max_ra,
+                                  ra->size);
+            }
+        }
+    }
+};
+
+TEST_F(StreamDetectorTest, sequential)
+{
+    vfs::StreamDetector d;
+
+    off_t ra_end = 0;
+    size_t max_ra = 0;
+    const size_t count = 1024;
+
+    check_stream(d,
+                 0,
+                 count,
+                 ra_end,
+                 max_ra);
+
+    EXPECT_EQ(1U, d.active_streams());
+    // the reader never caught up with the read ahead
+    EXPECT_GT(ra_end, static_cast<off_t>(count * rsize_));
+    // the window grew to the maximum
+    EXPECT_LE(max_window_ / 2, max_ra);
+    EXPECT_GE(max_window_, max_ra);
+}
+
+TEST_F(StreamDetectorTest, interleaved_streams)
+{
+    vfs::StreamDetector d;
+
+    const size_t nstreams = 3;
+    const off_t distance = 1ULL << 30;
+    std::vector<off_t> ra_ends(nstreams, 0);
+    std::vector<size_t> read_ahead(nstreams, 0);
+
+    for (size_t i = 0; i < 256; ++i)
+    {
+        for (size_t s = 0; s < nstreams; ++s)
+        {
+            const off_t off = s * distance + i * rsize_;
+            const auto ra(d.observe(off,
+                                    rsize_,
+                                    max_window_));
+            if (ra)
+            {
+                if (ra_ends[s] != 0)
+                {
+                    EXPECT_EQ(ra_ends[s], ra->off);
+                }
+                ra_ends[s] = ra->off + ra->size;
+                read_ahead[s] += ra->size;
+            }
+        }
+    }
+
+    EXPECT_EQ(nstreams, d.active_streams());
+
+    for (size_t s = 0; s < nstreams; ++s)
+    {
+        EXPECT_LT(0U, read_ahead[s]) << "stream " << s;
+        EXPECT_GT(ra_ends[s], static_cast<off_t>(s * distance + 256 * rsize_));
+    }
+}
+
+TEST_F(StreamDetectorTest, slightly_reordered)
+{
+    vfs::StreamDetector d;
+    size_t read_ahead = 0;
+
+    for (size_t i = 0; i < 256; i += 2)
+    {
+        // (i + 1) overtakes i
+        for (const size_t j : { i + 1, i })
+        {
+            const auto ra(d.observe(j * rsize_,
+                                    rsize_,
+                                    max_window_));
+            if (ra)
+            {
+                read_ahead += ra->size;
+            }
+        }
+    }
+
+    EXPECT_EQ(1U, d.active_streams());
+    EXPECT_LT(256 * rsize_, read_ahead);
+}
+
+TEST_F(StreamDetectorTest, random)
+{
+    vfs::StreamDetector d;
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint64_t> dist(0, 1ULL << 20);
+
+    for (size_t i = 0; i < 1024; ++i)
+    {
+        EXPECT_FALSE(d.observe(dist(gen) * rsize_,
+                               rsize_,
+                               max_window_));
+    }
+}
+
+TEST_F(StreamDetectorTest, disabled)
+{
+    vfs::StreamDetector d;
+
+    for (size_t i = 0; i < 64; ++i)
+    {
+        EXPECT_FALSE(d.observe(i * rsize_,
+                               rsize_,
+                               0));
+    }
+
+    EXPECT_EQ(0U, d.active_streams());
+}
+
+}
@@ -0,0 +1,285 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "CachePagePool.h"
+#include "ClusterLocationAndHash.h"
+
+#include <algorithm>
+#include <map>
+
+#include <youtils/Assert.h>
+
+namespace volumedriver
+{
+
+namespace
+{
+
+const uint64_t max_chunk_pages = 64;
+
+static_assert(sizeof(ClusterLocation) % sizeof(uint64_t) == 0,
+              "ClusterLocation size assumption does not hold");
+static_assert(sizeof(ClusterLocationAndHash) % sizeof(uint64_t) == 0,
+              "ClusterLocationAndHash size assumption does not hold");
+
+}
+
+CachePagePool::Chunk::Chunk(size_t n,
+                            PageFormat format)
+    : data(n * CachePage::size(format) / sizeof(uint64_t))
+{
+    const size_t words = CachePage::size(format) / sizeof(uint64_t);
+
+    pages.reserve(n);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        pages.emplace_back(0,
+                           &data[i * words],
+                           format);
+    }
+}
+
+uint64_t
+CachePageMemory::charge(uint64_t pages,
+                        size_t page_size,
+                        bool force)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (not force)
+    {
+        const uint64_t avail = used_ < capacity_ ?
+            capacity_ - used_ :
+            0;
+        pages = std::min(pages,
+                         avail / page_size);
+    }
+
+    used_ += pages * page_size;
+    return pages;
+}
+
+void
+CachePageMemory::uncharge(uint64_t pages,
+                          size_t page_size)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    VERIFY(used_ >= pages * page_size);
+    used_ -= pages * page_size;
+}
+
+uint64_t
+CachePageMemory::used() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return used_;
+}
+
+CachePagePool::CachePagePool(uint64_t capacity,
+                             PageFormat format,
+                             std::shared_ptr<CachePageMemory> memory)
+    : capacity_(capacity)
+    , format_(format)
+    , memory_(std::move(memory))
+    , allocated_(0)
+    , used_(0)
+{
+    VERIFY(capacity_ > 0);
+}
+
+CachePagePool::~CachePagePool()
+{
+    if (used_ != 0)
+    {
+        LOG_ERROR(used_ << " pages are still in use");
+    }
+
+    if (memory_)
+    {
+        memory_->uncharge(allocated_,
+                          CachePage::size(format_));
+    }
+}
+
+CachePage*
+CachePagePool::allocate(bool force)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (free_.empty())
+    {
+        uint64_t n = 0;
+        if (allocated_ < capacity_)
+        {
+            n = std::min(max_chunk_pages,
+                         capacity_ - allocated_);
+            if (memory_)
+            {
+                n = memory_->charge(n,
+                                    CachePage::size(format_));
+            }
+        }
+
+        if (n == 0)
+        {
+            if (force)
+            {
+                n = 1;
+                if (memory_)
+                {
+                    memory_->charge(n,
+                                    CachePage::size(format_),
+                                    true);
+                }
+
+                LOG_WARN("exceeding the capacity of " << capacity_ <<
+                         " pages or the shared memory limit to honour a reservation");
+            }
+            else
+            {
+                return nullptr;
+            }
+        }
+
+        chunks_.emplace_back(new Chunk(n,
+                                       format_));
+        for (CachePage& p : chunks_.back()->pages)
+        {
+            free_.push_back(&p);
+        }
+
+        allocated_ += n;
+    }
+
+    CachePage* p = free_.back();
+    free_.pop_back();
+    ++used_;
+
+    return p;
+}
+
+void
+CachePagePool::release(CachePage& p)
+{
+    ASSERT(not p.is_in_list());
+    ASSERT(not p.is_in_set());
+
+    // reset the state, the page might have been dropped while dirty
+    new(&p) CachePage(p.page_address(),
+                      p.data(),
+                      format_);
+
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    VERIFY(used_ > 0);
+    --used_;
+    free_.push_back(&p);
+}
+
+uint64_t
+CachePagePool::trim()
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (free_.empty())
+    {
+        return 0;
+    }
+
+    // first page of each chunk -> chunk index
+    std::map<const CachePage*, size_t> index;
+    for (size_t i = 0; i < chunks_.size(); ++i)
+    {
+        index.emplace(chunks_[i]->pages.data(),
+                      i);
+    }
+
+    auto chunk_of([&](const CachePage* p) -> size_t
+                  {
+                      auto it = index.upper_bound(p);
+                      ASSERT(it != index.begin());
+                      return (--it)->second;
+                  });
+
+    std::vector<size_t> nfree(chunks_.size(), 0);
+    for (const CachePage* p : free_)
+    {
+        ++nfree[chunk_of(p)];
+    }
+
+    std::vector<bool> unused(chunks_.size(), false);
+    uint64_t pages = 0;
+
+    for (size_t i = 0; i < chunks_.size(); ++i)
+    {
+        if (nfree[i] == chunks_[i]->pages.size())
+        {
+            unused[i] = true;
+            pages += nfree[i];
+        }
+    }
+
+    if (pages == 0)
+    {
+        return 0;
+    }
+
+    free_.erase(std::remove_if(free_.begin(),
+                               free_.end(),
+                               [&](const CachePage* p)
+                               {
+                                   return unused[chunk_of(p)];
+                               }),
+                free_.end());
+
+    size_t j = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i)
+    {
+        if (not unused[i])
+        {
+            chunks_[j++] = std::move(chunks_[i]);
+        }
+    }
+    chunks_.resize(j);
+
+    VERIFY(allocated_ >= pages);
+    allocated_ -= pages;
+
+    if (memory_)
+    {
+        memory_->uncharge(pages,
+                          CachePage::size(format_));
+    }
+
+    return pages;
+}
+
+uint64_t
+CachePagePool::used() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return used_;
+}
+
+uint64_t
+CachePagePool::allocated() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return allocated_;
+}
+
+}
@@ -0,0 +1,155 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VD_CACHE_PAGE_POOL_H_
+#define VD_CACHE_PAGE_POOL_H_
+
+#include "CachedMetaDataPage.h"
+
+#include <memory>
+#include <vector>
+
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+namespace volumedriver
+{
+
+// Memory limit shared by pools of different PageFormats (cf.
+// MetaDataCacheBudget), in bytes.
+class CachePageMemory
+{
+public:
+    explicit CachePageMemory(uint64_t capacity)
+        : capacity_(capacity)
+        , used_(0)
+    {}
+
+    ~CachePageMemory() = default;
+
+    CachePageMemory(const CachePageMemory&) = delete;
+
+    CachePageMemory&
+    operator=(const CachePageMemory&) = delete;
+
+    // Returns how many of the requested pages fit (and were charged) -
+    // all of them if force is set.
+    uint64_t
+    charge(uint64_t pages,
+           size_t page_size,
+           bool force = false);
+
+    void
+    uncharge(uint64_t pages,
+             size_t page_size);
+
+    uint64_t
+    capacity() const
+    {
+        return capacity_;
+    }
+
+    uint64_t
+    used() const;
+
+private:
+    DECLARE_LOGGER("CachePageMemory");
+
+    const uint64_t capacity_;
+
+    mutable boost::mutex lock_;
+    uint64_t used_;
+};
+
+// Arena the CachedMetaDataStores take their pages from - either one per
+// CachedMetaDataStore or one shared by all of them (cf. MetaDataCacheBudget).
+// Memory is allocated lazily in chunks and only given back to the system by
+// trim() or once the pool is destroyed. All pages of a pool have the same
+// PageFormat. If a CachePageMemory is passed in, chunks are also only
+// allocated as long as it has room for them.
+class CachePagePool
+{
+public:
+    explicit CachePagePool(uint64_t capacity,
+                           PageFormat format = PageFormat::Wide,
+                           std::shared_ptr<CachePageMemory> memory = nullptr);
+
+    ~CachePagePool();
+
+    CachePagePool(const CachePagePool&) = delete;
+
+    CachePagePool&
+    operator=(const CachePagePool&) = delete;
+
+    // Returns nullptr if all pages are in use, unless force is set in which
+    // case the pool grows beyond its capacity (used for reservations).
+    CachePage*
+    allocate(bool force = false);
+
+    void
+    release(CachePage&);
+
+    // Frees the chunks none of whose pages are in use. Returns the number of
+    // pages freed.
+    uint64_t
+    trim();
+
+    uint64_t
+    capacity() const
+    {
+        return capacity_;
+    }
+
+    PageFormat
+    format() const
+    {
+        return format_;
+    }
+
+    uint64_t
+    used() const;
+
+    uint64_t
+    allocated() const;
+
+private:
+    DECLARE_LOGGER("CachePagePool");
+
+    struct Chunk
+    {
+        Chunk(size_t pages,
+              PageFormat format);
+
+        // uint64_t to get the alignment right for either format
+        std::vector<uint64_t> data;
+        std::vector<CachePage> pages;
+    };
+
+    const uint64_t capacity_;
+    const PageFormat format_;
+    const std::shared_ptr<CachePageMemory> memory_;
+
+    mutable boost::mutex lock_;
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    std::vector<CachePage*> free_;
+    uint64_t allocated_;
+    uint64_t used_;
+};
+
+}
+
+#endif // !VD_CACHE_PAGE_POOL_H_
@@ -17,18 +17,20 @@
 #define CACHED_META_DATA_PAGE_H_
 
 #include "ClusterLocationAndHash.h"
+#include "PageFormat.h"
 #include "Types.h"
 
+#include <boost/functional/hash.hpp>
 #include <boost/thread/mutex.hpp>
-#include <boost/intrusive/set.hpp>
 #include <boost/intrusive/list.hpp>
+#include <boost/intrusive/unordered_set.hpp>
 
 namespace volumedriver
 {
 namespace bi = boost::intrusive;
 
 typedef bi::list_base_hook<bi::link_mode<bi::auto_unlink> > list_base_hook;
-typedef bi::set_base_hook<bi::link_mode<bi::auto_unlink> > set_base_hook;
+typedef bi::unordered_set_base_hook<bi::link_mode<bi::auto_unlink> > set_base_hook;
 
 // Uses malloc/free for the data_ member as it interfaces with C libs
 // (tokyocabinet, crakoon)
@@ -38,12 +40,17 @@ class CachePage
 {
 public:
     explicit CachePage(const PageAddress& pa,
-                       ClusterLocationAndHash* data)
+                       void* data,
+                       PageFormat format = PageFormat::Wide)
         : page_address_(pa)
         , data_(data)
+        , format_(format)
         , dirty(false)
         , written_clusters_since_last_backend_write(0)
         , discarded_clusters_since_last_backend_write(0)
+        , generation(0)
+        , writeback(false)
+        , frequent(false)
     {
         ASSERT(data_ != nullptr);
     }
@@ -51,23 +58,41 @@ public:
     CachePage(const CachePage& other) = delete;
 
     CachePage(const CachePage& other,
-              ClusterLocationAndHash* data)
+              void* data)
+        : CachePage(other,
+                    data,
+                    other.format_)
+    {}
+
+    // Converts the entries if the formats differ: the hashes are dropped
+    // when going from Wide to Compact and are null the other way round.
+    CachePage(const CachePage& other,
+              void* data,
+              PageFormat format)
         : page_address_(other.page_address_)
         , data_(data)
+        , format_(format)
         , dirty(other.dirty)
         , written_clusters_since_last_backend_write(other.written_clusters_since_last_backend_write)
         , discarded_clusters_since_last_backend_write(other.discarded_clusters_since_last_backend_write)
+        , generation(other.generation)
+        , writeback(false)
+        , frequent(other.frequent)
     {
-        memcpy(data_, other.data_, size());
+        copy_entries(other);
     }
 
     // std::vector<CachePage>::reserve() needs a copy or a move constructor
     CachePage(const CachePage&& other)
         : page_address_(other.page_address_)
         , data_(other.data_)
+        , format_(other.format_)
         , dirty(other.dirty)
         , written_clusters_since_last_backend_write(other.written_clusters_since_last_backend_write)
         , discarded_clusters_since_last_backend_write(other.discarded_clusters_since_last_backend_write)
+        , generation(other.generation)
+        , writeback(other.writeback)
+        , frequent(other.frequent)
     {}
 
     CachePage&
@@ -84,8 +109,11 @@ public:
                 other.written_clusters_since_last_backend_write;
             discarded_clusters_since_last_backend_write =
                 other.discarded_clusters_since_last_backend_write;
+            generation = other.generation;
+            writeback = other.writeback;
+            frequent = other.frequent;
 
-            memcpy(data_, other.data_, size());
+            copy_entries(other);
         }
 
         return *this;
@@ -153,12 +181,18 @@ public:
         return (ca & (capacity() - 1));
     }
 
+    inline PageFormat
+    format() const
+    {
+        return format_;
+    }
+
     inline bool
     empty() const
     {
         for (size_t i = 0; i < capacity(); ++i)
         {
-            if (not data_[i].clusterLocation.isNull())
+            if (not location(i).isNull())
             {
                 return false;
             }
@@ -173,7 +207,7 @@ public:
     {
         for(size_t i = 0; i < capacity(); ++i)
         {
-            ClusterLocation& cl = data_[i].clusterLocation;
+            ClusterLocation& cl = location(i);
             if(not cl.isNull())
             {
                 cl.incrementCloneID(increase);
@@ -182,12 +216,14 @@ public:
         dirty = set_dirty;
     }
 
+    // Wide pages only.
     inline ClusterLocationAndHash&
     operator[](size_t i)
     {
         // ASSERT HERE!!!
         ASSERT(i < capacity());
-        return data_[i];
+        ASSERT(format_ == PageFormat::Wide);
+        return wide_()[i];
     }
 
     inline const ClusterLocationAndHash&
@@ -195,31 +231,130 @@ public:
     {
         // ASSERT HERE!!!
         ASSERT(i < capacity());
-        return data_[i];
+        ASSERT(format_ == PageFormat::Wide);
+        return wide_()[i];
+    }
+
+    // Any format - the hash of a Compact page's entry is null.
+    inline ClusterLocationAndHash
+    get(size_t i) const
+    {
+        ASSERT(i < capacity());
+
+        if (format_ == PageFormat::Wide)
+        {
+            return wide_()[i];
+        }
+        else
+        {
+            return ClusterLocationAndHash(compact_()[i],
+                                          youtils::Weed::null());
+        }
+    }
+
+    inline void
+    set(size_t i,
+        const ClusterLocationAndHash& clh)
+    {
+        ASSERT(i < capacity());
+
+        if (format_ == PageFormat::Wide)
+        {
+            wide_()[i] = clh;
+        }
+        else
+        {
+            compact_()[i] = clh.clusterLocation;
+        }
+    }
+
+    inline ClusterLocation&
+    location(size_t i)
+    {
+        ASSERT(i < capacity());
+
+        if (format_ == PageFormat::Wide)
+        {
+            return wide_()[i].clusterLocation;
+        }
+        else
+        {
+            return compact_()[i];
+        }
+    }
+
+    inline const ClusterLocation&
+    location(size_t i) const
+    {
+        return const_cast<CachePage*>(this)->location(i);
     }
 
     void
     reset()
     {
-        memset(data_, 0x0, size());
+        memset(data_, 0x0, size(format_));
     }
 
-    const ClusterLocationAndHash*
+    // Converts the entries if the formats differ, cf. the converting
+    // constructor.
+    void
+    copy_entries(const CachePage& other)
+    {
+        ASSERT(data_ != nullptr);
+        ASSERT(other.data_ != nullptr);
+
+        if (format_ == other.format_)
+        {
+            memcpy(data_, other.data_, size(format_));
+        }
+        else
+        {
+            for (size_t i = 0; i < capacity(); ++i)
+            {
+                set(i, other.get(i));
+            }
+        }
+    }
+
+    const void*
     data() const
     {
         return data_;
     }
 
-    ClusterLocationAndHash*
+    void*
     data()
     {
         return data_;
     }
 
+    // Size of a Wide page, which is what the backends store.
     static size_t
     size()
     {
-        return capacity() * sizeof(ClusterLocationAndHash);
+        return size(PageFormat::Wide);
+    }
+
+    static size_t
+    size(PageFormat format)
+    {
+        return capacity() * entry_size(format);
+    }
+
+    static size_t
+    entry_size(PageFormat format)
+    {
+        return format == PageFormat::Wide ?
+            sizeof(ClusterLocationAndHash) :
+            sizeof(ClusterLocation);
+    }
+
+    // Number of pages of the given format that fit into the memory of a Wide
+    // one - page budgets and quotas are expressed in Wide pages.
+    static uint64_t
+    pages_per_wide_page(PageFormat format)
+    {
+        return size() / size(format);
     }
 
     static inline PageAddress
@@ -239,14 +374,42 @@ private:
 
     const static uint8_t page_bits_;
     PageAddress page_address_;
-    ClusterLocationAndHash* data_;
+    void* data_;
+    PageFormat format_;
+
+    inline ClusterLocationAndHash*
+    wide_() const
+    {
+        return static_cast<ClusterLocationAndHash*>(data_);
+    }
+
+    inline ClusterLocation*
+    compact_() const
+    {
+        return static_cast<ClusterLocation*>(data_);
+    }
 
 public:
     bool dirty;
     uint32_t written_clusters_since_last_backend_write;
     uint32_t discarded_clusters_since_last_backend_write;
+    // bumped on each modification, allows to tell whether a page was modified
+    // while a copy of it was being written out
+    uint64_t generation;
+    // a copy is being written out by CachedMetaDataStore::write_behind_ -
+    // the page must not be evicted in the mean time
+    bool writeback;
+    // on the list of frequently used pages (as opposed to the recently loaded
+    // ones) of the CachedMetaDataStore
+    bool frequent;
 };
 
+inline std::size_t
+hash_value(const CachePage& p)
+{
+    return boost::hash<PageAddress>()(p.page_address());
+}
+
 }
 
 #endif // CACHED_META_DATA_PAGE_H_
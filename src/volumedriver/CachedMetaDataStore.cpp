@@ -16,6 +16,7 @@
 #include "CachedMetaDataStore.h"
 #include "ClusterLocationAndHash.h"
 #include "CombinedTLogReader.h"
+#include "DeduplicatingTLogReader.h"
 #include "PageSortingGenerator.h"
 #include "RelocationReaderFactory.h"
 #include "TLog.h"
@@ -23,11 +24,17 @@
 #include "VolManager.h"
 #include "VolumeConfig.h"
 
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <limits>
+
 #include <boost/foreach.hpp>
 #include <boost/scope_exit.hpp>
 
 #include <youtils/Assert.h>
 #include <youtils/ScopeExit.h>
+#include <youtils/wall_timer.h>
 
 namespace volumedriver
 {
@@ -47,6 +54,9 @@ namespace yt = youtils;
 #define ASSERT_CORKS_WRITE_LOCKED               \
     ASSERT(not corks_lock_.try_lock_shared())
 
+#define LOCK_FLUSH                              \
+    boost::lock_guard<decltype(flush_lock_)> flushg__(flush_lock_)
+
 #define LOCK_CACHE_READ                                                 \
     boost::shared_lock<decltype(cache_lock_)> cacherg__(cache_lock_)
 
@@ -66,50 +76,86 @@ namespace yt = youtils;
     ASSERT(not backend_lock_.try_lock());
 
 uint64_t CachedMetaDataStore::replayClustersCached = 8000000;
+uint32_t CachedMetaDataStore::replayTLogFetchers = 8;
+uint32_t CachedMetaDataStore::writeBehindHighWatermark = 50;
+uint32_t CachedMetaDataStore::writeBehindLowWatermark = 25;
+uint32_t CachedMetaDataStore::writeBehindBatchPages = 64;
 
 CachedMetaDataStore::CachedMetaDataStore(const MetaDataBackendInterfacePtr& backend,
                                          const std::string& id,
-                                         uint64_t capacity)
+                                         uint64_t capacity,
+                                         std::shared_ptr<MetaDataCacheBudget> budget)
     : backend_(backend)
-    , page_data_(capacity * CachePage::capacity())
+    , budget_(std::move(budget))
+    , format_(PageFormat::Wide)
+    , wide_miss_data_(CachePage::capacity())
+    , wide_write_data_(CachePage::capacity())
+    , capacity_(capacity)
+    , reserved_pages_(0)
+    , miss_usecs_(0)
+    , page_buckets_(map_type::suggested_upper_bucket_count(capacity))
+    , page_map_(map_type::bucket_traits(page_buckets_.data(),
+                                        page_buckets_.size()))
     , num_pages_(0)
+    , frequent_pages_(0)
     , cache_hits_(0)
     , cache_misses_(0)
+    , frequent_hits_(0)
+    , ghost_hits_(0)
     , written_clusters_(0)
     , discarded_clusters_(0)
+    , dirty_pages_(0)
+    , eviction_stalls_(0)
+    , page_generation_(0)
     , id_(id)
 {
     VERIFY(capacity > 0);
 
+    PageFormat format = PageFormat::Wide;
+
     {
         LOCK_BACKEND;
         cork_uuid_ = backend_->lastCorkUUID();
         scrub_id_ = backend_->scrub_id();
+        format = backend_->page_format().get_value_or(PageFormat::Wide);
     }
 
-    init_pages_(capacity);
-}
+    if (budget_)
+    {
+        pool_ = budget_->pool();
+        reserved_pages_ = budget_->min_pages();
+        capacity_ = budget_->register_client(*this,
+                                             capacity);
+    }
+    else
+    {
+        pool_ = std::make_shared<CachePagePool>(capacity);
+        reserved_pages_ = capacity;
+    }
 
-CachedMetaDataStore::~CachedMetaDataStore()
-{
-    write_dirty_pages_to_backend_and_clear_page_list(true,
-                                                     true);
+    if (format != format_)
+    {
+        LOCK_CACHE_WRITE;
+        switch_format_(format);
+    }
+
+    LOG_INFO(id_ <<
+             ": page capacity (entries): " << CachePage::capacity() <<
+             ", page format: " << format_ <<
+             ", max cached pages: " << capacity_ <<
+             (budget_ ? " (shared budget)" : ""));
 }
 
-void
-CachedMetaDataStore::init_pages_(size_t capacity)
+CachedMetaDataStore::~CachedMetaDataStore()
 {
-    pages_.reserve(capacity);
-
-    for (uint64_t i = 0; i < capacity; ++i)
+    // first, as the budget might otherwise call in while we're going down
+    if (budget_)
     {
-        VERIFY((i + 1) * CachePage::capacity() <= page_data_.size());
-        pages_.emplace_back(i, &page_data_[i * CachePage::capacity()]);
+        budget_->unregister_client(*this);
     }
 
-    LOG_INFO(id_ <<
-             ": page capacity (entries): " << CachePage::capacity() <<
-             ", max cached pages: " << pages_.size());
+    write_dirty_pages_to_backend_and_clear_page_list(true,
+                                                     true);
 }
 
 void
@@ -183,6 +229,12 @@ CachedMetaDataStore::clear_all_keys()
     backend_->clear_all_keys();
     cork_uuid_ = boost::none;
     scrub_id_ = boost::none;
+
+    if (format_ != PageFormat::Wide)
+    {
+        // we're going to continue writing out pages without hashes
+        backend_->set_page_format(format_);
+    }
 }
 
 bool
@@ -204,7 +256,7 @@ CachedMetaDataStore::for_each(MetaDataStoreFunctor& f,
         LOCK_CORKS_READ;
         VERIFY(corks_.size() == 1);
         VERIFY(corks_.front().second->empty());
-        // VERIFY(page_list_.size() == 0);
+        // VERIFY(num_pages_ == 0);
     }
 
     LOCK_BACKEND;
@@ -223,7 +275,12 @@ CachedMetaDataStore::getStats(MetaDataStoreStats& stats)
     stats.cache_hits = cache_hits_;
     stats.cache_misses = cache_misses_;
     stats.cached_pages = num_pages_;
-    stats.max_pages = pages_.size();
+    stats.frequent_pages = frequent_pages_;
+    stats.frequent_hits = frequent_hits_;
+    stats.ghost_hits = ghost_hits_;
+    stats.max_pages = capacity_;
+    stats.dirty_pages = dirty_pages_;
+    stats.eviction_stalls = eviction_stalls_;
     stats.corked_clusters.clear();
 
     getCorkedClusters(stats.corked_clusters);
@@ -336,29 +393,27 @@ CachedMetaDataStore::unCork(const boost::optional<yt::UUID>& cork)
 
         for (const auto& val : *m)
         {
-            LOCK_CORKS_READ;
-            // Y42 not correct, just write to the own cache
-            // Ordening here might be better
-            if (not get_page_(val.first, const_cast<ClusterLocationAndHash&>(val.second), true))
             {
-                misses++;
+                LOCK_CORKS_READ;
+                // Y42 not correct, just write to the own cache
+                // Ordening here might be better
+                if (not get_page_(val.first, const_cast<ClusterLocationAndHash&>(val.second), true))
+                {
+                    misses++;
+                }
             }
+
+            // not under the corks lock: writing behind goes to the backend and
+            // would hold up cork() (and with it all other readers) meanwhile
+            maybe_write_behind_();
         }
         LOG_INFO(id_ << ": written " << corks_.front().second->size() <<
                  " entries to pages, " << misses << " cache misses");
     }
 
     {
-        uint32_t dirty_count = 0;
-
-        LOCK_CACHE_READ;
-        for (CachePage& p : page_list_)
-        {
-            if (maybeWritePage_locked_context(p, false))
-            {
-                dirty_count++;
-            }
-        }
+        const uint64_t dirty_count =
+            write_behind_(std::numeric_limits<uint64_t>::max());
         LOG_INFO(id_ << ": written out " << dirty_count << " dirty pages");
     }
 
@@ -388,34 +443,41 @@ CachedMetaDataStore::processCloneTLogs(const CloneTLogs& ctl,
            (corks_.size() == 1 and
             corks_.front().second->empty()));
 
+    yt::wall_timer replay_timer;
+
+    // Replaying backwards - the clone itself first and each clone's TLogs
+    // newest first - such that only the most recent entry per cluster address
+    // needs to be applied.
+    ClusterAddressFilter filter;
+    DeduplicatingTLogReader::Stats stats;
     SCOCloneID prev_cloneid;
 
-    for (CloneTLogs::size_type i = 0; i < ctl.size(); ++i)
+    for (auto it = ctl.rbegin(); it != ctl.rend(); ++it)
     {
-        const SCOCloneID cloneid = ctl[i].first;
-        if (i != 0)
+        const SCOCloneID cloneid = it->first;
+        if (it != ctl.rbegin())
         {
-            VERIFY(prev_cloneid > cloneid);
+            VERIFY(prev_cloneid < cloneid);
         }
         prev_cloneid = cloneid;
 
-        const OrderedTLogIds& tlogs = ctl[i].second;
+        const OrderedTLogIds& tlogs = it->second;
 
-        std::shared_ptr<TLogReaderInterface>
-            r(CombinedTLogReader::create(tlog_path,
-                                         tlogs,
-                                         nsidmap.get(cloneid)->clone()));
+        auto r(std::make_shared<DeduplicatingTLogReader>(tlog_path,
+                                                         tlogs,
+                                                         nsidmap.get(cloneid)->clone(),
+                                                         filter,
+                                                         replayTLogFetchers));
         processTLogReaderInterface(r, cloneid);
+        stats += r->stats();
     }
 
+    const double replay_secs = replay_timer.elapsed();
+    yt::wall_timer sync_timer;
+
     if(sync)
     {
-        LOCK_CACHE_WRITE;
-
-        for (CachePage& p : page_list_)
-        {
-            maybeWritePage_locked_context(p, false);
-        }
+        write_behind_(std::numeric_limits<uint64_t>::max());
 
         if (cork != boost::none)
         {
@@ -426,6 +488,10 @@ CachedMetaDataStore::processCloneTLogs(const CloneTLogs& ctl,
     }
 
     cork_uuid_ = cork;
+
+    LOG_INFO(id_ << ": replayed clone TLogs up to cork " << cork << ": " <<
+             stats << ", replay secs: " << replay_secs <<
+             ", sync secs: " << sync_timer.elapsed());
 }
 
 uint64_t
@@ -448,6 +514,7 @@ CachedMetaDataStore::processPages(std::unique_ptr<yt::Generator<PageDataPtr>> r,
             get_page_(e.clusterAddress(),
                      const_cast<ClusterLocationAndHash&>(loc),
                      true);
+            maybe_write_behind_();
             entries++;
         }
         pages++;
@@ -477,6 +544,7 @@ void
 CachedMetaDataStore::write_dirty_pages_to_backend_and_clear_page_list(bool sync,
                                                                       bool ignore_errors)
 {
+    LOCK_FLUSH;
     LOCK_CACHE_WRITE;
     do_write_dirty_pages_to_backend_and_clear_page_list(sync,
                                                         ignore_errors);
@@ -486,42 +554,53 @@ void
 CachedMetaDataStore::do_write_dirty_pages_to_backend_and_clear_page_list(bool sync,
                                                                          bool ignore_errors)
 {
-    while (not page_list_.empty())
+    for (list_type* l : { &recent_list_, &frequent_list_ })
     {
-        CachePage& p(page_list_.front());
+        while (not l->empty())
+        {
+            CachePage& p(l->front());
 
-        p.unlink_from_list();
-        p.unlink_from_set();
-        --num_pages_;
+            p.unlink_from_list();
+            p.unlink_from_set();
+            --num_pages_;
 
-        if (sync)
-        {
-            maybeWritePage_locked_context(p, ignore_errors);
+            if (sync)
+            {
+                maybeWritePage_locked_context(p, ignore_errors);
+            }
+
+            pool_->release(p);
         }
     }
 
     ASSERT(page_map_.empty());
     ASSERT(num_pages_ == 0);
 
-    for (auto& p : pages_)
-    {
-        p.reset();
-    }
+    frequent_pages_ = 0;
+    ghost_list_.clear();
+    ghost_map_.clear();
+
+    // the ones that could not be written out are gone nevertheless
+    dirty_pages_ = 0;
 }
 
 void
 CachedMetaDataStore::write_dirty_pages_to_backend_keeping_page_list()
 {
+    LOCK_FLUSH;
     LOCK_CACHE_WRITE;
 
-    for (auto& page : page_list_)
+    for (list_type* l : { &recent_list_, &frequent_list_ })
     {
-        if(page.dirty and not page.empty())
+        for (auto& page : *l)
         {
-            maybeWritePage_locked_context(page, false);
-            LOCK_BACKEND;
-            dispose_page(&MetaDataBackendInterface::putPage, page);
-            page.dirty = false;
+            if(page.dirty and not page.empty())
+            {
+                maybeWritePage_locked_context(page, false);
+                LOCK_BACKEND;
+                dispose_page(&MetaDataBackendInterface::putPage, page);
+                page.dirty = false;
+            }
         }
     }
 }
@@ -529,20 +608,22 @@ CachedMetaDataStore::write_dirty_pages_to_backend_keeping_page_list()
 namespace
 {
 
-struct PageCmp
+struct PageHash
 {
-    bool
-    operator()(const PageAddress& pa,
-               const CachePage& cp) const
+    size_t
+    operator()(const PageAddress& pa) const
     {
-        return pa < cp.page_address();
+        return boost::hash<PageAddress>()(pa);
     }
+};
 
+struct PageEq
+{
     bool
-    operator()(const CachePage& cp,
-               const PageAddress& pa) const
+    operator()(const PageAddress& pa,
+               const CachePage& cp) const
     {
-        return cp.page_address() < pa;
+        return pa == cp.page_address();
     }
 };
 
@@ -629,22 +710,168 @@ void
 CachedMetaDataStore::set_cache_capacity(const size_t new_capacity)
 {
     LOG_INFO(id_ << ": request to change cache capacity from " <<
-             pages_.size() << " to " << new_capacity);
+             capacity_ << " to " << new_capacity);
 
     VERIFY(new_capacity > 0);
 
+    if (budget_)
+    {
+        LOG_WARN(id_ <<
+                 ": cache capacity is managed by the node-wide budget, ignoring request");
+        return;
+    }
+
     LOCK_CORKS_WRITE;
+    LOCK_FLUSH;
     LOCK_CACHE_WRITE;
 
-    if (new_capacity != pages_.size())
+    const uint64_t pages = new_capacity * CachePage::pages_per_wide_page(format_);
+
+    if (pages != capacity_)
     {
         do_write_dirty_pages_to_backend_and_clear_page_list(true,
                                                             true);
 
-        page_data_.resize(new_capacity * CachePage::capacity());
-        pages_.clear();
+        std::vector<map_type::bucket_type>
+            buckets(map_type::suggested_upper_bucket_count(pages));
+        page_map_.rehash(map_type::bucket_traits(buckets.data(),
+                                                 buckets.size()));
+        page_buckets_.swap(buckets);
 
-        init_pages_(new_capacity);
+        pool_ = std::make_shared<CachePagePool>(pages,
+                                                format_);
+        capacity_ = pages;
+        reserved_pages_ = pages;
+    }
+}
+
+PageFormat
+CachedMetaDataStore::page_format()
+{
+    LOCK_CACHE_READ;
+    return format_;
+}
+
+void
+CachedMetaDataStore::set_page_format(PageFormat format)
+{
+    LOCK_CORKS_WRITE;
+    LOCK_FLUSH;
+    LOCK_CACHE_WRITE;
+
+    if (format == format_)
+    {
+        return;
+    }
+
+    {
+        LOCK_BACKEND;
+
+        if (backend_->page_format() == boost::none)
+        {
+            LOG_WARN(id_ << ": the backend cannot record the page format, sticking to " <<
+                     format_ << " pages");
+            return;
+        }
+
+        if (format == PageFormat::Wide and
+            (cork_uuid_ != boost::none or backend_->getUsedClusters() != 0))
+        {
+            LOG_ERROR(id_ << ": switching from " << format_ << " to " << format <<
+                      " pages requires an empty MetaDataStore");
+            throw MetaDataStoreException("Switching to Wide pages requires an empty MetaDataStore");
+        }
+    }
+
+    LOG_INFO(id_ << ": switching from " << format_ << " to " << format << " pages");
+
+    // The cached pages are written out in the old format before the backend
+    // learns about the new one.
+    do_write_dirty_pages_to_backend_and_clear_page_list(true,
+                                                        false);
+
+    {
+        LOCK_BACKEND;
+        backend_->set_page_format(format);
+    }
+
+    switch_format_(format);
+}
+
+// Swaps the (empty) cache over to another format, keeping its memory footprint.
+void
+CachedMetaDataStore::switch_format_(PageFormat format)
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+    VERIFY(num_pages_ == 0);
+
+    const uint64_t from = CachePage::pages_per_wide_page(format_);
+    const uint64_t to = CachePage::pages_per_wide_page(format);
+
+    capacity_ = capacity_ / from * to;
+    reserved_pages_ = reserved_pages_ / from * to;
+
+    if (budget_)
+    {
+        pool_ = budget_->pool(format);
+    }
+    else
+    {
+        pool_ = std::make_shared<CachePagePool>(capacity_,
+                                                format);
+    }
+
+    std::vector<map_type::bucket_type>
+        buckets(map_type::suggested_upper_bucket_count(capacity_));
+    page_map_.rehash(map_type::bucket_traits(buckets.data(),
+                                             buckets.size()));
+    page_buckets_.swap(buckets);
+
+    format_ = format;
+}
+
+uint64_t
+CachedMetaDataStore::collect_miss_cost()
+{
+    return miss_usecs_.exchange(0);
+}
+
+void
+CachedMetaDataStore::set_page_quota(uint64_t pages)
+{
+    VERIFY(pages > 0);
+
+    LOCK_CACHE_WRITE;
+
+    // the budget deals in Wide pages
+    pages *= CachePage::pages_per_wide_page(format_);
+
+    if (pages != capacity_)
+    {
+        LOG_INFO(id_ << ": page quota changes from " << capacity_ << " to " <<
+                 pages << " " << format_ << " pages, cached pages: " << num_pages_);
+
+        capacity_ = pages;
+        trim_unlocked_();
+    }
+}
+
+// Best effort: pages pinned by write_behind_ cannot be given back right now,
+// the next cache miss will try again.
+void
+CachedMetaDataStore::trim_unlocked_()
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+
+    while (num_pages_ > capacity_)
+    {
+        CachePage* page = evict_page_();
+        if (page == nullptr)
+        {
+            break;
+        }
+
+        pool_->release(*page);
     }
 }
 
@@ -658,80 +885,446 @@ CachedMetaDataStore::get_page_unlocked_(const ClusterAddress ca,
     CachePage* page = nullptr;
 
     typename map_type::iterator it = page_map_.find(pa,
-                                                    PageCmp());
+                                                    PageHash(),
+                                                    PageEq());
     if (it == page_map_.end())
     {
         ++cache_misses_;
 
-        if (num_pages_ < pages_.size())
+        if (num_pages_ > capacity_)
         {
-            page = &pages_[num_pages_];
+            trim_unlocked_();
         }
-        else
+
+        if (num_pages_ < capacity_)
         {
-            page = &page_list_.front();
-            page->unlink_from_list();
-            page->unlink_from_set();
-            --num_pages_;
-            maybeWritePage_locked_context(*page, false);
+            // a shared pool might be exhausted by others, in which case we
+            // have to make do with our own pages - unless we're below our
+            // reservation
+            page = pool_->allocate(num_pages_ < reserved_pages_);
+        }
+
+        if (page == nullptr and num_pages_ > 0)
+        {
+            page = evict_page_();
         }
 
+        if (page == nullptr)
+        {
+            page = pool_->allocate(true);
+        }
+
+        VERIFY(page != nullptr);
         ASSERT(not page->dirty);
         ASSERT(not page->is_in_set());
         ASSERT(not page->is_in_list());
-        ASSERT(num_pages_ < pages_.size());
 
-        page = new(page) CachePage(pa, page->data());
+        page = new(page) CachePage(pa,
+                                   page->data(),
+                                   page->format());
+
+        yt::wall_timer t;
+
+        bool found = false;
+
+        if (page->format() == PageFormat::Wide)
+        {
+            found = backend_->getPage(*page);
+        }
+        else
+        {
+            CachePage wide(pa,
+                           wide_miss_data_.data());
+            found = backend_->getPage(wide);
+            if (found)
+            {
+                page->copy_entries(wide);
+            }
+        }
 
-        const bool found = backend_->getPage(*page);
         if (not found)
         {
             page->reset();
         }
 
+        miss_usecs_ += t.elapsed() * 1e6;
+
         page_map_.insert(*page);
         ++num_pages_;
+
+        auto g = ghost_map_.find(pa);
+        if (g != ghost_map_.end())
+        {
+            ++ghost_hits_;
+            ghost_list_.erase(g->second);
+            ghost_map_.erase(g);
+
+            page->frequent = true;
+            ++frequent_pages_;
+            frequent_list_.push_back(*page);
+        }
+        else
+        {
+            recent_list_.push_back(*page);
+        }
     }
     else
     {
         ++cache_hits_;
         hit = true;
         page = &(*it);
-        page->unlink_from_list();
+
+        // hits on the recent list leave it alone, cf. the comment on it
+        if (page->frequent)
+        {
+            ++frequent_hits_;
+            page->unlink_from_list();
+            frequent_list_.push_back(*page);
+        }
     }
 
-    ASSERT(not page->is_in_list());
+    ASSERT(page->is_in_list());
     ASSERT(page->is_in_set());
 
-    page_list_.push_back(*page);
-
     if (for_write)
     {
-        ClusterLocationAndHash& clh = (*page)[CachePage::offset(ca)];
-        if (clh.clusterLocation.isNull() and
+        const size_t off = CachePage::offset(ca);
+        const ClusterLocation& cl = page->location(off);
+        if (cl.isNull() and
             not loc.clusterLocation.isNull())
         {
             page->written_clusters_since_last_backend_write++;
             written_clusters_++;
         }
-        else if (not clh.clusterLocation.isNull() and
+        else if (not cl.isNull() and
                  loc.clusterLocation.isNull())
         {
             page->discarded_clusters_since_last_backend_write++;
             discarded_clusters_++;
         }
 
-        clh = loc;
-        page->dirty = true;
+        page->set(off,
+                  loc);
+
+        if (not page->dirty)
+        {
+            page->dirty = true;
+            ++dirty_pages_;
+        }
+
+        page->generation = ++page_generation_;
     }
     else
     {
-        loc = (*page)[CachePage::offset(ca)];
+        loc = page->get(CachePage::offset(ca));
     }
 
     return hit;
 }
 
+// Prefers the first clean page on the list so cache misses don't have to wait
+// for a page to be written out first. Pages that are being written out by
+// write_behind_ are off limits. If there are only dirty ones (within the first
+// few pages of the list) the first one is returned nevertheless.
+CachePage*
+CachedMetaDataStore::pick_victim_(list_type& l)
+{
+    // write_behind_ pins at most writeBehindBatchPages pages
+    const size_t max_scan = 2 * writeBehindBatchPages + 1;
+    size_t scanned = 0;
+    CachePage* page = nullptr;
+
+    for (CachePage& p : l)
+    {
+        if (not p.writeback)
+        {
+            if (not p.dirty)
+            {
+                page = &p;
+                break;
+            }
+            else if (page == nullptr)
+            {
+                page = &p;
+            }
+        }
+
+        if (++scanned >= max_scan and page != nullptr)
+        {
+            break;
+        }
+    }
+
+    return page;
+}
+
+// Having to write out a dirty page before it can be reused is accounted as an
+// eviction stall. Returns nullptr if all pages are pinned by write_behind_.
+CachePage*
+CachedMetaDataStore::evict_page_()
+{
+    ASSERT_CACHE_WRITE_LOCKED;
+
+    const uint64_t recent_pages = num_pages_ - frequent_pages_;
+    const uint64_t max_recent_pages = std::max<uint64_t>(1,
+                                                         capacity_ / 4);
+
+    list_type* lists[] = { &recent_list_, &frequent_list_ };
+    if (recent_pages <= max_recent_pages and not frequent_list_.empty())
+    {
+        std::swap(lists[0], lists[1]);
+    }
+
+    CachePage* page = nullptr;
+
+    for (list_type* l : lists)
+    {
+        page = pick_victim_(*l);
+        if (page != nullptr)
+        {
+            break;
+        }
+    }
+
+    if (page == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (page->dirty)
+    {
+        ++eviction_stalls_;
+        maybeWritePage_locked_context(*page, false);
+    }
+
+    page->unlink_from_list();
+    page->unlink_from_set();
+    --num_pages_;
+
+    if (page->frequent)
+    {
+        --frequent_pages_;
+    }
+    else
+    {
+        remember_evicted_(page->page_address());
+    }
+
+    return page;
+}
+
+void
+CachedMetaDataStore::remember_evicted_(const PageAddress pa)
+{
+    const size_t max_ghosts = std::max<size_t>(1,
+                                               capacity_ / 2);
+
+    ghost_list_.push_back(pa);
+    const bool ok = ghost_map_.emplace(pa,
+                                       std::prev(ghost_list_.end())).second;
+    VERIFY(ok);
+
+    while (ghost_list_.size() > max_ghosts)
+    {
+        ghost_map_.erase(ghost_list_.front());
+        ghost_list_.pop_front();
+    }
+}
+
+// Writes out up to max_pages dirty pages, the ones closest to eviction first, in
+// batches sorted by page address. The cache lock is only held while copying
+// the pages and while updating them afterwards, not while talking to the
+// backend. Pages modified in the mean time stay dirty.
+uint64_t
+CachedMetaDataStore::write_behind_(uint64_t max_pages)
+{
+    LOCK_FLUSH;
+
+    const size_t batch_size = std::min<size_t>(writeBehindBatchPages,
+                                               capacity_ / 2);
+    uint64_t written = 0;
+
+    if (batch_size == 0)
+    {
+        // too few pages to pin some of them while they're written out
+        LOCK_CACHE_READ;
+        for (list_type* l : { &recent_list_, &frequent_list_ })
+        {
+            for (CachePage& p : *l)
+            {
+                if (maybeWritePage_locked_context(p, false))
+                {
+                    ++written;
+                }
+            }
+        }
+
+        return written;
+    }
+
+    std::vector<ClusterLocationAndHash> data(batch_size * CachePage::capacity());
+    std::vector<CachePage> copies;
+    copies.reserve(batch_size);
+    std::vector<uint64_t> generations;
+    generations.reserve(batch_size);
+    PageUpdates updates;
+    updates.reserve(batch_size);
+
+    while (written < max_pages)
+    {
+        copies.clear();
+        generations.clear();
+        updates.clear();
+
+        {
+            LOCK_CACHE_WRITE;
+
+            const size_t n = std::min<uint64_t>(batch_size,
+                                                max_pages - written);
+            std::vector<CachePage*> dirty;
+            dirty.reserve(n);
+
+            for (list_type* l : { &recent_list_, &frequent_list_ })
+            {
+                for (CachePage& p : *l)
+                {
+                    if (dirty.size() == n)
+                    {
+                        break;
+                    }
+
+                    if (p.dirty)
+                    {
+                        ASSERT(not p.writeback);
+                        dirty.push_back(&p);
+                    }
+                }
+            }
+
+            if (dirty.empty())
+            {
+                break;
+            }
+
+            std::sort(dirty.begin(),
+                      dirty.end(),
+                      [](const CachePage* a,
+                         const CachePage* b)
+                      {
+                          return a->page_address() < b->page_address();
+                      });
+
+            // the copies are Wide ones as that's what the backend expects
+            for (CachePage* p : dirty)
+            {
+                copies.emplace_back(*p,
+                                    &data[copies.size() * CachePage::capacity()],
+                                    PageFormat::Wide);
+                generations.push_back(p->generation);
+                p->writeback = true;
+            }
+        }
+
+        std::exception_ptr eptr;
+
+        try
+        {
+            LOCK_BACKEND;
+
+            for (const CachePage& c : copies)
+            {
+                const int32_t delta = c.written_clusters_since_last_backend_write -
+                    c.discarded_clusters_since_last_backend_write;
+                const bool discard = c.empty() and
+                    not backend_->pageExistsInParent(c.page_address());
+
+                updates.emplace_back(c,
+                                     delta,
+                                     discard);
+            }
+
+            backend_->putPages(updates);
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_ERROR(id_ << ": failed to write out " << copies.size() <<
+                          " pages: " << EWHAT);
+                eptr = std::current_exception();
+            });
+
+        {
+            LOCK_CACHE_WRITE;
+
+            for (size_t i = 0; i < copies.size(); ++i)
+            {
+                const CachePage& c = copies[i];
+
+                auto it = page_map_.find(c.page_address(),
+                                         PageHash(),
+                                         PageEq());
+                VERIFY(it != page_map_.end());
+
+                CachePage& p = *it;
+                VERIFY(p.writeback);
+                p.writeback = false;
+
+                if (i < updates.size() and updates[i].done)
+                {
+                    p.written_clusters_since_last_backend_write -=
+                        c.written_clusters_since_last_backend_write;
+                    p.discarded_clusters_since_last_backend_write -=
+                        c.discarded_clusters_since_last_backend_write;
+                    written_clusters_ -= c.written_clusters_since_last_backend_write;
+                    discarded_clusters_ -= c.discarded_clusters_since_last_backend_write;
+
+                    if (p.generation == generations[i])
+                    {
+                        p.dirty = false;
+                        --dirty_pages_;
+                    }
+
+                    ++written;
+                }
+            }
+        }
+
+        if (eptr)
+        {
+            std::rethrow_exception(eptr);
+        }
+    }
+
+    return written;
+}
+
+void
+CachedMetaDataStore::maybe_write_behind_()
+{
+    uint64_t excess = 0;
+
+    {
+        LOCK_CACHE_READ;
+
+        if (capacity_ / 2 == 0)
+        {
+            return;
+        }
+
+        const uint64_t high = capacity_ * writeBehindHighWatermark / 100;
+        if (dirty_pages_ > high)
+        {
+            const uint64_t low = capacity_ * writeBehindLowWatermark / 100;
+            excess = dirty_pages_ - std::min(low,
+                                             dirty_pages_);
+        }
+    }
+
+    if (excess > 0)
+    {
+        const uint64_t n = write_behind_(excess);
+        LOG_TRACE(id_ << ": wrote back " << n << " dirty pages");
+    }
+}
+
 void
 CachedMetaDataStore::dispose_page(backend_mem_fun dispose, CachePage& p)
 {
@@ -740,13 +1333,28 @@ CachedMetaDataStore::dispose_page(backend_mem_fun dispose, CachePage& p)
     const int32_t delta = p.written_clusters_since_last_backend_write -
         p.discarded_clusters_since_last_backend_write;
 
-    ((*backend_).*dispose)(p, delta);
+    if (p.format() == PageFormat::Wide)
+    {
+        ((*backend_).*dispose)(p, delta);
+    }
+    else
+    {
+        const CachePage wide(p,
+                             wide_write_data_.data(),
+                             PageFormat::Wide);
+        ((*backend_).*dispose)(wide, delta);
+    }
 
     written_clusters_ -= p.written_clusters_since_last_backend_write;
     discarded_clusters_ -= p.discarded_clusters_since_last_backend_write;
     p.written_clusters_since_last_backend_write = 0;
     p.discarded_clusters_since_last_backend_write = 0;
-    p.dirty = false;
+
+    if (p.dirty)
+    {
+        p.dirty = false;
+        --dirty_pages_;
+    }
 }
 
 // TODO: rather expensive - can we be more clever?
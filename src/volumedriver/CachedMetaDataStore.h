@@ -16,14 +16,19 @@
 #ifndef CACHED_METADATA_STORE_H_
 #define CACHED_METADATA_STORE_H_
 
+#include "CachePagePool.h"
 #include "CachedMetaDataPage.h"
 #include "MetaDataBackendInterface.h"
+#include "MetaDataCacheBudget.h"
 #include "MetaDataStoreInterface.h"
 #include "PageSortingGenerator.h"
 #include "ScrubId.h"
 #include "Types.h"
 
+#include <atomic>
+#include <list>
 #include <memory>
+#include <unordered_map>
 
 #include <boost/thread/locks.hpp>
 #include <boost/thread/shared_mutex.hpp>
@@ -44,14 +49,19 @@ class VolManagerTestSetup;
 
 class CachedMetaDataStore
     : public MetaDataStoreInterface
+    , public MetaDataCacheBudget::Client
 {
     friend class VolManagerTestSetup;
     friend class volumedrivertest::MetaDataStoreTest;
 
 public:
+    // With a budget the capacity is only the initial wish - the budget decides
+    // how many pages are actually used. The capacity is given in Wide pages,
+    // a Compact cache gets CachePage::pages_per_wide_page as many.
     CachedMetaDataStore(const MetaDataBackendInterfacePtr& backend,
                         const std::string& id,
-                        uint64_t capacity = default_capacity_);
+                        uint64_t capacity = default_capacity_,
+                        std::shared_ptr<MetaDataCacheBudget> budget = nullptr);
 
     virtual ~CachedMetaDataStore();
 
@@ -149,9 +159,22 @@ public:
     virtual void
     set_scrub_id(const ScrubId& id) override final;
 
+    // num_pages is in Wide pages, cf. PageFormat.
     virtual void
     set_cache_capacity(const size_t num_pages) override final;
 
+    virtual PageFormat
+    page_format() override final;
+
+    virtual void
+    set_page_format(PageFormat) override final;
+
+    virtual uint64_t
+    collect_miss_cost() override final;
+
+    virtual void
+    set_page_quota(uint64_t pages) override final;
+
     void
     discardCluster(const ClusterAddress caddr);
 
@@ -182,7 +205,7 @@ public:
     uint32_t
     capacity() const
     {
-        return pages_.size();
+        return capacity_;
     }
 
     void
@@ -199,14 +222,36 @@ public:
     // not const as VolManagerRestartTest.testAllTlogEntriesAreReplayed messes with it
     static uint64_t replayClustersCached;
     static const uint32_t replayPagesQueued = 5;
+    // number of TLogs fetched from the backend and decoded concurrently
+    static uint32_t replayTLogFetchers;
+    // Dirty pages are written out behind the back of the cache users once
+    // they make up more than writeBehindHighWatermark percent of the cache,
+    // until they're down to writeBehindLowWatermark percent ...
+    static uint32_t writeBehindHighWatermark;
+    static uint32_t writeBehindLowWatermark;
+    // ... in batches of at most that many pages.
+    static uint32_t writeBehindBatchPages;
 
 private:
     DECLARE_LOGGER("CachedMetaDataStore");
 
     MetaDataBackendInterfacePtr backend_;
 
-    std::vector<CachePage> pages_;
-    std::vector<ClusterLocationAndHash> page_data_;
+    const std::shared_ptr<MetaDataCacheBudget> budget_;
+    // either a private one or the budget's
+    std::shared_ptr<CachePagePool> pool_;
+    // of the cached pages - the backend only ever sees Wide ones, Compact ones
+    // are converted using these buffers (protected by cache_lock_ and
+    // backend_lock_ respectively)
+    PageFormat format_;
+    std::vector<ClusterLocationAndHash> wide_miss_data_;
+    std::vector<ClusterLocationAndHash> wide_write_data_;
+    // max number of pages (of format_) to use ...
+    uint64_t capacity_;
+    // ... and the ones we're entitled to in any case
+    uint64_t reserved_pages_;
+    // usecs spent in backend_->getPage, cf. collect_miss_cost
+    std::atomic<uint64_t> miss_usecs_;
 
     // For now "num_pages_" tracks the size of the map as its ->size() is not O(1).
     // However, we only make use of auto-unlinking (which necessitates our use of
@@ -215,19 +260,38 @@ private:
     // path. So it might be acceptable to use constant_time_size<true> instead and
     // get rid of "num_pages_" which has the potential of being out of sync if not
     // treated carefully.
-    typedef bi::set<CachePage,
-                    bi::constant_time_size<false> > map_type;
+    typedef bi::unordered_set<CachePage,
+                              bi::constant_time_size<false> > map_type;
 
     typedef bi::list<CachePage,
                      bi::constant_time_size<false> > list_type;
 
+    // Page replacement follows 2Q (Johnson / Shasha, VLDB '94) to keep
+    // sequential scans (backups, scrubbing, ...) from flushing the hot pages:
+    // * pages are loaded onto the FIFO recent_list_; hits there don't count as
+    //   they're typically correlated (several clusters of a page in a row)
+    // * when evicted from there, their addresses are remembered on the
+    //   ghost list for a while, and pages that are loaded again while still
+    //   on it go onto the LRU frequent_list_
+    // * the recent list is evicted from as long as it takes up more than a
+    //   quarter of the cache.
+    std::vector<map_type::bucket_type> page_buckets_;
     map_type page_map_;
-    list_type page_list_;
+    list_type recent_list_;
+    list_type frequent_list_;
+    std::list<PageAddress> ghost_list_;
+    std::unordered_map<PageAddress, std::list<PageAddress>::iterator> ghost_map_;
     uint64_t num_pages_;
+    uint64_t frequent_pages_;
     uint64_t cache_hits_;
     uint64_t cache_misses_;
+    uint64_t frequent_hits_;
+    uint64_t ghost_hits_;
     uint64_t written_clusters_;
     uint64_t discarded_clusters_;
+    uint64_t dirty_pages_;
+    uint64_t eviction_stalls_;
+    uint64_t page_generation_;
 
     const std::string id_;
 
@@ -239,6 +303,9 @@ private:
 
     // Ze locks - to be taken in this very order.
     mutable boost::shared_mutex corks_lock_;
+    // serializes write_behind_ against everything else that writes out or
+    // drops pages in bulk
+    mutable boost::mutex flush_lock_;
     mutable boost::shared_mutex cache_lock_;
     mutable boost::mutex backend_lock_;
 
@@ -257,9 +324,6 @@ private:
     processPages(std::unique_ptr<youtils::Generator<PageDataPtr>> r,
                  SCOCloneID cloneid);
 
-    void
-    init_pages_(size_t capacity);
-
     // bit of a misnomer - if sync is false nothing is written out!
     void
     write_dirty_pages_to_backend_and_clear_page_list(bool sync,
@@ -272,6 +336,27 @@ private:
     void
     write_dirty_pages_to_backend_keeping_page_list();
 
+    CachePage*
+    pick_victim_(list_type&);
+
+    CachePage*
+    evict_page_();
+
+    void
+    trim_unlocked_();
+
+    void
+    switch_format_(PageFormat);
+
+    void
+    remember_evicted_(const PageAddress);
+
+    uint64_t
+    write_behind_(uint64_t max_pages);
+
+    void
+    maybe_write_behind_();
+
     bool
     get_page_unlocked_(const ClusterAddress ca,
                        ClusterLocationAndHash& loc,
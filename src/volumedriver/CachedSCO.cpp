@@ -72,6 +72,7 @@ CachedSCO::CachedSCO(SCOCacheNamespace* nspace,
     , mntPoint_(mntPoint)
     , size_(0)
     , xVal_(0)
+    , xValAccounted_(false)
     , disposable_(false)
     , unlink_on_destruction_(false)
     , refcnt_(0)
@@ -106,6 +107,7 @@ CachedSCO::CachedSCO(SCOCacheNamespace* nspace,
     , mntPoint_(mntPoint)
     , size_(maxSize)
     , xVal_(xVal)
+    , xValAccounted_(false)
     , disposable_(false)
     , unlink_on_destruction_(false)
     , refcnt_(0)
@@ -20,6 +20,7 @@
 #include "Types.h"
 
 #include <boost/filesystem.hpp>
+#include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 
 #include <youtils/FileDescriptor.h>
@@ -91,10 +92,21 @@ private:
     SCOCacheMountPointPtr mntPoint_;
     uint64_t size_;
     float xVal_;
+    // whether xVal_ is part of SCOCache's running sum
+    bool xValAccounted_;
     bool disposable_;
     bool unlink_on_destruction_;
     std::atomic<uint32_t> refcnt_;
 
+    // links disposable SCOs into the eviction candidates of their
+    // mountpoint, see SCOCache
+    typedef boost::intrusive::set_member_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink> > CandidateHook;
+    CandidateHook candidate_hook_;
+
+    // ... or, while in use, parks them until the cleaner looks again
+    typedef boost::intrusive::list_member_hook<boost::intrusive::link_mode<boost::intrusive::auto_unlink> > ParkedHook;
+    ParkedHook parked_hook_;
+
     // protect the following four from being called arbitrarily in the code:
     //
     // - scans an existing SCO, only allowed from SCOCacheMountPoint
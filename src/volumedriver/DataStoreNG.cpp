@@ -587,6 +587,11 @@ DataStoreNG::readClusters(const std::vector<ClusterReadDescriptor>& descs)
         InsistOnLatestVersion::F :
         InsistOnLatestVersion::T;
 
+    const bc::seconds
+        promotion_window(VolManager::get()->partial_read_promotion_window_secs.value());
+    const uint32_t
+        promotion_threshold = VolManager::get()->partial_read_promotion_threshold.value();
+
     // Candidate for parallelization
     for (const auto& partial_reads : partial_reads_map)
     {
@@ -638,6 +643,50 @@ DataStoreNG::readClusters(const std::vector<ClusterReadDescriptor>& descs)
             }
 
             c.backend_read_request_size.count(bytes);
+
+            if (fallback.misses == 0)
+            {
+                partial_read_tracker_.backend_read(bytes,
+                                                   duration_us);
+            }
+        }
+
+        // SCOs that were fetched entirely by the fallback are in the SCOCache
+        // by now - only look at the ones that were actually read partially.
+        if (promotion_window != bc::seconds(0))
+        {
+            for (const auto& pr : partial_reads.second)
+            {
+                SCO sco(pr.first);
+                if (fallback.map.find(sco) != fallback.map.end())
+                {
+                    continue;
+                }
+
+                sco.cloneID(cid);
+
+                bool promote = false;
+                for (const auto& slice : pr.second)
+                {
+                    promote = partial_read_tracker_.record(sco,
+                                                           slice.offset / csize,
+                                                           slice.size / csize,
+                                                           cluster_size_,
+                                                           sco_mult_,
+                                                           promotion_window,
+                                                           promotion_threshold);
+                    if (promote)
+                    {
+                        break;
+                    }
+                }
+
+                if (promote)
+                {
+                    getVolume()->scheduleSCOPrefetch(sco,
+                                                     1.0);
+                }
+            }
         }
     }
 }
@@ -1357,6 +1406,7 @@ DataStoreNG::getSCO_(SCO sco,
 {
     std::unique_ptr<SCOFetcher> fetcher;
     ClusterLocation loc(sco, 0);
+    bool from_backend = false;
 
     ASSERT_RLOCKED();
 
@@ -1365,6 +1415,7 @@ DataStoreNG::getSCO_(SCO sco,
         pendingTLogSCOs_.find(sco) != pendingTLogSCOs_.end())
     {
         VERIFY(bi);
+        from_backend = true;
         // We should not get here in the read path anymore
         fetcher.reset(new BackendSCOFetcher(sco, getVolume(), bi->clone()));
     }
@@ -1377,11 +1428,21 @@ DataStoreNG::getSCO_(SCO sco,
 
     try
     {
-        return scoCache_->getSCO(nspace_,
-                                 sco,
-                                 sco_mult_.t * cluster_size_,
-                                 *fetcher,
-                                 &cached);
+        yt::SteadyTimer t;
+        CachedSCOPtr sco_ptr(scoCache_->getSCO(nspace_,
+                                               sco,
+                                               sco_mult_.t * cluster_size_,
+                                               *fetcher,
+                                               &cached));
+
+        if (from_backend and not cached)
+        {
+            partial_read_tracker_.forget(sco);
+            partial_read_tracker_.backend_read(sco_ptr->getSize(),
+                                               bc::duration_cast<bc::microseconds>(t.elapsed()));
+        }
+
+        return sco_ptr;
     }
     catch (SCOCacheNoMountPointsException& e)
     {
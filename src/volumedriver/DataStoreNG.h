@@ -21,6 +21,7 @@
 #include "ClusterLocationAndHash.h"
 #include "DataStoreCallBack.h"
 #include "OpenSCO.h"
+#include "PartialReadTracker.h"
 #include "SCO.h"
 #include "SCOCache.h"
 #include "SCOFetcher.h"
@@ -213,6 +214,12 @@ public:
         return cacheMissCounter_;
     }
 
+    uint64_t
+    getPartialReadPromotions() const
+    {
+        return partial_read_tracker_.promotions();
+    }
+
     const ClusterLocation&
     localRestart(uint64_t nspace_min,
                  uint64_t nspace_max,
@@ -284,6 +291,9 @@ private:
     std::atomic<uint64_t> cacheHitCounter_;
     std::atomic<uint64_t> cacheMissCounter_;
 
+    // has its own lock
+    PartialReadTracker partial_read_tracker_;
+
     std::unique_ptr<CheckSum> currentCheckSum_;
 
     OpenSCOPtr
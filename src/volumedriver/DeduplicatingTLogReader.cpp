@@ -0,0 +1,188 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "CachedMetaDataPage.h"
+#include "DeduplicatingTLogReader.h"
+#include "TLogReader.h"
+
+#include <iostream>
+
+#include <youtils/Assert.h>
+#include <youtils/wall_timer.h>
+
+namespace volumedriver
+{
+
+namespace fs = boost::filesystem;
+namespace yt = youtils;
+
+bool
+ClusterAddressFilter::insert(ClusterAddress ca)
+{
+    std::vector<uint64_t>& bits = pages_[CachePage::pageAddress(ca)];
+    if (bits.empty())
+    {
+        bits.resize((CachePage::capacity() + 63) / 64,
+                    0);
+    }
+
+    const uint32_t off = CachePage::offset(ca);
+    const uint64_t mask = 1ULL << (off % 64);
+    uint64_t& word = bits[off / 64];
+
+    if (word bitand mask)
+    {
+        return false;
+    }
+    else
+    {
+        word |= mask;
+        ++size_;
+        return true;
+    }
+}
+
+DeduplicatingTLogReader::Stats&
+DeduplicatingTLogReader::Stats::operator+=(const Stats& other)
+{
+    tlogs += other.tlogs;
+    entries += other.entries;
+    kept += other.kept;
+    fetch_seconds += other.fetch_seconds;
+    wait_seconds += other.wait_seconds;
+
+    return *this;
+}
+
+std::ostream&
+operator<<(std::ostream& os,
+           const DeduplicatingTLogReader::Stats& s)
+{
+    return os <<
+        "tlogs: " << s.tlogs <<
+        ", entries: " << s.entries <<
+        ", kept: " << s.kept <<
+        ", fetch secs: " << s.fetch_seconds <<
+        ", wait secs: " << s.wait_seconds;
+}
+
+DeduplicatingTLogReader::DeduplicatingTLogReader(const fs::path& tlog_path,
+                                                 const OrderedTLogIds& tlogs,
+                                                 BackendInterfacePtr bi,
+                                                 ClusterAddressFilter& filter,
+                                                 uint32_t fetchers)
+    : tlog_path_(tlog_path)
+    , tlogs_(tlogs.rbegin(),
+             tlogs.rend())
+    , bi_(std::move(bi))
+    , filter_(filter)
+    , fetchers_(std::max<uint32_t>(fetchers, 1))
+    , next_fetch_(0)
+    , pos_(0)
+{
+    schedule_fetches_();
+}
+
+void
+DeduplicatingTLogReader::schedule_fetches_()
+{
+    while (fetches_.size() < fetchers_ and next_fetch_ < tlogs_.size())
+    {
+        const std::string name(boost::lexical_cast<std::string>(tlogs_[next_fetch_++]));
+        BackendInterfacePtr bi(bi_ ? bi_->clone() : nullptr);
+
+        auto fun([name,
+                  path = tlog_path_,
+                  bi = std::move(bi)]() mutable -> Fetched
+                 {
+                     yt::wall_timer w;
+
+                     std::unique_ptr<TLogReader> r;
+                     if (bi)
+                     {
+                         r = std::make_unique<TLogReader>(path,
+                                                          name,
+                                                          std::move(bi));
+                     }
+                     else
+                     {
+                         r = std::make_unique<TLogReader>(path / name);
+                     }
+
+                     Fetched f;
+
+                     const Entry* e;
+                     while ((e = r->nextLocation()))
+                     {
+                         f.entries.push_back(*e);
+                     }
+
+                     // also covers removing the downloaded TLog
+                     r.reset();
+
+                     f.seconds = w.elapsed();
+                     return f;
+                 });
+
+        fetches_.emplace_back(std::async(std::launch::async,
+                                         std::move(fun)));
+    }
+}
+
+bool
+DeduplicatingTLogReader::refill_()
+{
+    while (pos_ == 0)
+    {
+        if (fetches_.empty())
+        {
+            return false;
+        }
+
+        yt::wall_timer w;
+        Fetched f(fetches_.front().get());
+        fetches_.pop_front();
+
+        stats_.wait_seconds += w.elapsed();
+        stats_.fetch_seconds += f.seconds;
+        stats_.entries += f.entries.size();
+        ++stats_.tlogs;
+
+        schedule_fetches_();
+
+        current_ = std::move(f.entries);
+        pos_ = current_.size();
+    }
+
+    return true;
+}
+
+const Entry*
+DeduplicatingTLogReader::nextAny()
+{
+    while (refill_())
+    {
+        const Entry& e = current_[--pos_];
+        if (filter_.insert(e.clusterAddress()))
+        {
+            ++stats_.kept;
+            return &e;
+        }
+    }
+
+    return nullptr;
+}
+
+}
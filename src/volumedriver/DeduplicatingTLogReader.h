@@ -0,0 +1,156 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VD_DEDUPLICATING_TLOG_READER_H_
+#define VD_DEDUPLICATING_TLOG_READER_H_
+
+#include "Entry.h"
+#include "TLogId.h"
+#include "TLogReaderInterface.h"
+#include "Types.h"
+
+#include <deque>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include <youtils/Logging.h>
+
+#include <backend/BackendInterface.h>
+
+namespace volumedriver
+{
+
+// The cluster addresses handed out so far, one bit per cluster address of a
+// metadata page that was touched at all.
+class ClusterAddressFilter
+{
+public:
+    ClusterAddressFilter() = default;
+
+    ~ClusterAddressFilter() = default;
+
+    ClusterAddressFilter(const ClusterAddressFilter&) = delete;
+
+    ClusterAddressFilter&
+    operator=(const ClusterAddressFilter&) = delete;
+
+    // Returns false if the address was already in there.
+    bool
+    insert(ClusterAddress);
+
+    uint64_t
+    size() const
+    {
+        return size_;
+    }
+
+private:
+    std::unordered_map<PageAddress, std::vector<uint64_t>> pages_;
+    uint64_t size_ = 0;
+};
+
+// Hands out the location entries of a number of TLogs backwards, from the
+// newest entry of the newest TLog to the oldest one of the oldest TLog, and
+// skips those whose cluster address was handed out before - so only the most
+// recent entry per cluster address is returned, which is all that's needed to
+// replay the TLogs in any order. Sharing the filter between the readers for the
+// clones of a volume (starting with the clone itself and proceeding with its
+// parents) extends this to the whole clone chain.
+// Fetching TLogs from the backend and decoding them is done by up to
+// `fetchers' threads ahead of the reader.
+class DeduplicatingTLogReader
+    : public TLogReaderInterface
+{
+public:
+    struct Stats
+    {
+        uint64_t tlogs = 0;
+        // location entries read ...
+        uint64_t entries = 0;
+        // ... and handed out
+        uint64_t kept = 0;
+        // summed up over all fetchers
+        double fetch_seconds = 0;
+        // spent by the reader waiting for fetchers
+        double wait_seconds = 0;
+
+        Stats&
+        operator+=(const Stats&);
+    };
+
+    // tlogs: oldest first, as in CloneTLogs
+    DeduplicatingTLogReader(const boost::filesystem::path& tlog_path,
+                            const OrderedTLogIds& tlogs,
+                            BackendInterfacePtr bi,
+                            ClusterAddressFilter& filter,
+                            uint32_t fetchers);
+
+    ~DeduplicatingTLogReader() = default;
+
+    DeduplicatingTLogReader(const DeduplicatingTLogReader&) = delete;
+
+    DeduplicatingTLogReader&
+    operator=(const DeduplicatingTLogReader&) = delete;
+
+    const Entry*
+    nextAny() override final;
+
+    const Stats&
+    stats() const
+    {
+        return stats_;
+    }
+
+private:
+    DECLARE_LOGGER("DeduplicatingTLogReader");
+
+    struct Fetched
+    {
+        // in TLog order
+        std::vector<Entry> entries;
+        double seconds = 0;
+    };
+
+    const boost::filesystem::path tlog_path_;
+    // newest first
+    const OrderedTLogIds tlogs_;
+    BackendInterfacePtr bi_;
+    ClusterAddressFilter& filter_;
+    const uint32_t fetchers_;
+
+    size_t next_fetch_;
+    std::deque<std::future<Fetched>> fetches_;
+    std::vector<Entry> current_;
+    size_t pos_;
+
+    Stats stats_;
+
+    void
+    schedule_fetches_();
+
+    bool
+    refill_();
+};
+
+std::ostream&
+operator<<(std::ostream&,
+           const DeduplicatingTLogReader::Stats&);
+
+}
+
+#endif // !VD_DEDUPLICATING_TLOG_READER_H_
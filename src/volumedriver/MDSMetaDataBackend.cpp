@@ -21,6 +21,8 @@
 #include "metadata-server/ClientNG.h"
 #include "metadata-server/Manager.h"
 
+#include <boost/lexical_cast.hpp>
+
 #include <youtils/Assert.h>
 #include <youtils/Catchers.h>
 
@@ -59,9 +61,9 @@ namespace yt = youtils;
 namespace
 {
 
-const std::string cork_key("cork_id");
 const std::string used_clusters_key("used_clusters");
 const std::string scrub_id_key("scrub_id");
+const std::string page_format_key("page_format");
 
 DECLARE_LOGGER("MDSMetaDataBackendHelpers");
 
@@ -230,6 +232,51 @@ MDSMetaDataBackend::discardPage(const CachePage& p,
     used_clusters_ = used_clusters;
 }
 
+// All pages and the used clusters counter go out in a single multiset, i.e.
+// one round trip per batch instead of one per page.
+void
+MDSMetaDataBackend::putPages(PageUpdates& updates)
+{
+    LOG_TRACE(table_->nspace() << ": " << updates.size() << " pages");
+
+    int64_t x = used_clusters_;
+
+    mds::TableInterface::Records recs;
+    recs.reserve(updates.size() + 1);
+
+    for (const auto& u : updates)
+    {
+        x += u.used_clusters_delta;
+
+        if (u.discard)
+        {
+            recs.emplace_back(mds::Key(u.page->page_address()),
+                              mds::None());
+        }
+        else
+        {
+            recs.emplace_back(mds::Key(u.page->page_address()),
+                              mds::Value(*u.page));
+        }
+    }
+
+    VERIFY(x >= 0);
+    const uint64_t used_clusters = x;
+
+    recs.emplace_back(mds::Key(used_clusters_key),
+                      mds::Value(used_clusters));
+
+    table_->multiset(recs,
+                     Barrier::F);
+
+    used_clusters_ = used_clusters;
+
+    for (auto& u : updates)
+    {
+        u.done = true;
+    }
+}
+
 void
 MDSMetaDataBackend::sync()
 {
@@ -251,7 +298,7 @@ MDSMetaDataBackend::setCork(const yt::UUID& cork_id)
 
     const std::string s(cork_id.str());
 
-    const mds::TableInterface::Records recs{ mds::Record(mds::Key(cork_key),
+    const mds::TableInterface::Records recs{ mds::Record(mds::Key(mds::cork_key),
                                                          mds::Value(s)) };
 
     table_->multiset(recs,
@@ -263,7 +310,7 @@ MDSMetaDataBackend::lastCorkUUID()
 {
     LOG_TRACE(table_->nspace());
 
-    const mds::TableInterface::Keys keys{ mds::Key(cork_key) };
+    const mds::TableInterface::Keys keys{ mds::Key(mds::cork_key) };
     const mds::TableInterface::MaybeStrings ms(table_->multiget(keys));
 
     boost::optional<yt::UUID> cork;
@@ -312,6 +359,38 @@ MDSMetaDataBackend::scrub_id()
     return scrub_id;
 }
 
+void
+MDSMetaDataBackend::set_page_format(PageFormat format)
+{
+    LOG_INFO(table_->nspace() << ": setting page format " << format);
+
+    const std::string s(boost::lexical_cast<std::string>(format));
+    const mds::TableInterface::Records recs{ mds::Record(mds::Key(page_format_key),
+                                                         mds::Value(s)) };
+    table_->multiset(recs,
+                     Barrier::T);
+}
+
+boost::optional<PageFormat>
+MDSMetaDataBackend::page_format()
+{
+    LOG_TRACE(table_->nspace());
+
+    const mds::TableInterface::Keys keys{ mds::Key(page_format_key) };
+    const mds::TableInterface::MaybeStrings ms(table_->multiget(keys));
+
+    PageFormat format = PageFormat::Wide;
+
+    if (ms[0] != boost::none)
+    {
+        format = boost::lexical_cast<PageFormat>(*ms[0]);
+    }
+
+    LOG_INFO(table_->nspace() << ": page format " << format);
+
+    return format;
+}
+
 MetaDataStoreFunctor&
 MDSMetaDataBackend::for_each(MetaDataStoreFunctor& f,
                              const ClusterAddress ca_max)
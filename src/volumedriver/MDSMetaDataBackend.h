@@ -65,6 +65,9 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) override final;
 
+    void
+    putPages(PageUpdates& updates) override final;
+
     bool
     pageExistsInParent(const PageAddress) const override final
     {
@@ -123,6 +126,12 @@ public:
     virtual void
     set_scrub_id(const ScrubId& id) override final;
 
+    virtual boost::optional<PageFormat>
+    page_format() override final;
+
+    virtual void
+    set_page_format(PageFormat) override final;
+
     static uint64_t
     locally_used_bytes(const VolumeConfig&)
     {
@@ -141,6 +150,12 @@ public:
         table_->set_role(metadata_server::Role::Master);
     }
 
+    void
+    set_slaves(const metadata_server::TableInterface::NodeConfigs& slaves)
+    {
+        table_->set_slaves(slaves);
+    }
+
 private:
     DECLARE_LOGGER("MDSMetaDataBackend");
 
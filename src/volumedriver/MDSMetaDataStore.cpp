@@ -46,7 +46,8 @@ namespace yt = youtils;
 MDSMetaDataStore::MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
                                    be::BackendInterfacePtr bi,
                                    const fs::path& home,
-                                   uint64_t num_pages_cached)
+                                   uint64_t num_pages_cached,
+                                   std::shared_ptr<MetaDataCacheBudget> budget)
     : VolumeBackPointer(getLogger__())
     , rwlock_("mdsmdstore-" + bi->getNS().str())
     , bi_(std::move(bi))
@@ -54,6 +55,7 @@ MDSMetaDataStore::MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
     , apply_relocations_to_slaves_(cfg.apply_relocations_to_slaves())
     , timeout_(cfg.timeout())
     , num_pages_cached_(num_pages_cached)
+    , budget_(std::move(budget))
     , home_(home)
     , incremental_rebuild_count_(0)
     , full_rebuild_count_(0)
@@ -79,7 +81,7 @@ MDSMetaDataStore::MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
 
     try
     {
-        mdstore_ = connect_(node_configs_[0]);
+        mdstore_ = connect_(node_configs_);
     }
     CATCH_STD_ALL_EWHAT({
             LOG_ERROR(bi_->getNS() << ": failed to connect to " <<
@@ -217,7 +219,7 @@ MDSMetaDataStore::do_failover_(bool startup)
 
         try
         {
-            MetaDataStorePtr md(build_new_one_(node_configs_[0],
+            MetaDataStorePtr md(build_new_one_(node_configs_,
                                                startup));
             std::stringstream ss;
             ss << node_configs_[0];
@@ -240,8 +242,11 @@ MDSMetaDataStore::do_failover_(bool startup)
 }
 
 MDSMetaDataStore::MetaDataStorePtr
-MDSMetaDataStore::connect_(const MDSNodeConfig& ncfg) const
+MDSMetaDataStore::connect_(const MDSNodeConfigs& ncfgs) const
 {
+    VERIFY(not ncfgs.empty());
+    const MDSNodeConfig& ncfg = ncfgs[0];
+
     LOG_INFO(bi_->getNS() << ": connecting to " << ncfg);
 
     auto mdb(std::make_shared<MDSMetaDataBackend>(ncfg,
@@ -250,22 +255,34 @@ MDSMetaDataStore::connect_(const MDSNodeConfig& ncfg) const
 
     auto md(std::make_shared<CachedMetaDataStore>(mdb,
                                                   bi_->getNS().str(),
-                                                  num_pages_cached_));
+                                                  num_pages_cached_,
+                                                  budget_));
 
     mdb->set_master();
 
+    // Not fatal - the slaves will then have to poll the backend.
+    try
+    {
+        mdb->set_slaves(MDSNodeConfigs(ncfgs.begin() + 1,
+                                       ncfgs.end()));
+    }
+    CATCH_STD_ALL_LOG_IGNORE(bi_->getNS() << ": failed to register slaves with " <<
+                             ncfg);
+
     return md;
 }
 
 MDSMetaDataStore::MetaDataStorePtr
-MDSMetaDataStore::build_new_one_(const MDSNodeConfig& ncfg,
+MDSMetaDataStore::build_new_one_(const MDSNodeConfigs& ncfgs,
                                  bool startup)
 {
     ASSERT_WLOCKED();
 
-    LOG_INFO(bi_->getNS() << ": attempting failover to " << ncfg);
+    VERIFY(not ncfgs.empty());
+
+    LOG_INFO(bi_->getNS() << ": attempting failover to " << ncfgs[0]);
 
-    auto md(connect_(ncfg));
+    auto md(connect_(ncfgs));
 
     // mdstore_ can only be nullptr when we ended up here while in the constructor
     // Find a way to enforce this invariant.
@@ -542,6 +559,23 @@ MDSMetaDataStore::set_scrub_id(const ScrubId& scrub_id)
                                 scrub_id);
 }
 
+PageFormat
+MDSMetaDataStore::page_format()
+{
+    return handle_<PageFormat>(__FUNCTION__,
+                               &MetaDataStoreInterface::page_format);
+}
+
+// Not subject to failover as refusing to switch formats is not an MDS problem.
+void
+MDSMetaDataStore::set_page_format(PageFormat format)
+{
+    LOCKW();
+
+    VERIFY(mdstore_);
+    mdstore_->set_page_format(format);
+}
+
 void
 MDSMetaDataStore::unCork(const boost::optional<yt::UUID>& cork)
 {
@@ -575,13 +609,26 @@ MDSMetaDataStore::set_config(const MDSMetaDataBackendConfig& cfg)
         LOG_INFO(bi_->getNS() << ": " << node_configs_[0] <<
                  " is currently in use, failover to " << new_configs[0] <<
                  " requested");
-        mdstore_ = build_new_one_(new_configs[0],
+        mdstore_ = build_new_one_(new_configs,
                                   false);
     }
     else
     {
         LOG_INFO(bi_->getNS() << ": " << new_configs[0] <<
                  " is already in use, no need to failover");
+
+        if (new_configs != node_configs_)
+        {
+            try
+            {
+                auto client(mds::ClientNG::create(new_configs[0]));
+                client->open(bi_->getNS().str())->set_slaves(MDSNodeConfigs(new_configs.begin() + 1,
+                                                                            new_configs.end()));
+            }
+            CATCH_STD_ALL_LOG_IGNORE(bi_->getNS() <<
+                                     ": failed to register the new slaves with " <<
+                                     new_configs[0]);
+        }
     }
 
     node_configs_ = new_configs;
@@ -34,6 +34,7 @@ namespace volumedriver
 
 class CachedMetaDataStore;
 class MDSMetaDataBackend;
+class MetaDataCacheBudget;
 
 class ClusterLocationAndHash;
 
@@ -48,7 +49,8 @@ public:
     MDSMetaDataStore(const MDSMetaDataBackendConfig& cfg,
                      backend::BackendInterfacePtr bi,
                      const boost::filesystem::path& home,
-                     uint64_t num_pages_cached);
+                     uint64_t num_pages_cached,
+                     std::shared_ptr<MetaDataCacheBudget> budget = nullptr);
 
     ~MDSMetaDataStore() = default;
 
@@ -127,6 +129,12 @@ public:
     virtual void
     set_cache_capacity(const size_t num_pages) override final;
 
+    virtual PageFormat
+    page_format() override;
+
+    virtual void
+    set_page_format(PageFormat) override;
+
     void
     set_config(const MDSMetaDataBackendConfig& cfg);
 
@@ -165,6 +173,7 @@ private:
     std::chrono::seconds timeout_;
 
     const uint64_t num_pages_cached_;
+    const std::shared_ptr<MetaDataCacheBudget> budget_;
     const boost::filesystem::path home_;
 
     size_t incremental_rebuild_count_;
@@ -172,11 +181,12 @@ private:
 
     using MetaDataStorePtr = std::shared_ptr<CachedMetaDataStore>;
 
+    // ncfgs[0] becomes the master, the others are registered as its slaves
     MetaDataStorePtr
-    connect_(const MDSNodeConfig& ncfg) const;
+    connect_(const MDSNodeConfigs& ncfgs) const;
 
     MetaDataStorePtr
-    build_new_one_(const MDSNodeConfig& ncfg,
+    build_new_one_(const MDSNodeConfigs& ncfgs,
                    bool startup);
 
     void
@@ -0,0 +1,630 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "MMapMetaDataBackend.h"
+#include "VolManager.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <boost/filesystem/fstream.hpp>
+
+#include <youtils/Catchers.h>
+#include <youtils/FileUtils.h>
+
+namespace volumedriver
+{
+
+namespace yt = youtils;
+
+#define HANDLE(x, msg)                                                  \
+    if ((x) < 0)                                                        \
+    {                                                                   \
+        const int err = errno;                                          \
+        LOG_ERROR(filename_ << ": " << msg << ": " << strerror(err));    \
+        throw MetaDataStoreBackendException(msg,                        \
+                                            filename_.string().c_str(), \
+                                            err);                       \
+    }
+
+namespace
+{
+
+const uint64_t header_magic = 0x4d4d41504d445631ULL;
+const uint32_t header_version = 1;
+
+}
+
+const std::string
+MMapMetaDataBackend::db_name = "mdstore.mmap";
+
+const std::string
+MMapMetaDataBackend::header_name = "mdstore.mmap.hdr";
+
+MMapMetaDataBackend::MMapMetaDataBackend(const VolumeConfig& cfg,
+                                         bool writer)
+    : MMapMetaDataBackend(VolManager::get()->getMetaDataPath(cfg),
+                          writer)
+{
+    LOG_INFO(cfg.id_ << ": metadata backend ready");
+}
+
+MMapMetaDataBackend::MMapMetaDataBackend(const fs::path& db_directory,
+                                         bool writer)
+    : filename_(db_directory / db_name)
+    , header_path_(db_directory / header_name)
+    , writer_(writer)
+    , fd_(-1)
+    , map_(nullptr)
+    , map_size_(0)
+    , used_clusters_(0)
+    , page_format_(PageFormat::Wide)
+{
+    fs::create_directories(db_directory);
+
+    fd_ = ::open(filename_.string().c_str(),
+                 writer_ ? (O_RDWR bitor O_CREAT) : O_RDONLY,
+                 S_IRUSR bitor S_IWUSR);
+    HANDLE(fd_, "failed to open page file");
+
+    try
+    {
+        struct stat st;
+        HANDLE(::fstat(fd_, &st), "failed to stat page file");
+
+        if (st.st_size % CachePage::size())
+        {
+            LOG_ERROR(filename_ << ": size " << st.st_size <<
+                      " is not a multiple of the page size " << CachePage::size());
+            throw MetaDataStoreBackendException("page file size is not a multiple of the page size",
+                                                filename_.string().c_str());
+        }
+
+        map_file_(st.st_size);
+
+        const bool clean = read_header_();
+        if (not clean and map_size_ > 0)
+        {
+            LOG_WARN(filename_ <<
+                     ": no clean shutdown recorded, recomputing the used clusters");
+            recount_used_clusters_();
+        }
+
+        if (writer_)
+        {
+            // From now on the used clusters in the header are not to be trusted
+            // until we shut down cleanly.
+            write_header_(false);
+        }
+    }
+    catch (...)
+    {
+        unmap_file_();
+        ::close(fd_);
+        throw;
+    }
+}
+
+MMapMetaDataBackend::~MMapMetaDataBackend()
+{
+    if (T(delete_local_artefacts))
+    {
+        unmap_file_();
+        ::close(fd_);
+
+        yt::FileUtils::removeFileNoThrow(filename_);
+        yt::FileUtils::removeFileNoThrow(header_path_);
+    }
+    else
+    {
+        if (writer_)
+        {
+            try
+            {
+                msync_();
+                write_header_(true);
+            }
+            CATCH_STD_ALL_LOG_IGNORE(filename_ << ": failed to record clean shutdown");
+        }
+
+        unmap_file_();
+        ::close(fd_);
+    }
+}
+
+uint64_t
+MMapMetaDataBackend::page_offset_(const PageAddress pa)
+{
+    static const uint64_t max_pa =
+        std::numeric_limits<off_t>::max() / CachePage::size() - 1;
+
+    if (pa > max_pa)
+    {
+        LOG_ERROR("Page address " << pa << " exceeds the maximum " << max_pa);
+        throw MetaDataStoreBackendException("Page address out of range");
+    }
+
+    return pa * CachePage::size();
+}
+
+void
+MMapMetaDataBackend::map_file_(uint64_t size)
+{
+    ASSERT(map_ == nullptr);
+
+    if (size > 0)
+    {
+        void* m = ::mmap(nullptr,
+                         size,
+                         writer_ ? (PROT_READ bitor PROT_WRITE) : PROT_READ,
+                         MAP_SHARED,
+                         fd_,
+                         0);
+        if (m == MAP_FAILED)
+        {
+            HANDLE(-1, "failed to map page file");
+        }
+
+        map_ = static_cast<uint8_t*>(m);
+    }
+
+    map_size_ = size;
+}
+
+void
+MMapMetaDataBackend::unmap_file_()
+{
+    if (map_ != nullptr)
+    {
+        ::munmap(map_,
+                 map_size_);
+        map_ = nullptr;
+    }
+
+    map_size_ = 0;
+}
+
+void
+MMapMetaDataBackend::grow_(uint64_t size)
+{
+    boost::unique_lock<decltype(map_lock_)> u(map_lock_);
+
+    if (size <= map_size_)
+    {
+        return;
+    }
+
+    // The file is sparse so growing it generously only costs address space,
+    // and it saves us from remapping on every new page.
+    const uint64_t new_size = std::max(size,
+                                       2 * map_size_);
+
+    LOG_TRACE(filename_ << ": growing from " << map_size_ << " to " << new_size);
+
+    HANDLE(::ftruncate(fd_, new_size), "failed to grow page file");
+
+    if (map_ == nullptr)
+    {
+        map_file_(new_size);
+    }
+    else
+    {
+        void* m = ::mremap(map_,
+                           map_size_,
+                           new_size,
+                           MREMAP_MAYMOVE);
+        if (m == MAP_FAILED)
+        {
+            HANDLE(-1, "failed to remap page file");
+        }
+
+        map_ = static_cast<uint8_t*>(m);
+        map_size_ = new_size;
+    }
+}
+
+void
+MMapMetaDataBackend::msync_()
+{
+    boost::shared_lock<decltype(map_lock_)> r(map_lock_);
+
+    if (map_ != nullptr)
+    {
+        HANDLE(::msync(map_, map_size_, MS_SYNC), "failed to msync page file");
+    }
+}
+
+bool
+MMapMetaDataBackend::read_header_()
+{
+    if (not fs::exists(header_path_))
+    {
+        return false;
+    }
+
+    Header h;
+    memset(&h, 0x0, sizeof(h));
+
+    fs::ifstream ifs(header_path_,
+                     std::ios::binary);
+    ifs.read(reinterpret_cast<char*>(&h),
+             sizeof(h));
+
+    if (ifs.gcount() != sizeof(h) or
+        h.magic != header_magic or
+        h.version != header_version)
+    {
+        LOG_ERROR(header_path_ << ": invalid header");
+        throw MetaDataStoreBackendException("invalid header",
+                                            header_path_.string().c_str());
+    }
+
+    if (h.page_size != CachePage::size())
+    {
+        LOG_ERROR(header_path_ << ": page size " << h.page_size <<
+                  " does not match the configured page size " << CachePage::size());
+        throw MetaDataStoreBackendException("page size mismatch",
+                                            header_path_.string().c_str());
+    }
+
+    used_clusters_ = h.used_clusters;
+
+    if (h.have_cork)
+    {
+        cork_ = yt::UUID(h.cork);
+    }
+
+    if (h.have_scrub_id)
+    {
+        scrub_id_ = ScrubId(yt::UUID(h.scrub_id));
+    }
+
+    switch (h.page_format)
+    {
+    case 0:
+        page_format_ = PageFormat::Wide;
+        break;
+    case static_cast<uint8_t>(PageFormat::Wide):
+    case static_cast<uint8_t>(PageFormat::Compact):
+        page_format_ = static_cast<PageFormat>(h.page_format);
+        break;
+    default:
+        LOG_ERROR(header_path_ << ": invalid page format " <<
+                  static_cast<uint32_t>(h.page_format));
+        throw MetaDataStoreBackendException("invalid page format",
+                                            header_path_.string().c_str());
+    }
+
+    return h.clean;
+}
+
+void
+MMapMetaDataBackend::write_header_(bool clean)
+{
+    VERIFY(writer_);
+
+    Header h;
+    memset(&h, 0x0, sizeof(h));
+
+    h.magic = header_magic;
+    h.version = header_version;
+    h.page_size = CachePage::size();
+    h.used_clusters = used_clusters_;
+    h.clean = clean;
+    h.page_format = static_cast<uint8_t>(page_format_);
+
+    static_assert(sizeof(h.cork) == 36,
+                  "header cork size does not match the UUID string size");
+    static_assert(sizeof(h.scrub_id) == 36,
+                  "header scrub id size does not match the UUID string size");
+
+    if (cork_)
+    {
+        h.have_cork = true;
+        memcpy(h.cork,
+               cork_->str().c_str(),
+               sizeof(h.cork));
+    }
+
+    if (scrub_id_)
+    {
+        h.have_scrub_id = true;
+        memcpy(h.scrub_id,
+               static_cast<const yt::UUID&>(*scrub_id_).str().c_str(),
+               sizeof(h.scrub_id));
+    }
+
+    yt::FileUtils::safe_copy(std::string(reinterpret_cast<const char*>(&h),
+                                         sizeof(h)),
+                             header_path_);
+}
+
+void
+MMapMetaDataBackend::recount_used_clusters_()
+{
+    boost::shared_lock<decltype(map_lock_)> r(map_lock_);
+
+    const size_t csize = sizeof(ClusterLocationAndHash);
+    uint64_t used = 0;
+    off_t off = 0;
+
+    // Only look at the parts of the file that are backed by data.
+    while (static_cast<uint64_t>(off) < map_size_)
+    {
+        off_t data = ::lseek(fd_, off, SEEK_DATA);
+        if (data < 0)
+        {
+            if (errno == ENXIO)
+            {
+                break;
+            }
+
+            HANDLE(data, "failed to seek to data");
+        }
+
+        off_t hole = ::lseek(fd_, data, SEEK_HOLE);
+        HANDLE(hole, "failed to seek to hole");
+
+        // extents are block aligned, entries aren't necessarily
+        data -= data % csize;
+        hole = std::min<uint64_t>(map_size_,
+                                  ((hole + csize - 1) / csize) * csize);
+
+        for (off_t o = data; o < hole; o += csize)
+        {
+            const auto clh = reinterpret_cast<const ClusterLocationAndHash*>(map_ + o);
+            if (not clh->clusterLocation.isNull())
+            {
+                ++used;
+            }
+        }
+
+        off = hole;
+    }
+
+    LOG_INFO(filename_ << ": used clusters " << used_clusters_ << " -> " << used);
+    used_clusters_ = used;
+}
+
+bool
+MMapMetaDataBackend::getPage(CachePage& p)
+{
+    LOG_TRACE("page address " << p.page_address());
+
+    const uint64_t off = page_offset_(p.page_address());
+
+    boost::shared_lock<decltype(map_lock_)> r(map_lock_);
+
+    if (off + CachePage::size() > map_size_)
+    {
+        return false;
+    }
+
+    memcpy(p.data(),
+           map_ + off,
+           CachePage::size());
+
+    return true;
+}
+
+void
+MMapMetaDataBackend::putPage(const CachePage& p,
+                             int32_t used_clusters_delta)
+{
+    LOG_TRACE("page address " << p.page_address() << ", used_clusters_delta " <<
+              used_clusters_delta);
+
+    const uint64_t off = page_offset_(p.page_address());
+    const int64_t used_clusters = used_clusters_ + used_clusters_delta;
+    ASSERT(used_clusters >= 0);
+
+    grow_(off + CachePage::size());
+
+    boost::shared_lock<decltype(map_lock_)> r(map_lock_);
+
+    memcpy(map_ + off,
+           p.data(),
+           CachePage::size());
+
+    used_clusters_ = used_clusters;
+}
+
+void
+MMapMetaDataBackend::discardPage(const CachePage& p,
+                                 int32_t used_clusters_delta)
+{
+    LOG_TRACE("page address " << p.page_address() << ", used_clusters_delta " <<
+              used_clusters_delta);
+
+    const uint64_t off = page_offset_(p.page_address());
+    const int64_t used_clusters = used_clusters_ + used_clusters_delta;
+    ASSERT(used_clusters >= 0);
+
+    boost::shared_lock<decltype(map_lock_)> r(map_lock_);
+
+    if (off + CachePage::size() > map_size_)
+    {
+        return;
+    }
+
+    // Give the space back to the filesystem if possible - partial blocks are
+    // zeroed by it.
+    const int ret = ::fallocate(fd_,
+                                FALLOC_FL_PUNCH_HOLE bitor FALLOC_FL_KEEP_SIZE,
+                                off,
+                                CachePage::size());
+    if (ret < 0)
+    {
+        LOG_TRACE(filename_ << ": failed to punch hole: " << strerror(errno) <<
+                  " - zeroing the page instead");
+        memset(map_ + off,
+               0x0,
+               CachePage::size());
+    }
+
+    used_clusters_ = used_clusters;
+}
+
+void
+MMapMetaDataBackend::sync()
+{
+    msync_();
+    write_header_(false);
+}
+
+void
+MMapMetaDataBackend::clear_all_keys()
+{
+    {
+        boost::unique_lock<decltype(map_lock_)> u(map_lock_);
+
+        unmap_file_();
+        HANDLE(::ftruncate(fd_, 0), "failed to truncate page file");
+    }
+
+    used_clusters_ = 0;
+    cork_ = boost::none;
+    scrub_id_ = boost::none;
+    page_format_ = PageFormat::Wide;
+
+    write_header_(false);
+}
+
+MetaDataStoreFunctor&
+MMapMetaDataBackend::for_each(MetaDataStoreFunctor& f,
+                              const ClusterAddress ca_max)
+{
+    const size_t page_size = CachePage::capacity();
+    std::vector<ClusterLocationAndHash> clh(page_size);
+
+    for (ClusterAddress ca = 0; ca < ca_max; ca += page_size)
+    {
+        const PageAddress pa = CachePage::pageAddress(ca);
+        CachePage p(pa, clh.data());
+
+        if (getPage(p))
+        {
+            for (size_t i = 0; i < page_size; ++i)
+            {
+                const ClusterLocationAndHash& loc = p[i];
+                if (not loc.clusterLocation.isNull())
+                {
+                    f(CachePage::clusterAddress(pa) + i, loc);
+                }
+            }
+        }
+    }
+
+    return f;
+}
+
+void
+MMapMetaDataBackend::setCork(const yt::UUID& cork_uuid)
+{
+    LOG_TRACE(cork_uuid);
+
+    // Everything up to the cork has to hit the disk before the cork does.
+    msync_();
+    cork_ = cork_uuid;
+    write_header_(false);
+}
+
+boost::optional<yt::UUID>
+MMapMetaDataBackend::lastCorkUUID()
+{
+    return cork_;
+}
+
+MaybeScrubId
+MMapMetaDataBackend::scrub_id()
+{
+    return scrub_id_;
+}
+
+void
+MMapMetaDataBackend::set_scrub_id(const ScrubId& scrub_id)
+{
+    LOG_INFO("Setting scrub ID " << scrub_id);
+
+    msync_();
+    scrub_id_ = scrub_id;
+    write_header_(false);
+}
+
+boost::optional<PageFormat>
+MMapMetaDataBackend::page_format()
+{
+    return page_format_;
+}
+
+void
+MMapMetaDataBackend::set_page_format(PageFormat format)
+{
+    LOG_INFO("Setting page format " << format);
+
+    msync_();
+    page_format_ = format;
+    write_header_(false);
+}
+
+uint64_t
+MMapMetaDataBackend::locally_required_bytes(const VolumeConfig& cfg)
+{
+    // Fully populated page file - there's no per-record overhead.
+    const uint64_t vsize = cfg.lba_size_ * cfg.lba_count();
+    const uint64_t csize = cfg.getClusterSize();
+    VERIFY(csize > 0);
+
+    const uint64_t nclusters = vsize / csize + (vsize % csize ? 1 : 0);
+    const uint64_t pentries = CachePage::capacity();
+    const uint64_t npages = nclusters / pentries + (nclusters % pentries ? 1 : 0);
+
+    return npages * CachePage::size() + sizeof(Header);
+}
+
+uint64_t
+MMapMetaDataBackend::locally_used_bytes(const VolumeConfig& cfg)
+{
+    const fs::path p(VolManager::get()->getMetaDataPath(cfg) / db_name);
+    struct stat st;
+
+    // the file is sparse, so look at the allocated blocks rather than its size
+    if (::stat(p.string().c_str(), &st) == 0)
+    {
+        return st.st_blocks * 512 + sizeof(Header);
+    }
+    else
+    {
+        LOG_WARN("failed to determine size of " << p << ": " << strerror(errno));
+        return 0;
+    }
+}
+
+std::unique_ptr<MetaDataBackendConfig>
+MMapMetaDataBackend::getConfig() const
+{
+    return std::unique_ptr<MetaDataBackendConfig>(new MMapMetaDataBackendConfig());
+}
+
+}
+
+// Local Variables: **
+// mode: c++ **
+// End: **
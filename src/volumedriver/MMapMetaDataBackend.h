@@ -0,0 +1,225 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VD_MMAP_META_DATA_BACKEND_H_
+#define VD_MMAP_META_DATA_BACKEND_H_
+
+#include "CachedMetaDataStore.h"
+#include "MetaDataBackendInterface.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <youtils/Logging.h>
+#include <youtils/UUID.h>
+
+namespace volumedrivertest
+{
+class MMapMetaDataBackendTest;
+}
+
+namespace volumedriver
+{
+
+// Local metadata backend that keeps the pages in a sparse file at fixed
+// offsets (page address * CachePage::size()) which is mmap'ed, so getting and
+// putting a page boils down to a memcpy and there's nothing to rebuild on
+// restart. Pages that were never written are holes in the file and read back
+// as zeroes, i.e. as empty pages.
+//
+// The bits that don't fit in there (used clusters, cork, scrub ID) live in a
+// small header file that is replaced atomically (write to temp + fsync + rename).
+// Crash consistency:
+// * the page file is msync'ed *before* a new cork or scrub ID is recorded in the
+//   header, so everything up to the last cork is durable once the cork is
+// * pages written after the last cork can be torn by a crash, but they are
+//   overwritten anyway by replaying the TLogs after the cork
+// * the header carries a clean shutdown flag; if it's not set on startup the
+//   used clusters count might be off and is recomputed from the page file.
+class MMapMetaDataBackend
+    : public MetaDataBackendInterface
+{
+    friend class ::volumedrivertest::MMapMetaDataBackendTest;
+
+public:
+    explicit MMapMetaDataBackend(const VolumeConfig& cfg,
+                                 bool writer = true);
+
+    explicit MMapMetaDataBackend(const boost::filesystem::path& db_directory,
+                                 bool writer = true);
+
+    ~MMapMetaDataBackend();
+
+    MMapMetaDataBackend(const MMapMetaDataBackend&) = delete;
+
+    MMapMetaDataBackend&
+    operator=(const MMapMetaDataBackend&) = delete;
+
+    bool
+    getPage(CachePage& p) override final;
+
+    void
+    putPage(const CachePage& p,
+            int32_t used_clusters_delta) override final;
+
+    void
+    discardPage(const CachePage& p,
+                int32_t used_clusters_delta) override final;
+
+    bool
+    pageExistsInParent(const PageAddress) const override final
+    {
+        return false;
+    }
+
+    void
+    sync() override final;
+
+    void
+    clear_all_keys() override final;
+
+    bool
+    freezeable() const override final
+    {
+        return false;
+    }
+
+    void
+    setCork(const youtils::UUID& cork_uuid) override final;
+
+    boost::optional<youtils::UUID>
+    lastCorkUUID() override final;
+
+    inline uint64_t
+    getUsedClusters() const override final
+    {
+        return used_clusters_;
+    }
+
+    youtils::UUID
+    setFrozenParentCloneCork() override final
+    {
+        VERIFY(0 == "I'm a MMapMetaDataBackend and don't know how to set a frozen parent clone cork");
+    }
+
+    std::unique_ptr<MetaDataBackendConfig>
+    getConfig() const override final;
+
+    MetaDataStoreFunctor&
+    for_each(MetaDataStoreFunctor& f,
+             const ClusterAddress max_pages) override final;
+
+    bool
+    hasFrozenParent() const override final
+    {
+        return false;
+    }
+
+    bool
+    isEmancipated() const override final
+    {
+        return true;
+    }
+
+    MaybeScrubId
+    scrub_id() override final;
+
+    void
+    set_scrub_id(const ScrubId& id) override final;
+
+    boost::optional<PageFormat>
+    page_format() override final;
+
+    void
+    set_page_format(PageFormat) override final;
+
+    static uint64_t
+    locally_used_bytes(const VolumeConfig&);
+
+    static uint64_t
+    locally_required_bytes(const VolumeConfig&);
+
+    static const std::string db_name;
+    static const std::string header_name;
+
+private:
+    DECLARE_LOGGER("MMapMetaDataBackend");
+
+    // On-disk layout of the header file.
+    struct Header
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t page_size;
+        uint64_t used_clusters;
+        uint8_t clean;
+        uint8_t have_cork;
+        uint8_t have_scrub_id;
+        char cork[36];
+        char scrub_id[36];
+        // 0: none recorded (Wide)
+        uint8_t page_format;
+    };
+
+    const boost::filesystem::path filename_;
+    const boost::filesystem::path header_path_;
+    const bool writer_;
+    int fd_;
+
+    // Protects the mapping itself (which moves when the file grows or is
+    // truncated), not the page contents - the CachedMetaDataStore makes sure
+    // that a page is not read and written concurrently.
+    mutable boost::shared_mutex map_lock_;
+    uint8_t* map_;
+    uint64_t map_size_;
+
+    uint64_t used_clusters_;
+    boost::optional<youtils::UUID> cork_;
+    MaybeScrubId scrub_id_;
+    PageFormat page_format_;
+
+    static uint64_t
+    page_offset_(const PageAddress);
+
+    void
+    map_file_(uint64_t size);
+
+    void
+    unmap_file_();
+
+    void
+    grow_(uint64_t size);
+
+    void
+    msync_();
+
+    bool
+    read_header_();
+
+    void
+    write_header_(bool clean);
+
+    void
+    recount_used_clusters_();
+};
+
+}
+
+#endif // !VD_MMAP_META_DATA_BACKEND_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -43,6 +43,7 @@ reminder(MetaDataBackendType t)
     case MetaDataBackendType::MDS:
     case MetaDataBackendType::RocksDB:
     case MetaDataBackendType::TCBT:
+    case MetaDataBackendType::MMap:
         // If the compiler yells at you that you've forgotten dealing with an enum
         // value here chances are that it's also missing from the translations map
         // below. If so add it NOW.
@@ -60,6 +61,7 @@ init_translations()
         { MetaDataBackendType::MDS, "MDS" },
         { MetaDataBackendType::RocksDB, "ROCKSDB" },
         { MetaDataBackendType::TCBT, "TCBT" },
+        { MetaDataBackendType::MMap, "MMAP" },
     };
 
     return TranslationsMap(initv.begin(),
@@ -40,6 +40,7 @@ enum class MetaDataBackendType
     MDS,
     RocksDB,
     TCBT,
+    MMap,
 };
 
 std::ostream&
@@ -149,6 +150,46 @@ private:
     }
 };
 
+struct MMapMetaDataBackendConfig
+    : public MetaDataBackendConfig
+{
+    MMapMetaDataBackendConfig()
+        : MetaDataBackendConfig(MetaDataBackendType::MMap)
+    {}
+
+    virtual ~MMapMetaDataBackendConfig() = default;
+
+    virtual std::unique_ptr<MetaDataBackendConfig>
+    clone() const override final
+    {
+        return std::unique_ptr<MetaDataBackendConfig>(new MMapMetaDataBackendConfig());
+    }
+
+protected:
+    virtual bool
+    equals(const MetaDataBackendConfig& other) const override final
+    {
+        return dynamic_cast<const MMapMetaDataBackendConfig*>(&other) != nullptr;
+    }
+
+private:
+    friend class boost::serialization::access;
+
+    template<typename A>
+    void
+    serialize(A& /* ar */,
+              const unsigned version)
+    {
+        if (version != 1)
+        {
+            THROW_SERIALIZATION_ERROR(version, 1, 1);
+        }
+
+        boost::serialization::void_cast_register<MMapMetaDataBackendConfig,
+                                                 MetaDataBackendConfig>();
+    }
+};
+
 struct RocksDBMetaDataBackendConfig
     : public MetaDataBackendConfig
 {
@@ -426,6 +467,9 @@ BOOST_CLASS_EXPORT_KEY(volumedriver::TCBTMetaDataBackendConfig);
 BOOST_CLASS_VERSION(volumedriver::RocksDBMetaDataBackendConfig, 1);
 BOOST_CLASS_EXPORT_KEY(volumedriver::RocksDBMetaDataBackendConfig);
 
+BOOST_CLASS_VERSION(volumedriver::MMapMetaDataBackendConfig, 1);
+BOOST_CLASS_EXPORT_KEY(volumedriver::MMapMetaDataBackendConfig);
+
 BOOST_CLASS_VERSION(volumedriver::ArakoonMetaDataBackendConfig, 1);
 BOOST_CLASS_EXPORT_KEY(volumedriver::ArakoonMetaDataBackendConfig);
 
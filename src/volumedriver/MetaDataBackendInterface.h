@@ -20,6 +20,8 @@
 #include "ScrubId.h"
 #include "Types.h"
 
+#include <vector>
+
 #include <youtils/IOException.h>
 
 namespace volumedriver
@@ -28,6 +30,28 @@ namespace volumedriver
 MAKE_EXCEPTION(MetaDataStoreBackendException, fungi::IOException);
 class CachePage;
 
+// A page that is to be written out as part of a batch, cf. putPages.
+struct PageUpdate
+{
+    PageUpdate(const CachePage& p,
+               int32_t delta,
+               bool disc)
+        : page(&p)
+        , used_clusters_delta(delta)
+        , discard(disc)
+        , done(false)
+    {}
+
+    const CachePage* page;
+    int32_t used_clusters_delta;
+    // remove the page instead of writing it
+    bool discard;
+    // set by the backend once the update was persisted
+    bool done;
+};
+
+typedef std::vector<PageUpdate> PageUpdates;
+
 class MetaDataBackendInterface
 {
 public:
@@ -52,6 +76,30 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) = 0;
 
+    // Writes out a batch of pages (sorted by page address). Backends that can
+    // persist several pages in one go should override this - the default just
+    // puts / discards them one by one.
+    // On error the updates that made it are flagged as done.
+    virtual void
+    putPages(PageUpdates& updates)
+    {
+        for (auto& u : updates)
+        {
+            if (u.discard)
+            {
+                discardPage(*u.page,
+                            u.used_clusters_delta);
+            }
+            else
+            {
+                putPage(*u.page,
+                        u.used_clusters_delta);
+            }
+
+            u.done = true;
+        }
+    }
+
     virtual bool
     pageExistsInParent(const PageAddress) const = 0;
 
@@ -67,6 +115,22 @@ public:
     virtual void
     set_scrub_id(const ScrubId& id) = 0;
 
+    // The PageFormat of the cache in front of the backend, which needs to be
+    // recorded as pages written out from a Compact cache lack the hashes.
+    // Backends that can record it return Wide if nothing was recorded (yet),
+    // the others return boost::none and are only used with Wide caches.
+    virtual boost::optional<PageFormat>
+    page_format()
+    {
+        return boost::none;
+    }
+
+    virtual void
+    set_page_format(PageFormat)
+    {
+        throw MetaDataStoreBackendException("Backend does not support recording the page format");
+    }
+
     void
     set_delete_local_artefacts_on_destroy() noexcept
     {
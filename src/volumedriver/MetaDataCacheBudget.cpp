@@ -0,0 +1,195 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "MetaDataCacheBudget.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+
+namespace volumedriver
+{
+
+namespace
+{
+
+// weight of the history in the decayed miss costs
+const double decay = 0.5;
+
+}
+
+MetaDataCacheBudget::MetaDataCacheBudget(uint64_t pages,
+                                         uint64_t min_pages)
+    : pages_(pages)
+    , memory_(std::make_shared<CachePageMemory>(pages * CachePage::size()))
+    , wide_pool_(std::make_shared<CachePagePool>(pages,
+                                                 PageFormat::Wide,
+                                                 memory_))
+    , compact_pool_(std::make_shared<CachePagePool>(pages *
+                                                    CachePage::pages_per_wide_page(PageFormat::Compact),
+                                                    PageFormat::Compact,
+                                                    memory_))
+    , min_pages_(std::max<uint64_t>(min_pages, 1))
+{
+    LOG_INFO("node-wide metadata cache budget: " << pages <<
+             " pages, min pages per volume: " << min_pages_);
+}
+
+MetaDataCacheBudget::~MetaDataCacheBudget()
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (not shares_.empty())
+    {
+        LOG_ERROR(shares_.size() << " clients are still registered");
+    }
+}
+
+uint64_t
+MetaDataCacheBudget::register_client(Client& c,
+                                     uint64_t requested_pages)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    uint64_t assigned = 0;
+    for (const auto& p : shares_)
+    {
+        assigned += p.second.quota;
+    }
+
+    const uint64_t unassigned = pages_ > assigned ?
+        pages_ - assigned :
+        0;
+
+    const uint64_t quota = std::max(min_pages_,
+                                    std::min(requested_pages,
+                                             unassigned));
+
+    const bool ok = shares_.emplace(&c,
+                                    Share{ quota, 0 }).second;
+    VERIFY(ok);
+
+    LOG_INFO(&c << ": registered, requested " << requested_pages <<
+             " pages, got " << quota << ", " << unassigned <<
+             " pages were unassigned");
+
+    return quota;
+}
+
+void
+MetaDataCacheBudget::unregister_client(Client& c)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    const size_t n = shares_.erase(&c);
+    VERIFY(n == 1);
+}
+
+void
+MetaDataCacheBudget::rebalance()
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (shares_.empty())
+    {
+        return;
+    }
+
+    double total_cost = 0;
+
+    for (auto& p : shares_)
+    {
+        uint64_t cost = 0;
+
+        try
+        {
+            cost = p.first->collect_miss_cost();
+        }
+        CATCH_STD_ALL_LOG_IGNORE(p.first << ": failed to collect miss cost");
+
+        p.second.cost = decay * p.second.cost + (1 - decay) * cost;
+        total_cost += p.second.cost;
+    }
+
+    if (total_cost == 0)
+    {
+        LOG_TRACE("no cache misses, nothing to rebalance");
+        return;
+    }
+
+    const uint64_t reserved = min_pages_ * shares_.size();
+    const uint64_t spare = pages_ > reserved ?
+        pages_ - reserved :
+        0;
+
+    std::vector<std::pair<Client*, uint64_t>> shrink;
+    std::vector<std::pair<Client*, uint64_t>> grow;
+
+    for (auto& p : shares_)
+    {
+        const uint64_t target = min_pages_ +
+            static_cast<uint64_t>(spare * p.second.cost / total_cost);
+        // only go half the way to dampen oscillations
+        const uint64_t quota = std::max(min_pages_,
+                                        (p.second.quota + target) / 2);
+
+        if (quota < p.second.quota)
+        {
+            shrink.emplace_back(p.first, quota);
+        }
+        else if (quota > p.second.quota)
+        {
+            grow.emplace_back(p.first, quota);
+        }
+
+        LOG_DEBUG(p.first << ": miss cost " << p.second.cost <<
+                  ", quota " << p.second.quota << " -> " << quota);
+
+        p.second.quota = quota;
+    }
+
+    auto set_quotas([](const std::vector<std::pair<Client*, uint64_t>>& v)
+                    {
+                        for (const auto& p : v)
+                        {
+                            try
+                            {
+                                p.first->set_page_quota(p.second);
+                            }
+                            CATCH_STD_ALL_LOG_IGNORE(p.first << ": failed to set quota to " <<
+                                                     p.second << " pages");
+                        }
+                    });
+
+    // shrinking first returns pages to the pools before others go after them,
+    // trimming the pools then frees the memory for the other format
+    set_quotas(shrink);
+
+    const uint64_t trimmed_wide = wide_pool_->trim();
+    const uint64_t trimmed_compact = compact_pool_->trim();
+
+    set_quotas(grow);
+
+    LOG_INFO("rebalanced " << shares_.size() << " volumes: " << shrink.size() <<
+             " shrunk, " << grow.size() << " grown, " << wide_pool_->used() <<
+             " wide and " << compact_pool_->used() << " compact pages in use, " <<
+             trimmed_wide << " wide and " << trimmed_compact <<
+             " compact pages trimmed, " << memory_->used() << " of " <<
+             memory_->capacity() << " bytes allocated");
+}
+
+}
@@ -0,0 +1,131 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VD_METADATA_CACHE_BUDGET_H_
+#define VD_METADATA_CACHE_BUDGET_H_
+
+#include "CachePagePool.h"
+
+#include <memory>
+#include <unordered_map>
+
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+namespace volumedriver
+{
+
+// Node-wide budget of metadata cache pages shared by all volumes.
+// Each user (CachedMetaDataStore) gets a quota that is adjusted periodically by
+// rebalance(): everyone keeps min_pages, the rest is handed out in proportion
+// to the (decayed) time spent on cache misses, i.e. volumes that are idle or
+// whose working set fits give up their pages to the ones that suffer.
+// Budget and quotas are expressed in Wide pages; clients using Compact pages
+// take them from a separate pool and get CachePage::pages_per_wide_page times
+// as many. Both pools draw on the same CachePageMemory so together they stay
+// within the budget, and rebalance() trims them so memory a pool no longer
+// needs can go to the other one.
+class MetaDataCacheBudget
+{
+public:
+    class Client
+    {
+    public:
+        virtual ~Client() = default;
+
+        // Time spent fetching pages from the backend on cache misses since
+        // the last call, in microseconds.
+        virtual uint64_t
+        collect_miss_cost() = 0;
+
+        // Pages beyond the new quota need to be returned to the pool.
+        virtual void
+        set_page_quota(uint64_t pages) = 0;
+    };
+
+    MetaDataCacheBudget(uint64_t pages,
+                        uint64_t min_pages);
+
+    ~MetaDataCacheBudget();
+
+    MetaDataCacheBudget(const MetaDataCacheBudget&) = delete;
+
+    MetaDataCacheBudget&
+    operator=(const MetaDataCacheBudget&) = delete;
+
+    // Returns the initial quota, based on the requested number of pages and
+    // what is not handed out yet.
+    uint64_t
+    register_client(Client&,
+                    uint64_t requested_pages);
+
+    void
+    unregister_client(Client&);
+
+    void
+    rebalance();
+
+    const std::shared_ptr<CachePagePool>&
+    pool(PageFormat format = PageFormat::Wide) const
+    {
+        return format == PageFormat::Wide ?
+            wide_pool_ :
+            compact_pool_;
+    }
+
+    uint64_t
+    pages() const
+    {
+        return pages_;
+    }
+
+    uint64_t
+    min_pages() const
+    {
+        return min_pages_;
+    }
+
+    const std::shared_ptr<CachePageMemory>&
+    memory() const
+    {
+        return memory_;
+    }
+
+private:
+    DECLARE_LOGGER("MetaDataCacheBudget");
+
+    struct Share
+    {
+        uint64_t quota;
+        double cost;
+    };
+
+    const uint64_t pages_;
+    const std::shared_ptr<CachePageMemory> memory_;
+    const std::shared_ptr<CachePagePool> wide_pool_;
+    const std::shared_ptr<CachePagePool> compact_pool_;
+    const uint64_t min_pages_;
+
+    // Held during rebalance() (including the callbacks into the clients), so
+    // clients must not be holding any of their own locks when (un)registering.
+    boost::mutex lock_;
+    std::unordered_map<Client*, Share> shares_;
+};
+
+}
+
+#endif // !VD_METADATA_CACHE_BUDGET_H_
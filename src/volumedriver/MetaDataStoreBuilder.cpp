@@ -18,7 +18,10 @@
 #include "SnapshotPersistor.h"
 #include "VolumeConfig.h"
 
+#include <iostream>
+
 #include <youtils/Catchers.h>
+#include <youtils/wall_timer.h>
 
 namespace volumedriver
 {
@@ -87,6 +90,8 @@ MetaDataStoreBuilder::update_metadata_store_(const boost::optional<yt::UUID>& fr
              from << ", " << to << "], check scrub ID: " << check_scrub_id <<
              ", dry run:" << dry_run << ", full rebuild: " << full_rebuild);
 
+    yt::wall_timer timer;
+
     // This has a lot in common with the mdstore rebuilding code in
     // volumedriver::VolumeFactory - see if this can be unified.
     // In that case special care needs to be taken WRT file locations
@@ -142,6 +147,8 @@ MetaDataStoreBuilder::update_metadata_store_(const boost::optional<yt::UUID>& fr
     LOG_INFO(bi_->getNS() << ": adjusted interval (" << start_cork << ", " <<
              end_cork << "]");
 
+    res.prepare_seconds = timer.elapsed();
+
     if (start_cork != boost::none and
         *start_cork == end_cork)
     {
@@ -160,9 +167,13 @@ MetaDataStoreBuilder::update_metadata_store_(const boost::optional<yt::UUID>& fr
                                       start_cork,
                                       end_cork);
 
+        timer.restart();
+
         sp.vold(acc,
                 bi_->clone());
 
+        res.collect_seconds = timer.elapsed();
+
         const CloneTLogs& tlogs(acc.clone_tlogs());
 
         VERIFY(tlogs.size() <= res.nsid_map.size());
@@ -178,6 +189,8 @@ MetaDataStoreBuilder::update_metadata_store_(const boost::optional<yt::UUID>& fr
         {
             LOG_INFO(bi_->getNS() << ": replaying " << res.num_tlogs << " TLogs");
 
+            timer.restart();
+
             mdstore_.processCloneTLogs(tlogs,
                                        res.nsid_map,
                                        scratch_dir_,
@@ -188,10 +201,26 @@ MetaDataStoreBuilder::update_metadata_store_(const boost::optional<yt::UUID>& fr
             {
                 mdstore_.set_scrub_id(sp_scrub_id);
             }
+
+            res.replay_seconds = timer.elapsed();
         }
     }
 
+    LOG_INFO(bi_->getNS() << ": " << res);
+
     return res;
 }
 
+std::ostream&
+operator<<(std::ostream& os,
+           const MetaDataStoreBuilder::Result& res)
+{
+    return os <<
+        "MetaDataStoreBuilder::Result(num_tlogs=" << res.num_tlogs <<
+        ", full_rebuild=" << res.full_rebuild <<
+        ", prepare_seconds=" << res.prepare_seconds <<
+        ", collect_seconds=" << res.collect_seconds <<
+        ", replay_seconds=" << res.replay_seconds << ")";
+}
+
 }
@@ -49,6 +49,13 @@ public:
         NSIDMap nsid_map;
         size_t num_tlogs = 0;
         bool full_rebuild = false;
+
+        // Phase timings (seconds): loading the snapshots and checking the
+        // scrub ID, determining the TLogs to replay, and replaying them
+        // (fetching, decoding, applying and syncing).
+        double prepare_seconds = 0;
+        double collect_seconds = 0;
+        double replay_seconds = 0;
     };
 
     // DryRun: don't apply to mdstore
@@ -72,6 +79,10 @@ private:
                            bool full_rebuild);
 };
 
+std::ostream&
+operator<<(std::ostream&,
+           const MetaDataStoreBuilder::Result&);
+
 }
 
 #endif // !VD_META_DATA_STORE_BUILDER_H_
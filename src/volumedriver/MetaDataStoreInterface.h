@@ -16,6 +16,7 @@
 #ifndef METADATA_STORE_INTERFACE_H_
 #define METADATA_STORE_INTERFACE_H_
 
+#include "PageFormat.h"
 #include "ScrubId.h"
 #include "Types.h"
 #include "MetaDataStoreStats.h"
@@ -128,6 +129,14 @@ public:
 
     virtual void
     set_cache_capacity(const size_t npages) = 0;
+
+    virtual PageFormat
+    page_format() = 0;
+
+    // Going from Compact to Wide does not bring back the hashes that were
+    // dropped - the store needs to be rebuilt for that.
+    virtual void
+    set_page_format(PageFormat) = 0;
 };
 
 }
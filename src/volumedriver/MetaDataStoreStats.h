@@ -34,6 +34,11 @@ struct MetaDataStoreStats
         , used_clusters(0)
         , max_pages(0)
         , cached_pages(0)
+        , dirty_pages(0)
+        , eviction_stalls(0)
+        , frequent_pages(0)
+        , frequent_hits(0)
+        , ghost_hits(0)
     {}
 
     uint64_t cache_hits;
@@ -41,6 +46,18 @@ struct MetaDataStoreStats
     uint64_t used_clusters;
     uint32_t max_pages;
     uint32_t cached_pages;
+    // pages not yet written back to the backend
+    uint32_t dirty_pages;
+    // cache misses that had to write out a dirty page before the page could
+    // be reused
+    uint64_t eviction_stalls;
+    // pages that were referenced again after being evicted once (and are hence
+    // not evicted by sequential scans) ...
+    uint64_t frequent_pages;
+    // ... and the share of the cache_hits on these
+    uint64_t frequent_hits;
+    // cache misses on pages that were evicted not long ago
+    uint64_t ghost_hits;
     // contains also discarded clusters!
     std::vector< std::pair<youtils::UUID, uint64_t> > corked_clusters;
 };
@@ -0,0 +1,48 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VD_PAGE_FORMAT_H_
+#define VD_PAGE_FORMAT_H_
+
+#include <iosfwd>
+#include <cstdint>
+
+namespace volumedriver
+{
+
+// In memory a metadata page either holds ClusterLocationAndHash entries (Wide)
+// or only the ClusterLocations (Compact), which is all that's needed by volumes
+// that don't use content based cluster caching and allows to cache several
+// times as many entries in the same amount of memory.
+// The backends only ever get to see Wide pages - Compact ones are converted on
+// the fly (with null hashes), cf. CachedMetaDataStore.
+enum class PageFormat: uint8_t
+{
+    // 0 is used by backends to indicate that no format was recorded
+    Wide = 1,
+    Compact = 2,
+};
+
+std::ostream&
+operator<<(std::ostream&,
+           const PageFormat);
+
+std::istream&
+operator>>(std::istream&,
+           PageFormat&);
+
+}
+
+#endif // !VD_PAGE_FORMAT_H_
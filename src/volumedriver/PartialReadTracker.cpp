@@ -0,0 +1,254 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "PartialReadTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace volumedriver
+{
+
+namespace bc = boost::chrono;
+
+#define LOCK()                                  \
+    boost::lock_guard<decltype(lock_)> lg__(lock_)
+
+namespace
+{
+
+// weight of older samples in the least squares fit
+const double decay = 0.98;
+
+// don't trust the fit before having seen that many samples
+const uint64_t min_samples = 8;
+
+}
+
+PartialReadTracker::PartialReadTracker(size_t max_entries)
+    : max_entries_(std::max<size_t>(max_entries, 1))
+    , promotions_(0)
+    , sw_(0)
+    , sx_(0)
+    , sy_(0)
+    , sxx_(0)
+    , sxy_(0)
+    , samples_(0)
+{}
+
+bool
+PartialReadTracker::record(const SCO sco,
+                           const SCOOffset off,
+                           const size_t num_clusters,
+                           const ClusterSize csize,
+                           const SCOMultiplier sco_mult,
+                           const bc::seconds window,
+                           const uint32_t threshold,
+                           const Clock::time_point now)
+{
+    if (window == bc::seconds(0) or num_clusters == 0)
+    {
+        return false;
+    }
+
+    LOCK();
+
+    auto it = map_.find(sco);
+    if (it == map_.end())
+    {
+        if (map_.size() >= max_entries_)
+        {
+            trim_(now, window);
+        }
+
+        it = map_.emplace(sco, Entry()).first;
+        it->second.start = now;
+    }
+    else if (now - it->second.start > window)
+    {
+        it->second.start = now;
+        it->second.clusters.reset();
+    }
+
+    boost::dynamic_bitset<>& clusters = it->second.clusters;
+    const size_t end = std::max<size_t>(off + num_clusters,
+                                        sco_mult);
+    if (clusters.size() < end)
+    {
+        clusters.resize(end);
+    }
+
+    for (size_t i = off; i < off + num_clusters; ++i)
+    {
+        clusters.set(i);
+    }
+
+    const uint32_t thresh = threshold ?
+        threshold :
+        auto_threshold_(csize,
+                        sco_mult);
+
+    if (clusters.count() >= thresh)
+    {
+        LOG_INFO(sco << ": " << clusters.count() <<
+                 " distinct clusters read partially within " << window <<
+                 ", threshold " << thresh << " - promoting to a full fetch");
+        map_.erase(it);
+        ++promotions_;
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+void
+PartialReadTracker::forget(const SCO sco)
+{
+    LOCK();
+    map_.erase(sco);
+}
+
+void
+PartialReadTracker::trim_(const Clock::time_point now,
+                          const bc::seconds window)
+{
+    for (auto it = map_.begin(); it != map_.end(); )
+    {
+        if (now - it->second.start > window)
+        {
+            it = map_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (map_.size() >= max_entries_)
+    {
+        auto victim = std::min_element(map_.begin(),
+                                       map_.end(),
+                                       [](const auto& a,
+                                          const auto& b)
+                                       {
+                                           return a.second.start < b.second.start;
+                                       });
+        map_.erase(victim);
+    }
+}
+
+void
+PartialReadTracker::backend_read(uint64_t bytes,
+                                 bc::microseconds duration)
+{
+    const double x = bytes;
+    const double y = duration.count();
+
+    LOCK();
+
+    sw_ = decay * sw_ + 1;
+    sx_ = decay * sx_ + x;
+    sy_ = decay * sy_ + y;
+    sxx_ = decay * sxx_ + x * x;
+    sxy_ = decay * sxy_ + x * y;
+    ++samples_;
+}
+
+boost::optional<PartialReadTracker::CostModel>
+PartialReadTracker::cost_model() const
+{
+    LOCK();
+    return cost_model_();
+}
+
+boost::optional<PartialReadTracker::CostModel>
+PartialReadTracker::cost_model_() const
+{
+    if (samples_ < min_samples)
+    {
+        return boost::none;
+    }
+
+    const double d = sw_ * sxx_ - sx_ * sx_;
+    // All samples (nearly) of the same size - latency and bandwidth cannot be
+    // told apart.
+    if (d <= 1e-6 * sw_ * sxx_)
+    {
+        return boost::none;
+    }
+
+    CostModel m;
+    m.usecs_per_byte = std::max(0.0,
+                                (sw_ * sxy_ - sx_ * sy_) / d);
+    m.latency_usecs = std::max(0.0,
+                               (sy_ - m.usecs_per_byte * sx_) / sw_);
+
+    return m;
+}
+
+uint32_t
+PartialReadTracker::auto_threshold(const ClusterSize csize,
+                                   const SCOMultiplier sco_mult) const
+{
+    LOCK();
+    return auto_threshold_(csize,
+                           sco_mult);
+}
+
+uint32_t
+PartialReadTracker::auto_threshold_(const ClusterSize csize,
+                                    const SCOMultiplier sco_mult) const
+{
+    const uint32_t lo = 2;
+    const uint32_t hi = std::max(lo,
+                                 static_cast<uint32_t>(sco_mult));
+
+    const boost::optional<CostModel> m(cost_model_());
+    if (not m)
+    {
+        return std::max(lo, hi / 8);
+    }
+
+    const double partial = m->latency_usecs + m->usecs_per_byte * csize;
+    if (partial <= 0)
+    {
+        return hi;
+    }
+
+    const double full = m->latency_usecs +
+        m->usecs_per_byte * csize * static_cast<uint32_t>(sco_mult);
+
+    const double k = std::ceil(full / partial);
+    return std::min<double>(hi,
+                            std::max<double>(lo, k));
+}
+
+size_t
+PartialReadTracker::size() const
+{
+    LOCK();
+    return map_.size();
+}
+
+uint64_t
+PartialReadTracker::promotions() const
+{
+    LOCK();
+    return promotions_;
+}
+
+}
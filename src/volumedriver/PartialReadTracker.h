@@ -0,0 +1,141 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef VD_PARTIAL_READ_TRACKER_H_
+#define VD_PARTIAL_READ_TRACKER_H_
+
+#include "SCO.h"
+#include "Types.h"
+
+#include <map>
+
+#include <boost/chrono.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <youtils/Logging.h>
+
+namespace volumedriver
+{
+
+// Per-volume bookkeeping of partial reads from the backend. It records which
+// clusters of a SCO were fetched with partial reads within a time window and
+// tells the caller when it is cheaper to fetch the whole SCO into the SCOCache
+// instead of paying yet more per-slice round trips.
+//
+// The promotion threshold (number of distinct clusters) is either fixed or
+// derived from a cost model t(bytes) = latency + bytes / bandwidth which is fitted
+// (exponentially decaying least squares) to the observed backend reads: a SCO
+// is promoted once the partial reads of it add up to the cost of a full fetch
+// ("ski rental"), so random readers keep doing partial reads while scans switch
+// over to full SCO fetches.
+class PartialReadTracker
+{
+public:
+    using Clock = boost::chrono::steady_clock;
+
+    explicit PartialReadTracker(size_t max_entries = 4096);
+
+    ~PartialReadTracker() = default;
+
+    PartialReadTracker(const PartialReadTracker&) = delete;
+
+    PartialReadTracker&
+    operator=(const PartialReadTracker&) = delete;
+
+    // Returns true if the SCO crossed the threshold and should be fetched
+    // entirely - it's then no longer tracked.
+    // threshold == 0: use the auto-tuned threshold.
+    bool
+    record(const SCO,
+           const SCOOffset off,
+           const size_t num_clusters,
+           const ClusterSize,
+           const SCOMultiplier,
+           const boost::chrono::seconds window,
+           const uint32_t threshold,
+           const Clock::time_point now = Clock::now());
+
+    void
+    forget(const SCO);
+
+    // Feed the cost model with the duration of a backend read of `bytes`.
+    void
+    backend_read(uint64_t bytes,
+                 boost::chrono::microseconds duration);
+
+    uint32_t
+    auto_threshold(const ClusterSize,
+                   const SCOMultiplier) const;
+
+    size_t
+    size() const;
+
+    uint64_t
+    promotions() const;
+
+    // Fitted model parameters, boost::none if there are not enough
+    // (or not enough diverse) samples yet.
+    struct CostModel
+    {
+        double latency_usecs;
+        double usecs_per_byte;
+    };
+
+    boost::optional<CostModel>
+    cost_model() const;
+
+private:
+    DECLARE_LOGGER("PartialReadTracker");
+
+    struct Entry
+    {
+        Clock::time_point start;
+        boost::dynamic_bitset<> clusters;
+    };
+
+    mutable boost::mutex lock_;
+    std::map<SCO, Entry> map_;
+    const size_t max_entries_;
+    uint64_t promotions_;
+
+    // exponentially decaying sums for the least squares fit
+    double sw_;
+    double sx_;
+    double sy_;
+    double sxx_;
+    double sxy_;
+    uint64_t samples_;
+
+    boost::optional<CostModel>
+    cost_model_() const;
+
+    uint32_t
+    auto_threshold_(const ClusterSize,
+                    const SCOMultiplier) const;
+
+    void
+    trim_(const Clock::time_point now,
+          const boost::chrono::seconds window);
+};
+
+}
+
+#endif // !VD_PARTIAL_READ_TRACKER_H_
+
+// Local Variables: **
+// mode: c++ **
+// End: **
@@ -13,17 +13,37 @@
 // Open vStorage is distributed in the hope that it will be useful,
 // but WITHOUT ANY WARRANTY of any kind.
 
+#include "DataStoreNG.h"
 #include "PrefetchData.h"
 #include "VolManager.h"
 #include "SCOCache.h"
 #include "SCOFetcher.h"
 
+#include <youtils/ScopeExit.h>
+
 namespace volumedriver
 {
 
+namespace bc = boost::chrono;
+namespace yt = youtils;
+
+namespace
+{
+
+// number of cluster reads the hit rate is evaluated over
+const uint64_t hit_rate_window = 1024;
+
+}
+
 PrefetchData::PrefetchData()
     :VolumeBackPointer(getLogger__()),
-     stop_(false)
+     stop_(false),
+     inflight_(0),
+     budget_(0),
+     budget_stamp_(Clock::now()),
+     hits_base_(0),
+     misses_base_(0),
+     cancellations_(0)
 {};
 
 void
@@ -39,21 +59,41 @@ PrefetchData::addSCO(SCO a,
     boost::lock_guard<boost::mutex> g(mut);
     if (not stop_)
     {
+        if (scos.empty() and inflight_ == 0)
+        {
+            // a new round of prefetching - only reads from now on tell
+            // whether it's (still) needed
+            reset_hit_rate_window_();
+        }
+
         scos.push(std::make_pair(a, val));
         cond.notify_one();
     }
 }
 
 void
-PrefetchData::stop()
+PrefetchData::clear_()
 {
-    boost::lock_guard<boost::mutex> g(mut);
-    stop_ = true;
     while(not scos.empty())
     {
         scos.pop();
     }
-    cond.notify_one();
+}
+
+void
+PrefetchData::stop()
+{
+    boost::lock_guard<boost::mutex> g(mut);
+    stop_ = true;
+    clear_();
+    cond.notify_all();
+}
+
+uint64_t
+PrefetchData::cancellations() const
+{
+    boost::lock_guard<boost::mutex> g(mut);
+    return cancellations_;
 }
 
 void
@@ -70,79 +110,156 @@ PrefetchData::operator()()
         });
 }
 
+void
+PrefetchData::reset_hit_rate_window_()
+{
+    DataStoreNG* ds = getVolume()->getDataStore();
+    hits_base_ = ds->getCacheHits();
+    misses_base_ = ds->getCacheMisses();
+}
+
+bool
+PrefetchData::working_set_resident_()
+{
+    const uint32_t pct = VolManager::get()->prefetch_cancel_hit_rate_percent.value();
+    if (pct == 0)
+    {
+        return false;
+    }
+
+    DataStoreNG* ds = getVolume()->getDataStore();
+    const uint64_t hits = ds->getCacheHits() - hits_base_;
+    const uint64_t misses = ds->getCacheMisses() - misses_base_;
+
+    if (hits + misses < hit_rate_window)
+    {
+        return false;
+    }
+
+    reset_hit_rate_window_();
+
+    if (hits * 100 >= pct * (hits + misses))
+    {
+        LOG_INFO(getVolume()->getNamespace() << ": " << hits << " out of " <<
+                 (hits + misses) << " reads were cache hits, working set is resident - dropping " <<
+                 scos.size() << " SCOs from the prefetch queue");
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+bool
+PrefetchData::throttle_(boost::unique_lock<boost::mutex>& u,
+                        uint64_t bytes)
+{
+    while (not stop_)
+    {
+        const double rate =
+            static_cast<uint64_t>(VolManager::get()->prefetch_max_mib_per_sec.value()) << 20;
+        if (rate == 0)
+        {
+            return true;
+        }
+
+        // allow bursts of up to a second's worth (or one SCO)
+        const Clock::time_point now = Clock::now();
+        const double burst = std::max<double>(rate,
+                                              bytes);
+        budget_ = std::min(burst,
+                           budget_ + rate * bc::duration<double>(now - budget_stamp_).count());
+        budget_stamp_ = now;
+
+        if (budget_ >= 0)
+        {
+            budget_ -= bytes;
+            return true;
+        }
+
+        const bc::duration<double> wait(-budget_ / rate);
+        cond.wait_for(u,
+                      bc::duration_cast<bc::microseconds>(wait) + bc::microseconds(1));
+    }
+
+    return false;
+}
+
 void
 PrefetchData::run_()
 {
     LOG_INFO("Starting prefetch thread");
     while(true)
     {
-
-        if(not scos.empty())
+        SCO sconame;
+        float val;
         {
+            boost::unique_lock<boost::mutex> u(mut);
+            while (not stop_ and scos.empty())
+            {
+                cond.wait(u);
+            }
 
-            SCO sconame;
-            float val;
+            if (stop_)
             {
-                boost::lock_guard<boost::mutex> g(mut);
-                if(scos.empty())
-                {
-                    continue;
-                }
-                sconame = scos.top().first;
-                val = scos.top().second;
-                scos.pop();
+                break;
             }
 
-            //Volume* vol = getVolume();
-
-            LOG_INFO("Prefetching sco " << getVolume()->getNamespace() << "/" <<
-                     sconame << " with sap " << val);
-
-            ClusterLocation loc(sconame, 0);
-            BackendInterfacePtr bi = getVolume()->getBackendInterface(loc.cloneID())->clone();
-            BackendSCOFetcher fetcher(sconame,
-                                      getVolume(),
-                                      bi->clone(),
-                                      false); // Don't signal an error if we can't get a sco
-            const VolumeConfig cfg(getVolume()->get_config());
-            const uint64_t scoSize = cfg.getSCOSize();
-            bool res =
-                VolManager::get()->getSCOCache()->prefetchSCO(getVolume()->getNamespace(),
-                                                              sconame,
-                                                              scoSize,
-                                                              val,
-                                                              fetcher);
-
-            LOG_INFO("Prefetching sco " << getVolume()->getNamespace() << "/"
-                     << sconame << " done, " <<
-                     (res ? "continuing" : "stopping") << " prefetching");
-
-            if(not res)
+            if (working_set_resident_())
             {
-                boost::lock_guard<boost::mutex> g(mut);
-                while(not scos.empty())
-                {
-                    scos.pop();
-                }
+                ++cancellations_;
+                clear_();
+                continue;
             }
+
+            sconame = scos.top().first;
+            val = scos.top().second;
+            scos.pop();
+            ++inflight_;
         }
-        else if(not stop_)
+
+        auto on_exit(yt::make_scope_exit([&]
+                                         {
+                                             boost::lock_guard<boost::mutex> g(mut);
+                                             --inflight_;
+                                         }));
+
+        const VolumeConfig cfg(getVolume()->get_config());
+        const uint64_t scoSize = cfg.getSCOSize();
+
         {
-            boost::unique_lock<boost::mutex> lock(mut);
-            if(not stop_)
-            {
-                LOG_INFO("I'm waiting for the man");
-                cond.wait(lock);
-                LOG_INFO("Woke up too early, 't was a terrible mistake");
-            }
-            else
+            boost::unique_lock<boost::mutex> u(mut);
+            if (not throttle_(u, scoSize))
             {
                 break;
             }
         }
-        else
+
+        LOG_INFO("Prefetching sco " << getVolume()->getNamespace() << "/" <<
+                 sconame << " with sap " << val);
+
+        ClusterLocation loc(sconame, 0);
+        BackendInterfacePtr bi = getVolume()->getBackendInterface(loc.cloneID())->clone();
+        BackendSCOFetcher fetcher(sconame,
+                                  getVolume(),
+                                  bi->clone(),
+                                  false); // Don't signal an error if we can't get a sco
+        bool res =
+            VolManager::get()->getSCOCache()->prefetchSCO(getVolume()->getNamespace(),
+                                                          sconame,
+                                                          scoSize,
+                                                          val,
+                                                          fetcher);
+
+        LOG_INFO("Prefetching sco " << getVolume()->getNamespace() << "/"
+                 << sconame << " done, " <<
+                 (res ? "continuing" : "stopping") << " prefetching");
+
+        if(not res)
         {
-            break;
+            boost::lock_guard<boost::mutex> g(mut);
+            clear_();
         }
     }
     LOG_INFO("Stopping prefetch thread ");
@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <string>
+#include <boost/chrono.hpp>
 #include <boost/thread.hpp>
 #include "Types.h"
 #include "NSIDMap.h"
@@ -44,6 +45,13 @@ public:
 
 };
 
+// Fetches SCOs into the SCOCache in the background, most valuable SCOs first.
+// All SCOs of a volume have the same size so the SCO access probability also
+// is the expected hit value per fetched byte.
+// Several threads (prefetch_threads) can run operator() concurrently. Fetches
+// are throttled to prefetch_max_mib_per_sec and the queue is dropped once the
+// volume's cache hit rate reaches prefetch_cancel_hit_rate_percent, i.e. the
+// working set is resident.
 class PrefetchData : public VolumeBackPointer
 {
     friend class VolManagerTestSetup;
@@ -70,13 +78,44 @@ public:
     void
     operator()();
 
+    // Number of times the remaining queue was dropped because of the
+    // hit rate.
+    uint64_t
+    cancellations() const;
+
 private:
+    using Clock = boost::chrono::steady_clock;
+
     void run_();
+
+    // Waits until the bandwidth budget allows fetching `bytes`. Returns false
+    // if stopped in the meantime.
+    bool
+    throttle_(boost::unique_lock<boost::mutex>&,
+              uint64_t bytes);
+
+    bool
+    working_set_resident_();
+
+    void
+    reset_hit_rate_window_();
+
+    void
+    clear_();
+
     bool stop_;
     SCOQueue scos;
-    boost::mutex mut;
+    unsigned inflight_;
+    mutable boost::mutex mut;
     boost::condition_variable cond;
 
+    // token bucket, in bytes - may go negative
+    double budget_;
+    Clock::time_point budget_stamp_;
+
+    uint64_t hits_base_;
+    uint64_t misses_base_;
+    uint64_t cancellations_;
 };
 
 
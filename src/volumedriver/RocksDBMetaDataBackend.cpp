@@ -22,6 +22,9 @@
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
 #include <rocksdb/status.h>
+#include <rocksdb/write_batch.h>
+
+#include <boost/lexical_cast.hpp>
 
 #include <youtils/RocksLogger.h>
 
@@ -48,6 +51,9 @@ RocksDBMetaDataBackend::used_clusters_key_ = std::numeric_limits<uint64_t>::max(
 const uint64_t
 RocksDBMetaDataBackend::scrub_id_key_ = std::numeric_limits<uint64_t>::max() - 2;
 
+const uint64_t
+RocksDBMetaDataBackend::page_format_key_ = std::numeric_limits<uint64_t>::max() - 3;
+
 const std::string
 RocksDBMetaDataBackend::db_name = "mdstore.rocksdb";
 
@@ -297,6 +303,53 @@ RocksDBMetaDataBackend::discardPage(const CachePage& p,
                                sizeof(used_clusters))));
 }
 
+void
+RocksDBMetaDataBackend::putPages(PageUpdates& updates)
+{
+    LOG_TRACE(updates.size() << " pages");
+
+    int64_t used_clusters = used_clusters_;
+    // copies keys and values
+    rdb::WriteBatch batch;
+
+    for (const auto& u : updates)
+    {
+        const PageAddress pa = u.page->page_address();
+        check_page_address_(pa);
+
+        used_clusters += u.used_clusters_delta;
+
+        const rdb::Slice key(reinterpret_cast<const char*>(&pa),
+                             sizeof(pa));
+
+        if (u.discard)
+        {
+            batch.Delete(key);
+        }
+        else
+        {
+            batch.Put(key,
+                      rdb::Slice(reinterpret_cast<const char*>(u.page->data()),
+                                 u.page->size()));
+        }
+    }
+
+    ASSERT(used_clusters >= 0);
+
+    batch.Put(rdb::Slice(reinterpret_cast<const char*>(&used_clusters_key_),
+                         sizeof(used_clusters_key_)),
+              rdb::Slice(reinterpret_cast<const char*>(&used_clusters),
+                         sizeof(used_clusters)));
+
+    HANDLE(db_->Write(make_write_options(),
+                      &batch));
+
+    for (auto& u : updates)
+    {
+        u.done = true;
+    }
+}
+
 void
 RocksDBMetaDataBackend::sync()
 {
@@ -436,6 +489,47 @@ RocksDBMetaDataBackend::set_scrub_id(const ScrubId& scrub_id)
                     rdb::Slice(static_cast<const yt::UUID&>(scrub_id).str())));
 }
 
+boost::optional<PageFormat>
+RocksDBMetaDataBackend::page_format()
+{
+    std::string res;
+    const rdb::Status status(db_->Get(make_read_options(),
+                                      rdb::Slice(reinterpret_cast<const char*>(&page_format_key_),
+                                                 sizeof(page_format_key_)),
+                                      &res));
+
+    switch (status.code())
+    {
+    case rdb::Status::kOk:
+        {
+            LOG_TRACE("page format: " << res);
+            return boost::lexical_cast<PageFormat>(res);
+        }
+    case rdb::Status::kNotFound:
+        {
+            LOG_TRACE("no page format");
+            return PageFormat::Wide;
+        }
+    default:
+        {
+            HANDLE(status);
+        }
+    }
+
+    UNREACHABLE;
+}
+
+void
+RocksDBMetaDataBackend::set_page_format(PageFormat format)
+{
+    LOG_INFO("Setting page format " << format);
+
+    HANDLE(db_->Put(make_write_options(),
+                    rdb::Slice(reinterpret_cast<const char*>(&page_format_key_),
+                               sizeof(page_format_key_)),
+                    rdb::Slice(boost::lexical_cast<std::string>(format))));
+}
+
 uint64_t
 RocksDBMetaDataBackend::locally_required_bytes_(const VolumeConfig& cfg)
 {
@@ -537,7 +631,8 @@ RocksDBMetaDataBackend::check_page_address_(const PageAddress pa)
 {
     if (pa == cork_key_ or
         pa == used_clusters_key_ or
-        pa == scrub_id_key_)
+        pa == scrub_id_key_ or
+        pa == page_format_key_)
     {
         LOG_ERROR("Page address " << pa << " conflicts with internal key");
         throw MetaDataStoreBackendException("Page address conflicts with internal key");
@@ -53,6 +53,10 @@ public:
     discardPage(const CachePage& p,
                 int32_t used_clusters_delta) override final;
 
+    // One WriteBatch for all of them.
+    void
+    putPages(PageUpdates&) override final;
+
     bool
     pageExistsInParent(const PageAddress) const override final
     {
@@ -114,6 +118,12 @@ public:
     virtual void
     set_scrub_id(const ScrubId& id) override final;
 
+    virtual boost::optional<PageFormat>
+    page_format() override final;
+
+    virtual void
+    set_page_format(PageFormat) override final;
+
     void
     set_delete_local_artefacts_on_destroy() noexcept
     {
@@ -139,6 +149,7 @@ private:
     static const uint64_t cork_key_;
     static const uint64_t used_clusters_key_;
     static const uint64_t scrub_id_key_;
+    static const uint64_t page_format_key_;
 
     std::unique_ptr<rocksdb::DB> db_;
     uint64_t used_clusters_;
@@ -172,7 +172,8 @@ SCOAccessDataPersistor::pull(bool must_exist)
 }
 
 void
-SCOAccessDataPersistor::push(const SCOAccessData& sad)
+SCOAccessDataPersistor::push(const SCOAccessData& sad,
+                             const backend::BackendRequestParameters& params)
 {
     VERIFY(sad.getNamespace() == bi_->getNS());
 
@@ -187,7 +188,9 @@ SCOAccessDataPersistor::push(const SCOAccessData& sad)
 
     bi_->write(p.string(),
                backend_name,
-               OverwriteObject::T);
+               OverwriteObject::T,
+               nullptr,
+               params);
 }
 
 }
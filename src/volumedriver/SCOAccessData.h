@@ -145,7 +145,9 @@ public:
     pull(bool must_exist = false);
 
     void
-    push(const SCOAccessData&);
+    push(const SCOAccessData&,
+         const backend::BackendRequestParameters& =
+         backend::BackendInterface::default_request_parameters());
 
     static SCOAccessDataPtr
     deserialize(const fs::path& p);
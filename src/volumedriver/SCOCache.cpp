@@ -24,6 +24,7 @@
 #include <fstream>
 #include <set>
 #include <limits>
+#include <queue>
 #include <boost/scope_exit.hpp>
 
 #include <boost/thread/lock_guard.hpp>
@@ -53,7 +54,7 @@
     rwLock_.assertLocked()
 
 #define ASSERT_SPINLOCKED()                     \
-    xvalSpinLock_.assertLocked()
+    xValSpinLock_.assertLocked()
 
 #define ASSERT_CLEANUP_LOCKED()                 \
     assert(cleanupLock_.try_lock() == false)
@@ -81,9 +82,12 @@ namespace volumedriver
 {
 
 namespace fs = boost::filesystem;
-namespace bi = boost::intrusive;
 using namespace initialized_params;
 
+const size_t SCOCache::cleanup_batch_size_ = 64;
+const size_t SCOCache::trim_batch_size_ = 256;
+const double SCOCache::max_xval_sum_ = 1e20;
+
 SCOCache::SCOCache(const boost::property_tree::ptree& pt)
     : VolumeDriverComponent(RegisterComponent::T,
                             pt)
@@ -94,6 +98,8 @@ SCOCache::SCOCache(const boost::property_tree::ptree& pt)
     , currentMountPoint_(mountPoints_.end())
     , cachedXValMin_(0)
     , initialXVal_(1.0)
+    , xValSum_(0)
+    , xValScale_(1.0)
     , mpErrorCount_(0)
     , trigger_gap(pt)
     , backoff_gap(pt)
@@ -329,6 +335,12 @@ SCOCache::destroy_()
     ASSERT_CLEANUP_LOCKED();
     ASSERT_RWLOCKED();
 
+    {
+        LOCK_XVALS();
+        candidates_.clear();
+        parked_.clear();
+    }
+
     LOG_DEBUG("Clearing the mountpoints");
 
     mountPoints_.clear();
@@ -345,36 +357,41 @@ SCOCache::initXVals_(SCOCacheNamespace* ns, const SCOAccessData& sad)
 {
     ASSERT_RWLOCKED();
 
-    // 1. feed sco access data to the SCOs - the ones found are unblocked.
-    const SCOAccessData::VectorType& sadv = sad.getVector();
-    for (SCOAccessData::VectorType::const_iterator sadIt = sadv.begin();
-         sadIt != sadv.end();
-         ++sadIt)
+    // Z42: this used to use the avg (sum / count)
+    const float xValAvg = getInitialXVal_();
+
     {
-        SCOCacheNamespaceEntry* e = ns->findEntry(sadIt->first);
-        if (e != nullptr)
+        LOCK_XVALS();
+
+        // 1. feed sco access data to the SCOs - the ones found are unblocked.
+        const SCOAccessData::VectorType& sadv = sad.getVector();
+        for (SCOAccessData::VectorType::const_iterator sadIt = sadv.begin();
+             sadIt != sadv.end();
+             ++sadIt)
         {
-            float xval = sadIt->second;
-            CachedSCOPtr sco = e->getSCO();
-            sco->setXVal(xval);
-            e->setBlocked(false);
+            SCOCacheNamespaceEntry* e = ns->findEntry(sadIt->first);
+            if (e != nullptr)
+            {
+                float xval = sadIt->second;
+                CachedSCOPtr sco = e->getSCO();
+                setXVal_(*sco, toRawXVal_(xval));
+                unblockSCO_(*e);
+            }
         }
-    }
-
-    // 2. now deal with the SCOs that are still left blocked
-    // Z42: this used to use the avg (sum / count)
 
-    float xValAvg = getInitialXVal_();
+        // 2. now deal with the SCOs that are still left blocked
+        const float rawXValAvg = toRawXVal_(xValAvg);
 
-    for (SCOCacheNamespace::value_type& t: *ns)
-    {
-        SCOCacheNamespaceEntry& e = t.second;
-        CachedSCOPtr sco = e.getSCO();
-
-        if (e.isBlocked())
+        for (SCOCacheNamespace::value_type& t: *ns)
         {
-            sco->setXVal(xValAvg);
-            e.setBlocked(false);
+            SCOCacheNamespaceEntry& e = t.second;
+            CachedSCOPtr sco = e.getSCO();
+
+            if (e.isBlocked())
+            {
+                setXVal_(*sco, rawXValAvg);
+                unblockSCO_(e);
+            }
         }
     }
 
@@ -400,6 +417,8 @@ SCOCache::insertSCO_(CachedSCOPtr sco,
     // }
 
     VERIFY(res.second == true);
+
+    accountSCO_(ns, *sco, true);
 }
 
 void
@@ -409,7 +428,10 @@ SCOCache::removeSCO_(CachedSCOPtr sco,
     ASSERT_RWLOCKED();
 
     SCOCacheNamespace* ns = findNamespace_throw_(sco->getNamespace()->getName());
-    ns->erase(sco->getSCO());
+    if (ns->erase(sco->getSCO()) != 0)
+    {
+        accountSCO_(ns, *sco, false);
+    }
 
     if (unlink)
     {
@@ -462,6 +484,154 @@ SCOCache::findAndRemoveSCO_(const backend::Namespace& nsname,
     removeSCO_(sco, unlink);
 }
 
+void
+SCOCache::accountSCO_(SCOCacheNamespace* ns,
+                      CachedSCO& sco,
+                      bool add)
+{
+    const int64_t size = add ?
+        sco.getSize() :
+        -static_cast<int64_t>(sco.getSize());
+
+    ns->updateSizes(size,
+                    sco.isDisposable() ? size : 0);
+
+    LOCK_XVALS();
+
+    if (add)
+    {
+        VERIFY(not sco.xValAccounted_);
+        xValSum_ += sco.getXVal();
+        sco.xValAccounted_ = true;
+    }
+    else if (sco.xValAccounted_)
+    {
+        xValSum_ -= sco.getXVal();
+        sco.xValAccounted_ = false;
+    }
+
+    if (sco.isDisposable())
+    {
+        if (add)
+        {
+            linkCandidate_(sco);
+        }
+        else
+        {
+            unlinkCandidate_(sco);
+        }
+    }
+}
+
+void
+SCOCache::linkCandidate_(CachedSCO& sco)
+{
+    ASSERT_SPINLOCKED();
+
+    if (not sco.candidate_hook_.is_linked())
+    {
+        // blocked ones are linked by unblockSCO_
+        const SCOCacheNamespaceEntry* e =
+            sco.getNamespace()->findEntry(sco.getSCO());
+        if (e != nullptr and not e->isBlocked())
+        {
+            if (sco.parked_hook_.is_linked())
+            {
+                sco.parked_hook_.unlink();
+            }
+
+            candidates_[sco.mntPoint_.get()][sco.getNamespace()].insert(sco);
+        }
+    }
+}
+
+void
+SCOCache::unlinkCandidate_(CachedSCO& sco)
+{
+    ASSERT_SPINLOCKED();
+
+    if (sco.candidate_hook_.is_linked())
+    {
+        sco.candidate_hook_.unlink();
+    }
+
+    if (sco.parked_hook_.is_linked())
+    {
+        sco.parked_hook_.unlink();
+    }
+}
+
+void
+SCOCache::unblockSCO_(SCOCacheNamespaceEntry& e)
+{
+    ASSERT_SPINLOCKED();
+
+    e.setBlocked(false);
+
+    CachedSCO& sco = *e.getSCO();
+    if (sco.isDisposable())
+    {
+        linkCandidate_(sco);
+    }
+}
+
+// Parked SCOs that were released in the mean time are candidates again.
+void
+SCOCache::unparkCandidates_()
+{
+    ASSERT_SPINLOCKED();
+
+    ParkedList::iterator it = parked_.begin();
+    while (it != parked_.end())
+    {
+        CachedSCO& sco = *it;
+        if (sco.use_count() == 1)
+        {
+            it = parked_.erase(it);
+            linkCandidate_(sco);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void
+SCOCache::eraseNamespaceCandidates_(const SCOCacheNamespace* ns)
+{
+    ASSERT_SPINLOCKED();
+
+    for (CandidateMap::value_type& c : candidates_)
+    {
+        c.second.erase(ns);
+    }
+}
+
+// candidates are ordered by xval, so they need to be repositioned
+void
+SCOCache::setXVal_(CachedSCO& sco,
+                   float xval)
+{
+    ASSERT_SPINLOCKED();
+
+    if (sco.xValAccounted_)
+    {
+        xValSum_ += static_cast<double>(xval) - sco.getXVal();
+    }
+
+    if (sco.candidate_hook_.is_linked())
+    {
+        sco.candidate_hook_.unlink();
+        sco.setXVal(xval);
+        candidates_[sco.mntPoint_.get()][sco.getNamespace()].insert(sco);
+    }
+    else
+    {
+        sco.setXVal(xval);
+    }
+}
+
 void
 SCOCache::insertScannedSCO(CachedSCOPtr sco)
 {
@@ -551,50 +721,104 @@ SCOCache::signalSCOAccessed(CachedSCOPtr sco, uint32_t num)
     //TODO probably make non-blocking as rescale or fill-in scoaccess data could be busy along
     LOCK_XVALS();
     //every cleanup it is made sure sum == 1, so multiplication with sum is implicit
-    float newxv = sco->getXVal() + num * discount_factor.value();
-    sco->setXVal(newxv);
+    float newxv = sco->getXVal() + num * discount_factor.value() / xValScale_;
+    setXVal_(*sco, newxv);
 }
 
+float
+SCOCache::toRawXVal_(float xval) const
+{
+    ASSERT_SPINLOCKED();
+    return xval / xValScale_;
+}
+
+// Normalizing only adjusts the scale, the raw values (and hence the order of
+// the eviction candidates) stay as they are. The minimum is taken from the
+// coldest eviction candidates.
 void
 SCOCache::rescaleXVals_()
 {
     // RWLock required (at least R)
     ASSERT_RWLOCKED();
     LOG_DEBUG("rescaling xvals");
+
+    const int scoNum = scoCount_();
+
     LOCK_XVALS();
 
-    float xValSum = 0.0;
+    if (scoNum > 0 and
+        (xValSum_ <= 0 or xValSum_ > max_xval_sum_))
+    {
+        renormalizeXVals_();
+    }
+
+    xValScale_ = xValSum_ > 0 ?
+        1.0 / xValSum_ :
+        1.0;
+
+    float min = std::numeric_limits<float>::max();
+
+    for (const CandidateMap::value_type& c : candidates_)
+    {
+        for (const NSCandidateMap::value_type& p : c.second)
+        {
+            if (not p.second.empty())
+            {
+                min = std::min<float>(min,
+                                      p.second.begin()->getXVal() * xValScale_);
+            }
+        }
+    }
+
+    VERIFY(min >= 0.0);
+    cachedXValMin_ = min != std::numeric_limits<float>::max() ? min : 0;
+    initialXVal_ = scoNum > 0 ? 1.0 / scoNum : 1.0;
+}
+
+// The expensive variant that rewrites all raw values (and recalculates their
+// sum from scratch), only needed every now and then. Scaling all of them by
+// the same factor keeps the order of the eviction candidates intact.
+void
+SCOCache::renormalizeXVals_()
+{
+    ASSERT_RWLOCKED();
+    ASSERT_SPINLOCKED();
+
+    LOG_INFO("renormalizing xvals, sum of raw values: " << xValSum_);
+
+    double xValSum = 0.0;
+    int scoNum = 0;
+
     for (NSMap::value_type& p: nsMap_)
     {
         for (SCOCacheNamespace::value_type& q: *(p.second))
         {
             xValSum += q.second.getSCO()->getXVal();
+            ++scoNum;
         }
     }
 
     VERIFY(xValSum >= 0.0);
 
-    float min = std::numeric_limits<float>::max();
-    int scoNum = scoCount_();
+    xValSum_ = 0.0;
 
     for (NSMap::value_type& p: nsMap_)
     {
-        SCOCacheNamespace* ns = p.second;
-        for (SCOCacheNamespace::value_type& q: *ns)
+        for (SCOCacheNamespace::value_type& q: *(p.second))
         {
-            SCOCacheNamespaceEntry& e = q.second;
-            CachedSCOPtr sco = e.getSCO();
-            float newVal = xValSum > 0 ?
+            CachedSCOPtr sco = q.second.getSCO();
+            const float newVal = xValSum > 0 ?
                 sco->getXVal() / xValSum :
                 1.0 / scoNum;
-            min = std::min<float>(min, newVal);
             sco->setXVal(newVal);
+            if (sco->xValAccounted_)
+            {
+                xValSum_ += newVal;
+            }
         }
     }
 
-    VERIFY(min >= 0.0);
-    cachedXValMin_ = scoNum ? min : 0;
-    initialXVal_ = scoNum > 0 ? 1.0 / scoNum : 1.0;
+    xValScale_ = 1.0;
 }
 
 float
@@ -620,7 +844,7 @@ SCOCache::fillSCOAccessData(SCOAccessData& sad)
         SCOCacheNamespaceEntry& e = t.second;
         CachedSCOPtr sco = e.getSCO();
         sad.addData(sco->getSCO(),
-                    sco->getXVal());
+                    sco->getXVal() * xValScale_);
     }
 }
 
@@ -824,6 +1048,11 @@ SCOCache::removeNamespace(const backend::Namespace& nsname)
     // throw instead?
     VERIFY(ns->empty());
 
+    {
+        LOCK_XVALS();
+        eraseNamespaceCandidates_(ns);
+    }
+
     delete ns;
     nsMap_.erase(nsname);
 
@@ -914,6 +1143,24 @@ SCOCache::disableNamespace_(SCOCacheNamespace* ns)
     ASSERT_RWLOCKED();
 
     nsMap_.erase(ns->getName());
+
+    {
+        LOCK_XVALS();
+        for (SCOCacheNamespace::value_type& t: *ns)
+        {
+            CachedSCO& sco = *t.second.getSCO();
+            unlinkCandidate_(sco);
+
+            if (sco.xValAccounted_)
+            {
+                xValSum_ -= sco.getXVal();
+                sco.xValAccounted_ = false;
+            }
+        }
+
+        eraseNamespaceCandidates_(ns);
+    }
+
     ns->clear();
     delete ns;
 }
@@ -1028,11 +1275,18 @@ SCOCache::createSCO_(const backend::Namespace& nsname,
     }
 
     SCOCacheMountPointPtr mp = getWriteMountPoint_(scoSize);
+
+    float rawXVal;
+    {
+        LOCK_XVALS();
+        rawXVal = toRawXVal_(xval);
+    }
+
     CachedSCOPtr sco = new CachedSCO(ns,
                                      scoName,
                                      mp,
                                      scoSize,
-                                     xval);
+                                     rawXVal);
 
     // we can do better by re-using the SCOCacheNamespace we looked up
     // above
@@ -1208,7 +1462,7 @@ SCOCache::getSCO_(const backend::Namespace& nsname,
     {
         try
         {
-            sco->setDisposable();
+            setSCODisposable_(sco);
         }
         catch (std::exception& e)
         {
@@ -1222,7 +1476,8 @@ SCOCache::getSCO_(const backend::Namespace& nsname,
     try
     {
         SCOCacheNamespaceEntry* e = sco->getNamespace()->findEntry_throw(sco->getSCO());
-        e->setBlocked(false);
+        LOCK_XVALS();
+        unblockSCO_(*e);
     }
     CATCH_STD_ALL_LOG_RETHROW("Problem with mountpoint when getting SCO " <<
                               scoName << " From the FOC");
@@ -1324,7 +1579,32 @@ void
 SCOCache::setSCODisposable(CachedSCOPtr sco)
 {
     RLOCK_CACHE();
+    setSCODisposable_(sco);
+}
+
+void
+SCOCache::setSCODisposable_(CachedSCOPtr sco)
+{
+    ASSERT_RWLOCKED();
+
+    const bool was_disposable = sco->isDisposable();
+    const uint64_t old_size = sco->getSize();
+
     sco->setDisposable();
+
+    // the SCO might have been dropped from the cache in the mean time
+    // (I/O error on the mountpoint), don't account for it then.
+    SCOCacheNamespace* ns = sco->getNamespace();
+    SCOCacheNamespaceEntry* e = ns->findEntry(sco->getSCO());
+    if (e != nullptr and e->getSCO() == sco)
+    {
+        const int64_t size = sco->getSize();
+        ns->updateSizes(size - old_size,
+                        was_disposable ? size - old_size : size);
+
+        LOCK_XVALS();
+        linkCandidate_(*sco);
+    }
 }
 
 bool
@@ -1434,6 +1714,7 @@ SCOCache::offlineMountPoint_(SCOCacheMountPointPtr mp)
             {
                 SCOCacheNamespace::iterator tmp = it;
                 ++it;
+                accountSCO_(ns, *tmp->second.getSCO(), false);
                 ns->erase(tmp);
             }
             else
@@ -1443,6 +1724,11 @@ SCOCache::offlineMountPoint_(SCOCacheMountPointPtr mp)
         }
     }
 
+    {
+        LOCK_XVALS();
+        candidates_.erase(mp.get());
+    }
+
     currentMountPoint_ = mountPoints_.begin();
     bumpMountPointErrorCount_();
 }
@@ -1455,18 +1741,10 @@ SCOCache::maybeChokeNamespaces_()
     for (NSMap::value_type& t: nsMap_)
     {
         SCOCacheNamespace* ns = t.second;
-        uint64_t nondisposable = 0;
 
         // doesn't reuse getNamespaceInfo as that looks at the real SCO size
-        for (SCOCacheNamespace::value_type& u: *ns)
-        {
-            SCOCacheNamespaceEntry& e = u.second;
-            CachedSCOPtr sco = e.getSCO();
-            if (not sco->isDisposable())
-            {
-                nondisposable += sco->getSize();
-            }
-        }
+        const uint64_t nondisposable =
+            ns->getSize() - ns->getDisposableSize();
 
         bool choke = nondisposable > ns->getMaxNonDisposableSize();
 
@@ -1577,7 +1855,12 @@ SCOCache::cleanup()
         {
             LOG_PERIODIC("no cleanup required");
         }
+    }
 
+    {
+        // rescaling preserves the order of the xvals and hence doesn't need
+        // to touch the eviction candidates - a stable set of SCOs is enough.
+        RLOCK_CACHE();
         rescaleXVals_();
     }
 
@@ -1596,13 +1879,21 @@ SCOCache::doCleanup_(SCOSet& to_delete,
 {
     ASSERT_CLEANUP_LOCKED();
 
-    SCOSet::iterator it = to_delete.begin();
-
-    while (it != to_delete.end())
+    // The SCO files are handed to the mountpoint's DeferredFileRemover and
+    // unlinked off the lock, so the write lock is only needed to drop the
+    // SCOs from the cache - do that in batches instead of grabbing it once
+    // per SCO.
+    while (not to_delete.empty())
     {
         WLOCK_CACHE();
-        eraseSCOSetIterator_(to_delete, it, remove_non_disposable);
-        it = to_delete.begin();
+
+        for (size_t i = 0;
+             i < cleanup_batch_size_ and not to_delete.empty();
+             ++i)
+        {
+            SCOSet::iterator it = to_delete.begin();
+            eraseSCOSetIterator_(to_delete, it, remove_non_disposable);
+        }
     }
 }
 
@@ -1612,51 +1903,40 @@ SCOCache::prepareCleanup_(SCOSet& to_delete)
     ASSERT_CLEANUP_LOCKED();
     ASSERT_RWLOCKED();
 
-    // trim namespaces:
-    NSSCOSets nsSCOSets;
+    // enforce min sizes: only the disposable SCOs exceeding a namespace's
+    // min size may go, the ones with the highest access probabilities are
+    // preserved as victims are picked in order of increasing xval.
+    NSBudgets budgets;
 
     for (NSMap::value_type& p: nsMap_)
     {
         SCOCacheNamespace* ns = p.second;
 
-        SCOSet* scoSet = new SCOSet();
+        const uint64_t min = ns->getMinSize();
+        const uint64_t disposableSize = ns->getDisposableSize();
+        const uint64_t nonDisposableSize = ns->getSize() - disposableSize;
 
-        std::pair<NSSCOSets::iterator, bool> res =
-            nsSCOSets.insert(std::make_pair(ns, scoSet));
-        VERIFY(res.second);
+        const uint64_t preserve = (nonDisposableSize >= min) ?
+            0 :
+            min - nonDisposableSize;
 
-        uint64_t totalSize = 0;
-        uint64_t disposableSize = 0;
-        for (SCOCacheNamespace::value_type& q: *ns)
-        {
-            SCOCacheNamespaceEntry& e = q.second;
-            CachedSCOPtr sco = e.getSCO();
-
-            // usecount: sco, entry in SCOCacheNamespace in nsMap_
-            VERIFY(sco->use_count() >= 2);
-
-            // e.isBlocked is actually currently redundant - the use count
-            // should not allow these to enter. But lets explicitly test it just in
-            // case that changes at some point
-            if (sco->isDisposable() && sco->use_count() == 2 && !e.isBlocked())
-            {
-                scoSet->insert(*sco);
-                disposableSize += sco->getSize();
-            }
-
-            totalSize += sco->getSize();
-        }
+        std::pair<NSBudgets::iterator, bool> res =
+            budgets.insert(std::make_pair(ns,
+                                          disposableSize > preserve ?
+                                          disposableSize - preserve :
+                                          0));
+        VERIFY(res.second);
+    }
 
-        ensureNamespaceMin_(ns, *scoSet, totalSize, disposableSize);
+    {
+        LOCK_XVALS();
+        unparkCandidates_();
     }
 
     // don't checkForWork_() but rather go all the way through
-    trimMountPoints_(nsSCOSets, to_delete);
-
-    for (NSSCOSets::value_type& p: nsSCOSets)
+    for (SCOCacheMountPointPtr mp: mountPoints_)
     {
-        SCOSet* scoSet = p.second;
-        delete scoSet;
+        trimMountPoint_(mp, budgets, to_delete);
     }
 }
 
@@ -1699,99 +1979,9 @@ SCOCache::eraseSCOSetIterator_(SCOSet& scoSet,
     return scoSize;
 }
 
-void
-SCOCache::ensureNamespaceMin_(SCOCacheNamespace* ns,
-                              SCOSet& scoSet,
-                              uint64_t totalSize,
-                              uint64_t disposableSize)
-{
-    ASSERT_CLEANUP_LOCKED();
-    ASSERT_RWLOCKED();
-
-    // enforce min sizes by preserving the disposable scos with the highest
-    // access probabilities
-    uint64_t min = ns->getMinSize();
-    uint64_t nonDisposableSize = totalSize - disposableSize;
-
-    int64_t preserve = (nonDisposableSize >= min) ?
-        0 :
-        min - nonDisposableSize;
-
-    SCOSet::reverse_iterator rit = scoSet.rbegin();
-
-    while (rit != scoSet.rend() && preserve > 0)
-    {
-        CachedSCO& sco = *rit;
-        preserve -= sco.getSize();
-        // gah - scoSet.erase(rit) does not work
-        //scoSet.erase(rit);
-        sco.bi::set_base_hook<bi::link_mode<bi::auto_unlink> >::unlink();
-        rit = scoSet.rbegin();
-    }
-}
-
-void
-SCOCache::trimMountPoints_(NSSCOSets& nsSCOSets, SCOSet& to_delete)
-{
-    ASSERT_CLEANUP_LOCKED();
-    ASSERT_RWLOCKED();
-
-    // heck, we could even check the mountpoints idea of used size against
-    // the view of the nsMap_ ...
-    // will keeping a permanent intrusive list at the mountpoint (which needs
-    // to be sorted on cleanup) give any benefits over the below approach?
-    typedef std::map<const SCOCacheMountPointPtr, SCOSet*> MPSCOSets;
-    MPSCOSets mpSCOSets;
-
-    for (SCOCacheMountPointPtr mp: mountPoints_)
-    {
-        std::pair<MPSCOSets::iterator, bool> res =
-            mpSCOSets.insert(std::make_pair(mp, new SCOSet()));
-        VERIFY(res.second);
-    }
-
-    for (NSSCOSets::value_type& p: nsSCOSets)
-    {
-        SCOSet* nsSCOSet = p.second;
-
-        SCOSet::iterator nsit = nsSCOSet->begin();
-        while (nsit != nsSCOSet->end())
-        {
-            CachedSCO& sco = *nsit;
-
-            // namespace trimming happened before and must have ensured that
-            VERIFY(sco.isDisposable());
-            VERIFY(sco.use_count() == 1);
-
-            MPSCOSets::iterator mpit = mpSCOSets.find(sco.getMountPoint());
-            VERIFY(mpit != mpSCOSets.end());
-
-            SCOSet* mpSCOSet = mpit->second;
-            nsSCOSet->erase(nsit);
-            nsit = nsSCOSet->begin();
-
-            mpSCOSet->insert(sco);
-
-        }
-    }
-
-    MPSCOSets::iterator it = mpSCOSets.begin();
-    while (it != mpSCOSets.end())
-    {
-        SCOSet* scoSet = it->second;
-
-        trimMountPoint_(it->first, *scoSet, to_delete);
-
-        mpSCOSets.erase(it);
-        delete scoSet;
-
-        it = mpSCOSets.begin();
-    }
-}
-
 void
 SCOCache::trimMountPoint_(const SCOCacheMountPointPtr mp,
-                          SCOSet& mpSCOSet,
+                          NSBudgets& budgets,
                           SCOSet& to_delete)
 {
     ASSERT_CLEANUP_LOCKED();
@@ -1804,27 +1994,105 @@ SCOCache::trimMountPoint_(const SCOCacheMountPointPtr mp,
     freespace = std::min<uint64_t>(freespace,
                                    mp->getCapacity() - mp->getUsedSize());
 
-    SCOSet::iterator it = mpSCOSet.begin();
-
     if (freespace < trigger_gap.value().getBytes())
     {
-        while (it != mpSCOSet.end() && freespace < backoff_gap.value().getBytes())
+        // Victims are picked in order of increasing xval across the
+        // namespaces' candidate sets, a namespace drops out once its budget
+        // is exhausted. The spinlock is dropped every trim_batch_size_
+        // candidates - the read lock keeps the SCOs around but they might be
+        // repositioned in the mean time, so the fronts are looked up afresh
+        // after relocking.
+        typedef std::pair<float, CandidateSet*> Front;
+        typedef std::priority_queue<Front,
+                                    std::vector<Front>,
+                                    std::greater<Front>> Fronts;
+
+        bool more = true;
+
+        while (more and freespace < backoff_gap.value().getBytes())
         {
-            CachedSCO& sco = *it;
-            VERIFY(sco.use_count() == 1);
-            VERIFY(sco.isDisposable());
+            LOCK_XVALS();
 
-            SCOCacheNamespaceEntry* e =
-                sco.getNamespace()->findEntry(sco.getSCO());
-            VERIFY(e != nullptr);
-            e->setBlocked(true);
+            Fronts fronts;
+
+            CandidateMap::iterator cit = candidates_.find(mp.get());
+            if (cit != candidates_.end())
+            {
+                for (NSCandidateMap::value_type& p : cit->second)
+                {
+                    NSBudgets::const_iterator bit = budgets.find(p.first);
+                    VERIFY(bit != budgets.end());
 
-            mpSCOSet.erase(it);
-            it = mpSCOSet.begin();
+                    if (bit->second != 0 and not p.second.empty())
+                    {
+                        fronts.emplace(p.second.begin()->getXVal(),
+                                       &p.second);
+                    }
+                }
+            }
 
-            to_delete.insert(sco);
+            for (size_t i = 0;
+                 i < trim_batch_size_ and
+                     not fronts.empty() and
+                     freespace < backoff_gap.value().getBytes();
+                 ++i)
+            {
+                CandidateSet& candidates = *fronts.top().second;
+                fronts.pop();
+
+                CachedSCO& sco = *candidates.begin();
+                VERIFY(sco.isDisposable());
+
+                SCOCacheNamespaceEntry* e =
+                    sco.getNamespace()->findEntry(sco.getSCO());
+                VERIFY(e != nullptr);
+
+                NSBudgets::iterator bit = budgets.find(sco.getNamespace());
+                VERIFY(bit != budgets.end());
+
+                // This is where the old ensureNamespaceMin_ drew the line:
+                // it preserved the hottest disposable SCOs until min size
+                // was reached, and the SCO that doesn't fit into the budget
+                // anymore is the last one of those (all others of the
+                // namespace are hotter). So the namespace is done - for the
+                // other mountpoints, too, as the budget is per namespace.
+                if (bit->second < sco.getSize())
+                {
+                    bit->second = 0;
+                    continue;
+                }
 
-            freespace += sco.getSize();
+                candidates.erase(candidates.begin());
+
+                // usecount: entry in SCOCacheNamespace in nsMap_. SCOs in use
+                // are parked until released, blocked ones are linked again
+                // once unblocked.
+                if (e->isBlocked())
+                {
+                    LOG_DEBUG(sco.path() << " is blocked, dropping it from the candidates");
+                }
+                else if (sco.use_count() != 1)
+                {
+                    parked_.push_back(sco);
+                }
+                else
+                {
+                    bit->second -= sco.getSize();
+                    e->setBlocked(true);
+
+                    to_delete.insert(sco);
+
+                    freespace += sco.getSize();
+                }
+
+                if (not candidates.empty())
+                {
+                    fronts.emplace(candidates.begin()->getXVal(),
+                                   &candidates);
+                }
+            }
+
+            more = not fronts.empty();
         }
 
         if (freespace < trigger_gap.value().getBytes())
@@ -1926,7 +2194,7 @@ SCOCache::dumpSCOInfo(const fs::path& outfile)
                 sco->getSize() << "," <<
                 sco->isDisposable() << "," <<
                 sco->getMountPoint()->getPath() << "," <<
-                sco->getXVal() << std::endl;
+                sco->getXVal() * xValScale_ << std::endl;
         }
     }
 
@@ -2082,6 +2350,11 @@ SCOCache::removeMountPoint_(const fs::path& path, bool force)
                 }
             }
 
+            {
+                LOCK_XVALS();
+                candidates_.erase(mp.get());
+            }
+
             mountPoints_.erase(it);
             return;
         }
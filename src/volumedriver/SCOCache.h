@@ -28,6 +28,7 @@
 #include <list>
 #include <vector>
 
+#include <boost/intrusive/list.hpp>
 #include <boost/intrusive/set.hpp>
 #include <boost/thread/mutex.hpp>
 
@@ -229,7 +230,7 @@ private:
     //   write-locked if any of these need to be modified (addition /
     //   removal of items, change of currentMountPoint_), otherwise
     //   read-locked.
-    // - xValSpinLock_ protects xvals (SumMinMax)
+    // - xValSpinLock_ protects xvals (SumMinMax) and the eviction candidates
     // - cleanupLock_ prevents namespace removal vs. cache cleanup races
     //   (both generate an intrusive set).
     // - nspaceMgmtLock_ serializes management calls on inactive
@@ -267,6 +268,18 @@ private:
     float cachedXValMin_;
     float initialXVal_;
 
+    // The xvals stored in the SCOs are raw values which are normalized (such
+    // that they sum up to 1) by multiplying them with xValScale_. xValSum_ is
+    // the running sum of the raw values of all SCOs in the cache, so
+    // rescaleXVals_ only needs to update the scale instead of touching every
+    // SCO. Protected by xValSpinLock_.
+    double xValSum_;
+    double xValScale_;
+
+    // the raw values keep growing as accesses are added in terms of the
+    // current scale - they're renormalized once the sum exceeds this
+    static const double max_xval_sum_;
+
 
     uint64_t mpErrorCount_;
 
@@ -291,6 +304,65 @@ private:
                          boost::intrusive::compare<SCOCompare>,
                          boost::intrusive::constant_time_size<false> > SCOSet;
 
+    // Disposable SCOs per mountpoint and namespace, ordered by xval and kept
+    // up to date as SCOs come and go, are accessed or become disposable, so
+    // the cleaner can pick its victims from the front instead of rescanning
+    // all SCOs, and skip namespaces that must not give up any more space.
+    // Blocked SCOs are only linked once unblocked, the ones found in use by
+    // the cleaner are parked until they're released.
+    // Protected by xValSpinLock_.
+    typedef boost::intrusive::multiset<CachedSCO,
+                         boost::intrusive::member_hook<CachedSCO,
+                                                       CachedSCO::CandidateHook,
+                                                       &CachedSCO::candidate_hook_>,
+                         boost::intrusive::compare<SCOCompare>,
+                         boost::intrusive::constant_time_size<false> > CandidateSet;
+
+    typedef std::map<const SCOCacheNamespace*, CandidateSet> NSCandidateMap;
+    typedef std::map<const SCOCacheMountPoint*, NSCandidateMap> CandidateMap;
+    CandidateMap candidates_;
+
+    typedef boost::intrusive::list<CachedSCO,
+                         boost::intrusive::member_hook<CachedSCO,
+                                                       CachedSCO::ParkedHook,
+                                                       &CachedSCO::parked_hook_>,
+                         boost::intrusive::constant_time_size<false> > ParkedList;
+    ParkedList parked_;
+
+    // number of SCOs removed per write lock acquisition by doCleanup_
+    static const size_t cleanup_batch_size_;
+
+    // number of candidates trimMountPoint_ looks at per xValSpinLock_
+    // acquisition
+    static const size_t trim_batch_size_;
+
+    void
+    linkCandidate_(CachedSCO& sco);
+
+    void
+    unlinkCandidate_(CachedSCO& sco);
+
+    void
+    unblockSCO_(SCOCacheNamespaceEntry& e);
+
+    void
+    unparkCandidates_();
+
+    void
+    eraseNamespaceCandidates_(const SCOCacheNamespace* ns);
+
+    void
+    setXVal_(CachedSCO& sco,
+             float xval);
+
+    void
+    accountSCO_(SCOCacheNamespace* ns,
+                CachedSCO& sco,
+                bool add);
+
+    void
+    setSCODisposable_(CachedSCOPtr sco);
+
     void
     prepareCleanup_(SCOSet& to_delete);
 
@@ -378,6 +450,12 @@ private:
     void
     rescaleXVals_();
 
+    void
+    renormalizeXVals_();
+
+    float
+    toRawXVal_(float xval) const;
+
     void
     updateXValThresholds_();
 
@@ -395,22 +473,14 @@ private:
                          SCOSet::iterator& it,
                          bool remove_non_disposable);
 
-    void
-    ensureNamespaceMin_(SCOCacheNamespace* ns,
-                        SCOSet& scoSet,
-                        uint64_t totalSize,
-                        uint64_t disposableSize);
-
     void
     maybeChokeNamespaces_();
 
-    typedef std::map<const SCOCacheNamespace*, SCOSet*> NSSCOSets;
-    void
-    trimMountPoints_(NSSCOSets& nsSCOSets, SCOSet& to_delete);
+    typedef std::map<const SCOCacheNamespace*, uint64_t> NSBudgets;
 
     void
     trimMountPoint_(const SCOCacheMountPointPtr mp,
-                    SCOSet& mpSCOSet,
+                    NSBudgets& budgets,
                     SCOSet& to_delete);
 
     int
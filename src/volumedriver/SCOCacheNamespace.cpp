@@ -27,6 +27,8 @@ SCOCacheNamespace::SCOCacheNamespace(const backend::Namespace& nspace,
   , min_(min)
   , max_non_disposable_(max_non_disposable)
   , choking_(false)
+  , size_(0)
+  , disposable_size_(0)
 {
     LOG_DEBUG(nspace_ << ": created");
 }
@@ -107,6 +109,26 @@ SCOCacheNamespace::setChoking(bool choking)
     choking_ = choking;
 }
 
+uint64_t
+SCOCacheNamespace::getSize() const
+{
+    return size_;
+}
+
+uint64_t
+SCOCacheNamespace::getDisposableSize() const
+{
+    return disposable_size_;
+}
+
+void
+SCOCacheNamespace::updateSizes(int64_t size_diff,
+                               int64_t disposable_diff)
+{
+    size_ += size_diff;
+    disposable_size_ += disposable_diff;
+}
+
 }
 
 // Local Variables: **
@@ -16,6 +16,7 @@
 #ifndef SCO_CACHE_NAMESPACE_H_
 #define SCO_CACHE_NAMESPACE_H_
 
+#include <atomic>
 #include <map>
 #include <string>
 
@@ -104,6 +105,18 @@ public:
     bool
     isChoking() const;
 
+    // Sizes of the SCOs in the namespace, maintained by the SCOCache as SCOs
+    // are inserted / removed or become disposable.
+    uint64_t
+    getSize() const;
+
+    uint64_t
+    getDisposableSize() const;
+
+    void
+    updateSizes(int64_t size_diff,
+                int64_t disposable_diff);
+
 private:
     DECLARE_LOGGER("SCOCacheNamespace");
 
@@ -111,6 +124,8 @@ private:
     uint64_t min_;
     uint64_t max_non_disposable_;
     bool choking_;
+    std::atomic<uint64_t> size_;
+    std::atomic<uint64_t> disposable_size_;
 };
 
 }
@@ -38,6 +38,7 @@ TODO("AR: investigate and fix this!");
 BOOST_CLASS_EXPORT_IMPLEMENT(volumedriver::MetaDataBackendConfig);
 BOOST_CLASS_EXPORT_IMPLEMENT(volumedriver::TCBTMetaDataBackendConfig);
 BOOST_CLASS_EXPORT_IMPLEMENT(volumedriver::RocksDBMetaDataBackendConfig);
+BOOST_CLASS_EXPORT_IMPLEMENT(volumedriver::MMapMetaDataBackendConfig);
 BOOST_CLASS_EXPORT_IMPLEMENT(volumedriver::ArakoonMetaDataBackendConfig);
 BOOST_CLASS_EXPORT_IMPLEMENT(volumedriver::MDSMetaDataBackendConfig);
 
@@ -19,6 +19,8 @@
 
 #include <tcutil.h>
 
+#include <boost/lexical_cast.hpp>
+
 namespace volumedriver
 {
 
@@ -45,6 +47,9 @@ TokyoCabinetMetaDataBackend::used_clusters_key_ = std::numeric_limits<uint64_t>:
 const uint64_t
 TokyoCabinetMetaDataBackend::scrub_id_key_ = std::numeric_limits<uint64_t>::max() - 2;
 
+const uint64_t
+TokyoCabinetMetaDataBackend::page_format_key_ = std::numeric_limits<uint64_t>::max() - 3;
+
 const std::string
 TokyoCabinetMetaDataBackend::db_name = "mdstore.tc";
 
@@ -421,7 +426,8 @@ TokyoCabinetMetaDataBackend::check_page_address_(const CachePage& p)
 
     if (pa == cork_key_ or
         pa == used_clusters_key_ or
-        pa == scrub_id_key_)
+        pa == scrub_id_key_ or
+        pa == page_format_key_)
     {
         LOG_ERROR("Page address " << pa << " conflicts with internal key");
         throw MetaDataStoreBackendException("Page address conflicts with internal key");
@@ -465,6 +471,45 @@ TokyoCabinetMetaDataBackend::set_scrub_id(const ScrubId& scrub_id)
                     yt::UUID::getUUIDStringSize()));
 }
 
+boost::optional<PageFormat>
+TokyoCabinetMetaDataBackend::page_format()
+{
+    int return_size;
+    void* retval = tcbdbget(database_,
+                            &page_format_key_,
+                            sizeof(page_format_key_),
+                            &return_size);
+    BOOST_SCOPE_EXIT((retval))
+    {
+        free(retval);
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    if (retval)
+    {
+        return boost::lexical_cast<PageFormat>(std::string(static_cast<char*>(retval),
+                                                           return_size));
+    }
+    else
+    {
+        return PageFormat::Wide;
+    }
+}
+
+void
+TokyoCabinetMetaDataBackend::set_page_format(PageFormat format)
+{
+    LOG_INFO("Setting page format " << format);
+
+    const std::string s(boost::lexical_cast<std::string>(format));
+
+    HANDLE(tcbdbput(database_,
+                    &page_format_key_,
+                    sizeof(page_format_key_),
+                    s.c_str(),
+                    s.size()));
+}
+
 }
 
 // Local Variables: **
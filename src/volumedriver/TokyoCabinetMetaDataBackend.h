@@ -128,6 +128,12 @@ public:
     virtual void
     set_scrub_id(const ScrubId& id) override final;
 
+    virtual boost::optional<PageFormat>
+    page_format() override final;
+
+    virtual void
+    set_page_format(PageFormat) override final;
+
     static uint64_t
     locally_used_bytes(const VolumeConfig&);
 
@@ -145,6 +151,7 @@ private:
     static const uint64_t cork_key_;
     static const uint64_t used_clusters_key_;
     static const uint64_t scrub_id_key_;
+    static const uint64_t page_format_key_;
 
     bool
     getPage_(CachePage& p);
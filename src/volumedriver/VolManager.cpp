@@ -16,6 +16,7 @@
 #include "BackendTasks.h"
 #include "Entry.h"
 #include "LockStoreFactory.h"
+#include "MetaDataCacheBudget.h"
 #include "SCOCache.h"
 #include "SCOCacheAccessDataPersistor.h"
 #include "SnapshotManagement.h"
@@ -152,9 +153,17 @@ try
           , non_disposable_scos_factor(pt)
           , default_cluster_size(pt)
           , metadata_cache_capacity(pt)
+          , metadata_cache_budget(pt)
+          , metadata_cache_min_pages(pt)
+          , metadata_cache_rebalance_interval(pt)
           , debug_metadata_path(pt)
           , arakoon_metadata_sequence_size(pt)
           , allow_inconsistent_partial_reads(pt)
+          , partial_read_promotion_window_secs(pt)
+          , partial_read_promotion_threshold(pt)
+          , prefetch_threads(pt)
+          , prefetch_max_mib_per_sec(pt)
+          , prefetch_cancel_hit_rate_percent(pt)
           , volume_nullio(pt)
 {
     THROW_UNLESS((default_cluster_size.value() % VolumeConfig::default_lba_size()) == 0);
@@ -187,6 +196,20 @@ try
                                                           checkVolumeFailoverCaches();
                                                       },
                                                       dtl_check_interval_in_seconds.value()));
+
+    if (metadata_cache_budget.value() > 0)
+    {
+        metadata_cache_budget_ =
+            std::make_shared<MetaDataCacheBudget>(metadata_cache_budget.value(),
+                                                  metadata_cache_min_pages.value());
+
+        periodicActions_.push_back(new yt::PeriodicAction("MetaDataCacheRebalancer",
+                                                          [this]
+                                                          {
+                                                              metadata_cache_budget_->rebalance();
+                                                          },
+                                                          metadata_cache_rebalance_interval.value()));
+    }
 }
 CATCH_STD_ALL_LOG_RETHROW("Exception during VolManager construction");
 
@@ -1753,6 +1776,28 @@ VolManager::checkConfig(const boost::property_tree::ptree& pt,
         }
     }
 
+    {
+        PARAMETER_TYPE(prefetch_threads) val(pt);
+        if (val.value() < 1)
+        {
+            rep.push_front(ConfigurationProblem(val.name(),
+                                                val.section_name(),
+                                                "prefetch_threads must be >= 1"));
+            result = false;
+        }
+    }
+
+    {
+        PARAMETER_TYPE(prefetch_cancel_hit_rate_percent) val(pt);
+        if (val.value() > 100)
+        {
+            rep.push_front(ConfigurationProblem(val.name(),
+                                                val.section_name(),
+                                                "prefetch_cancel_hit_rate_percent must be <= 100"));
+            result = false;
+        }
+    }
+
     {
         PARAMETER_TYPE(max_volume_size) val(pt);
         if (val.value() + barts_correction >
@@ -1824,9 +1869,17 @@ VolManager::update(const boost::property_tree::ptree& pt,
     non_disposable_scos_factor.update(pt, report);
     default_cluster_size.update(pt, report);
     metadata_cache_capacity.update(pt, report);
+    metadata_cache_budget.update(pt, report);
+    metadata_cache_min_pages.update(pt, report);
+    metadata_cache_rebalance_interval.update(pt, report);
     debug_metadata_path.update(pt, report);
     arakoon_metadata_sequence_size.update(pt, report);
     allow_inconsistent_partial_reads.update(pt, report);
+    partial_read_promotion_window_secs.update(pt, report);
+    partial_read_promotion_threshold.update(pt, report);
+    prefetch_threads.update(pt, report);
+    prefetch_max_mib_per_sec.update(pt, report);
+    prefetch_cancel_hit_rate_percent.update(pt, report);
     volume_nullio.update(pt, report);
 }
 
@@ -1856,9 +1909,17 @@ VolManager::persist(boost::property_tree::ptree& pt,
     non_disposable_scos_factor.persist(pt, reportDefault);
     default_cluster_size.persist(pt, reportDefault);
     metadata_cache_capacity.persist(pt, reportDefault);
+    metadata_cache_budget.persist(pt, reportDefault);
+    metadata_cache_min_pages.persist(pt, reportDefault);
+    metadata_cache_rebalance_interval.persist(pt, reportDefault);
     debug_metadata_path.persist(pt, reportDefault);
     arakoon_metadata_sequence_size.persist(pt, reportDefault);
     allow_inconsistent_partial_reads.persist(pt, reportDefault);
+    partial_read_promotion_window_secs.persist(pt, reportDefault);
+    partial_read_promotion_threshold.persist(pt, reportDefault);
+    prefetch_threads.persist(pt, reportDefault);
+    prefetch_max_mib_per_sec.persist(pt, reportDefault);
+    prefetch_cancel_hit_rate_percent.persist(pt, reportDefault);
     volume_nullio.persist(pt, reportDefault);
 }
 
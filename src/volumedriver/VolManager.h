@@ -66,6 +66,7 @@ namespace volumedriver
 
 class ClusterClusterCache;
 class LockStoreFactory;
+class MetaDataCacheBudget;
 class PeriodicAction;
 class Volume;
 
@@ -475,6 +476,12 @@ public:
     size_t
     effective_metadata_cache_capacity(const VolumeConfig&) const;
 
+    const std::shared_ptr<MetaDataCacheBudget>&
+    get_metadata_cache_budget() const
+    {
+        return metadata_cache_budget_;
+    }
+
 private:
     DECLARE_LOGGER("VolManager");
 
@@ -506,6 +513,9 @@ private:
 
     std::shared_ptr<metadata_server::Manager> mds_manager_;
 
+    // nullptr unless metadata_cache_budget is set
+    std::shared_ptr<MetaDataCacheBudget> metadata_cache_budget_;
+
     mutable boost::optional<uint64_t> max_file_descriptors_;
 
     DECLARE_PARAMETER(metadata_path);
@@ -536,9 +546,17 @@ public:
     DECLARE_PARAMETER(non_disposable_scos_factor);
     DECLARE_PARAMETER(default_cluster_size);
     DECLARE_PARAMETER(metadata_cache_capacity);
+    DECLARE_PARAMETER(metadata_cache_budget);
+    DECLARE_PARAMETER(metadata_cache_min_pages);
+    DECLARE_PARAMETER(metadata_cache_rebalance_interval);
     DECLARE_PARAMETER(debug_metadata_path);
     DECLARE_PARAMETER(arakoon_metadata_sequence_size);
     DECLARE_PARAMETER(allow_inconsistent_partial_reads);
+    DECLARE_PARAMETER(partial_read_promotion_window_secs);
+    DECLARE_PARAMETER(partial_read_promotion_threshold);
+    DECLARE_PARAMETER(prefetch_threads);
+    DECLARE_PARAMETER(prefetch_max_mib_per_sec);
+    DECLARE_PARAMETER(prefetch_cancel_hit_rate_percent);
     DECLARE_PARAMETER(volume_nullio);
 
 private:
@@ -62,6 +62,7 @@
 #include <youtils/UUID.h>
 
 #include <backend/BackendInterface.h>
+#include <backend/BackendRequestParameters.h>
 #include <backend/Garbage.h>
 #include <backend/GarbageCollector.h>
 
@@ -107,6 +108,18 @@ namespace bc = boost::chrono;
 namespace be = backend;
 namespace yt = youtils;
 
+namespace
+{
+
+// Leaving fresher SCO access data behind on stop is merely nice to have -
+// don't let backend retries / timeouts hold up stopping the volume.
+const be::BackendRequestParameters sad_on_stop_request_params =
+    be::BackendRequestParameters()
+    .retries_on_error(0)
+    .timeout(boost::posix_time::seconds(5));
+
+}
+
 Volume::Volume(const VolumeConfig& vCfg,
                const OwnerTag owner_tag,
                std::unique_ptr<SnapshotManagement> snapshotManagement,
@@ -166,7 +179,14 @@ Volume::Volume(const VolumeConfig& vCfg,
     metaDataBackendConfigHasChanged(*metaDataStore_->getBackendConfig());
 
     prefetch_data_.initialize(this);
-    prefetch_thread_.reset(new boost::thread(boost::ref(prefetch_data_)));
+
+    const uint32_t nthreads = std::max<uint32_t>(1,
+                                                 VolManager::get()->prefetch_threads.value());
+    prefetch_threads_.reserve(nthreads);
+    for (uint32_t i = 0; i < nthreads; ++i)
+    {
+        prefetch_threads_.emplace_back(boost::ref(prefetch_data_));
+    }
 }
 
 Volume::~Volume()
@@ -176,9 +196,9 @@ Volume::~Volume()
     LOG_VINFO("Destructor of " << this);
     VolManager::get()->backend_thread_pool()->stop(this);
 
-    // we really shouldn't end up here with a running prefetch_thread_ - destroy()
-    // is supposed to have stopped it already.
-    ASSERT(prefetch_thread_ == nullptr);
+    // we really shouldn't end up here with running prefetch_threads_ - destroy()
+    // is supposed to have stopped them already.
+    ASSERT(prefetch_threads_.empty());
 
     try
     {
@@ -1608,6 +1628,16 @@ Volume::destroy(DeleteLocalData delete_local_data,
 
     // SYNC WAS REMOVED HERE
 
+    if (not halted_ and
+        F(delete_local_data) and
+        F(remove_volume_completely))
+    {
+        // The volume is likely to be restarted elsewhere (migration) - leave
+        // the current SCO access data behind for its prefetching instead of
+        // the one from the last sap_persist_interval.
+        persistSCOAccessData_();
+    }
+
     stopPrefetch_();
 
     // OVS-827: wait forever, otherwise we might leave tasks that might try call back into
@@ -2728,11 +2758,12 @@ Volume::stopPrefetch_()
 
     prefetch_data_.stop();
     // Y42 not sure do we want a timed join here?
-    if(prefetch_thread_.get())
+    for (auto& t : prefetch_threads_)
     {
-        prefetch_thread_->join();
-        prefetch_thread_.reset();
+        t.join();
     }
+
+    prefetch_threads_.clear();
 }
 
 void
@@ -2829,6 +2860,23 @@ Volume::writeFailOverCacheConfigToBackend_()
                                        OverwriteObject::T);
 }
 
+void
+Volume::persistSCOAccessData_()
+{
+    try
+    {
+        SCOAccessData sad(getNamespace(),
+                          readActivity());
+        VolManager::get()->getSCOCache()->fillSCOAccessData(sad);
+
+        SCOAccessDataPersistor
+            sadp(getBackendInterface()->cloneWithNewNamespace(getNamespace()));
+        sadp.push(sad,
+                  sad_on_stop_request_params);
+    }
+    CATCH_STD_ALL_VLOG_IGNORE("Failed to persist the SCO access data");
+}
+
 void
 Volume::startPrefetch(SCONumber last_sco_number)
 {
@@ -311,6 +311,14 @@ public:
     virtual void
     metaDataBackendConfigHasChanged(const MetaDataBackendConfig& cfg) override final;
 
+    virtual void
+    scheduleSCOPrefetch(const SCO sco,
+                        float sap) override final
+    {
+        prefetch_data_.addSCO(sco,
+                              sap);
+    }
+
     // End VolumeInterface
 
     void
@@ -577,7 +585,7 @@ private:
 
     double read_activity_;
     PrefetchData prefetch_data_;
-    std::unique_ptr<boost::thread> prefetch_thread_;
+    std::vector<boost::thread> prefetch_threads_;
     // volume_readcache_id_t read_cache_id_;
     std::vector<ClusterLocation> cluster_locations_;
 
@@ -637,6 +645,9 @@ private:
     void
     stopPrefetch_();
 
+    void
+    persistSCOAccessData_();
+
     void
     localRestartDataStore_(SCONumber lastSCOInBackend,
                            ClusterLocation lastClusterLocationNotInBackend);
@@ -154,6 +154,41 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(allow_inconsistent_partial_reads,
                                       ShowDocumentation::F,
                                       true);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(partial_read_promotion_window_secs,
+                                      volmanager_component_name,
+                                      "partial_read_promotion_window_secs",
+                                      "Time window (in seconds) within which partial backend reads of a SCO are accumulated to decide whether to fetch the whole SCO into the SCO cache instead. 0 disables the promotion",
+                                      ShowDocumentation::T,
+                                      60ULL);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(partial_read_promotion_threshold,
+                                      volmanager_component_name,
+                                      "partial_read_promotion_threshold",
+                                      "Number of distinct clusters of a SCO read partially within partial_read_promotion_window_secs that triggers fetching the whole SCO. 0 derives it from the observed backend latency and bandwidth",
+                                      ShowDocumentation::T,
+                                      0U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(prefetch_threads,
+                                      volmanager_component_name,
+                                      "prefetch_threads",
+                                      "Number of concurrent SCO fetches per volume when (re)warming the SCO cache. Applies to volumes started afterwards",
+                                      ShowDocumentation::T,
+                                      2U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(prefetch_max_mib_per_sec,
+                                      volmanager_component_name,
+                                      "prefetch_max_mib_per_sec",
+                                      "Bandwidth budget (MiB/s) per volume for prefetching SCOs from the backend. 0 means unlimited",
+                                      ShowDocumentation::T,
+                                      0U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(prefetch_cancel_hit_rate_percent,
+                                      volmanager_component_name,
+                                      "prefetch_cancel_hit_rate_percent",
+                                      "Stop prefetching SCOs of a volume once this percentage of its reads are served from the cache. 0 disables this",
+                                      ShowDocumentation::T,
+                                      95U);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(freespace_check_interval,
                                       volmanager_component_name,
                                       "freespace_check_interval",
@@ -189,6 +224,27 @@ DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_capacity,
                                       ShowDocumentation::T,
                                       8192);
 
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_budget,
+                                      volmanager_component_name,
+                                      "metadata_cache_budget",
+                                      "number of metadata pages shared by all volumes of this node; the per-volume metadata_cache_capacity then only serves as the initial request. 0 disables the shared budget",
+                                      ShowDocumentation::T,
+                                      0ULL);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_min_pages,
+                                      volmanager_component_name,
+                                      "metadata_cache_min_pages",
+                                      "number of metadata pages each volume is guaranteed when the shared metadata_cache_budget is used",
+                                      ShowDocumentation::T,
+                                      256U);
+
+DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_rebalance_interval,
+                                      volmanager_component_name,
+                                      "metadata_cache_rebalance_interval",
+                                      "Interval between redistributions of the shared metadata_cache_budget among the volumes, in seconds",
+                                      ShowDocumentation::T,
+                                      30ULL);
+
 DEFINE_INITIALIZED_PARAM_WITH_DEFAULT(debug_metadata_path,
                                       volmanager_component_name,
                                       "no_python_name",
@@ -65,6 +65,18 @@ DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(max_volume_size,
                                                   std::atomic<uint64_t>);
 DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(allow_inconsistent_partial_reads,
                                                   std::atomic<bool>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(partial_read_promotion_window_secs,
+                                                  std::atomic<uint64_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(partial_read_promotion_threshold,
+                                                  std::atomic<uint32_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(prefetch_threads,
+                                                  std::atomic<uint32_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(prefetch_max_mib_per_sec,
+                                                  std::atomic<uint32_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(prefetch_cancel_hit_rate_percent,
+                                                  std::atomic<uint32_t>);
+DECLARE_RESETTABLE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_rebalance_interval,
+                                                  std::atomic<uint64_t>);
 
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(number_of_scos_in_tlog,
                                        uint32_t);
@@ -74,6 +86,10 @@ DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(default_cluster_size,
                                        uint32_t);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_capacity,
                                        uint32_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_budget,
+                                       uint64_t);
+DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(metadata_cache_min_pages,
+                                       uint32_t);
 
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(debug_metadata_path, std::string);
 DECLARE_INITIALIZED_PARAM_WITH_DEFAULT(arakoon_metadata_sequence_size, uint32_t);
@@ -21,6 +21,7 @@
 #include "LocalTLogScanner.h"
 #include "MDSMetaDataBackend.h"
 #include "MDSMetaDataStore.h"
+#include "MMapMetaDataBackend.h"
 #include "MetaDataStoreBuilder.h"
 #include "MetaDataStoreDebug.h"
 #include "MetaDataStoreInterface.h"
@@ -126,6 +127,9 @@ make_metadata_store(const VolumeConfig& config)
     case MetaDataBackendType::TCBT:
         mdb.reset(new TokyoCabinetMetaDataBackend(config));
         break;
+    case MetaDataBackendType::MMap:
+        mdb.reset(new MMapMetaDataBackend(config));
+        break;
     case MetaDataBackendType::MDS:
         {
             const auto& mcfg(dynamic_cast<const MDSMetaDataBackendConfig&>(*config.metadata_backend_config_));
@@ -135,13 +139,41 @@ make_metadata_store(const VolumeConfig& config)
             return std::unique_ptr<MetaDataStoreInterface>(new MDSMetaDataStore(mcfg,
                                                                                 std::move(bi),
                                                                                 home,
-                                                                                num_pages_cached));
+                                                                                num_pages_cached,
+                                                                                vm.get_metadata_cache_budget()));
         }
     }
 
     return std::unique_ptr<MetaDataStoreInterface>(new CachedMetaDataStore(mdb,
                                                                            config.ns_,
-                                                                           num_pages_cached));
+                                                                           num_pages_cached,
+                                                                           vm.get_metadata_cache_budget()));
+}
+
+// Volumes that don't use content based cluster caching have no use for the
+// hashes, so their metadata can be cached in Compact pages. Going back to
+// content based caching is not supported, so this is only a concern if the
+// node-wide default mode is changed.
+// ContentBased volumes with ClusterCacheBehaviour::NoCache stay Wide: the
+// behaviour can be switched back on a live volume (set_cluster_cache_behaviour)
+// and the cache then needs the hashes right away, whereas the Compact -> Wide
+// rebuild below only happens when the volume is (re)started.
+PageFormat
+wanted_page_format(const VolumeConfig& config)
+{
+    const ClusterCacheMode mode = config.cluster_cache_mode_ ?
+        *config.cluster_cache_mode_ :
+        VolManager::get()->get_cluster_cache_default_mode();
+
+    if (mode == ClusterCacheMode::LocationBased and
+        ClusterLocationAndHash::use_hash())
+    {
+        return PageFormat::Compact;
+    }
+    else
+    {
+        return PageFormat::Wide;
+    }
 }
 
 std::unique_ptr<MetaDataStoreInterface>
@@ -168,6 +200,21 @@ make_metadata_store(const VolumeConfig& config,
                  ": no scrub ID present in MetaDataStore - did we crash before writing it out?");
     }
 
+    const PageFormat have = md->page_format();
+    const PageFormat want = wanted_page_format(config);
+
+    if (have != want)
+    {
+        if (have == PageFormat::Compact)
+        {
+            LOG_WARN(config.id_ <<
+                     ": the MetaDataStore lacks the hashes required for content based caching - clearing it to have it rebuilt!");
+            md->clear_all_keys();
+        }
+
+        md->set_page_format(want);
+    }
+
     return md;
 }
 
@@ -951,6 +998,8 @@ VolumeFactory::metadata_locally_used_bytes(const VolumeConfig& cfg)
         return RocksDBMetaDataBackend::locally_used_bytes(cfg);
     case MetaDataBackendType::TCBT:
         return TokyoCabinetMetaDataBackend::locally_used_bytes(cfg);
+    case MetaDataBackendType::MMap:
+        return MMapMetaDataBackend::locally_used_bytes(cfg);
     }
 
     UNREACHABLE;
@@ -969,6 +1018,8 @@ VolumeFactory::metadata_locally_required_bytes(const VolumeConfig& cfg)
         return RocksDBMetaDataBackend::locally_required_bytes(cfg);
     case MetaDataBackendType::TCBT:
         return TokyoCabinetMetaDataBackend::locally_required_bytes(cfg);
+    case MetaDataBackendType::MMap:
+        return MMapMetaDataBackend::locally_required_bytes(cfg);
     }
 
     UNREACHABLE;
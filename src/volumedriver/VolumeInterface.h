@@ -116,6 +116,11 @@ public:
     virtual void
     metaDataBackendConfigHasChanged(const MetaDataBackendConfig& cfg) = 0;
 
+    // Fetch the whole SCO into the SCOCache in the background.
+    virtual void
+    scheduleSCOPrefetch(const SCO,
+                        float sap) = 0;
+
     PerformanceCounters&
     performance_counters()
     {
@@ -247,6 +247,11 @@ public:
     virtual void
     metaDataBackendConfigHasChanged(const MetaDataBackendConfig& cfg) override final;
 
+    virtual void
+    scheduleSCOPrefetch(const SCO,
+                        float /* sap */) override final
+    {}
+
     void
     restoreSnapshot(const SnapshotName&);
 
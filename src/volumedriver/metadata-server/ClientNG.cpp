@@ -24,6 +24,7 @@
 #include <capnp/serialize.h>
 
 #include <youtils/Assert.h>
+#include <youtils/ScopeExit.h>
 #include <youtils/SourceOfUncertainty.h>
 
 namespace metadata_server
@@ -271,6 +272,19 @@ struct TableHandle
                    counters.total_tlogs_read = c.getTotalTLogsRead();
                    counters.incremental_updates = c.getIncrementalUpdates();
                    counters.full_rebuilds = c.getFullRebuilds();
+
+#define GET_HISTOGRAM(name, get)                                        \
+                   for (const auto n : c.get())                         \
+                   {                                                    \
+                       counters.name.push_back(n);                      \
+                   }
+
+                   GET_HISTOGRAM(multiset_batch_sizes, getMultiSetBatchSizes);
+                   GET_HISTOGRAM(multiget_batch_sizes, getMultiGetBatchSizes);
+                   GET_HISTOGRAM(global_multiset_batch_sizes, getGlobalMultiSetBatchSizes);
+                   GET_HISTOGRAM(global_multiget_batch_sizes, getGlobalMultiGetBatchSizes);
+
+#undef GET_HISTOGRAM
                });
 
         client_->interact_<mdsproto::RequestHeader::Type::GetTableCounters>(std::move(b),
@@ -278,35 +292,145 @@ struct TableHandle
         return counters;
     }
 
+    virtual void
+    set_slaves(const NodeConfigs& slaves) override final
+    {
+        auto b([&](mdsproto::Methods::SetSlavesParams::Builder& builder)
+               {
+                   builder.setNspace(nspace_);
+
+                   size_t idx = 0;
+                   auto l = builder.initSlaves(slaves.size());
+
+                   for (const auto& s : slaves)
+                   {
+                       auto e = l[idx];
+                       e.setAddress(s.address());
+                       e.setPort(s.port());
+                       ++idx;
+                   }
+               });
+
+        auto r([&](mdsproto::Methods::SetSlavesResults::Reader&)
+               {
+               });
+
+        client_->interact_<mdsproto::RequestHeader::Type::SetSlaves>(std::move(b),
+                                                                     std::move(r));
+    }
+
+    virtual bool
+    replicate(const ReplicationUpdate& update) override final
+    {
+        auto b([&](mdsproto::Methods::ReplicateParams::Builder& builder)
+               {
+                   builder.setNspace(nspace_);
+                   builder.setStream(update.stream);
+                   builder.setSeqNum(update.seq);
+                   builder.setCork(update.cork);
+                   builder.setBarrier(update.barrier == Barrier::T);
+
+                   size_t idx = 0;
+                   auto l = builder.initRecords(update.records.size());
+
+                   for (const auto& r : update.records)
+                   {
+                       auto e = l[idx];
+                       e.setKey(capnp::Data::Reader(reinterpret_cast<const kj::byte*>(r.first.data()),
+                                                    r.first.size()));
+                       if (r.second)
+                       {
+                           e.setVal(capnp::Data::Reader(reinterpret_cast<const kj::byte*>(r.second->data()),
+                                                        r.second->size()));
+                       }
+                       else
+                       {
+                           e.setVal(capnp::Data::Reader(nullptr,
+                                                        0));
+                       }
+                       ++idx;
+                   }
+               });
+
+        bool applied = false;
+
+        auto r([&](mdsproto::Methods::ReplicateResults::Reader& reader)
+               {
+                   applied = reader.getApplied();
+               });
+
+        client_->interact_<mdsproto::RequestHeader::Type::Replicate>(std::move(b),
+                                                                     std::move(r));
+        return applied;
+    }
+
     const std::string nspace_;
     ClientNG::Ptr client_;
 };
 
+struct ClientNG::Channel
+{
+    yt::LocORemClient client;
+    std::unique_ptr<yt::SharedMemoryRegion> mr;
+    // false while a request is outstanding - a channel that fails before the
+    // complete response was read cannot be reused
+    bool in_sync = true;
+
+    Channel(const std::string& addr,
+            uint16_t port,
+            const boost::optional<std::chrono::seconds>& timeout,
+            ForceRemote force_remote,
+            size_t shmem_size)
+        : client(addr,
+                 port,
+                 timeout,
+                 force_remote)
+        , mr((shmem_size and client.is_local()) ?
+             new yt::SharedMemoryRegion(shmem_size) :
+             nullptr)
+    {}
+};
+
+constexpr size_t ClientNG::default_max_channels;
+constexpr size_t ClientNG::max_shmem_size;
+
 ClientNG::Ptr
 ClientNG::create(const vd::MDSNodeConfig& cfg,
                  size_t shmem_size,
                  const boost::optional<std::chrono::seconds>& timeout,
-                 ForceRemote force_remote)
+                 ForceRemote force_remote,
+                 size_t max_channels)
 {
     return Ptr(new ClientNG(cfg,
                             shmem_size,
                             timeout,
-                            force_remote));
+                            force_remote,
+                            max_channels));
 }
 
 ClientNG::ClientNG(const vd::MDSNodeConfig& cfg,
                    size_t shmem_size,
                    const boost::optional<std::chrono::seconds>& timeout,
-                   ForceRemote force_remote)
-    : client_(cfg.address(),
-              cfg.port(),
-              timeout,
-              force_remote)
-    , mr_(shmem_size ? new yt::SharedMemoryRegion(shmem_size) : nullptr)
+                   ForceRemote force_remote,
+                   size_t max_channels)
+    : address_(cfg.address())
+    , port_(cfg.port())
     , timeout_(timeout)
+    , force_remote_(force_remote)
+    , max_channels_(std::max<size_t>(max_channels, 1))
+    , local_(false)
+    , num_channels_(1)
+    , shmem_size_(shmem_size)
+    , next_tag_(0)
 {
-    LOG_INFO(this << ": " << cfg << ", shmem size " << shmem_size <<
-             ", is local: " << client_.is_local() << ", timeout: " <<
+    // Connect right away to report an unreachable server to the creator.
+    ChannelPtr chan(make_channel_(shmem_size_));
+    local_ = chan->client.is_local();
+    idle_channels_.emplace_back(std::move(chan));
+
+    LOG_INFO(this << ": " << cfg << ", shmem size " << shmem_size_ <<
+             ", max channels " << max_channels_ <<
+             ", is local: " << local_ << ", timeout: " <<
              (timeout_ ? boost::lexical_cast<std::string>(timeout->count()) : "--") <<
              " secs");
 }
@@ -316,6 +440,174 @@ ClientNG::~ClientNG()
     LOG_INFO(this << ": terminating");
 }
 
+size_t
+ClientNG::channels() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return num_channels_;
+}
+
+size_t
+ClientNG::shmem_size() const
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+    return local_ ? shmem_size_ : 0;
+}
+
+ClientNG::ChannelPtr
+ClientNG::make_channel_(size_t shmem_size)
+{
+    return std::make_unique<Channel>(address_,
+                                     port_,
+                                     timeout_,
+                                     force_remote_,
+                                     shmem_size);
+}
+
+ClientNG::ChannelPtr
+ClientNG::get_channel_()
+{
+    ChannelPtr outgrown;
+    size_t shmem_size = 0;
+
+    {
+        boost::unique_lock<decltype(lock_)> u(lock_);
+
+        while (true)
+        {
+            if (not idle_channels_.empty())
+            {
+                ChannelPtr chan(std::move(idle_channels_.back()));
+                idle_channels_.pop_back();
+
+                if (chan->mr == nullptr or chan->mr->size() >= shmem_size_)
+                {
+                    return chan;
+                }
+
+                // Replace the whole channel rather than just the region, as
+                // the server holds on to the regions of a connection until
+                // it's closed.
+                outgrown = std::move(chan);
+                break;
+            }
+            else if (num_channels_ < max_channels_)
+            {
+                ++num_channels_;
+                break;
+            }
+            else
+            {
+                channel_cond_.wait(u);
+            }
+        }
+
+        shmem_size = shmem_size_;
+    }
+
+    outgrown.reset();
+
+    try
+    {
+        return make_channel_(shmem_size);
+    }
+    catch (...)
+    {
+        {
+            boost::lock_guard<decltype(lock_)> g(lock_);
+            --num_channels_;
+        }
+
+        channel_cond_.notify_one();
+        throw;
+    }
+}
+
+void
+ClientNG::put_channel_(ChannelPtr chan)
+{
+    if (not chan->in_sync)
+    {
+        LOG_WARN(this << ": dropping channel " << chan.get() <<
+                 " as it's out of sync with the server");
+        chan.reset();
+    }
+
+    {
+        boost::lock_guard<decltype(lock_)> g(lock_);
+        if (chan)
+        {
+            idle_channels_.emplace_back(std::move(chan));
+        }
+        else
+        {
+            VERIFY(num_channels_ > 0);
+            --num_channels_;
+        }
+    }
+
+    channel_cond_.notify_one();
+}
+
+void
+ClientNG::account_out_(size_t size,
+                       bool shmem_overrun)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    ++out_counters_.messages;
+    out_counters_.data_bytes += size;
+    out_counters_.data_bytes_sqsum += size * size;
+
+    if (shmem_overrun)
+    {
+        ++out_counters_.shmem_overruns;
+    }
+}
+
+void
+ClientNG::account_in_(size_t size,
+                      bool shmem_overrun)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    ++in_counters_.messages;
+    in_counters_.data_bytes += size;
+    in_counters_.data_bytes_sqsum += size * size;
+
+    if (shmem_overrun)
+    {
+        ++in_counters_.shmem_overruns;
+    }
+}
+
+void
+ClientNG::grow_shmem_(size_t needed)
+{
+    boost::lock_guard<decltype(lock_)> g(lock_);
+
+    if (shmem_size_ > 0 and
+        shmem_size_ < needed and
+        shmem_size_ < max_shmem_size)
+    {
+        size_t size = shmem_size_;
+        while (size < needed and size < max_shmem_size)
+        {
+            size *= 2;
+        }
+
+        size = std::min(size,
+                        max_shmem_size);
+
+        if (size != shmem_size_)
+        {
+            LOG_INFO(this << ": growing shmem size from " << shmem_size_ <<
+                     " to " << size << " as " << needed << " bytes were required");
+            shmem_size_ = size;
+        }
+    }
+}
+
 TableInterfacePtr
 ClientNG::open(const std::string& nspace)
 {
@@ -409,8 +701,14 @@ ClientNG::ping(const std::vector<uint8_t>& out,
                                                    std::move(r));
 }
 
+bool
+ClientNG::use_shmem_(const Channel& chan) const
+{
+    return chan.mr != nullptr and is_local();
+}
+
 void
-ClientNG::prepare_shmem_()
+ClientNG::prepare_shmem_(Channel& chan)
 {
     // This is a serious performance hog, but Cap'n Proto shows all sorts of weird errors
     // (exceptions about missing \0-terminators of strings) when not doing it. Sigh.
@@ -418,11 +716,11 @@ ClientNG::prepare_shmem_()
     // the buffer to prevent information leaks in hostile environments this also punishes
     // those in a controlled environment, FFS!
 #if 1
-    if (mr_ != nullptr)
+    if (chan.mr != nullptr)
     {
-        memset(mr_->address(),
+        memset(chan.mr->address(),
                0x0,
-               mr_->size());
+               chan.mr->size());
     }
 #endif
 }
@@ -430,15 +728,18 @@ ClientNG::prepare_shmem_()
 template<enum metadata_server_protocol::RequestHeader::Type T,
          typename Build>
 size_t
-ClientNG::send_shmem_(mdsproto::Tag tag,
+ClientNG::send_shmem_(Channel& chan,
+                      mdsproto::Tag tag,
                       Build&& build)
 {
     using Traits = mdsproto::RequestTraits<T>;
 
-    prepare_shmem_();
+    prepare_shmem_(chan);
+
+    yt::SharedMemoryRegion& mr = *chan.mr;
 
-    capnp::FlatMessageBuilder builder(kj::arrayPtr(static_cast<capnp::word*>(mr_->address()),
-                                                   mr_->size() / sizeof(capnp::word)));
+    capnp::FlatMessageBuilder builder(kj::arrayPtr(static_cast<capnp::word*>(mr.address()),
+                                                   mr.size() / sizeof(capnp::word)));
 
     auto root(builder.initRoot<typename Traits::Params>());
 
@@ -450,9 +751,9 @@ ClientNG::send_shmem_(mdsproto::Tag tag,
     const mdsproto::RequestHeader hdr(Traits::request_type,
                                       size,
                                       tag,
-                                      mr_->id(),
+                                      mr.id(),
                                       0,
-                                      mr_->id(),
+                                      mr.id(),
                                       size);
 
     // LOG_TRACE("sending " << hdr.request_type <<
@@ -461,13 +762,12 @@ ClientNG::send_shmem_(mdsproto::Tag tag,
     //           ", out region " << hdr.out_region << ", off " << hdr.out_offset <<
     //           ", in region " << hdr.in_region << ", off " << hdr.in_offset);
 
-    client_.send(ba::buffer(&hdr,
-                            sizeof(hdr)),
-                 timeout_);
+    chan.client.send(ba::buffer(&hdr,
+                                sizeof(hdr)),
+                     timeout_);
 
-    ++out_counters_.messages;
-    out_counters_.data_bytes += size;
-    out_counters_.data_bytes_sqsum += size * size;
+    account_out_(size,
+                 false);
 
     return size;
 }
@@ -475,7 +775,8 @@ ClientNG::send_shmem_(mdsproto::Tag tag,
 template<enum metadata_server_protocol::RequestHeader::Type T,
          typename Build>
 size_t
-ClientNG::send_inband_(mdsproto::Tag tag,
+ClientNG::send_inband_(Channel& chan,
+                       mdsproto::Tag tag,
                        Build&& build)
 {
     using Traits = mdsproto::RequestTraits<T>;
@@ -487,15 +788,15 @@ ClientNG::send_inband_(mdsproto::Tag tag,
 
     kj::Array<capnp::word> data(capnp::messageToFlatArray(builder));
 
-    prepare_shmem_();
+    prepare_shmem_(chan);
 
     const mdsproto::RequestHeader hdr(Traits::request_type,
                                       data.size() * sizeof(capnp::word),
                                       tag,
                                       yt::SharedMemoryRegionId(0),
                                       0,
-                                      use_shmem_() ?
-                                      mr_->id() :
+                                      use_shmem_(chan) ?
+                                      chan.mr->id() :
                                       yt::SharedMemoryRegionId(0),
                                       0);
 
@@ -512,12 +813,8 @@ ClientNG::send_inband_(mdsproto::Tag tag,
     //           ", out region " << hdr.out_region << ", off " << hdr.out_offset <<
     //           ", in region " << hdr.in_region << ", off " << hdr.in_offset);
 
-    client_.send(bufs,
-                 timeout_);
-
-    ++out_counters_.messages;
-    out_counters_.data_bytes += hdr.size;
-    out_counters_.data_bytes_sqsum += hdr.size * hdr.size;
+    chan.client.send(bufs,
+                     timeout_);
 
     return hdr.size;
 }
@@ -529,36 +826,55 @@ void
 ClientNG::interact_(Build&& build,
                     Read&& read)
 {
-    boost::lock_guard<decltype(lock_)> g(lock_);
+    ChannelPtr chan(get_channel_());
+
+    auto on_exit(yt::make_scope_exit([&]
+                                     {
+                                         put_channel_(std::move(chan));
+                                     }));
 
-    const mdsproto::Tag txtag(reinterpret_cast<uint64_t>(this));
+    const mdsproto::Tag txtag(++next_tag_);
+
+    chan->in_sync = false;
 
     size_t txoff = 0;
 
-    bool use_shmem = use_shmem_();
+    bool use_shmem = use_shmem_(*chan);
     if (use_shmem)
     {
         try
         {
-            txoff = send_shmem_<T>(txtag,
-                                    std::move(build));
+            txoff = send_shmem_<T>(*chan,
+                                   txtag,
+                                   std::move(build));
         }
         catch (kj::Exception& e)
         {
-            LOG_ERROR("Failed to build shmem message " << e.getDescription().cStr() <<
-                      " - falling back to socket");
-            ++out_counters_.shmem_overruns;
+            LOG_WARN("Failed to build shmem message " << e.getDescription().cStr() <<
+                     " - falling back to socket");
             use_shmem = false;
         }
     }
 
     if (not use_shmem)
     {
-        send_inband_<T>(txtag,
-                        std::move(build));
+        const size_t size = send_inband_<T>(*chan,
+                                            txtag,
+                                            std::move(build));
+        const bool overrun = use_shmem_(*chan);
+
+        account_out_(size,
+                     overrun);
+
+        if (overrun)
+        {
+            // leave room for a response of about the same size
+            grow_shmem_(2 * size);
+        }
     }
 
-    recv_<T>(txtag,
+    recv_<T>(*chan,
+             txtag,
              txoff,
              std::move(read));
 }
@@ -566,15 +882,16 @@ ClientNG::interact_(Build&& build,
 template<enum mdsproto::RequestHeader::Type T,
          typename Read>
 void
-ClientNG::recv_(mdsproto::Tag txtag,
+ClientNG::recv_(Channel& chan,
+                mdsproto::Tag txtag,
                 size_t txoff,
                 Read&& read)
 {
     mdsproto::ResponseHeader rxhdr;
 
-    client_.recv(ba::buffer(&rxhdr,
-                            sizeof(rxhdr)),
-                 timeout_);
+    chan.client.recv(ba::buffer(&rxhdr,
+                                sizeof(rxhdr)),
+                     timeout_);
 
     if (rxhdr.magic != mdsproto::magic)
     {
@@ -590,23 +907,26 @@ ClientNG::recv_(mdsproto::Tag txtag,
     TODO("AR: better exceptions");
     THROW_WHEN(rxhdr.tag != txtag);
 
-    ++in_counters_.messages;
-    in_counters_.data_bytes += rxhdr.size;
-    in_counters_.data_bytes_sqsum += rxhdr.size * rxhdr.size;
-
     if (rxhdr.size)
     {
         if ((rxhdr.flags bitand mdsproto::ResponseHeader::Flags::UseShmem) == 0)
         {
-            if (use_shmem_())
+            const bool overrun = use_shmem_(chan);
+
+            account_in_(rxhdr.size,
+                        overrun);
+
+            if (overrun)
             {
-                ++in_counters_.shmem_overruns;
+                grow_shmem_(txoff + rxhdr.size);
             }
 
             std::vector<capnp::word> rxbuf(rxhdr.size / sizeof(capnp::word));
 
-            client_.recv(ba::buffer(rxbuf),
-                         timeout_);
+            chan.client.recv(ba::buffer(rxbuf),
+                             timeout_);
+
+            chan.in_sync = true;
 
             capnp::FlatArrayMessageReader reader(kj::arrayPtr(rxbuf.data(),
                                                               rxbuf.size()));
@@ -616,12 +936,18 @@ ClientNG::recv_(mdsproto::Tag txtag,
         }
         else
         {
-            THROW_UNLESS(use_shmem_());
+            account_in_(rxhdr.size,
+                        false);
 
-            const uint8_t* addr = static_cast<const uint8_t*>(mr_->address()) + txoff;
+            THROW_UNLESS(use_shmem_(chan));
+
+            yt::SharedMemoryRegion& mr = *chan.mr;
+            const uint8_t* addr = static_cast<const uint8_t*>(mr.address()) + txoff;
 
             THROW_UNLESS(addr + rxhdr.size <=
-                         static_cast<const uint8_t*>(mr_->address()) + mr_->size());
+                         static_cast<const uint8_t*>(mr.address()) + mr.size());
+
+            chan.in_sync = true;
 
             auto seg(kj::arrayPtr(reinterpret_cast<const capnp::word*>(addr),
                                   rxhdr.size / sizeof(capnp::word)));
@@ -633,6 +959,12 @@ ClientNG::recv_(mdsproto::Tag txtag,
                                 std::move(read));
         }
     }
+    else
+    {
+        account_in_(0,
+                    false);
+        chan.in_sync = true;
+    }
 }
 
 template<enum mdsproto::RequestHeader::Type T,
@@ -19,8 +19,10 @@
 #include "Interface.h"
 #include "Protocol.h"
 
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <vector>
 
 #include <boost/thread.hpp>
 
@@ -41,6 +43,14 @@ namespace metadata_server
 
 class TableHandle;
 
+// Requests are sent over a pool of connections ("channels") which is grown on
+// demand up to max_channels, so callers sharing a client (e.g. the metadata
+// page fetches of one or several volumes) don't have to wait for each other -
+// the server handles each connection on its own.
+// Each channel of a local client comes with its own shared memory region. The
+// regions start out at shmem_size and are grown (up to max_shmem_size) when
+// requests or responses turn out to be too big for them, i.e. after shmem
+// overruns.
 class ClientNG
     : public DataBaseInterface
     , public std::enable_shared_from_this<ClientNG>
@@ -48,11 +58,15 @@ class ClientNG
 public:
     using Ptr = std::shared_ptr<ClientNG>;
 
+    static constexpr size_t default_max_channels = 8;
+    static constexpr size_t max_shmem_size = 1ULL << 20;
+
     static Ptr
     create(const volumedriver::MDSNodeConfig& cfg,
            size_t shmem_size = 8ULL << 10,
            const boost::optional<std::chrono::seconds>& timeout = boost::none,
-           ForceRemote force_remote = ForceRemote::F);
+           ForceRemote force_remote = ForceRemote::F,
+           size_t max_channels = default_max_channels);
 
     ~ClientNG();
 
@@ -77,9 +91,18 @@ public:
     bool
     is_local() const
     {
-        return client_.is_local();
+        return local_;
     }
 
+    // number of open connections to the server
+    size_t
+    channels() const;
+
+    // size of the shared memory regions of new or reused channels (0: not
+    // using shared memory)
+    size_t
+    shmem_size() const;
+
     enum class Direction
     {
         Out,
@@ -102,6 +125,7 @@ public:
     counters(OutCounters& out,
              InCounters& in) const
     {
+        boost::lock_guard<decltype(lock_)> g(lock_);
         out = out_counters_;
         in = in_counters_;
     }
@@ -111,10 +135,24 @@ private:
 
     friend class TableHandle;
 
-    boost::mutex lock_;
-    youtils::LocORemClient client_;
-    std::unique_ptr<youtils::SharedMemoryRegion> mr_;
+    struct Channel;
+    using ChannelPtr = std::unique_ptr<Channel>;
+
+    const std::string address_;
+    const uint16_t port_;
     const boost::optional<std::chrono::seconds> timeout_;
+    const ForceRemote force_remote_;
+    const size_t max_channels_;
+    bool local_;
+
+    // protects the channel pool, the shmem size and the counters
+    mutable boost::mutex lock_;
+    boost::condition_variable channel_cond_;
+    std::vector<ChannelPtr> idle_channels_;
+    size_t num_channels_;
+    size_t shmem_size_;
+
+    std::atomic<uint64_t> next_tag_;
 
     OutCounters out_counters_;
     InCounters in_counters_;
@@ -122,18 +160,41 @@ private:
     ClientNG(const volumedriver::MDSNodeConfig& cfg,
              size_t shmem_size,
              const boost::optional<std::chrono::seconds>& timeout,
-             ForceRemote force_remote);
+             ForceRemote force_remote,
+             size_t max_channels);
+
+    ChannelPtr
+    make_channel_(size_t shmem_size);
+
+    ChannelPtr
+    get_channel_();
+
+    void
+    put_channel_(ChannelPtr);
+
+    void
+    account_out_(size_t size,
+                 bool shmem_overrun);
+
+    void
+    account_in_(size_t size,
+                bool shmem_overrun);
+
+    void
+    grow_shmem_(size_t needed);
 
     template<enum metadata_server_protocol::RequestHeader::Type r,
              typename Build>
     size_t
-    send_shmem_(metadata_server_protocol::Tag tag,
+    send_shmem_(Channel&,
+                metadata_server_protocol::Tag tag,
                 Build&& build);
 
     template<enum metadata_server_protocol::RequestHeader::Type r,
              typename Build>
     size_t
-    send_inband_(metadata_server_protocol::Tag tag,
+    send_inband_(Channel&,
+                 metadata_server_protocol::Tag tag,
                  Build&& build);
 
     template<enum metadata_server_protocol::RequestHeader::Type r,
@@ -146,7 +207,8 @@ private:
     template<enum metadata_server_protocol::RequestHeader::Type r,
              typename Read>
     void
-    recv_(metadata_server_protocol::Tag tag,
+    recv_(Channel&,
+          metadata_server_protocol::Tag tag,
           size_t txsize,
           Read&&);
 
@@ -158,13 +220,10 @@ private:
                      Read&&);
 
     void
-    prepare_shmem_();
+    prepare_shmem_(Channel&);
 
     bool
-    use_shmem_() const
-    {
-        return mr_ != nullptr and is_local();
-    }
+    use_shmem_(const Channel&) const;
 };
 
 }
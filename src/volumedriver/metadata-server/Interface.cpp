@@ -20,6 +20,51 @@
 namespace metadata_server
 {
 
+const std::string cork_key("cork_id");
+
+constexpr size_t TableCounters::batch_size_buckets;
+
+void
+TableCounters::record_batch_size(std::vector<uint64_t>& histogram,
+                                 size_t requests)
+{
+    if (histogram.empty())
+    {
+        histogram.resize(batch_size_buckets, 0);
+    }
+
+    size_t b = 0;
+    while (requests > 1 and b < histogram.size() - 1)
+    {
+        requests >>= 1;
+        ++b;
+    }
+
+    ++histogram[b];
+}
+
+namespace
+{
+
+struct PrintHistogram
+{
+    const std::vector<uint64_t>& histogram;
+};
+
+std::ostream&
+operator<<(std::ostream& os,
+           const PrintHistogram& p)
+{
+    os << "[";
+    for (size_t i = 0; i < p.histogram.size(); ++i)
+    {
+        os << (i ? "," : "") << p.histogram[i];
+    }
+    return os << "]";
+}
+
+}
+
 std::ostream&
 operator<<(std::ostream& os,
            const TableCounters& c)
@@ -28,6 +73,10 @@ operator<<(std::ostream& os,
         "TableCounters{total_tlogs_read=" << c.total_tlogs_read <<
         ",incremental_updates=" << c.incremental_updates <<
         ",full_rebuilds=" << c.full_rebuilds <<
+        ",multiset_batch_sizes=" << PrintHistogram{ c.multiset_batch_sizes } <<
+        ",multiget_batch_sizes=" << PrintHistogram{ c.multiget_batch_sizes } <<
+        ",global_multiset_batch_sizes=" << PrintHistogram{ c.global_multiset_batch_sizes } <<
+        ",global_multiget_batch_sizes=" << PrintHistogram{ c.global_multiget_batch_sizes } <<
         "}";
 }
 
@@ -20,6 +20,8 @@
 #include <iosfwd>
 #include <memory>
 #include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/optional.hpp>
@@ -31,9 +33,18 @@
 
 VD_BOOLEAN_ENUM(Barrier);
 
+namespace volumedriver
+{
+class MDSNodeConfig;
+}
+
 namespace metadata_server
 {
 
+// The key MDSMetaDataBackend stores the cork under. Tables need to know about
+// it as the replication stream is tagged with corks.
+extern const std::string cork_key;
+
 // duplicates DataBufferTraits from Arakoon.
 template <typename T>
 struct DataBufferTraits
@@ -157,13 +168,34 @@ struct TableCounters
     uint64_t incremental_updates = 0;
     uint64_t full_rebuilds = 0;
 
+    // Histograms of the number of requests that were coalesced into one
+    // RocksDB write (multiset) / MultiGet (multiget), cf. RocksBatcher:
+    // bucket i counts batches of 2^i up to 2^(i + 1) - 1 requests, the last
+    // bucket all bigger ones. The table's own ones count each of its requests
+    // once, the global ones each batch (of any table) on the server; the
+    // latter are not reset.
+    static constexpr size_t batch_size_buckets = 8;
+
+    std::vector<uint64_t> multiset_batch_sizes;
+    std::vector<uint64_t> multiget_batch_sizes;
+    std::vector<uint64_t> global_multiset_batch_sizes;
+    std::vector<uint64_t> global_multiget_batch_sizes;
+
+    static void
+    record_batch_size(std::vector<uint64_t>& histogram,
+                      size_t requests);
+
     bool
     operator==(const TableCounters& other) const
     {
         return
             total_tlogs_read == other.total_tlogs_read and
             incremental_updates == other.incremental_updates and
-            full_rebuilds == other.full_rebuilds;
+            full_rebuilds == other.full_rebuilds and
+            multiset_batch_sizes == other.multiset_batch_sizes and
+            multiget_batch_sizes == other.multiget_batch_sizes and
+            global_multiset_batch_sizes == other.global_multiset_batch_sizes and
+            global_multiget_batch_sizes == other.global_multiget_batch_sizes;
     }
 
     bool
@@ -183,6 +215,21 @@ enum class Role
     Slave
 };
 
+// An update pushed from a master table to its slaves: the records of one
+// multiset (copied, as they're sent off asynchronously), numbered consecutively
+// within a stream. A master starts a new stream whenever it (re)assumes its
+// role or gets a new set of slaves.
+struct ReplicationUpdate
+{
+    std::string stream;
+    uint64_t seq = 0;
+    // the cork of the master table once the records are applied (empty if none)
+    std::string cork;
+    Barrier barrier = Barrier::F;
+    // boost::none deletes the key
+    std::vector<std::pair<std::string, boost::optional<std::string>>> records;
+};
+
 // A table represents a namespace within a database.
 //
 // This is modelled after RocksDB's API, which returns values as `std::string's.
@@ -245,6 +292,29 @@ public:
     virtual TableCounters
     get_counters(volumedriver::Reset) = 0;
 
+    using NodeConfigs = std::vector<volumedriver::MDSNodeConfig>;
+
+    // Master: the slaves to push updates to, replacing the previous ones.
+    virtual void
+    set_slaves(const NodeConfigs&) = 0;
+
+    // Slave: apply an update pushed by the master. Returns false if the update
+    // was not applied (yet) as the slave lost track of the stream and needs to
+    // catch up with the backend first.
+    virtual bool
+    replicate(const ReplicationUpdate&) = 0;
+
+    // The table is about to be rebuilt from scratch. Implementations may
+    // buffer the records written until end_bulk_load() (they still need to be
+    // visible to multiget) and persist them in a cheaper way.
+    virtual void
+    begin_bulk_load()
+    {}
+
+    virtual void
+    end_bulk_load()
+    {}
+
 private:
     Role role_ = Role::Slave;
 };
@@ -52,6 +52,8 @@ req_hdr_reminder(RequestHeader::Type t)
         C(ApplyRelocationLogs);
         C(CatchUp);
         C(GetTableCounters);
+        C(SetSlaves);
+        C(Replicate);
         // If the compiler yells at you that you've forgotten dealing with an enum
         // value chances are that it's also missing from the translations map below.
         // If so add it RIGHT NOW.
@@ -107,6 +109,8 @@ operator<<(std::ostream& os,
         P(ApplyRelocationLogs),
         P(CatchUp),
         P(GetTableCounters),
+        P(SetSlaves),
+        P(Replicate),
     };
 
 #undef P
@@ -70,6 +70,8 @@ struct RequestHeader
         ApplyRelocationLogs = 9,
         CatchUp = 10,
         GetTableCounters = 11,
+        SetSlaves = 12,
+        Replicate = 13,
     };
 
     RequestHeader() = default;
@@ -190,6 +192,8 @@ MAKE_REQUEST(Ping);
 MAKE_REQUEST(ApplyRelocationLogs);
 MAKE_REQUEST(CatchUp);
 MAKE_REQUEST(GetTableCounters);
+MAKE_REQUEST(SetSlaves);
+MAKE_REQUEST(Replicate);
 
 #undef MAKE_REQUEST
 
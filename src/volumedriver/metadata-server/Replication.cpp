@@ -0,0 +1,514 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "ClientNG.h"
+#include "Replication.h"
+
+#include "../MDSNodeConfig.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/UUID.h>
+
+namespace metadata_server
+{
+
+namespace vd = volumedriver;
+namespace yt = youtils;
+
+#define LOCK()                                          \
+    boost::lock_guard<decltype(lock_)> lg__(lock_)
+
+namespace
+{
+
+// Slaves that don't respond within that time are considered gone for the
+// updates at hand.
+const std::chrono::seconds send_timeout(10);
+
+// How long to leave a slave alone after failing to push an update to it.
+const boost::chrono::seconds retry_interval(5);
+
+bool
+sets_cork(const ReplicationUpdate& update)
+{
+    for (const auto& r : update.records)
+    {
+        if (r.first == cork_key)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string
+table_cork(TableInterface& table)
+{
+    const TableInterface::Keys keys{ Key(cork_key) };
+    const TableInterface::MaybeStrings cork(table.multiget(keys));
+    return cork[0] ? *cork[0] : std::string();
+}
+
+void
+apply_update(const ReplicationUpdate& update,
+             TableInterface& table)
+{
+    TableInterface::Records records;
+    records.reserve(update.records.size());
+
+    for (const auto& r : update.records)
+    {
+        if (r.second)
+        {
+            records.emplace_back(Record(Key(r.first),
+                                        Value(*r.second)));
+        }
+        else
+        {
+            records.emplace_back(Record(Key(r.first),
+                                        Value(None())));
+        }
+    }
+
+    table.multiset(records,
+                   update.barrier);
+}
+
+}
+
+// One per slave, so a slow or dead slave does not hold up the others.
+struct ReplicationStream::Sender
+{
+    const std::string nspace;
+    const vd::MDSNodeConfig config;
+    const size_t max_queued;
+
+    boost::mutex lock;
+    boost::condition_variable cond;
+    std::deque<UpdatePtr> queue;
+    bool stop = false;
+
+    TableInterfacePtr table;
+
+    boost::thread thread;
+
+    Sender(const std::string& ns,
+           const vd::MDSNodeConfig& cfg,
+           size_t max)
+        : nspace(ns)
+        , config(cfg)
+        , max_queued(max)
+        , thread([this]
+                 {
+                     run();
+                 })
+    {}
+
+    ~Sender()
+    {
+        {
+            boost::lock_guard<decltype(lock)> g(lock);
+            stop = true;
+        }
+
+        cond.notify_one();
+        thread.join();
+    }
+
+    Sender(const Sender&) = delete;
+
+    Sender&
+    operator=(const Sender&) = delete;
+
+    void
+    push(UpdatePtr update)
+    {
+        boost::lock_guard<decltype(lock)> g(lock);
+
+        if (queue.size() >= max_queued)
+        {
+            LOG_WARN(nspace << ": " << config <<
+                     " does not keep up, dropping " << queue.size() <<
+                     " queued updates - it will have to catch up from the backend");
+            queue.clear();
+        }
+
+        queue.emplace_back(std::move(update));
+        cond.notify_one();
+    }
+
+    void
+    run()
+    {
+        boost::unique_lock<decltype(lock)> u(lock);
+
+        while (true)
+        {
+            cond.wait(u,
+                      [&]
+                      {
+                          return stop or not queue.empty();
+                      });
+
+            if (stop)
+            {
+                return;
+            }
+
+            UpdatePtr update(std::move(queue.front()));
+            queue.pop_front();
+
+            u.unlock();
+            const bool ok = send(*update);
+            u.lock();
+
+            if (not ok)
+            {
+                // the slave will notice the gap
+                queue.clear();
+                cond.wait_for(u,
+                              retry_interval,
+                              [&]
+                              {
+                                  return stop;
+                              });
+            }
+        }
+    }
+
+    bool
+    send(const ReplicationUpdate& update)
+    {
+        try
+        {
+            if (table == nullptr)
+            {
+                table = ClientNG::create(config,
+                                         0,
+                                         send_timeout)->open(nspace);
+            }
+
+            table->replicate(update);
+            return true;
+        }
+        CATCH_STD_ALL_EWHAT({
+                LOG_ERROR(nspace << ": failed to push update " << update.seq <<
+                          " to " << config << ": " << EWHAT);
+                table = nullptr;
+            });
+
+        return false;
+    }
+};
+
+ReplicationStream::ReplicationStream(const std::string& nspace,
+                                     const TableInterface::NodeConfigs& slaves,
+                                     const boost::optional<std::string>& cork,
+                                     size_t max_queued)
+    : nspace_(nspace)
+    , id_(yt::UUID().str())
+    , max_queued_(max_queued)
+    , seq_(0)
+    , cork_(cork ? *cork : std::string())
+{
+    VERIFY(max_queued_ > 0);
+
+    LOG_INFO(nspace_ << ": starting replication stream " << id_ <<
+             " at cork " << cork_ << " to " << slaves.size() << " slave(s)");
+
+    senders_.reserve(slaves.size());
+
+    for (const auto& s : slaves)
+    {
+        LOG_INFO(nspace_ << ": slave " << s);
+        senders_.emplace_back(std::make_unique<Sender>(nspace_,
+                                                       s,
+                                                       max_queued_));
+    }
+
+    auto start(std::make_shared<ReplicationUpdate>());
+    start->stream = id_;
+    start->seq = seq_++;
+    start->cork = cork_;
+
+    send_(start);
+}
+
+ReplicationStream::~ReplicationStream()
+{
+    LOG_INFO(nspace_ << ": stopping replication stream " << id_ <<
+             " after " << seq_ << " updates");
+}
+
+void
+ReplicationStream::push(const TableInterface::Records& records,
+                        Barrier barrier)
+{
+    if (senders_.empty())
+    {
+        return;
+    }
+
+    auto update(std::make_shared<ReplicationUpdate>());
+    update->stream = id_;
+    update->seq = seq_++;
+    update->barrier = barrier;
+    update->records.reserve(records.size());
+
+    for (const auto& r : records)
+    {
+        std::string key(static_cast<const char*>(r.key.data),
+                        r.key.size);
+
+        boost::optional<std::string> val;
+        if (r.val.data != nullptr)
+        {
+            val = std::string(static_cast<const char*>(r.val.data),
+                              r.val.size);
+            if (key == cork_key)
+            {
+                cork_ = *val;
+            }
+        }
+
+        update->records.emplace_back(std::move(key),
+                                     std::move(val));
+    }
+
+    update->cork = cork_;
+
+    send_(update);
+}
+
+void
+ReplicationStream::send_(UpdatePtr update)
+{
+    for (auto& s : senders_)
+    {
+        s->push(update);
+    }
+}
+
+ReplicationSink::ReplicationSink(const std::string& nspace,
+                                 size_t max_backlog)
+    : nspace_(nspace)
+    , max_backlog_(max_backlog)
+    , active_(false)
+    , backlog_records_(0)
+{}
+
+bool
+ReplicationSink::apply(const ReplicationUpdate& update,
+                       TableInterface& table)
+{
+    LOCK();
+
+    if (next_ and
+        update.seq == *next_ and
+        update.stream == stream_)
+    {
+        apply_update(update,
+                     table);
+        next_ = update.seq + 1;
+        active_ = true;
+        return true;
+    }
+
+    if (next_)
+    {
+        LOG_WARN(nspace_ << ": expected update " << *next_ << " of stream " <<
+                 stream_ << ", got " << update.seq << " of stream " <<
+                 update.stream << " - falling back to the backend");
+        lose_track_();
+    }
+
+    if (update.seq == 0 and
+        update.records.empty() and
+        update.cork == table_cork(table))
+    {
+        LOG_INFO(nspace_ << ": following replication stream " << update.stream <<
+                 " from cork " << update.cork);
+
+        stream_ = update.stream;
+        next_ = 1;
+        active_ = true;
+
+        backlog_.clear();
+        backlog_records_ = 0;
+
+        return true;
+    }
+
+    add_to_backlog_(update);
+    return false;
+}
+
+void
+ReplicationSink::defer(const ReplicationUpdate& update)
+{
+    LOCK();
+
+    if (next_)
+    {
+        LOG_INFO(nspace_ << ": table is being rebuilt, no longer following replication stream " <<
+                 stream_);
+        lose_track_();
+    }
+
+    add_to_backlog_(update);
+}
+
+void
+ReplicationSink::add_to_backlog_(const ReplicationUpdate& update)
+{
+    if (not backlog_.empty())
+    {
+        const ReplicationUpdate& last = backlog_.back();
+        if (update.seq != last.seq + 1 or
+            update.stream != last.stream)
+        {
+            LOG_INFO(nspace_ << ": gap in the replication backlog, dropping it");
+            backlog_.clear();
+            backlog_records_ = 0;
+        }
+    }
+
+    // The backlog needs to start at a cork the backend can get us to.
+    if (backlog_.empty() and not sets_cork(update))
+    {
+        return;
+    }
+
+    backlog_.push_back(update);
+    backlog_records_ += update.records.size();
+
+    trim_backlog_();
+}
+
+void
+ReplicationSink::trim_backlog_()
+{
+    while (backlog_records_ > max_backlog_ and not backlog_.empty())
+    {
+        do
+        {
+            backlog_records_ -= backlog_.front().records.size();
+            backlog_.pop_front();
+        }
+        while (not backlog_.empty() and not sets_cork(backlog_.front()));
+    }
+}
+
+void
+ReplicationSink::resync(const boost::optional<std::string>& cork,
+                        TableInterface& table)
+{
+    LOCK();
+
+    if (next_ or cork == boost::none)
+    {
+        return;
+    }
+
+    auto rit = std::find_if(backlog_.rbegin(),
+                            backlog_.rend(),
+                            [&](const ReplicationUpdate& u)
+                            {
+                                return u.cork == *cork and sets_cork(u);
+                            });
+
+    if (rit == backlog_.rend())
+    {
+        LOG_INFO(nspace_ << ": backend is at cork " << *cork <<
+                 " which is not in the backlog of " << backlog_.size() <<
+                 " updates - cannot pick up the replication stream yet");
+        return;
+    }
+
+    backlog_.erase(backlog_.begin(),
+                   std::prev(rit.base()));
+
+    try
+    {
+        for (const auto& u : backlog_)
+        {
+            apply_update(u,
+                         table);
+        }
+    }
+    CATCH_STD_ALL_EWHAT({
+            LOG_ERROR(nspace_ << ": failed to apply the replication backlog: " <<
+                      EWHAT);
+            backlog_.clear();
+            backlog_records_ = 0;
+            throw;
+        });
+
+    stream_ = backlog_.back().stream;
+    next_ = backlog_.back().seq + 1;
+    active_ = true;
+
+    LOG_INFO(nspace_ << ": picked up replication stream " << stream_ <<
+             " at cork " << *cork << ", applied " << backlog_.size() <<
+             " updates from the backlog");
+
+    backlog_.clear();
+    backlog_records_ = 0;
+}
+
+void
+ReplicationSink::reset()
+{
+    LOCK();
+
+    if (next_)
+    {
+        LOG_INFO(nspace_ << ": no longer following replication stream " << stream_);
+    }
+
+    lose_track_();
+}
+
+void
+ReplicationSink::lose_track_()
+{
+    next_ = boost::none;
+    stream_.clear();
+    active_ = false;
+}
+
+bool
+ReplicationSink::current()
+{
+    LOCK();
+
+    const bool res = next_ != boost::none and active_;
+    active_ = false;
+    return res;
+}
+
+bool
+ReplicationSink::in_sync() const
+{
+    LOCK();
+    return next_ != boost::none;
+}
+
+}
@@ -0,0 +1,167 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef META_DATA_SERVER_REPLICATION_H_
+#define META_DATA_SERVER_REPLICATION_H_
+
+#include "Interface.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <youtils/Logging.h>
+
+namespace metadata_server
+{
+
+// Replication of master table updates to the slaves:
+// * the master pushes the records of each multiset to all registered slaves
+//   (ReplicationStream), off the multiset path
+// * slaves apply them if they're next in line (ReplicationSink); so as long as
+//   the stream is intact a slave does not have to poll the backend.
+// * a stream starts with an empty update carrying the master's cork; slaves
+//   that are at the same cork follow the stream right away (a master table is
+//   only updated while uncorking, right before the next cork is set).
+// * if a slave misses an update (restart on either side, network trouble, a
+//   master overwhelmed by a slow slave) it falls back to catching up with the
+//   backend (Table::work_) and keeps the updates since the last cork(s) in a
+//   backlog; once the catch up brought it to one of these corks the backlog is
+//   applied and the slave is back in sync.
+//
+// Since a master only sets the cork after the TLog made it to the backend,
+// everything that precedes a cork in the stream can also be found on the
+// backend.
+
+// Master side.
+class ReplicationStream
+{
+public:
+    ReplicationStream(const std::string& nspace,
+                      const TableInterface::NodeConfigs& slaves,
+                      const boost::optional<std::string>& cork,
+                      size_t max_queued = 1024);
+
+    ~ReplicationStream();
+
+    ReplicationStream(const ReplicationStream&) = delete;
+
+    ReplicationStream&
+    operator=(const ReplicationStream&) = delete;
+
+    // Callers need to serialize push()es with the updates of the table.
+    void
+    push(const TableInterface::Records&,
+         Barrier);
+
+    const std::string&
+    id() const
+    {
+        return id_;
+    }
+
+private:
+    DECLARE_LOGGER("MetaDataServerReplicationStream");
+
+    using UpdatePtr = std::shared_ptr<const ReplicationUpdate>;
+
+    struct Sender;
+
+    void
+    send_(UpdatePtr);
+
+    const std::string nspace_;
+    const std::string id_;
+    const size_t max_queued_;
+    uint64_t seq_;
+    std::string cork_;
+    std::vector<std::unique_ptr<Sender>> senders_;
+};
+
+// Slave side.
+class ReplicationSink
+{
+public:
+    explicit ReplicationSink(const std::string& nspace,
+                             size_t max_backlog = 64ULL << 10);
+
+    ~ReplicationSink() = default;
+
+    ReplicationSink(const ReplicationSink&) = delete;
+
+    ReplicationSink&
+    operator=(const ReplicationSink&) = delete;
+
+    // Applies the update to the table if it's the next one in the stream, puts
+    // it into the backlog otherwise.
+    bool
+    apply(const ReplicationUpdate&,
+          TableInterface&);
+
+    // The table is being rebuilt from the backend: the update cannot be applied
+    // now, only put into the backlog for resync().
+    void
+    defer(const ReplicationUpdate&);
+
+    // The table was brought to `cork' by catching up with the backend: try to
+    // pick up the stream again from the backlog.
+    void
+    resync(const boost::optional<std::string>& cork,
+           TableInterface&);
+
+    // The table was modified behind the stream's back.
+    void
+    reset();
+
+    // In sync and updates were received since the last invocation.
+    bool
+    current();
+
+    bool
+    in_sync() const;
+
+private:
+    DECLARE_LOGGER("MetaDataServerReplicationSink");
+
+    mutable boost::mutex lock_;
+    const std::string nspace_;
+    const size_t max_backlog_;
+
+    std::string stream_;
+    boost::optional<uint64_t> next_;
+    bool active_;
+
+    // starts with an update that sets the cork
+    std::deque<ReplicationUpdate> backlog_;
+    size_t backlog_records_;
+
+    void
+    lose_track_();
+
+    void
+    add_to_backlog_(const ReplicationUpdate&);
+
+    void
+    trim_backlog_();
+};
+
+}
+
+#endif // !META_DATA_SERVER_REPLICATION_H_
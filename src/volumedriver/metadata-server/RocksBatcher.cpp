@@ -0,0 +1,283 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "RocksBatcher.h"
+#include "RocksTable.h"
+
+#include <rocksdb/slice.h>
+#include <rocksdb/status.h>
+#include <rocksdb/write_batch.h>
+
+#include <youtils/Assert.h>
+
+namespace metadata_server
+{
+
+namespace rdb = rocksdb;
+
+#define LOCK()                                          \
+    boost::unique_lock<decltype(lock_)> ulg__(lock_)
+
+#define HANDLE(s) if (not s.ok())                                       \
+    {                                                                   \
+        LOG_ERROR("quoth rocksdb: " << s.ToString());                   \
+        throw RocksDataBaseException(s.ToString().c_str(),              \
+                                     __FUNCTION__);                     \
+    }
+
+namespace
+{
+
+template<typename T>
+rdb::Slice
+item_to_slice(const T& t)
+{
+    return rdb::Slice(static_cast<const char*>(t.data),
+                      t.size);
+}
+
+}
+
+RocksBatcher::RocksBatcher(std::shared_ptr<rdb::DB> db,
+                           const rdb::ReadOptions& read_options,
+                           const rdb::WriteOptions& write_options)
+    : db_(std::move(db))
+    , read_options_(read_options)
+    , write_options_(write_options)
+{
+    VERIFY(db_ != nullptr);
+}
+
+size_t
+RocksBatcher::multiset(rdb::ColumnFamilyHandle& cf,
+                       const TableInterface::Records& records,
+                       Barrier barrier)
+{
+    // The records of our batch peers (if any) end up behind the flush just
+    // as they would without batching if they raced with us.
+    if (barrier == Barrier::T)
+    {
+        HANDLE(db_->Flush(rdb::FlushOptions(),
+                          &cf));
+    }
+
+    SetRequest req(cf,
+                   records);
+
+    return run_(set_queue_,
+                req,
+                [&](const std::vector<SetRequest*>& batch)
+                {
+                    submit_sets_(batch);
+                });
+}
+
+size_t
+RocksBatcher::multiget(rdb::ColumnFamilyHandle& cf,
+                       const TableInterface::Keys& keys,
+                       TableInterface::MaybeStrings& vals)
+{
+    GetRequest req(cf,
+                   keys,
+                   vals);
+
+    return run_(get_queue_,
+                req,
+                [&](const std::vector<GetRequest*>& batch)
+                {
+                    submit_gets_(batch);
+                });
+}
+
+template<typename R,
+         typename SubmitFun>
+size_t
+RocksBatcher::run_(Queue<R>& queue,
+                   R& req,
+                   SubmitFun&& submit)
+{
+    LOCK();
+
+    queue.pending.push_back(&req);
+
+    while (true)
+    {
+        cond_.wait(ulg__,
+                   [&]
+                   {
+                       return req.done or not queue.busy;
+                   });
+
+        if (req.done)
+        {
+            break;
+        }
+
+        // Our turn to lead - the batch is everything that's queued,
+        // including our own request.
+        queue.busy = true;
+
+        const std::vector<R*> batch(queue.pending.begin(),
+                                    queue.pending.end());
+        queue.pending.clear();
+        VERIFY(not batch.empty());
+
+        std::exception_ptr error;
+
+        ulg__.unlock();
+
+        try
+        {
+            submit(batch);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        ulg__.lock();
+
+        TableCounters::record_batch_size(queue.batch_sizes,
+                                         batch.size());
+
+        for (R* r : batch)
+        {
+            r->done = true;
+            r->batch_size = batch.size();
+            if (error)
+            {
+                r->error = error;
+            }
+        }
+
+        queue.busy = false;
+        cond_.notify_all();
+    }
+
+    if (req.error)
+    {
+        std::rethrow_exception(req.error);
+    }
+
+    return req.batch_size;
+}
+
+void
+RocksBatcher::submit_sets_(const std::vector<SetRequest*>& reqs)
+{
+    rdb::WriteBatch batch;
+
+    for (const SetRequest* r : reqs)
+    {
+        for (const auto& rec : r->records)
+        {
+            if (rec.val.data == nullptr)
+            {
+                batch.Delete(&r->column_family,
+                             item_to_slice(rec.key));
+            }
+            else
+            {
+                batch.Put(&r->column_family,
+                          item_to_slice(rec.key),
+                          item_to_slice(rec.val));
+            }
+        }
+    }
+
+    HANDLE(db_->Write(write_options_,
+                      &batch));
+}
+
+// Errors are reported per request, a failing key only fails its own request.
+void
+RocksBatcher::submit_gets_(const std::vector<GetRequest*>& reqs)
+{
+    size_t nkeys = 0;
+    for (const GetRequest* r : reqs)
+    {
+        nkeys += r->keys.size();
+    }
+
+    std::vector<rdb::ColumnFamilyHandle*> handles;
+    handles.reserve(nkeys);
+
+    std::vector<rdb::Slice> keyv;
+    keyv.reserve(nkeys);
+
+    for (const GetRequest* r : reqs)
+    {
+        for (const auto& k : r->keys)
+        {
+            handles.push_back(&r->column_family);
+            keyv.emplace_back(item_to_slice(k));
+        }
+    }
+
+    std::vector<std::string> valv;
+
+    const std::vector<rdb::Status> statv(db_->MultiGet(read_options_,
+                                                       handles,
+                                                       keyv,
+                                                       &valv));
+
+    VERIFY(statv.size() == keyv.size());
+    VERIFY(keyv.size() == valv.size());
+
+    size_t idx = 0;
+
+    for (GetRequest* r : reqs)
+    {
+        r->vals.clear();
+        r->vals.reserve(r->keys.size());
+
+        for (size_t i = 0; i < r->keys.size(); ++i, ++idx)
+        {
+            switch (statv[idx].code())
+            {
+            case rdb::Status::kOk:
+                r->vals.emplace_back(std::move(valv[idx]));
+                break;
+            case rdb::Status::kNotFound:
+                r->vals.emplace_back(boost::none);
+                break;
+            default:
+                if (not r->error)
+                {
+                    try
+                    {
+                        HANDLE(statv[idx]);
+                    }
+                    catch (...)
+                    {
+                        r->error = std::current_exception();
+                    }
+                }
+                r->vals.emplace_back(boost::none);
+            }
+        }
+    }
+}
+
+void
+RocksBatcher::get_counters(TableCounters& counters) const
+{
+    LOCK();
+
+    counters.global_multiset_batch_sizes = set_queue_.batch_sizes;
+    counters.global_multiget_batch_sizes = get_queue_.batch_sizes;
+}
+
+}
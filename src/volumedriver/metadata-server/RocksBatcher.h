@@ -0,0 +1,155 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#ifndef META_DATA_SERVER_ROCKS_BATCHER_H_
+#define META_DATA_SERVER_ROCKS_BATCHER_H_
+
+#include "Interface.h"
+
+#include <deque>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+
+#include <youtils/Logging.h>
+
+namespace metadata_server
+{
+
+// Coalesces the multisets / multigets the ServerNG threads issue concurrently
+// against the tables (column families) of one RocksDB instance: the first
+// caller that does not find a batch in flight becomes the leader, takes all
+// queued requests, submits them as one WriteBatch (and hence one WAL sync)
+// or one MultiGet respectively and hands out the results. Requests arriving
+// in the mean time queue up for the next batch. The number of queued requests
+// is bounded by the number of server threads.
+// Barriers (memtable flushes) are not part of the batches: they're synchronous
+// and potentially slow, so the requesting thread does them before queueing its
+// records instead of holding up everyone else in the batch.
+//
+// Callers need to keep their ColumnFamilyHandle alive until their call returns
+// (cf. RocksTable's rwlock_).
+class RocksBatcher
+{
+public:
+    RocksBatcher(std::shared_ptr<rocksdb::DB>,
+                 const rocksdb::ReadOptions&,
+                 const rocksdb::WriteOptions&);
+
+    ~RocksBatcher() = default;
+
+    RocksBatcher(const RocksBatcher&) = delete;
+
+    RocksBatcher&
+    operator=(const RocksBatcher&) = delete;
+
+    // Both return the number of requests of the batch the request went into.
+    size_t
+    multiset(rocksdb::ColumnFamilyHandle&,
+             const TableInterface::Records&,
+             Barrier);
+
+    size_t
+    multiget(rocksdb::ColumnFamilyHandle&,
+             const TableInterface::Keys&,
+             TableInterface::MaybeStrings&);
+
+    // Fills in the global_* histograms.
+    void
+    get_counters(TableCounters&) const;
+
+private:
+    DECLARE_LOGGER("MetaDataServerRocksBatcher");
+
+    struct Request
+    {
+        rocksdb::ColumnFamilyHandle& column_family;
+        bool done = false;
+        size_t batch_size = 0;
+        std::exception_ptr error;
+
+        explicit Request(rocksdb::ColumnFamilyHandle& cf)
+            : column_family(cf)
+        {}
+    };
+
+    struct SetRequest
+        : public Request
+    {
+        const TableInterface::Records& records;
+
+        SetRequest(rocksdb::ColumnFamilyHandle& cf,
+                   const TableInterface::Records& recs)
+            : Request(cf)
+            , records(recs)
+        {}
+    };
+
+    struct GetRequest
+        : public Request
+    {
+        const TableInterface::Keys& keys;
+        TableInterface::MaybeStrings& vals;
+
+        GetRequest(rocksdb::ColumnFamilyHandle& cf,
+                   const TableInterface::Keys& ks,
+                   TableInterface::MaybeStrings& vs)
+            : Request(cf)
+            , keys(ks)
+            , vals(vs)
+        {}
+    };
+
+    template<typename R>
+    struct Queue
+    {
+        std::deque<R*> pending;
+        bool busy = false;
+        std::vector<uint64_t> batch_sizes;
+    };
+
+    std::shared_ptr<rocksdb::DB> db_;
+    const rocksdb::ReadOptions read_options_;
+    const rocksdb::WriteOptions write_options_;
+
+    // protects the queues; the batches are submitted without holding it
+    mutable boost::mutex lock_;
+    boost::condition_variable cond_;
+    Queue<SetRequest> set_queue_;
+    Queue<GetRequest> get_queue_;
+
+    template<typename R,
+             typename SubmitFun>
+    size_t
+    run_(Queue<R>&,
+         R&,
+         SubmitFun&&);
+
+    void
+    submit_sets_(const std::vector<SetRequest*>&);
+
+    void
+    submit_gets_(const std::vector<GetRequest*>&);
+};
+
+}
+
+#endif // !META_DATA_SERVER_ROCKS_BATCHER_H_
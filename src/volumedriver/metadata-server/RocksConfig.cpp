@@ -18,6 +18,10 @@
 #include <boost/bimap.hpp>
 #include <boost/optional/optional_io.hpp>
 
+#include <rocksdb/cache.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/table.h>
+
 #include <youtils/RocksLogger.h>
 #include <youtils/StreamUtils.h>
 
@@ -27,6 +31,13 @@ namespace metadata_server
 namespace rdb = rocksdb;
 namespace yt = youtils;
 
+namespace
+{
+
+// OptimizeForPointLookup's default
+const int default_bloom_filter_bits_per_key = 10;
+
+}
 
 bool
 RocksConfig::operator==(const RocksConfig& other) const
@@ -48,7 +59,12 @@ RocksConfig::operator==(const RocksConfig& other) const
         C(level0_stop_writes_trigger) and
         C(target_file_size_base) and
         C(max_bytes_for_level_base) and
-        C(compaction_style);
+        C(compaction_style) and
+        C(shared_block_cache) and
+        C(bloom_filter_bits_per_key) and
+        C(pin_l0_filter_and_index_blocks) and
+        C(direct_io_for_compaction) and
+        C(bulk_load_buffer_size);
 
 #undef C
 }
@@ -68,12 +84,31 @@ RocksConfig::db_options(const std::string& id) const
     opts.paranoid_checks = false;
     opts.create_if_missing = true;
     opts.info_log = std::make_shared<yt::RocksLogger>(id);
+    // aka use_direct_io_for_flush_and_compaction in later RocksDB versions
+    opts.use_direct_writes = direct_io_for_compaction ?
+        *direct_io_for_compaction == DirectIOForCompaction::T :
+        false;
     return opts;
 
 }
 
+std::shared_ptr<rdb::Cache>
+RocksConfig::make_shared_block_cache() const
+{
+    if (shared_block_cache and *shared_block_cache == SharedBlockCache::T)
+    {
+        return rdb::NewLRUCache(read_cache_size ?
+                                read_cache_size->t :
+                                4ULL << 20);
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
 rdb::ColumnFamilyOptions
-RocksConfig::column_family_options() const
+RocksConfig::column_family_options(const std::shared_ptr<rdb::Cache>& block_cache) const
 {
     rdb::ColumnFamilyOptions opts;
 
@@ -84,6 +119,34 @@ RocksConfig::column_family_options() const
                                 read_cache_size->t >> 20 :
                                 4);
 
+    // OptimizeForPointLookup sets up a table factory with its own block cache
+    // and a fixed bloom filter - replace it with one that takes our options
+    // into account.
+    rdb::BlockBasedTableOptions table_opts;
+    table_opts.index_type = rdb::BlockBasedTableOptions::kHashSearch;
+    table_opts.block_cache = block_cache ?
+        block_cache :
+        rdb::NewLRUCache(read_cache_size ?
+                         read_cache_size->t :
+                         4ULL << 20);
+
+    const int bloom_bits = bloom_filter_bits_per_key ?
+        *bloom_filter_bits_per_key :
+        default_bloom_filter_bits_per_key;
+    if (bloom_bits > 0)
+    {
+        table_opts.filter_policy.reset(rdb::NewBloomFilterPolicy(bloom_bits));
+    }
+
+    if (pin_l0_filter_and_index_blocks and
+        *pin_l0_filter_and_index_blocks == PinL0FilterAndIndexBlocks::T)
+    {
+        table_opts.cache_index_and_filter_blocks = true;
+        table_opts.pin_l0_filter_and_index_blocks_in_cache = true;
+    }
+
+    opts.table_factory.reset(rdb::NewBlockBasedTableFactory(table_opts));
+
     if (write_cache_size)
     {
         opts.write_buffer_size = write_cache_size->t >> 20; // default: 4 MiB
@@ -225,6 +288,11 @@ operator<<(std::ostream& os,
         ",target_file_size_base=" << cfg.target_file_size_base <<
         ",max_bytes_for_level_base=" << cfg.max_bytes_for_level_base <<
         ",compaction_style=" << cfg.compaction_style <<
+        ",shared_block_cache=" << cfg.shared_block_cache <<
+        ",bloom_filter_bits_per_key=" << cfg.bloom_filter_bits_per_key <<
+        ",pin_l0_filter_and_index_blocks=" << cfg.pin_l0_filter_and_index_blocks <<
+        ",direct_io_for_compaction=" << cfg.direct_io_for_compaction <<
+        ",bulk_load_buffer_size=" << cfg.bulk_load_buffer_size <<
         "}";
 }
 
@@ -16,10 +16,17 @@
 #ifndef MDS_ROCKS_CONFIG_H_
 #define MDS_ROCKS_CONFIG_H_
 
+#include <memory>
+
 #include <boost/optional.hpp>
 
 #include <rocksdb/options.h>
 
+namespace rocksdb
+{
+class Cache;
+}
+
 #include <youtils/BooleanEnum.h>
 #include <youtils/OurStrongTypedef.h>
 
@@ -40,6 +47,9 @@ namespace metadata_server
 
 VD_BOOLEAN_ENUM(EnableWal);
 VD_BOOLEAN_ENUM(DataSync);
+VD_BOOLEAN_ENUM(SharedBlockCache);
+VD_BOOLEAN_ENUM(PinL0FilterAndIndexBlocks);
+VD_BOOLEAN_ENUM(DirectIOForCompaction);
 
 struct RocksConfig
 {
@@ -83,6 +93,20 @@ struct RocksConfig
     // verify_checksums_in_compaction?
     // filter_deletes? we don't do these without TRIM support
 
+    // one block cache (of read_cache_size) for all tables of a DB instead of
+    // one per table
+    boost::optional<SharedBlockCache> shared_block_cache;
+    // on the page key; 0 disables the bloom filter
+    boost::optional<int> bloom_filter_bits_per_key;
+    // keep the index and filter blocks of L0 files in the block cache
+    boost::optional<PinL0FilterAndIndexBlocks> pin_l0_filter_and_index_blocks;
+    // don't let flushes and compactions pollute the page cache
+    boost::optional<DirectIOForCompaction> direct_io_for_compaction;
+    // Tables that are rebuilt from scratch buffer up to that many bytes of
+    // records, which are then written to an SST file and ingested in one go
+    // instead of going through the memtables and WAL. 0 disables this.
+    boost::optional<uint64_t> bulk_load_buffer_size;
+
     RocksConfig() = default;
 
     ~RocksConfig() = default;
@@ -109,8 +133,13 @@ struct RocksConfig
     rocksdb::DBOptions
     db_options(const std::string& id) const;
 
+    // nullptr unless shared_block_cache is set.
+    std::shared_ptr<rocksdb::Cache>
+    make_shared_block_cache() const;
+
+    // A per-table block cache is created if block_cache is nullptr.
     rocksdb::ColumnFamilyOptions
-    column_family_options() const;
+    column_family_options(const std::shared_ptr<rocksdb::Cache>& block_cache = nullptr) const;
 
     rocksdb::ReadOptions
     read_options() const;
@@ -51,6 +51,7 @@ const std::string default_column_family("default");
 RocksDataBase::RocksDataBase(const fs::path& path,
                              const RocksConfig& rocks_config)
     : rocks_config_(rocks_config)
+    , block_cache_(rocks_config_.make_shared_block_cache())
 {
     rdb::DB* db;
 
@@ -102,7 +103,7 @@ RocksDataBase::RocksDataBase(const fs::path& path,
         family_names.push_back(rdb::kDefaultColumnFamilyName);
     }
 
-    const rdb::ColumnFamilyOptions family_opts(rocks_config_.column_family_options());
+    const rdb::ColumnFamilyOptions family_opts(rocks_config_.column_family_options(block_cache_));
 
     std::vector<rdb::ColumnFamilyDescriptor> family_descs;
     family_descs.reserve(family_names.size());
@@ -123,6 +124,9 @@ RocksDataBase::RocksDataBase(const fs::path& path,
                          &db));
 
     db_.reset(db);
+    batcher_ = std::make_shared<RocksBatcher>(db_,
+                                              rocks_config_.read_options(),
+                                              rocks_config_.write_options());
 
     VERIFY(family_handles.size() == family_descs.size());
 
@@ -170,7 +174,7 @@ RocksDataBase::open(const std::string& nspace)
     {
         rdb::ColumnFamilyHandle* h;
 
-        HANDLE(db_->CreateColumnFamily(rocks_config_.column_family_options(),
+        HANDLE(db_->CreateColumnFamily(rocks_config_.column_family_options(block_cache_),
                                        nspace,
                                        &h));
 
@@ -192,7 +196,9 @@ RocksDataBase::make_table_(const std::string& nspace,
     auto table(std::make_shared<RocksTable>(nspace,
                                             db_,
                                             std::move(handle),
-                                            rocks_config_));
+                                            rocks_config_,
+                                            batcher_,
+                                            block_cache_));
 
     const auto r(tables_.insert(std::make_pair(nspace,
                                                table)));
@@ -63,6 +63,10 @@ private:
     std::shared_ptr<rocksdb::DB> db_;
     std::map<std::string, RocksTablePtr> tables_;
     RocksConfig rocks_config_;
+    // shared by all tables if configured, nullptr otherwise
+    std::shared_ptr<rocksdb::Cache> block_cache_;
+    // shared by all tables
+    std::shared_ptr<RocksBatcher> batcher_;
 
     RocksTablePtr
     make_table_(const std::string& nspace,
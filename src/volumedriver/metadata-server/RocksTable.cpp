@@ -16,11 +16,18 @@
 #include "RocksDataBase.h"
 #include "RocksTable.h"
 
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <rocksdb/env.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/status.h>
 #include <rocksdb/write_batch.h>
 
 #include <youtils/Assert.h>
+#include <youtils/Catchers.h>
+#include <youtils/ScopeExit.h>
 
 #include <volumedriver/CachedMetaDataPage.h>
 
@@ -33,7 +40,14 @@ namespace metadata_server
 #define LOCKW()                                 \
     boost::unique_lock<decltype(rwlock_)> wlg__(rwlock_)
 
+#define LOCK_BULK()                             \
+    boost::lock_guard<decltype(bulk_lock_)> blg__(bulk_lock_)
+
+#define LOCK_COUNTERS()                         \
+    boost::lock_guard<decltype(counters_lock_)> clg__(counters_lock_)
+
 namespace be = backend;
+namespace fs = boost::filesystem;
 namespace rdb = rocksdb;
 namespace vd = volumedriver;
 namespace yt = youtils;
@@ -56,19 +70,37 @@ item_to_slice(const T& t)
                       t.size);
 }
 
+template<typename T>
+std::string
+item_to_string(const T& t)
+{
+    return std::string(static_cast<const char*>(t.data),
+                       t.size);
+}
+
 }
 
 RocksTable::RocksTable(const std::string& nspace,
                        std::shared_ptr<rdb::DB>& db,
                        std::unique_ptr<rdb::ColumnFamilyHandle> column_family,
-                       const RocksConfig& rocks_config)
+                       const RocksConfig& rocks_config,
+                       std::shared_ptr<RocksBatcher> batcher,
+                       const std::shared_ptr<rdb::Cache>& block_cache)
     : db_(db)
     , column_family_(std::move(column_family))
-    , column_family_options_(rocks_config.column_family_options())
+    , column_family_options_(rocks_config.column_family_options(block_cache))
     , read_options_(rocks_config.read_options())
     , write_options_(rocks_config.write_options())
     , nspace_(nspace)
+    , batcher_(std::move(batcher))
+    , bulk_load_buffer_size_(rocks_config.bulk_load_buffer_size ?
+                             *rocks_config.bulk_load_buffer_size :
+                             0)
+    , bulk_load_(false)
+    , bulk_bytes_(0)
+    , bulk_files_(0)
 {
+    VERIFY(batcher_ != nullptr);
     LOG_INFO(nspace_ << ": creating table");
 }
 
@@ -85,82 +117,76 @@ void
 RocksTable::multiset(const TableInterface::Records& records,
                      Barrier barrier)
 {
-    rdb::WriteBatch batch;
-
     LOCKR();
 
     ASSERT(column_family_ != nullptr);
 
-    for (const auto& r : records)
     {
-        if (r.val.data == nullptr)
-        {
-            batch.Delete(column_family_.get(),
-                         item_to_slice(r.key));
-        }
-        else
+        LOCK_BULK();
+
+        if (bulk_load_)
         {
-            batch.Put(column_family_.get(),
-                      item_to_slice(r.key),
-                      item_to_slice(r.val));
+            for (const auto& r : records)
+            {
+                const std::string key(item_to_string(r.key));
+                auto& val = bulk_records_[key];
+
+                bulk_bytes_ -= val ? key.size() + val->size() : 0;
+
+                if (r.val.data == nullptr)
+                {
+                    val = boost::none;
+                }
+                else
+                {
+                    val = item_to_string(r.val);
+                    bulk_bytes_ += key.size() + val->size();
+                }
+            }
+
+            if (bulk_bytes_ >= bulk_load_buffer_size_)
+            {
+                ingest_bulk_records_();
+            }
+
+            return;
         }
     }
 
-    if (barrier == Barrier::T)
-    {
-        HANDLE(db_->Flush(rdb::FlushOptions(),
-                          column_family_.get()));
-    }
+    const size_t batch_size = batcher_->multiset(*column_family_,
+                                                 records,
+                                                 barrier);
 
-    HANDLE(db_->Write(write_options_,
-                      &batch));
+    LOCK_COUNTERS();
+    TableCounters::record_batch_size(multiset_batch_sizes_,
+                                     batch_size);
 }
 
 TableInterface::MaybeStrings
 RocksTable::multiget(const TableInterface::Keys& keys)
 {
-    std::vector<rdb::Slice> keyv;
-    keyv.reserve(keys.size());
-
-    for (const auto& k : keys)
-    {
-        keyv.emplace_back(item_to_slice(k));
-    }
-
-    std::vector<std::string> valv;
-
     LOCKR();
 
     ASSERT(column_family_ != nullptr);
-    const std::vector<rdb::ColumnFamilyHandle*> handles(keys.size(),
-                                                        column_family_.get());
-
-    const std::vector<rdb::Status> statv(db_->MultiGet(read_options_,
-                                                       handles,
-                                                       keyv,
-                                                       &valv));
-
-    VERIFY(statv.size() == keyv.size());
-    VERIFY(keyv.size() == valv.size());
-
-    TableInterface::MaybeStrings vals;
-    vals.reserve(statv.size());
 
-    for (size_t i = 0; i < statv.size(); ++i)
     {
-        switch (statv[i].code())
+        LOCK_BULK();
+
+        if (bulk_load_)
         {
-        case rdb::Status::kOk:
-            vals.emplace_back(std::move(valv[i]));
-            break;
-        case rdb::Status::kNotFound:
-            vals.emplace_back(boost::none);
-            break;
-        default:
-            HANDLE(statv[i]);
+            return bulk_multiget_(keys);
         }
     }
 
+    TableInterface::MaybeStrings vals;
+    const size_t batch_size = batcher_->multiget(*column_family_,
+                                                 keys,
+                                                 vals);
+
+    LOCK_COUNTERS();
+    TableCounters::record_batch_size(multiget_batch_sizes_,
+                                     batch_size);
+
     return vals;
 }
 
@@ -180,6 +206,12 @@ RocksTable::clear()
     // ColumnFamilyHandle.
     LOCKW();
 
+    {
+        LOCK_BULK();
+        bulk_records_.clear();
+        bulk_bytes_ = 0;
+    }
+
     HANDLE(db_->DropColumnFamily(column_family_.get()));
 
     // Rather take down the thing by dereferencing a nullptr than continuing with the
@@ -205,9 +237,199 @@ RocksTable::catch_up(vd::DryRun)
 }
 
 TableCounters
-RocksTable::get_counters(vd::Reset)
+RocksTable::get_counters(vd::Reset reset)
 {
-    VERIFY(0 == "RocksTable::get_table_counters shouldn't be invoked");
+    TableCounters c;
+
+    {
+        LOCK_COUNTERS();
+
+        c.multiset_batch_sizes = multiset_batch_sizes_;
+        c.multiget_batch_sizes = multiget_batch_sizes_;
+
+        if (reset == vd::Reset::T)
+        {
+            multiset_batch_sizes_.clear();
+            multiget_batch_sizes_.clear();
+        }
+    }
+
+    batcher_->get_counters(c);
+    return c;
+}
+
+void
+RocksTable::set_slaves(const TableInterface::NodeConfigs&)
+{
+    VERIFY(0 == "RocksTable::set_slaves shouldn't be invoked");
+}
+
+bool
+RocksTable::replicate(const ReplicationUpdate&)
+{
+    VERIFY(0 == "RocksTable::replicate shouldn't be invoked");
+}
+
+void
+RocksTable::begin_bulk_load()
+{
+    LOCKR();
+    LOCK_BULK();
+
+    if (bulk_load_buffer_size_ == 0)
+    {
+        LOG_INFO(nspace_ << ": bulk loading is disabled");
+        return;
+    }
+
+    LOG_INFO(nspace_ << ": starting bulk load, buffer size " <<
+             bulk_load_buffer_size_);
+
+    VERIFY(not bulk_load_);
+    VERIFY(bulk_records_.empty());
+
+    bulk_load_ = true;
+    bulk_bytes_ = 0;
+}
+
+void
+RocksTable::end_bulk_load()
+{
+    LOCKR();
+    LOCK_BULK();
+
+    if (bulk_load_)
+    {
+        ingest_bulk_records_();
+        bulk_load_ = false;
+
+        LOG_INFO(nspace_ << ": finished bulk load, ingested " << bulk_files_ <<
+                 " files so far");
+    }
+}
+
+TableInterface::MaybeStrings
+RocksTable::bulk_multiget_(const TableInterface::Keys& keys)
+{
+    TableInterface::MaybeStrings vals;
+    vals.reserve(keys.size());
+
+    for (const auto& k : keys)
+    {
+        auto it = bulk_records_.find(item_to_string(k));
+        if (it != bulk_records_.end())
+        {
+            vals.emplace_back(it->second);
+            continue;
+        }
+
+        std::string val;
+        const rdb::Status s(db_->Get(read_options_,
+                                     column_family_.get(),
+                                     item_to_slice(k),
+                                     &val));
+        switch (s.code())
+        {
+        case rdb::Status::kOk:
+            vals.emplace_back(std::move(val));
+            break;
+        case rdb::Status::kNotFound:
+            vals.emplace_back(boost::none);
+            break;
+        default:
+            HANDLE(s);
+        }
+    }
+
+    return vals;
+}
+
+// The buffered records are written out sorted (std::string's ordering matches
+// RocksDB's bytewise comparator) to one SST file which is then moved into the
+// DB. Deletions cannot go into the SST file and are applied beforehand - they
+// refer to other keys than the ones in the file, and this way the cork (in the
+// file) only shows up once everything else is in place.
+void
+RocksTable::ingest_bulk_records_()
+{
+    if (bulk_records_.empty())
+    {
+        return;
+    }
+
+    rdb::WriteBatch deletes;
+    size_t puts = 0;
+
+    for (const auto& r : bulk_records_)
+    {
+        if (r.second)
+        {
+            ++puts;
+        }
+        else
+        {
+            deletes.Delete(column_family_.get(),
+                           r.first);
+        }
+    }
+
+    if (deletes.Count() > 0)
+    {
+        HANDLE(db_->Write(write_options_,
+                          &deletes));
+    }
+
+    if (puts > 0)
+    {
+        const fs::path path(fs::path(db_->GetName()) /
+                            (nspace_ + "-bulk-load-" +
+                             boost::lexical_cast<std::string>(bulk_files_) +
+                             ".sst"));
+
+        auto on_exit(yt::make_scope_exit([&]
+                                          {
+                                              try
+                                              {
+                                                  fs::remove(path);
+                                              }
+                                              CATCH_STD_ALL_LOG_IGNORE(nspace_ <<
+                                                                       ": failed to remove " <<
+                                                                       path);
+                                          }));
+
+        rdb::SstFileWriter writer(rdb::EnvOptions(),
+                                  rdb::Options(db_->GetDBOptions(),
+                                               column_family_options_),
+                                  column_family_.get());
+
+        HANDLE(writer.Open(path.string()));
+
+        for (const auto& r : bulk_records_)
+        {
+            if (r.second)
+            {
+                HANDLE(writer.Add(r.first,
+                                  *r.second));
+            }
+        }
+
+        HANDLE(writer.Finish());
+
+        rdb::IngestExternalFileOptions opts;
+        opts.move_files = true;
+
+        HANDLE(db_->IngestExternalFile(column_family_.get(),
+                                       { path.string() },
+                                       opts));
+
+        ++bulk_files_;
+    }
+
+    LOG_INFO(nspace_ << ": bulk loaded " << puts << " records, deleted " <<
+             deletes.Count() << ", " << bulk_bytes_ << " bytes");
+
+    bulk_records_.clear();
+    bulk_bytes_ = 0;
 }
 
 }
@@ -17,10 +17,14 @@
 #define META_DATA_SERVER_ROCKS_TABLE_H_
 
 #include "Interface.h"
+#include "RocksBatcher.h"
 #include "RocksConfig.h"
 
+#include <map>
 #include <memory>
 
+#include <boost/optional.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
 #include <rocksdb/db.h>
@@ -33,6 +37,8 @@
 namespace metadata_server
 {
 
+// multisets and multigets outside of bulk loads go through the RocksBatcher
+// shared by all tables of the RocksDataBase.
 class RocksTable
     : public TableInterface
 {
@@ -40,7 +46,9 @@ public:
     RocksTable(const std::string& nspace,
                std::shared_ptr<rocksdb::DB>&,
                std::unique_ptr<rocksdb::ColumnFamilyHandle>,
-               const RocksConfig&);
+               const RocksConfig&,
+               std::shared_ptr<RocksBatcher>,
+               const std::shared_ptr<rocksdb::Cache>& block_cache = nullptr);
 
     virtual ~RocksTable() = default;
 
@@ -76,8 +84,25 @@ public:
     virtual size_t
     catch_up(volumedriver::DryRun) override final;
 
+    // Only the batch size histograms (the table's own and the global ones).
     virtual TableCounters
     get_counters(volumedriver::Reset) override final;
+
+    virtual void
+    set_slaves(const TableInterface::NodeConfigs&) override final;
+
+    virtual bool
+    replicate(const ReplicationUpdate&) override final;
+
+    // Records are collected in memory and written out as SST files that are
+    // ingested in one go (once more than bulk_load_buffer_size bytes were
+    // collected, and at the end), bypassing memtables, WAL and L0 compactions.
+    virtual void
+    begin_bulk_load() override final;
+
+    virtual void
+    end_bulk_load() override final;
+
 private:
     DECLARE_LOGGER("MetaDataServerRocksTable");
 
@@ -93,6 +118,27 @@ private:
     const rocksdb::ReadOptions read_options_;
     const rocksdb::WriteOptions write_options_;
     const std::string nspace_;
+    std::shared_ptr<RocksBatcher> batcher_;
+
+    // protects the batch size histograms; taken after rwlock_
+    boost::mutex counters_lock_;
+    std::vector<uint64_t> multiset_batch_sizes_;
+    std::vector<uint64_t> multiget_batch_sizes_;
+
+    // cf. begin_bulk_load; taken after rwlock_
+    boost::mutex bulk_lock_;
+    const uint64_t bulk_load_buffer_size_;
+    bool bulk_load_;
+    // boost::none: deleted
+    std::map<std::string, boost::optional<std::string>> bulk_records_;
+    uint64_t bulk_bytes_;
+    uint64_t bulk_files_;
+
+    TableInterface::MaybeStrings
+    bulk_multiget_(const TableInterface::Keys&);
+
+    void
+    ingest_bulk_records_();
 };
 
 typedef std::shared_ptr<RocksTable> RocksTablePtr;
@@ -103,6 +103,11 @@ KEY(level0_stop_writes_trigger_key, "rocksdb_level0_stop_writes_trigger");
 KEY(target_file_size_base_key, "rocksdb_target_file_size_base");
 KEY(max_bytes_for_level_base_key, "rocksdb_max_bytes_for_level_base");
 KEY(compaction_style_key, "rocksdb_compaction_style");
+KEY(shared_block_cache_key, "rocksdb_shared_block_cache");
+KEY(bloom_filter_bits_per_key_key, "rocksdb_bloom_filter_bits_per_key");
+KEY(pin_l0_filter_and_index_blocks_key, "rocksdb_pin_l0_filter_and_index_blocks");
+KEY(direct_io_for_compaction_key, "rocksdb_direct_io_for_compaction");
+KEY(bulk_load_buffer_size_key, "rocksdb_bulk_load_buffer_size");
 
 #undef KEY
 }
@@ -90,6 +90,11 @@ struct PropertyTreeVectorAccessor<metadata_server::ServerConfig>
     static const std::string target_file_size_base_key;
     static const std::string max_bytes_for_level_base_key;
     static const std::string compaction_style_key;
+    static const std::string shared_block_cache_key;
+    static const std::string bloom_filter_bits_per_key_key;
+    static const std::string pin_l0_filter_and_index_blocks_key;
+    static const std::string direct_io_for_compaction_key;
+    static const std::string bulk_load_buffer_size_key;
 
     static Type
     get(const boost::property_tree::ptree& pt)
@@ -125,6 +130,16 @@ struct PropertyTreeVectorAccessor<metadata_server::ServerConfig>
             pt.get_optional<uint64_t>(max_bytes_for_level_base_key);
         rcfg.compaction_style =
             pt.get_optional<RocksConfig::CompactionStyle>(compaction_style_key);
+        rcfg.shared_block_cache =
+            pt.get_optional<SharedBlockCache>(shared_block_cache_key);
+        rcfg.bloom_filter_bits_per_key =
+            pt.get_optional<int>(bloom_filter_bits_per_key_key);
+        rcfg.pin_l0_filter_and_index_blocks =
+            pt.get_optional<PinL0FilterAndIndexBlocks>(pin_l0_filter_and_index_blocks_key);
+        rcfg.direct_io_for_compaction =
+            pt.get_optional<DirectIOForCompaction>(direct_io_for_compaction_key);
+        rcfg.bulk_load_buffer_size =
+            pt.get_optional<uint64_t>(bulk_load_buffer_size_key);
 
         return Type(ncfg,
                     pt.get<boost::filesystem::path>(db_path_key),
@@ -166,6 +181,11 @@ struct PropertyTreeVectorAccessor<metadata_server::ServerConfig>
         P(target_file_size_base);
         P(max_bytes_for_level_base);
         P(compaction_style);
+        P(shared_block_cache);
+        P(bloom_filter_bits_per_key);
+        P(pin_l0_filter_and_index_blocks);
+        P(direct_io_for_compaction);
+        P(bulk_load_buffer_size);
 
 #undef P
     }
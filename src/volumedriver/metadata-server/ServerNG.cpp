@@ -17,6 +17,8 @@
 #include "ServerNG.h"
 #include "Utils.h"
 
+#include "../MDSNodeConfig.h"
+
 #include <map>
 
 #include <capnp/message.h>
@@ -216,6 +218,8 @@ ServerNG::dispatch_(C& conn,
         CASE(ApplyRelocationLogs, apply_relocation_logs_);
         CASE(CatchUp, catch_up_);
         CASE(GetTableCounters, get_table_counters_);
+        CASE(SetSlaves, set_slaves_);
+        CASE(Replicate, replicate_);
     }
 
 #undef CASE
@@ -734,6 +738,86 @@ ServerNG::get_table_counters_(mdsproto::Methods::GetTableCountersParams::Reader&
     cbuilder.setTotalTLogsRead(table_counters.total_tlogs_read);
     cbuilder.setIncrementalUpdates(table_counters.incremental_updates);
     cbuilder.setFullRebuilds(table_counters.full_rebuilds);
+
+#define SET_HISTOGRAM(name, init)                                       \
+    {                                                                   \
+        auto l(cbuilder.init(table_counters.name.size()));              \
+        for (size_t i = 0; i < table_counters.name.size(); ++i)         \
+        {                                                               \
+            l.set(i, table_counters.name[i]);                           \
+        }                                                               \
+    }
+
+    SET_HISTOGRAM(multiset_batch_sizes, initMultiSetBatchSizes);
+    SET_HISTOGRAM(multiget_batch_sizes, initMultiGetBatchSizes);
+    SET_HISTOGRAM(global_multiset_batch_sizes, initGlobalMultiSetBatchSizes);
+    SET_HISTOGRAM(global_multiget_batch_sizes, initGlobalMultiGetBatchSizes);
+
+#undef SET_HISTOGRAM
+}
+
+void
+ServerNG::set_slaves_(mdsproto::Methods::SetSlavesParams::Reader& reader,
+                      mdsproto::Methods::SetSlavesResults::Builder&)
+{
+    const std::string nspace(reader.getNspace().begin(),
+                             reader.getNspace().size());
+
+    auto slaves_reader(reader.getSlaves());
+    TableInterface::NodeConfigs slaves;
+    slaves.reserve(slaves_reader.size());
+
+    for (const auto& s : slaves_reader)
+    {
+        slaves.emplace_back(std::string(s.getAddress().begin(),
+                                        s.getAddress().size()),
+                            s.getPort());
+    }
+
+    // LOG_TRACE("set_slaves request to " << nspace << ", size " << slaves.size());
+
+    db_->open(nspace)->set_slaves(slaves);
+}
+
+void
+ServerNG::replicate_(mdsproto::Methods::ReplicateParams::Reader& reader,
+                     mdsproto::Methods::ReplicateResults::Builder& builder)
+{
+    const std::string nspace(reader.getNspace().begin(),
+                             reader.getNspace().size());
+
+    ReplicationUpdate update;
+    update.stream = std::string(reader.getStream().begin(),
+                                reader.getStream().size());
+    update.seq = reader.getSeqNum();
+    update.cork = std::string(reader.getCork().begin(),
+                              reader.getCork().size());
+    update.barrier = reader.getBarrier() ? Barrier::T : Barrier::F;
+
+    auto recs_reader(reader.getRecords());
+    update.records.reserve(recs_reader.size());
+
+    for (const auto& r : recs_reader)
+    {
+        capnp::Data::Reader kreader(r.getKey());
+        capnp::Data::Reader vreader(r.getVal());
+
+        boost::optional<std::string> val;
+        if (vreader.size() != 0)
+        {
+            val = std::string(reinterpret_cast<const char*>(vreader.begin()),
+                              vreader.size());
+        }
+
+        update.records.emplace_back(std::string(reinterpret_cast<const char*>(kreader.begin()),
+                                                kreader.size()),
+                                    std::move(val));
+    }
+
+    // LOG_TRACE("replicate request to " << nspace << ", seq " << update.seq <<
+    //           ", size " << update.records.size());
+
+    builder.setApplied(db_->open(nspace)->replicate(update));
 }
 
 }
@@ -201,6 +201,14 @@ private:
     get_table_counters_(metadata_server_protocol::Methods::GetTableCountersParams::Reader&,
                         metadata_server_protocol::Methods::GetTableCountersResults::Builder&);
 
+    void
+    set_slaves_(metadata_server_protocol::Methods::SetSlavesParams::Reader&,
+                metadata_server_protocol::Methods::SetSlavesResults::Builder&);
+
+    void
+    replicate_(metadata_server_protocol::Methods::ReplicateParams::Reader&,
+               metadata_server_protocol::Methods::ReplicateResults::Builder&);
+
 };
 
 }
@@ -18,6 +18,7 @@
 #include "Utils.h"
 
 #include <youtils/Assert.h>
+#include <youtils/Catchers.h>
 
 #include <volumedriver/MetaDataStoreBuilder.h>
 #include <volumedriver/RelocationReaderFactory.h>
@@ -42,6 +43,9 @@ namespace yt = youtils;
 #define LOCK_COUNTERS()                                         \
     boost::lock_guard<decltype(counters_lock_)> clg__(counters_lock_)
 
+#define LOCK_REPL()                                             \
+    boost::lock_guard<decltype(repl_lock_)> rplg__(repl_lock_)
+
 Table::Table(DataBaseInterfacePtr db,
              be::BackendInterfacePtr bi,
              yt::PeriodicActionPool::Ptr act_pool,
@@ -56,6 +60,7 @@ Table::Table(DataBaseInterfacePtr db,
     , poll_secs_(poll_secs)
     , max_cached_pages_(max_cached_pages)
     , scratch_dir_(scratch_dir)
+    , repl_sink_(table_->nspace())
 {
     VERIFY(bi_->getNS().str() == table_->nspace());
 
@@ -120,15 +125,20 @@ Table::set_role(Role role)
     if (role != old_role)
     {
 
+        LOCK_REPL();
+
         switch (role)
         {
         case Role::Master:
             {
                 stop_act = std::move(act_);
+                repl_sink_.reset();
+                start_replication_();
                 break;
             }
         case Role::Slave:
             {
+                repl_stream_ = nullptr;
                 start_(sc::milliseconds(0));
                 break;
             }
@@ -195,12 +205,9 @@ Table::apply_relocations(const vd::ScrubId& scrub_id,
     }
     else
     {
-        vd::MetaDataStoreBuilder builder(*mdstore,
-                                         bi_->clone(),
-                                         scratch_dir_);
-
-        const vd::MetaDataStoreBuilder::Result res(builder(boost::none,
-                                                           vd::CheckScrubId::T));
+        const vd::MetaDataStoreBuilder::Result res(build_(*mdstore,
+                                                          vd::CheckScrubId::T,
+                                                          vd::DryRun::F));
 
         update_nsid_map_(res.nsid_map);
         update_counters_(res);
@@ -221,6 +228,7 @@ Table::apply_relocations(const vd::ScrubId& scrub_id,
                 mdstore->applyRelocs(factory,
                                      cid,
                                      scrub_id);
+                repl_sink_.reset();
             }
             CATCH_STD_ALL_EWHAT({
                     LOG_ERROR(table_->nspace() <<
@@ -261,8 +269,16 @@ Table::multiset(const TableInterface::Records& records,
 
     prevent_updates_on_slaves_("multiset");
 
+    LOCK_REPL();
+
     table_->multiset(records,
                      barrier);
+
+    if (repl_stream_)
+    {
+        repl_stream_->push(records,
+                           barrier);
+    }
 }
 
 TableInterface::MaybeStrings
@@ -284,21 +300,49 @@ Table::work_()
 
     if (TableInterface::get_role() == Role::Slave)
     {
-        try
+        if (repl_sink_.current())
+        {
+            LOG_INFO(table_->nspace() <<
+                     ": kept up to date by the replication stream, not checking the backend");
+            return yt::PeriodicActionContinue::T;
+        }
+
+        // The upgrade lock doesn't keep replicate() out, so updates arriving
+        // while the builder replays TLogs into the table are put into the
+        // backlog instead of being overwritten by older TLog entries.
+        // Upgrading waits for the ones in flight.
         {
-            auto mdstore(make_mdstore_());
+            boost::upgrade_to_unique_lock<decltype(rwlock_)> u(ulg);
+            build_in_progress_ = true;
+        }
 
-            vd::MetaDataStoreBuilder builder(*mdstore,
-                                             bi_->clone(),
-                                             scratch_dir_);
+        try
+        {
+            std::unique_ptr<vd::CachedMetaDataStore> mdstore;
+            boost::optional<vd::MetaDataStoreBuilder::Result> res;
 
-            const vd::MetaDataStoreBuilder::Result res(builder(boost::none,
-                                                               vd::CheckScrubId::F));
+            try
+            {
+                mdstore = make_mdstore_();
+                res = build_(*mdstore,
+                             vd::CheckScrubId::F,
+                             vd::DryRun::F);
+            }
+            catch (...)
+            {
+                boost::upgrade_to_unique_lock<decltype(rwlock_)> u(ulg);
+                build_in_progress_ = false;
+                throw;
+            }
 
             boost::upgrade_to_unique_lock<decltype(rwlock_)> u(ulg);
 
-            update_nsid_map_(res.nsid_map);
-            update_counters_(res);
+            build_in_progress_ = false;
+
+            update_nsid_map_(res->nsid_map);
+            update_counters_(*res);
+            resync_replication_(*mdstore,
+                                *res);
         }
         catch (be::BackendNamespaceDoesNotExistException& e)
         {
@@ -345,39 +389,83 @@ Table::catch_up(vd::DryRun dry_run)
     {
         auto mdstore(make_mdstore_());
 
-        vd::MetaDataStoreBuilder builder(*mdstore,
-                                         bi_->clone(),
-                                         scratch_dir_);
-
-        const vd::MetaDataStoreBuilder::Result res(builder(boost::none,
-                                                           vd::CheckScrubId::T,
-                                                           dry_run));
+        const vd::MetaDataStoreBuilder::Result res(build_(*mdstore,
+                                                          vd::CheckScrubId::T,
+                                                          dry_run));
         if (dry_run == vd::DryRun::F)
         {
             update_nsid_map_(res.nsid_map);
             update_counters_(res);
+            resync_replication_(*mdstore,
+                                res);
         }
 
         return res.num_tlogs;
     }
 }
 
+// Tables without any metadata yet (new slaves, or ones that were cleared) are
+// built through the bulk load path of the underlying table.
+vd::MetaDataStoreBuilder::Result
+Table::build_(vd::CachedMetaDataStore& mdstore,
+              vd::CheckScrubId check_scrub_id,
+              vd::DryRun dry_run)
+{
+    vd::MetaDataStoreBuilder builder(mdstore,
+                                     bi_->clone(),
+                                     scratch_dir_);
+
+    if (dry_run == vd::DryRun::T or mdstore.lastCork() != boost::none)
+    {
+        return builder(boost::none,
+                       check_scrub_id,
+                       dry_run);
+    }
+
+    LOG_INFO(table_->nspace() << ": table is empty, building it via bulk load");
+
+    table_->begin_bulk_load();
+
+    try
+    {
+        const vd::MetaDataStoreBuilder::Result res(builder(boost::none,
+                                                           check_scrub_id,
+                                                           dry_run));
+        table_->end_bulk_load();
+        return res;
+    }
+    catch (...)
+    {
+        try
+        {
+            table_->end_bulk_load();
+        }
+        CATCH_STD_ALL_LOG_IGNORE(table_->nspace() <<
+                                 ": failed to end bulk load");
+        throw;
+    }
+}
+
+// The batch size histograms are maintained by the underlying table.
 TableCounters
 Table::get_counters(vd::Reset reset)
 {
     LOCKR();
+
+    TableCounters c(table_->get_counters(reset));
+
     LOCK_COUNTERS();
 
+    c.total_tlogs_read = counters_.total_tlogs_read;
+    c.incremental_updates = counters_.incremental_updates;
+    c.full_rebuilds = counters_.full_rebuilds;
+
     if (reset == vd::Reset::T)
     {
-        TableCounters c;
-        std::swap(c, counters_);
-        return c;
-    }
-    else
-    {
-        return counters_;
+        counters_ = TableCounters();
     }
+
+    return c;
 }
 
 void
@@ -399,4 +487,83 @@ Table::update_counters_(const vd::MetaDataStoreBuilder::Result& res)
     }
 }
 
+void
+Table::set_slaves(const TableInterface::NodeConfigs& slaves)
+{
+    LOG_INFO(table_->nspace() << ": slaves: " << slaves);
+
+    LOCKR();
+    LOCK_REPL();
+
+    if (slaves == slaves_ and repl_stream_ != nullptr)
+    {
+        LOG_INFO(table_->nspace() << ": slaves unchanged, keeping the replication stream");
+        return;
+    }
+
+    slaves_ = slaves;
+
+    if (TableInterface::get_role() == Role::Master)
+    {
+        start_replication_();
+    }
+}
+
+void
+Table::start_replication_()
+{
+    repl_stream_ = nullptr;
+
+    if (not slaves_.empty())
+    {
+        const TableInterface::Keys keys{ Key(cork_key) };
+        const TableInterface::MaybeStrings cork(table_->multiget(keys));
+
+        repl_stream_ = std::make_unique<ReplicationStream>(table_->nspace(),
+                                                           slaves_,
+                                                           cork[0]);
+    }
+}
+
+bool
+Table::replicate(const ReplicationUpdate& update)
+{
+    LOCKR();
+
+    if (TableInterface::get_role() != Role::Slave)
+    {
+        LOG_ERROR(table_->nspace() <<
+                  ": replication updates are not accepted while in master role");
+        throw NoReplicationToMastersException("Replication updates are not accepted in master role",
+                                              table_->nspace().c_str());
+    }
+
+    if (build_in_progress_)
+    {
+        repl_sink_.defer(update);
+        return false;
+    }
+
+    return repl_sink_.apply(update,
+                            *table_);
+}
+
+void
+Table::resync_replication_(vd::CachedMetaDataStore& mdstore,
+                           const vd::MetaDataStoreBuilder::Result& res)
+{
+    // The backend had something the stream did not deliver (or we started over
+    // from scratch), so whatever we thought to be in sync with can't be trusted.
+    if (res.num_tlogs != 0 or res.full_rebuild)
+    {
+        repl_sink_.reset();
+    }
+
+    const boost::optional<yt::UUID> cork(mdstore.lastCork());
+    repl_sink_.resync(cork ?
+                      boost::optional<std::string>(cork->str()) :
+                      boost::none,
+                      *table_);
+}
+
 }
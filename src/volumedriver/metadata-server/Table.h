@@ -17,6 +17,7 @@
 #define META_DATA_SERVER_TABLE_H_
 
 #include "Interface.h"
+#include "Replication.h"
 
 #include <memory>
 
@@ -32,6 +33,7 @@
 
 #include <volumedriver/CachedMetaDataStore.h>
 #include <volumedriver/MDSMetaDataBackend.h>
+#include <volumedriver/MDSNodeConfig.h>
 #include <volumedriver/MetaDataStoreBuilder.h>
 #include <volumedriver/NSIDMap.h>
 #include <volumedriver/ScrubId.h>
@@ -49,7 +51,11 @@ namespace metadata_server
 //   . Callers are not permitted to update the underlying TableInterface via multiset.
 //   Scrub application is allowed.
 // * Master: no background action; all calls are routed through to the underlying
-//   TableInterface.
+//   TableInterface. Updates are pushed to the slaves registered via
+//   ->set_slaves() (cf. Replication.h).
+// * Slaves that are kept in sync by the master's replication stream skip the
+//   periodic backend check, the latter is only the fallback for slaves that
+//   fell behind.
 //
 // Roles are switched explicitly via ->set_role().
 //
@@ -62,12 +68,15 @@ namespace metadata_server
 //   All other calls use it in shared mode.
 //
 //   The counters are protected by a plain mutex which needs to be grabbed *after* the shared one.
+//   The same goes for the replication state, whose mutex also serializes multisets on
+//   masters so the stream reflects the order of updates.
 class Table
     : public TableInterface
 {
 public:
     MAKE_EXCEPTION(Exception, fungi::IOException);
     MAKE_EXCEPTION(NoUpdatesOnSlavesException, Exception);
+    MAKE_EXCEPTION(NoReplicationToMastersException, Exception);
 
     Table(DataBaseInterfacePtr db,
           backend::BackendInterfacePtr bi,
@@ -118,6 +127,12 @@ public:
     virtual TableCounters
     get_counters(volumedriver::Reset) override final;
 
+    virtual void
+    set_slaves(const TableInterface::NodeConfigs&) override final;
+
+    virtual bool
+    replicate(const ReplicationUpdate&) override final;
+
     void
     stop();
 
@@ -126,6 +141,9 @@ private:
 
     mutable boost::shared_mutex rwlock_;
 
+    // set (under the write lock) while the periodic action replays TLogs
+    bool build_in_progress_ = false;
+
     DataBaseInterfacePtr db_;
     TableInterfacePtr table_;
     backend::BackendInterfacePtr bi_;
@@ -142,6 +160,11 @@ private:
     boost::mutex counters_lock_;
     TableCounters counters_;
 
+    boost::mutex repl_lock_;
+    TableInterface::NodeConfigs slaves_;
+    std::unique_ptr<ReplicationStream> repl_stream_;
+    ReplicationSink repl_sink_;
+
     void
     start_(const std::chrono::milliseconds& ramp_up);
 
@@ -154,6 +177,11 @@ private:
     std::unique_ptr<volumedriver::CachedMetaDataStore>
     make_mdstore_();
 
+    volumedriver::MetaDataStoreBuilder::Result
+    build_(volumedriver::CachedMetaDataStore&,
+           volumedriver::CheckScrubId,
+           volumedriver::DryRun);
+
     void
     update_nsid_map_(const volumedriver::NSIDMap&);
 
@@ -162,6 +190,13 @@ private:
 
     void
     update_counters_(const volumedriver::MetaDataStoreBuilder::Result&);
+
+    void
+    start_replication_();
+
+    void
+    resync_replication_(volumedriver::CachedMetaDataStore&,
+                        const volumedriver::MetaDataStoreBuilder::Result&);
 };
 
 typedef std::shared_ptr<Table> TablePtr;
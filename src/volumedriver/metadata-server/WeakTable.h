@@ -96,6 +96,18 @@ public:
         return lock_()->get_counters(reset);
     }
 
+    virtual void
+    set_slaves(const NodeConfigs& slaves) override final
+    {
+        lock_()->set_slaves(slaves);
+    }
+
+    virtual bool
+    replicate(const ReplicationUpdate& update) override final
+    {
+        return lock_()->replicate(update);
+    }
+
     MAKE_EXCEPTION(Exception,
                    fungi::IOException);
 
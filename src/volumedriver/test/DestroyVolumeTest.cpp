@@ -82,6 +82,13 @@ public:
                 EXPECT_TRUE(fs::exists(md_path));
             }
             break;
+        case MetaDataBackendType::MMap:
+            {
+                const fs::path p(VolManager::get()->getMetaDataPath(cfg) / "mdstore.mmap");
+                EXPECT_EQ(delete_local == DeleteLocalData::F,
+                          fs::exists(p));
+                break;
+            }
         }
 
         if (delete_local == DeleteLocalData::T)
@@ -178,6 +185,7 @@ TEST_P(DestroyVolumeTest, test_errors_when_deleting_mdstore)
     case MetaDataBackendType::Arakoon:
     case MetaDataBackendType::MDS:
     case MetaDataBackendType::RocksDB:
+    case MetaDataBackendType::MMap:
         TODO("AR: revisit - this should also work with RocksDB.");
         return;
     case MetaDataBackendType::TCBT:
@@ -1245,6 +1245,7 @@ TEST_P(LocalRestartTest, RestartWithMetaDataReplay)
     case MetaDataBackendType::Arakoon:
     case MetaDataBackendType::MDS:
     case MetaDataBackendType::RocksDB:
+    case MetaDataBackendType::MMap:
         TODO("AR: fix at least for RocksDB?");
         {
             LOG_FATAL("This test cannot be run with an " <<
@@ -2347,6 +2348,7 @@ TEST_P(LocalRestartTest, MDStoreOutToLunch)
         }
     case MetaDataBackendType::RocksDB:
     case MetaDataBackendType::TCBT:
+    case MetaDataBackendType::MMap:
         {
             VolumeId vid1("volume1");
             // const backend::Namespace ns1;
@@ -57,6 +57,12 @@ TEST_F(MDSServerConfigTest, roundtrip)
         rocks_config.read_cache_size = mds::ReadCacheSize(i << 20);
         rocks_config.enable_wal = mds::EnableWal::T;
         rocks_config.data_sync = mds::DataSync::T;
+        rocks_config.shared_block_cache = mds::SharedBlockCache::T;
+        rocks_config.bloom_filter_bits_per_key = i;
+        rocks_config.pin_l0_filter_and_index_blocks =
+            mds::PinL0FilterAndIndexBlocks::T;
+        rocks_config.direct_io_for_compaction = mds::DirectIOForCompaction::F;
+        rocks_config.bulk_load_buffer_size = i << 20;
 
         rocks_configs.emplace_back(std::move(rocks_config));
 
@@ -18,6 +18,7 @@
 
 #include <functional>
 #include <future>
+#include <mutex>
 
 #include <youtils/Assert.h>
 #include <youtils/ScopeExit.h>
@@ -36,6 +37,8 @@
 #include "../MDSMetaDataStore.h"
 #include "../metadata-server/ClientNG.h"
 #include "../metadata-server/Manager.h"
+#include "../metadata-server/RocksDataBase.h"
+#include "../metadata-server/Table.h"
 #include "../Scrubber.h"
 #include "../ScrubberAdapter.h"
 #include "../ScrubReply.h"
@@ -888,6 +891,255 @@ TEST_P(MDSVolumeTest, catch_up)
               table->catch_up(DryRun::T));
 }
 
+namespace
+{
+
+// Holds up the bulk load of a table that is built from scratch until released.
+class StallingTable
+    : public mds::TableInterface
+{
+public:
+    explicit StallingTable(mds::TableInterfacePtr table)
+        : table_(table)
+        , release_future_(release_.get_future().share())
+    {}
+
+    virtual void
+    multiset(const Records& recs,
+             Barrier barrier) override final
+    {
+        table_->multiset(recs,
+                         barrier);
+    }
+
+    virtual MaybeStrings
+    multiget(const Keys& keys) override final
+    {
+        return table_->multiget(keys);
+    }
+
+    virtual void
+    apply_relocations(const ScrubId& scrub_id,
+                      const SCOCloneID cid,
+                      const RelocationLogs& relocs) override final
+    {
+        table_->apply_relocations(scrub_id,
+                                  cid,
+                                  relocs);
+    }
+
+    virtual void
+    clear() override final
+    {
+        table_->clear();
+    }
+
+    virtual const std::string&
+    nspace() const override final
+    {
+        return table_->nspace();
+    }
+
+    virtual size_t
+    catch_up(DryRun dry_run) override final
+    {
+        return table_->catch_up(dry_run);
+    }
+
+    virtual mds::TableCounters
+    get_counters(Reset reset) override final
+    {
+        return table_->get_counters(reset);
+    }
+
+    virtual void
+    set_slaves(const NodeConfigs& slaves) override final
+    {
+        table_->set_slaves(slaves);
+    }
+
+    virtual bool
+    replicate(const mds::ReplicationUpdate& update) override final
+    {
+        return table_->replicate(update);
+    }
+
+    virtual void
+    begin_bulk_load() override final
+    {
+        table_->begin_bulk_load();
+        started_.set_value();
+        release_future_.wait();
+    }
+
+    virtual void
+    end_bulk_load() override final
+    {
+        table_->end_bulk_load();
+    }
+
+    std::promise<void> started_;
+    std::promise<void> release_;
+
+private:
+    mds::TableInterfacePtr table_;
+    std::shared_future<void> release_future_;
+};
+
+class StallingDataBase
+    : public mds::DataBaseInterface
+{
+public:
+    explicit StallingDataBase(mds::DataBaseInterfacePtr db)
+        : db_(db)
+    {}
+
+    virtual mds::TableInterfacePtr
+    open(const std::string& nspace) override final
+    {
+        std::lock_guard<std::mutex> g(lock_);
+
+        auto it = tables_.find(nspace);
+        if (it == tables_.end())
+        {
+            it = tables_.emplace(nspace,
+                                 std::make_shared<StallingTable>(db_->open(nspace))).first;
+        }
+
+        return it->second;
+    }
+
+    virtual void
+    drop(const std::string& nspace) override final
+    {
+        std::lock_guard<std::mutex> g(lock_);
+
+        tables_.erase(nspace);
+        db_->drop(nspace);
+    }
+
+    virtual std::vector<std::string>
+    list_namespaces() override final
+    {
+        return db_->list_namespaces();
+    }
+
+    std::shared_ptr<StallingTable>
+    table(const std::string& nspace)
+    {
+        std::lock_guard<std::mutex> g(lock_);
+        return tables_.at(nspace);
+    }
+
+private:
+    mds::DataBaseInterfacePtr db_;
+    std::mutex lock_;
+    std::map<std::string, std::shared_ptr<StallingTable>> tables_;
+};
+
+}
+
+TEST_P(MDSVolumeTest, replication_updates_during_rebuild)
+{
+    const size_t num_tlogs = 3;
+
+    const auto wrns(make_random_namespace());
+    const std::string nspace(wrns->ns().str());
+    SharedVolumePtr v = make_volume(*wrns);
+
+    const size_t csize = v->getClusterSize();
+
+    for (size_t i = 0; i < num_tlogs; ++i)
+    {
+        writeToVolume(*v,
+                      i * v->getClusterMultiplier() * CachePage::capacity(),
+                      csize,
+                      boost::lexical_cast<std::string>(i));
+        scheduleBackendSync(*v);
+    }
+
+    waitForThisBackendWrite(*v);
+
+    const fs::path root(yt::FileUtils::temp_path(testName_) / "replication_updates_during_rebuild");
+    fs::remove_all(root);
+    ALWAYS_CLEANUP_DIRECTORY(root);
+
+    auto db(std::make_shared<StallingDataBase>(std::make_shared<mds::RocksDataBase>(root / "db")));
+    auto pool(yt::PeriodicActionPool::create("replication_updates_during_rebuild",
+                                             1));
+    const std::atomic<uint64_t> poll_secs(3600);
+
+    // the periodic action fires right away and builds the empty table from
+    // the backend, which gets stuck in the bulk load
+    auto table(std::make_shared<mds::Table>(db,
+                                            cm_->newBackendInterface(wrns->ns()),
+                                            pool,
+                                            root / "scratch",
+                                            1024,
+                                            poll_secs,
+                                            std::chrono::milliseconds(0)));
+
+    std::shared_ptr<StallingTable> stalling(db->table(nspace));
+    auto release(yt::make_scope_exit([&]
+                                     {
+                                         try
+                                         {
+                                             stalling->release_.set_value();
+                                         }
+                                         catch (std::future_error&)
+                                         {}
+                                     }));
+
+    ASSERT_EQ(std::future_status::ready,
+              stalling->started_.get_future().wait_for(std::chrono::seconds(60)));
+
+    // the half built table has no cork yet - the handshake would match
+    mds::ReplicationUpdate handshake;
+    handshake.stream = "some-stream";
+    handshake.seq = 0;
+
+    EXPECT_FALSE(table->replicate(handshake));
+
+    const std::string key("some-key");
+
+    mds::ReplicationUpdate update;
+    update.stream = handshake.stream;
+    update.seq = 1;
+    update.records.emplace_back(key,
+                                "some-value"s);
+
+    EXPECT_FALSE(table->replicate(update));
+
+    const mds::TableInterface::Keys keys{ mds::Key(key) };
+    EXPECT_TRUE(stalling->multiget(keys)[0] == boost::none);
+
+    stalling->release_.set_value();
+
+    bool built = false;
+    for (size_t i = 0; i < 600 and not built; ++i)
+    {
+        built = table->get_counters(Reset::F).full_rebuilds != 0;
+        if (not built)
+        {
+            boost::this_thread::sleep_for(boost::chrono::milliseconds(100));
+        }
+    }
+
+    ASSERT_TRUE(built);
+
+    EXPECT_TRUE(table->multiget(keys)[0] == boost::none);
+
+    for (size_t i = 0; i < num_tlogs; ++i)
+    {
+        checkVolume(*v,
+                    i * v->getClusterMultiplier() * CachePage::capacity(),
+                    csize,
+                    boost::lexical_cast<std::string>(i));
+    }
+
+    table.reset();
+}
+
 TEST_P(MDSVolumeTest, failover_monkey_business)
 {
     auto f([&](Volume& v,
@@ -0,0 +1,293 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "../CachedMetaDataPage.h"
+#include "../ClusterLocationAndHash.h"
+#include "../MMapMetaDataBackend.h"
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <gtest/gtest.h>
+
+#include <youtils/FileUtils.h>
+#include <youtils/UUID.h>
+
+namespace volumedrivertest
+{
+
+namespace fs = boost::filesystem;
+namespace vd = volumedriver;
+namespace yt = youtils;
+
+class MMapMetaDataBackendTest
+    : public testing::Test
+{
+protected:
+    MMapMetaDataBackendTest()
+        : dir_(yt::FileUtils::temp_path("MMapMetaDataBackendTest"))
+        , data_(vd::CachePage::capacity())
+    {}
+
+    void
+    SetUp() override final
+    {
+        fs::remove_all(dir_);
+        fs::create_directories(dir_);
+    }
+
+    void
+    TearDown() override final
+    {
+        fs::remove_all(dir_);
+    }
+
+    // fills the first n entries of the page
+    void
+    fill(vd::CachePage& p,
+         size_t n,
+         uint32_t sco)
+    {
+        p.reset();
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const std::vector<uint8_t> buf(1, i);
+            p[i] = vd::ClusterLocationAndHash(vd::ClusterLocation(vd::SCONumber(sco),
+                                                                  vd::SCOOffset(i)),
+                                              buf.data(),
+                                              buf.size());
+        }
+    }
+
+    using Header = vd::MMapMetaDataBackend::Header;
+
+    Header
+    read_header() const
+    {
+        Header h;
+        fs::ifstream ifs(dir_ / vd::MMapMetaDataBackend::header_name,
+                         std::ios::binary);
+        ifs.read(reinterpret_cast<char*>(&h),
+                 sizeof(h));
+        EXPECT_EQ(sizeof(h),
+                  static_cast<size_t>(ifs.gcount()));
+        return h;
+    }
+
+    void
+    write_header(const Header& h)
+    {
+        yt::FileUtils::safe_copy(std::string(reinterpret_cast<const char*>(&h),
+                                             sizeof(h)),
+                                 dir_ / vd::MMapMetaDataBackend::header_name);
+    }
+
+    const fs::path dir_;
+    std::vector<vd::ClusterLocationAndHash> data_;
+};
+
+TEST_F(MMapMetaDataBackendTest, empty)
+{
+    vd::MMapMetaDataBackend mdb(dir_);
+
+    EXPECT_EQ(0U, mdb.getUsedClusters());
+    EXPECT_EQ(boost::none, mdb.lastCorkUUID());
+    EXPECT_EQ(boost::none, mdb.scrub_id());
+
+    vd::CachePage p(vd::PageAddress(7), data_.data());
+    EXPECT_FALSE(mdb.getPage(p));
+}
+
+TEST_F(MMapMetaDataBackendTest, put_and_get)
+{
+    std::vector<vd::ClusterLocationAndHash> data(vd::CachePage::capacity());
+    const size_t n = vd::CachePage::capacity() / 2;
+    const std::vector<vd::PageAddress> pas{ vd::PageAddress(0),
+                                            vd::PageAddress(13),
+                                            vd::PageAddress(4096) };
+
+    {
+        vd::MMapMetaDataBackend mdb(dir_);
+
+        for (const auto& pa : pas)
+        {
+            vd::CachePage p(pa, data.data());
+            fill(p, n, pa + 1);
+            mdb.putPage(p, n);
+        }
+
+        EXPECT_EQ(pas.size() * n, mdb.getUsedClusters());
+
+        for (const auto& pa : pas)
+        {
+            vd::CachePage p(pa, data_.data());
+            ASSERT_TRUE(mdb.getPage(p));
+
+            vd::CachePage q(pa, data.data());
+            fill(q, n, pa + 1);
+            EXPECT_EQ(0, memcmp(p.data(), q.data(), vd::CachePage::size()));
+        }
+
+        // a page in between that was never written
+        vd::CachePage p(vd::PageAddress(14), data_.data());
+        ASSERT_TRUE(mdb.getPage(p));
+        EXPECT_TRUE(p.empty());
+    }
+
+    // restart is just mapping the file again
+    vd::MMapMetaDataBackend mdb(dir_);
+    EXPECT_EQ(pas.size() * n, mdb.getUsedClusters());
+
+    for (const auto& pa : pas)
+    {
+        vd::CachePage p(pa, data_.data());
+        ASSERT_TRUE(mdb.getPage(p));
+
+        vd::CachePage q(pa, data.data());
+        fill(q, n, pa + 1);
+        EXPECT_EQ(0, memcmp(p.data(), q.data(), vd::CachePage::size()));
+    }
+}
+
+TEST_F(MMapMetaDataBackendTest, discard)
+{
+    vd::MMapMetaDataBackend mdb(dir_);
+    const size_t n = vd::CachePage::capacity();
+
+    vd::CachePage p(vd::PageAddress(3), data_.data());
+    fill(p, n, 1);
+    mdb.putPage(p, n);
+    EXPECT_EQ(n, mdb.getUsedClusters());
+
+    mdb.discardPage(p, -static_cast<int32_t>(n));
+    EXPECT_EQ(0U, mdb.getUsedClusters());
+
+    fill(p, n, 1);
+    ASSERT_TRUE(mdb.getPage(p));
+    EXPECT_TRUE(p.empty());
+}
+
+TEST_F(MMapMetaDataBackendTest, cork_and_scrub_id)
+{
+    const yt::UUID cork;
+    const vd::ScrubId scrub_id;
+
+    {
+        vd::MMapMetaDataBackend mdb(dir_);
+        mdb.setCork(cork);
+        mdb.set_scrub_id(scrub_id);
+
+        EXPECT_EQ(cork, *mdb.lastCorkUUID());
+        EXPECT_EQ(scrub_id, *mdb.scrub_id());
+    }
+
+    vd::MMapMetaDataBackend mdb(dir_);
+
+    EXPECT_EQ(cork, *mdb.lastCorkUUID());
+    EXPECT_EQ(scrub_id, *mdb.scrub_id());
+
+    mdb.clear_all_keys();
+
+    EXPECT_EQ(boost::none, mdb.lastCorkUUID());
+    EXPECT_EQ(boost::none, mdb.scrub_id());
+    EXPECT_EQ(0U, mdb.getUsedClusters());
+}
+
+TEST_F(MMapMetaDataBackendTest, page_format)
+{
+    {
+        vd::MMapMetaDataBackend mdb(dir_);
+        EXPECT_EQ(vd::PageFormat::Wide, *mdb.page_format());
+
+        mdb.set_page_format(vd::PageFormat::Compact);
+        EXPECT_EQ(vd::PageFormat::Compact, *mdb.page_format());
+    }
+
+    vd::MMapMetaDataBackend mdb(dir_);
+    EXPECT_EQ(vd::PageFormat::Compact, *mdb.page_format());
+
+    mdb.clear_all_keys();
+    EXPECT_EQ(vd::PageFormat::Wide, *mdb.page_format());
+}
+
+TEST_F(MMapMetaDataBackendTest, invalid_page_format)
+{
+    {
+        vd::MMapMetaDataBackend mdb(dir_);
+    }
+
+    Header h(read_header());
+    h.page_format = 42;
+    write_header(h);
+
+    EXPECT_THROW(vd::MMapMetaDataBackend mdb(dir_),
+                 vd::MetaDataStoreBackendException);
+}
+
+TEST_F(MMapMetaDataBackendTest, unclean_shutdown)
+{
+    const size_t n = 10;
+    const yt::UUID cork;
+    const fs::path crashed(dir_ / "crashed");
+
+    {
+        vd::MMapMetaDataBackend mdb(dir_);
+
+        vd::CachePage p(vd::PageAddress(1), data_.data());
+        fill(p, n, 1);
+        mdb.putPage(p, n);
+        mdb.setCork(cork);
+
+        // after the cork, so the header is not updated
+        vd::CachePage q(vd::PageAddress(1000), data_.data());
+        fill(q, n, 2);
+        mdb.putPage(q, n);
+
+        EXPECT_EQ(n, read_header().used_clusters);
+
+        // a snapshot of what is on disk if we crashed now
+        fs::create_directories(crashed);
+        for (const auto& name : { vd::MMapMetaDataBackend::db_name,
+                                  vd::MMapMetaDataBackend::header_name })
+        {
+            fs::copy_file(dir_ / name,
+                          crashed / name);
+        }
+    }
+
+    vd::MMapMetaDataBackend mdb(crashed);
+
+    EXPECT_EQ(cork, *mdb.lastCorkUUID());
+    EXPECT_EQ(2 * n, mdb.getUsedClusters());
+}
+
+TEST_F(MMapMetaDataBackendTest, page_size_mismatch)
+{
+    {
+        vd::MMapMetaDataBackend mdb(dir_);
+    }
+
+    Header h(read_header());
+    h.page_size *= 2;
+    write_header(h);
+
+    EXPECT_THROW(vd::MMapMetaDataBackend mdb(dir_),
+                 vd::MetaDataStoreBackendException);
+}
+
+}
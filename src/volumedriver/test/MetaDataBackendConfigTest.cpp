@@ -59,6 +59,9 @@ protected:
             mdb.reset(new vd::RocksDBMetaDataBackendConfig());
             oa << mdb;
 
+            mdb.reset(new vd::MMapMetaDataBackendConfig());
+            oa << mdb;
+
             std::vector<vd::MDSNodeConfig> nodes{ vd::MDSNodeConfig(addr,
                                                                     port) };
             mdb.reset(new vd::MDSMetaDataBackendConfig(nodes,
@@ -93,6 +96,15 @@ protected:
 
         ia >> mdb;
 
+        {
+            ASSERT_EQ(vd::MetaDataBackendType::MMap,
+                      mdb->backend_type());
+            ASSERT_TRUE(boost::dynamic_pointer_cast<vd::MMapMetaDataBackendConfig>(mdb) != nullptr);
+            mdb.reset();
+        }
+
+        ia >> mdb;
+
         {
             ASSERT_EQ(vd::MetaDataBackendType::MDS,
                       mdb->backend_type());
@@ -180,6 +192,7 @@ TEST_F(MetaDataBackendConfigTest, enum_streaming)
     test(vd::MetaDataBackendType::MDS);
     test(vd::MetaDataBackendType::RocksDB);
     test(vd::MetaDataBackendType::TCBT);
+    test(vd::MetaDataBackendType::MMap);
 }
 
 }
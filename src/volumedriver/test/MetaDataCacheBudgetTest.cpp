@@ -0,0 +1,280 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+#include "../CachePagePool.h"
+#include "../ClusterLocationAndHash.h"
+#include "../MetaDataCacheBudget.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace volumedrivertest
+{
+
+namespace vd = volumedriver;
+
+class MetaDataCacheBudgetTest
+    : public testing::Test
+{
+protected:
+    struct Client
+        : public vd::MetaDataCacheBudget::Client
+    {
+        uint64_t cost = 0;
+        uint64_t quota = 0;
+
+        virtual uint64_t
+        collect_miss_cost() override final
+        {
+            const uint64_t c = cost;
+            cost = 0;
+            return c;
+        }
+
+        virtual void
+        set_page_quota(uint64_t pages) override final
+        {
+            quota = pages;
+        }
+    };
+};
+
+TEST_F(MetaDataCacheBudgetTest, pool)
+{
+    const uint64_t capacity = 100;
+    vd::CachePagePool pool(capacity);
+
+    EXPECT_EQ(0U, pool.allocated());
+
+    std::vector<vd::CachePage*> pages;
+    for (uint64_t i = 0; i < capacity; ++i)
+    {
+        vd::CachePage* p = pool.allocate();
+        ASSERT_TRUE(p != nullptr);
+        pages.push_back(p);
+    }
+
+    EXPECT_EQ(capacity, pool.used());
+    EXPECT_EQ(capacity, pool.allocated());
+    EXPECT_TRUE(pool.allocate() == nullptr);
+
+    vd::CachePage* p = pool.allocate(true);
+    ASSERT_TRUE(p != nullptr);
+    pages.push_back(p);
+    EXPECT_EQ(capacity + 1, pool.used());
+
+    for (vd::CachePage* p : pages)
+    {
+        pool.release(*p);
+    }
+
+    EXPECT_EQ(0U, pool.used());
+    // memory is kept around ...
+    EXPECT_EQ(capacity + 1, pool.allocated());
+
+    // ... until the pool is trimmed
+    EXPECT_EQ(capacity + 1, pool.trim());
+    EXPECT_EQ(0U, pool.allocated());
+
+    // chunks with pages in use stay
+    p = pool.allocate();
+    ASSERT_TRUE(p != nullptr);
+    const uint64_t allocated = pool.allocated();
+    EXPECT_EQ(0U, pool.trim());
+    EXPECT_EQ(allocated, pool.allocated());
+
+    pool.release(*p);
+    EXPECT_EQ(allocated, pool.trim());
+}
+
+TEST_F(MetaDataCacheBudgetTest, compact_pool)
+{
+    const uint64_t capacity = 16;
+    vd::CachePagePool pool(capacity,
+                           vd::PageFormat::Compact);
+
+    EXPECT_EQ(vd::PageFormat::Compact, pool.format());
+
+    const vd::ClusterLocation loc(13);
+    const vd::ClusterLocationAndHash clh(loc,
+                                         youtils::Weed::null());
+
+    std::vector<vd::CachePage*> pages;
+    for (uint64_t i = 0; i < capacity; ++i)
+    {
+        vd::CachePage* p = pool.allocate();
+        ASSERT_TRUE(p != nullptr);
+        EXPECT_EQ(vd::PageFormat::Compact, p->format());
+        EXPECT_TRUE(p->empty());
+
+        p->set(vd::CachePage::capacity() - 1, clh);
+        EXPECT_EQ(loc, p->get(vd::CachePage::capacity() - 1).clusterLocation);
+        EXPECT_FALSE(p->empty());
+
+        pages.push_back(p);
+    }
+
+    EXPECT_TRUE(pool.allocate() == nullptr);
+
+    for (vd::CachePage* p : pages)
+    {
+        pool.release(*p);
+    }
+
+    EXPECT_EQ(0U, pool.used());
+
+    // released pages come back empty and compact
+    vd::CachePage* p = pool.allocate();
+    ASSERT_TRUE(p != nullptr);
+    EXPECT_EQ(vd::PageFormat::Compact, p->format());
+    EXPECT_TRUE(p->empty());
+    pool.release(*p);
+
+    const uint64_t budget_pages = 64;
+    vd::MetaDataCacheBudget budget(budget_pages,
+                                   8);
+
+    EXPECT_EQ(budget_pages,
+              budget.pool()->capacity());
+    EXPECT_EQ(budget_pages * vd::CachePage::pages_per_wide_page(vd::PageFormat::Compact),
+              budget.pool(vd::PageFormat::Compact)->capacity());
+}
+
+TEST_F(MetaDataCacheBudgetTest, shared_memory)
+{
+    const uint64_t budget_pages = 128;
+    vd::MetaDataCacheBudget budget(budget_pages,
+                                   8);
+
+    const std::shared_ptr<vd::CachePagePool>& wide = budget.pool(vd::PageFormat::Wide);
+    const std::shared_ptr<vd::CachePagePool>& compact = budget.pool(vd::PageFormat::Compact);
+    const std::shared_ptr<vd::CachePageMemory>& mem = budget.memory();
+
+    EXPECT_EQ(budget_pages * vd::CachePage::size(),
+              mem->capacity());
+
+    auto drain([](vd::CachePagePool& pool) -> std::vector<vd::CachePage*>
+               {
+                   std::vector<vd::CachePage*> pages;
+                   while (vd::CachePage* p = pool.allocate())
+                   {
+                       pages.push_back(p);
+                   }
+                   return pages;
+               });
+
+    std::vector<vd::CachePage*> wpages(drain(*wide));
+    EXPECT_EQ(budget_pages, wpages.size());
+    EXPECT_EQ(mem->capacity(), mem->used());
+
+    // the wide pages took all the memory ...
+    EXPECT_TRUE(compact->allocate() == nullptr);
+
+    // ... which doesn't stop reservations
+    vd::CachePage* p = compact->allocate(true);
+    ASSERT_TRUE(p != nullptr);
+    EXPECT_LT(mem->capacity(), mem->used());
+    compact->release(*p);
+    EXPECT_EQ(1U, compact->trim());
+    EXPECT_EQ(mem->capacity(), mem->used());
+
+    for (vd::CachePage* p : wpages)
+    {
+        wide->release(*p);
+    }
+
+    // free but not trimmed yet
+    EXPECT_TRUE(compact->allocate() == nullptr);
+
+    EXPECT_EQ(budget_pages, wide->trim());
+    EXPECT_EQ(0U, mem->used());
+
+    std::vector<vd::CachePage*> cpages(drain(*compact));
+    EXPECT_EQ(budget_pages * vd::CachePage::pages_per_wide_page(vd::PageFormat::Compact),
+              cpages.size());
+    EXPECT_EQ(mem->capacity(), mem->used());
+    EXPECT_TRUE(wide->allocate() == nullptr);
+
+    for (vd::CachePage* p : cpages)
+    {
+        compact->release(*p);
+    }
+
+    EXPECT_EQ(cpages.size(), compact->trim());
+    EXPECT_EQ(0U, mem->used());
+}
+
+TEST_F(MetaDataCacheBudgetTest, registration)
+{
+    const uint64_t min_pages = 16;
+    vd::MetaDataCacheBudget budget(128,
+                                   min_pages);
+
+    Client c1;
+    Client c2;
+    Client c3;
+
+    EXPECT_EQ(64U, budget.register_client(c1, 64));
+    EXPECT_EQ(64U, budget.register_client(c2, 96));
+    // nothing left, but everyone gets the minimum
+    EXPECT_EQ(min_pages, budget.register_client(c3, 64));
+
+    budget.unregister_client(c3);
+    budget.unregister_client(c2);
+    budget.unregister_client(c1);
+}
+
+TEST_F(MetaDataCacheBudgetTest, rebalance)
+{
+    const uint64_t pages = 1024;
+    const uint64_t min_pages = 64;
+    vd::MetaDataCacheBudget budget(pages,
+                                   min_pages);
+
+    Client busy;
+    Client idle;
+
+    busy.quota = budget.register_client(busy, pages / 2);
+    idle.quota = budget.register_client(idle, pages / 2);
+
+    // no misses at all -> nothing changes
+    budget.rebalance();
+    EXPECT_EQ(pages / 2, busy.quota);
+    EXPECT_EQ(pages / 2, idle.quota);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        busy.cost = 1000;
+        budget.rebalance();
+
+        EXPECT_GE(pages, busy.quota + idle.quota);
+        EXPECT_LE(min_pages, idle.quota);
+    }
+
+    EXPECT_EQ(min_pages, idle.quota);
+    EXPECT_LT(pages - 2 * min_pages, busy.quota);
+
+    // the tables are turned, gradually
+    idle.cost = 1000;
+    budget.rebalance();
+
+    EXPECT_LT(min_pages, idle.quota);
+    EXPECT_LT(idle.quota, busy.quota);
+
+    budget.unregister_client(idle);
+    budget.unregister_client(busy);
+}
+
+}
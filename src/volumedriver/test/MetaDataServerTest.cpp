@@ -16,6 +16,7 @@
 #include "MDSTestSetup.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <youtils/FileUtils.h>
 #include <gtest/gtest.h>
@@ -709,10 +710,21 @@ TEST_P(MetaDataServerTest, exceeding_the_shmem_size)
     EXPECT_EQ(expect_overrun ? 1U : 0U, shmem_out_overruns());
     EXPECT_EQ(0U, shmem_in_overruns());
 
+    if (expect_overrun)
+    {
+        EXPECT_LT(GetParam().shmem_size,
+                  client->shmem_size());
+    }
+    else
+    {
+        EXPECT_EQ(0U, client->shmem_size());
+    }
+
+    // the shmem region was grown after the overrun
     mds::TableInterface::MaybeStrings mvals(table->multiget(keys));
 
-    EXPECT_EQ(expect_overrun ? 2U : 0U, shmem_out_overruns());
-    EXPECT_EQ(expect_overrun ? 1U : 0U, shmem_in_overruns());
+    EXPECT_EQ(expect_overrun ? 1U : 0U, shmem_out_overruns());
+    EXPECT_EQ(0U, shmem_in_overruns());
 
     ASSERT_EQ(keys.size(),
               mvals.size());
@@ -724,6 +736,73 @@ TEST_P(MetaDataServerTest, exceeding_the_shmem_size)
     }
 }
 
+TEST_P(MetaDataServerTest, shared_client)
+{
+    const size_t nthreads = 2 * mds::ClientNG::default_max_channels;
+    const size_t iterations = 256;
+
+    be::BackendTestSetup::WithRandomNamespace wrns("",
+                                                   cm_);
+
+    auto client(make_client());
+    client->open(wrns.ns().str())->set_role(mds::Role::Master);
+
+    auto fun([&](size_t t)
+             {
+                 auto table(client->open(wrns.ns().str()));
+
+                 for (size_t i = 0; i < iterations; ++i)
+                 {
+                     const std::string key(boost::lexical_cast<std::string>(t) +
+                                           "-" +
+                                           boost::lexical_cast<std::string>(i));
+                     // make some of them overrun the shmem
+                     const std::string val(key + std::string(i % 64 ? 0 : 16ULL << 10,
+                                                             'v'));
+
+                     const mds::TableInterface::Keys keys{ mds::Key(key) };
+
+                     table->multiset({ mds::Record(mds::Key(key),
+                                                   mds::Value(val)) },
+                                     Barrier::F);
+
+                     const mds::TableInterface::MaybeStrings
+                         mvals(table->multiget(keys));
+
+                     ASSERT_EQ(1U, mvals.size());
+                     ASSERT_TRUE(mvals[0] != boost::none);
+                     ASSERT_EQ(val, *mvals[0]);
+                 }
+             });
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(nthreads);
+
+    for (size_t i = 0; i < nthreads; ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async,
+                                        fun,
+                                        i));
+    }
+
+    for (auto& f : futures)
+    {
+        f.get();
+    }
+
+    EXPECT_LT(0U, client->channels());
+    EXPECT_GE(mds::ClientNG::default_max_channels, client->channels());
+
+    mds::ClientNG::OutCounters out;
+    mds::ClientNG::InCounters in;
+    client->counters(out,
+                     in);
+
+    // 2 requests per iteration, one open per thread + the initial open / set_role
+    EXPECT_EQ(nthreads * (2 * iterations + 1) + 2, out.messages);
+    EXPECT_EQ(out.messages, in.messages);
+}
+
 TEST_P(MetaDataServerTest, empty_multiget_performance)
 {
     test_multiget_performance(true,
@@ -748,6 +827,84 @@ TEST_P(MetaDataServerTest, multiget_performance_local)
                               false);
 }
 
+TEST_P(MetaDataServerTest, replication)
+{
+    // The slave only polls the backend every 300 seconds - only the replication
+    // stream can get the updates there in time.
+    auto slave_manager(mds_test_setup_->make_manager(cm_,
+                                                     1));
+    const mds::ServerConfigs slave_cfgs(slave_manager->server_configs());
+    ASSERT_EQ(1U, slave_cfgs.size());
+
+    be::BackendTestSetup::WithRandomNamespace wrns("",
+                                                   cm_);
+    const std::string nspace(wrns.ns().str());
+
+    auto slave_client(mds::ClientNG::create(slave_cfgs[0].node_config,
+                                            GetParam().shmem_size,
+                                            boost::none,
+                                            GetParam().force_remote));
+    auto slave(slave_client->open(nspace));
+    ASSERT_EQ(mds::Role::Slave,
+              slave->get_role());
+
+    auto client(make_client());
+    auto master(client->open(nspace));
+    master->set_role(mds::Role::Master);
+    master->set_slaves({ slave_cfgs[0].node_config });
+
+    const std::string key("key");
+    const std::string val("val");
+    const mds::TableInterface::Keys keys{ mds::Key(key) };
+
+    auto wait_for_slave([&](const boost::optional<std::string>& exp)
+                        {
+                            for (size_t i = 0; i < 100; ++i)
+                            {
+                                if (slave->multiget(keys)[0] == exp)
+                                {
+                                    return true;
+                                }
+
+                                boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+                            }
+
+                            return false;
+                        });
+
+    master->multiset({ mds::Record(mds::Key(key),
+                                   mds::Value(val)) },
+                     Barrier::F);
+
+    EXPECT_TRUE(wait_for_slave(val));
+
+    master->multiset({ mds::Record(mds::Key(key),
+                                   mds::Value(mds::None())) },
+                     Barrier::F);
+
+    EXPECT_TRUE(wait_for_slave(boost::none));
+
+    mds::ReplicationUpdate update;
+    update.stream = "some-other-stream";
+    update.seq = 42;
+    update.records.emplace_back(key,
+                                val);
+
+    EXPECT_THROW(master->replicate(update),
+                 std::exception);
+
+    // Out of sequence: the slave loses track of the stream and has to wait
+    // for the backend catch up.
+    EXPECT_FALSE(slave->replicate(update));
+    EXPECT_TRUE(slave->multiget(keys)[0] == boost::none);
+
+    master->multiset({ mds::Record(mds::Key(key),
+                                   mds::Value(val)) },
+                     Barrier::F);
+
+    EXPECT_FALSE(wait_for_slave(val));
+}
+
 INSTANTIATE_TEST_CASE_P(MetaDataServerTests,
                         MetaDataServerTest,
                         ::testing::Values(Config(ForceRemote::F,
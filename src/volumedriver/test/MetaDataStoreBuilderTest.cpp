@@ -20,6 +20,8 @@
 #include "../MetaDataStoreBuilder.h"
 
 #include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scope_exit.hpp>
 
 namespace volumedrivertest
 {
@@ -68,7 +70,7 @@ protected:
         vd::MetaDataStoreInterface& orig_;
     };
 
-    virtual void
+    virtual vd::MetaDataStoreBuilder::Result
     check(vd::Volume& vol,
           vd::MetaDataStoreInterface& copy)
     {
@@ -77,9 +79,10 @@ protected:
 
         be::BackendInterfacePtr bi(vol.getBackendInterface()->clone());
 
-        vd::MetaDataStoreBuilder(copy,
-                                 bi->clone(),
-                                 scratch_dir)();
+        const vd::MetaDataStoreBuilder::Result
+            res(vd::MetaDataStoreBuilder(copy,
+                                         bi->clone(),
+                                         scratch_dir)());
 
         const vd::ClusterAddress max_ca =
             vol.getSize() / vol.getClusterSize();
@@ -93,6 +96,8 @@ protected:
 
         orig.for_each(cmp,
                       max_ca);
+
+        return res;
     }
 };
 
@@ -198,6 +203,58 @@ TEST_P(MetaDataStoreBuilderTest, clone)
           copy);
 }
 
+TEST_P(MetaDataStoreBuilderTest, overwrites_across_tlogs)
+{
+    const uint32_t fetchers = vd::CachedMetaDataStore::replayTLogFetchers;
+
+    BOOST_SCOPE_EXIT((fetchers))
+    {
+        vd::CachedMetaDataStore::replayTLogFetchers = fetchers;
+    }
+    BOOST_SCOPE_EXIT_END;
+
+    // fewer fetchers than TLogs
+    vd::CachedMetaDataStore::replayTLogFetchers = 3;
+
+    auto ns(make_random_namespace());
+    vd::SharedVolumePtr v = newVolume(*ns,
+                                      vd::VolumeSize(4ULL << 20));
+
+    const size_t count = 8;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        writeToVolume(*v,
+                      0,
+                      v->getSize() / (i % 2 ? 2 : 4),
+                      "overwrite-"s + boost::lexical_cast<std::string>(i));
+
+        v->createSnapshot(SnapshotName("snap-"s +
+                                       boost::lexical_cast<std::string>(i)));
+        waitForThisBackendWrite(*v);
+    }
+
+    const fs::path db_dir(directory_ / "db_copy");
+    fs::create_directories(db_dir);
+
+    auto tc(std::make_shared<vd::TokyoCabinetMetaDataBackend>(db_dir,
+                                                              true));
+
+    be::BackendInterfacePtr bi(v->getBackendInterface()->clone());
+
+    vd::CachedMetaDataStore copy(tc,
+                                 "copy-of-"s + bi->getNS().str());
+
+    const vd::MetaDataStoreBuilder::Result res(check(*v,
+                                                     copy));
+
+    EXPECT_LE(count, res.num_tlogs);
+    EXPECT_FALSE(res.full_rebuild);
+    EXPECT_LE(0, res.prepare_seconds);
+    EXPECT_LE(0, res.collect_seconds);
+    EXPECT_LT(0, res.replay_seconds);
+}
+
 INSTANTIATE_TEST(MetaDataStoreBuilderTest);
 
 }
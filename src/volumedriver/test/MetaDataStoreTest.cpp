@@ -25,6 +25,7 @@
 
 #include <snappy.h>
 
+#include <youtils/ScopeExit.h>
 #include <youtils/SourceOfUncertainty.h>
 #include <youtils/System.h>
 #include <youtils/UUID.h>
@@ -201,9 +202,12 @@ protected:
         boost::unique_lock<decltype(CachedMetaDataStore::cache_lock_)>
             cachewg(md->cache_lock_);
 
-        for (CachePage& p : md->page_list_)
+        for (auto l : { &md->recent_list_, &md->frequent_list_ })
         {
-            md->maybeWritePage_locked_context(p, false);
+            for (CachePage& p : *l)
+            {
+                md->maybeWritePage_locked_context(p, false);
+            }
         }
 
         std::cout <<
@@ -1009,7 +1013,7 @@ struct MetaDataCounter
     uint64_t count_;
 };
 
-TEST_P(MetaDataStoreTest, LRU)
+TEST_P(MetaDataStoreTest, page_replacement)
 {
     const uint32_t npages(youtils::System::get_env_with_default<uint32_t>("MD_PAGES",
                                                                           32));
@@ -1094,18 +1098,273 @@ TEST_P(MetaDataStoreTest, LRU)
 
     check_stats(Entries(npages), Hits(npages), Misses(npages + 1));
 
-    // read page N - this should've caused another miss
+    // page N was used least recently but is still there as the pages are
+    // evicted in the order they were loaded as long as they were not evicted
+    // before
     {
         ClusterLocationAndHash clh;
         md->readCluster((npages - 1) * page_entries, clh);
+        const ClusterLocation loc(npages);
+        EXPECT_EQ(loc, clh.clusterLocation);
+
+        check_stats(Entries(npages), Hits(npages + 1), Misses(npages + 1));
+    }
+
+    // read page 0 - this should've caused another miss ...
+    {
+        ClusterLocationAndHash clh;
+        md->readCluster(0, clh);
 #ifdef ENABLE_MD5_HASH
         EXPECT_EQ(w, clh.weed());
 #endif
-        const ClusterLocation loc(npages);
+        const ClusterLocation loc(1);
         EXPECT_EQ(loc, clh.clusterLocation);
 
-        check_stats(Entries(npages), Hits(npages), Misses(npages + 2));
+        check_stats(Entries(npages), Hits(npages + 1), Misses(npages + 2));
     }
+
+    // ... and it's considered a frequently used one now
+    MetaDataStoreStats mds;
+    md->getStats(mds);
+
+    EXPECT_EQ(1U, mds.ghost_hits);
+    EXPECT_EQ(1U, mds.frequent_pages);
+    EXPECT_EQ(0U, mds.frequent_hits);
+}
+
+TEST_P(MetaDataStoreTest, scan_resistance)
+{
+    const uint32_t npages = 32;
+    const uint64_t page_entries = CachePage::capacity();
+    // small enough to fit into the cache, but a sequential scan of more than
+    // the cache size happens between two accesses
+    const uint64_t hot_pages = 4;
+    const uint64_t scan_pages = npages + 4;
+    const uint64_t warmup_rounds = 2;
+    const uint64_t rounds = 6;
+    const uint64_t vsize = (hot_pages + (warmup_rounds + rounds) * scan_pages) *
+        page_entries * default_cluster_size();
+
+    auto ns_ptr = make_random_namespace();
+
+    auto v = newVolume("vol",
+                       ns_ptr->ns(),
+                       VolumeSize(vsize),
+                       default_sco_multiplier(),
+                       default_lba_size(),
+                       default_cluster_multiplier(),
+                       npages);
+
+    MetaDataStoreInterface* md = v->getMetaDataStore();
+
+    uint64_t next_scan_page = hot_pages;
+
+    auto round([&]
+               {
+                   ClusterLocationAndHash clh;
+
+                   for (uint64_t i = 0; i < hot_pages; ++i)
+                   {
+                       md->readCluster(i * page_entries, clh);
+                   }
+
+                   for (uint64_t i = 0; i < scan_pages; ++i, ++next_scan_page)
+                   {
+                       // correlated references to the same page
+                       for (uint64_t j = 0; j < 4; ++j)
+                       {
+                           md->readCluster(next_scan_page * page_entries + j,
+                                           clh);
+                       }
+                   }
+               });
+
+    // the hot pages are evicted by the scan but referenced again shortly
+    // thereafter
+    for (uint64_t i = 0; i < warmup_rounds; ++i)
+    {
+        round();
+    }
+
+    MetaDataStoreStats before;
+    md->getStats(before);
+
+    EXPECT_EQ(hot_pages, before.ghost_hits);
+    EXPECT_EQ(hot_pages, before.frequent_pages);
+
+    for (uint64_t i = 0; i < rounds; ++i)
+    {
+        round();
+    }
+
+    MetaDataStoreStats after;
+    md->getStats(after);
+
+    // only the scanned pages missed
+    EXPECT_EQ(rounds * scan_pages,
+              after.cache_misses - before.cache_misses);
+    EXPECT_EQ(rounds * hot_pages,
+              after.frequent_hits - before.frequent_hits);
+    EXPECT_EQ(hot_pages, after.frequent_pages);
+}
+
+TEST_P(MetaDataStoreTest, write_behind)
+{
+    const uint32_t npages = 32;
+    const uint64_t page_entries = CachePage::capacity();
+    const uint64_t vsize = 4 * npages * page_entries * default_cluster_size();
+
+    const uint32_t high_watermark = CachedMetaDataStore::writeBehindHighWatermark;
+
+    auto on_exit(yt::make_scope_exit([&]
+                                     {
+                                         CachedMetaDataStore::writeBehindHighWatermark =
+                                             high_watermark;
+                                     }));
+
+    auto ns_ptr = make_random_namespace();
+
+    auto v = newVolume("vol",
+                       ns_ptr->ns(),
+                       VolumeSize(vsize),
+                       default_sco_multiplier(),
+                       default_lba_size(),
+                       default_cluster_multiplier(),
+                       npages);
+
+    MetaDataStoreInterface* md = v->getMetaDataStore();
+
+    // twice as many pages as fit into the cache, one cluster each
+    auto write([&](uint64_t first_page)
+               {
+                   for (uint64_t i = first_page; i < first_page + 2 * npages; ++i)
+                   {
+                       const ClusterLocation loc(i + 1);
+                       const ClusterLocationAndHash clh(loc, w);
+                       md->writeCluster(i * page_entries, clh);
+                   }
+
+                   md->cork(yt::UUID());
+                   md->unCork();
+               });
+
+    write(0);
+
+    MetaDataStoreStats mds;
+    md->getStats(mds);
+
+    // dirty pages were written out before the cache filled up, so the misses
+    // found clean pages to evict
+    EXPECT_EQ(0U, mds.eviction_stalls);
+    EXPECT_EQ(0U, mds.dirty_pages);
+    EXPECT_EQ(npages, mds.cached_pages);
+    EXPECT_EQ(2 * npages, mds.used_clusters);
+
+    // without write behind each miss has to write out a dirty page first
+    CachedMetaDataStore::writeBehindHighWatermark = 100;
+
+    write(2 * npages);
+
+    md->getStats(mds);
+
+    EXPECT_EQ(npages, mds.eviction_stalls);
+    EXPECT_EQ(0U, mds.dirty_pages);
+    EXPECT_EQ(4 * npages, mds.used_clusters);
+
+    for (uint64_t i = 0; i < 4 * npages; ++i)
+    {
+        ClusterLocationAndHash clh;
+        md->readCluster(i * page_entries, clh);
+        EXPECT_EQ(ClusterLocation(i + 1), clh.clusterLocation);
+    }
+}
+
+TEST_P(MetaDataStoreTest, compact_pages)
+{
+    const uint32_t npages = 8;
+    const uint64_t page_entries = CachePage::capacity();
+    const uint64_t vsize = 4 * npages * page_entries * default_cluster_size();
+
+    auto ns_ptr = make_random_namespace();
+
+    auto v = newVolume("vol",
+                       ns_ptr->ns(),
+                       VolumeSize(vsize),
+                       default_sco_multiplier(),
+                       default_lba_size(),
+                       default_cluster_multiplier(),
+                       npages);
+
+    MetaDataStoreInterface* md = v->getMetaDataStore();
+    EXPECT_EQ(PageFormat::Wide,
+              md->page_format());
+
+    // more pages than fit into the cache, one cluster each
+    auto write([&](uint64_t offset)
+               {
+                   for (uint64_t i = 0; i < 2 * npages; ++i)
+                   {
+                       const ClusterLocation loc(i + offset + 1);
+                       const ClusterLocationAndHash clh(loc, w);
+                       md->writeCluster(i * page_entries, clh);
+                   }
+
+                   md->cork(yt::UUID());
+                   md->unCork();
+               });
+
+    auto check([&](uint64_t offset,
+                   const yt::Weed& weed)
+               {
+                   for (uint64_t i = 0; i < 2 * npages; ++i)
+                   {
+                       ClusterLocationAndHash clh;
+                       md->readCluster(i * page_entries, clh);
+                       EXPECT_EQ(ClusterLocation(i + offset + 1), clh.clusterLocation);
+                       if (ClusterLocationAndHash::use_hash())
+                       {
+                           EXPECT_TRUE(weed == clh.weed());
+                       }
+                   }
+               });
+
+    write(0);
+    check(0, w);
+
+    md->set_page_format(PageFormat::Compact);
+    if (md->page_format() != PageFormat::Compact)
+    {
+        LOG_WARN("backend does not support compact pages, skipping the rest of the test");
+        return;
+    }
+
+    MetaDataStoreStats mds;
+    md->getStats(mds);
+
+    EXPECT_EQ(npages * CachePage::pages_per_wide_page(PageFormat::Compact),
+              mds.max_pages);
+    EXPECT_EQ(2 * npages, mds.used_clusters);
+
+    // the hashes are gone, the locations are not
+    check(0, yt::Weed::null());
+
+    write(2 * npages);
+    check(2 * npages, yt::Weed::null());
+
+    // the hashes cannot be brought back without starting over
+    EXPECT_THROW(md->set_page_format(PageFormat::Wide),
+                 MetaDataStoreException);
+
+    md->clear_all_keys();
+    EXPECT_EQ(PageFormat::Compact,
+              md->page_format());
+
+    md->set_page_format(PageFormat::Wide);
+    EXPECT_EQ(PageFormat::Wide,
+              md->page_format());
+
+    write(0);
+    check(0, w);
 }
 
 TEST_P(MetaDataStoreTest, DISABLED_page_compression)
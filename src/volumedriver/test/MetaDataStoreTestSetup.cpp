@@ -42,6 +42,9 @@ opt_traits_t::str_ = {
     },
     {
         volumedriver::MetaDataBackendType::TCBT, "TCBT"
+    },
+    {
+        volumedriver::MetaDataBackendType::MMap, "MMAP"
     }
 };
 }
@@ -92,6 +95,9 @@ MetaDataStoreTestSetup::make_config()
     case vd::MetaDataBackendType::TCBT:
         cfg.reset(new vd::TCBTMetaDataBackendConfig());
         break;
+    case vd::MetaDataBackendType::MMap:
+        cfg.reset(new vd::MMapMetaDataBackendConfig());
+        break;
     }
 
     return cfg;
@@ -196,10 +196,38 @@ private:
     boost::program_options::options_description desc_;
 };
 
-typedef LOKI_TYPELIST_4(ArakoonMDStoreOptions,
+class MMapMDStoreOptions
+    : public youtils::AlternativeOptionAgain<volumedriver::MetaDataBackendType,
+                                             volumedriver::MetaDataBackendType::MMap>
+{
+public:
+    MMapMDStoreOptions()
+    {}
+
+    void
+    actions() override
+    {
+        LOG_INFO("Running the tests with " << id_() <<
+                 " metadata stores");
+        MetaDataStoreTestSetup::backend_type_ = volumedriver::MetaDataBackendType::MMap;
+    }
+
+    const boost::program_options::options_description&
+    options_description() const override
+    {
+        return desc_;
+    }
+
+private:
+    DECLARE_LOGGER("MMapOptions");
+    boost::program_options::options_description desc_;
+};
+
+typedef LOKI_TYPELIST_5(ArakoonMDStoreOptions,
                         MDSMDStoreOptions,
                         RocksDBMDStoreOptions,
-                        TCBTMDStoreOptions)
+                        TCBTMDStoreOptions,
+                        MMapMDStoreOptions)
     metadata_options_t;
 
 }
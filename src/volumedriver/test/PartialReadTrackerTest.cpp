@@ -0,0 +1,126 @@
+// Copyright (C) 2016 iNuron NV
+//
+// This file is part of Open vStorage Open Source Edition (OSE),
+// as available from
+//
+//      http://www.openvstorage.org and
+//      http://www.openvstorage.com.
+//
+// This file is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Affero General Public License v3 (GNU AGPLv3)
+// as published by the Free Software Foundation, in version 3 as it comes in
+// the LICENSE.txt file of the Open vStorage OSE distribution.
+// Open vStorage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY of any kind.
+
+#include "../PartialReadTracker.h"
+
+#include <gtest/gtest.h>
+
+namespace volumedrivertest
+{
+
+using namespace volumedriver;
+namespace bc = boost::chrono;
+
+class PartialReadTrackerTest
+    : public testing::Test
+{
+protected:
+    const ClusterSize csize_ = ClusterSize(4096);
+    const SCOMultiplier sco_mult_ = SCOMultiplier(1024);
+    const bc::seconds window_ = bc::seconds(60);
+};
+
+TEST_F(PartialReadTrackerTest, fixed_threshold)
+{
+    PartialReadTracker t;
+    const SCO sco(SCONumber(1));
+    const uint32_t thresh = 8;
+
+    for (SCOOffset i = 0; i < thresh - 1; ++i)
+    {
+        EXPECT_FALSE(t.record(sco, i, 1, csize_, sco_mult_, window_, thresh));
+        // reading the same cluster again does not increase the density
+        EXPECT_FALSE(t.record(sco, i, 1, csize_, sco_mult_, window_, thresh));
+    }
+
+    EXPECT_EQ(1U, t.size());
+    EXPECT_TRUE(t.record(sco, thresh - 1, 1, csize_, sco_mult_, window_, thresh));
+    EXPECT_EQ(0U, t.size());
+    EXPECT_EQ(1U, t.promotions());
+}
+
+TEST_F(PartialReadTrackerTest, window)
+{
+    PartialReadTracker t;
+    const SCO sco(SCONumber(1));
+    const uint32_t thresh = 4;
+    const auto now = PartialReadTracker::Clock::now();
+
+    EXPECT_FALSE(t.record(sco, 0, 2, csize_, sco_mult_, window_, thresh, now));
+    EXPECT_FALSE(t.record(sco, 2, 1, csize_, sco_mult_, window_, thresh,
+                          now + window_ + bc::seconds(1)));
+    EXPECT_TRUE(t.record(sco, 4, 3, csize_, sco_mult_, window_, thresh,
+                         now + window_ + bc::seconds(2)));
+
+    EXPECT_FALSE(t.record(sco, 0, sco_mult_, csize_, sco_mult_, bc::seconds(0), thresh));
+    EXPECT_EQ(0U, t.size());
+}
+
+TEST_F(PartialReadTrackerTest, bounded)
+{
+    const size_t max = 16;
+    PartialReadTracker t(max);
+
+    for (size_t i = 0; i < 4 * max; ++i)
+    {
+        EXPECT_FALSE(t.record(SCO(SCONumber(i)), 0, 1, csize_, sco_mult_, window_, 2));
+        EXPECT_GE(max, t.size());
+    }
+}
+
+TEST_F(PartialReadTrackerTest, auto_threshold)
+{
+    PartialReadTracker t;
+    EXPECT_FALSE(t.cost_model());
+    EXPECT_EQ(sco_mult_ / 8, t.auto_threshold(csize_, sco_mult_));
+
+    // same-sized samples don't allow to tell latency and bandwidth apart
+    for (size_t i = 0; i < 32; ++i)
+    {
+        t.backend_read(csize_, bc::microseconds(1000));
+    }
+
+    EXPECT_FALSE(t.cost_model());
+
+    // 1ms latency, 100 MB/s
+    const uint64_t sco_size = csize_ * sco_mult_;
+    for (size_t i = 0; i < 32; ++i)
+    {
+        t.backend_read(csize_, bc::microseconds(1000 + csize_ / 100));
+        t.backend_read(sco_size, bc::microseconds(1000 + sco_size / 100));
+    }
+
+    const boost::optional<PartialReadTracker::CostModel> m(t.cost_model());
+    ASSERT_TRUE(m != boost::none);
+    EXPECT_NEAR(1000, m->latency_usecs, 50);
+    EXPECT_NEAR(0.01, m->usecs_per_byte, 0.001);
+
+    // a full SCO costs as much as ~42 partial reads of one cluster
+    const uint32_t k = t.auto_threshold(csize_, sco_mult_);
+    EXPECT_LT(30U, k);
+    EXPECT_GT(60U, k);
+
+    // A really slow backend (connection-wise) favours full fetches
+    PartialReadTracker u;
+    for (size_t i = 0; i < 32; ++i)
+    {
+        u.backend_read(csize_, bc::microseconds(100000));
+        u.backend_read(sco_size, bc::microseconds(100000 + sco_size / 1000));
+    }
+
+    EXPECT_GT(k, u.auto_threshold(csize_, sco_mult_));
+}
+
+}
@@ -14,13 +14,21 @@
 // but WITHOUT ANY WARRANTY of any kind.
 
 #include "VolManagerTestSetup.h"
+#include "../DataStoreNG.h"
 #include "../PrefetchData.h"
 #include "../SCOCache.h"
 #include "../VolManager.h"
 
+#include <youtils/ConfigurationReport.h>
+#include <youtils/UpdateReport.h>
+
 namespace volumedriver
 {
 
+namespace bpt = boost::property_tree;
+namespace ip = initialized_params;
+namespace yt = youtils;
+
 class PrefetchThreadTest
     : public VolManagerTestSetup
 {
@@ -30,6 +38,24 @@ public:
         : VolManagerTestSetup("PrefetchThreadTest")
     {}
 
+    void
+    set_prefetch_bandwidth(uint32_t mib_per_sec)
+    {
+        bpt::ptree pt;
+        VolManager& vm = *VolManager::get();
+        vm.persistConfiguration(pt);
+
+        ip::PARAMETER_TYPE(prefetch_max_mib_per_sec)(mib_per_sec).persist(pt);
+        yt::UpdateReport urep;
+        yt::ConfigurationReport crep;
+
+        vm.updateConfiguration(pt,
+                               urep,
+                               crep);
+
+        ASSERT_EQ(mib_per_sec,
+                  vm.prefetch_max_mib_per_sec.value());
+    }
 };
 
 TEST_P(PrefetchThreadTest, test_one)
@@ -141,6 +167,108 @@ TEST_P(PrefetchThreadTest, test_two)
                   RemoveVolumeCompletely::F);
 }
 
+TEST_P(PrefetchThreadTest, cancel_once_working_set_is_resident)
+{
+    auto ns_ptr = make_random_namespace();
+    const backend::Namespace& ns = ns_ptr->ns();
+
+    SharedVolumePtr v = newVolume("v1",
+                                  ns);
+
+    // reads served by the cluster cache never make it to the DataStore's
+    // hit / miss counters the cancellation is based on
+    v->set_cluster_cache_behaviour(ClusterCacheBehaviour::NoCache);
+
+    const VolumeConfig cfg = v->get_config();
+    const uint64_t sco_size = cfg.getSCOSize();
+    const size_t nscos = 8;
+
+    for (size_t i = 0; i < nscos; ++i)
+    {
+        writeToVolume(*v,
+                      0,
+                      sco_size,
+                      "prefetch");
+    }
+
+    syncToBackend(*v);
+
+    SCOCache& sc = *VolManager::get()->getSCOCache();
+    SCONameList list;
+    sc.getSCONameList(ns,
+                      list,
+                      true);
+    ASSERT_EQ(nscos, list.size());
+
+    // the whole working set (the last SCO) stays resident, all others
+    // have to be prefetched
+    const SCO hot = *std::max_element(list.begin(),
+                                      list.end(),
+                                      [](const SCO& a,
+                                         const SCO& b)
+                                      {
+                                          return a.number() < b.number();
+                                      });
+
+    for (const auto& sco : list)
+    {
+        if (sco != hot)
+        {
+            sc.removeSCO(ns,
+                         sco,
+                         false);
+        }
+    }
+
+    // slow enough to keep SCOs queued for the remainder of the test
+    set_prefetch_bandwidth(1);
+
+    for (const auto& sco : list)
+    {
+        if (sco != hot)
+        {
+            v->getPrefetchData().addSCO(sco,
+                                        1);
+        }
+    }
+
+    DataStoreNG& ds = *v->getDataStore();
+    const uint64_t hits = ds.getCacheHits();
+    const uint64_t misses = ds.getCacheMisses();
+
+    const size_t nreads = 2048;
+    for (size_t i = 0; i < nreads; ++i)
+    {
+        checkVolume(*v,
+                    0,
+                    v->getClusterSize(),
+                    "prefetch");
+    }
+
+    ASSERT_EQ(hits + nreads, ds.getCacheHits());
+    ASSERT_EQ(misses, ds.getCacheMisses());
+
+    size_t count = 0;
+    while (v->getPrefetchData().cancellations() == 0 and count++ < 60)
+    {
+        boost::this_thread::sleep_for(boost::chrono::seconds(1));
+    }
+
+    EXPECT_LT(0U, v->getPrefetchData().cancellations());
+
+    SCONameList list2;
+    sc.getSCONameList(ns,
+                      list2,
+                      true);
+    EXPECT_GT(nscos, list2.size());
+
+    set_prefetch_bandwidth(0);
+
+    destroyVolume(v,
+                  DeleteLocalData::T,
+                  RemoveVolumeCompletely::F);
+}
+
 INSTANTIATE_TEST(PrefetchThreadTest);
 
 
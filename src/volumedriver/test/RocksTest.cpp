@@ -17,7 +17,9 @@
 #include "../metadata-server/RocksTable.h"
 
 #include <algorithm>
+#include <future>
 #include <map>
+#include <numeric>
 #include <set>
 
 #include <boost/algorithm/string.hpp>
@@ -35,6 +37,7 @@ namespace metadata_server_test
 namespace fs = boost::filesystem;
 namespace mds = metadata_server;
 namespace rdb = rocksdb;
+namespace vd = volumedriver;
 namespace yt = youtils;
 
 using namespace std::string_literals;
@@ -297,6 +300,97 @@ TEST_F(RocksTest, multi_set_n_get)
     test_multi_set_n_get_n_delete(64);
 }
 
+TEST_F(RocksTest, batch_size_histogram)
+{
+    std::vector<uint64_t> h;
+
+    for (const size_t n : { 1, 2, 3, 4, 7, 8, 127, 128, 100000 })
+    {
+        mds::TableCounters::record_batch_size(h,
+                                              n);
+    }
+
+    const std::vector<uint64_t> exp{ 1, 2, 2, 1, 0, 0, 1, 2 };
+    EXPECT_EQ(exp, h);
+}
+
+TEST_F(RocksTest, concurrent_requests_on_multiple_tables)
+{
+    mds::RocksDataBase db(path_);
+
+    const size_t ntables = 8;
+    const size_t nrequests = 64;
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(ntables);
+
+    for (size_t t = 0; t < ntables; ++t)
+    {
+        mds::TableInterfacePtr table(db.open("table-"s +
+                                             boost::lexical_cast<std::string>(t)));
+
+        futures.emplace_back(std::async(std::launch::async,
+                                        [table, t, nrequests, this]
+                                        {
+                                            for (size_t i = 0; i < nrequests; ++i)
+                                            {
+                                                const std::string key(boost::lexical_cast<std::string>(i));
+                                                const std::string val(key + "@"s +
+                                                                      boost::lexical_cast<std::string>(t));
+                                                mds::TableInterfacePtr tp(table);
+                                                set(tp,
+                                                    mds::Record(mds::Key(key),
+                                                                mds::Value(val)),
+                                                    i % 8 ? Barrier::F : Barrier::T);
+
+                                                ASSERT_EQ(boost::optional<std::string>(val),
+                                                          get(tp,
+                                                              mds::Key(key)));
+                                            }
+                                        }));
+    }
+
+    for (auto& f : futures)
+    {
+        f.get();
+    }
+
+    auto sum([](const std::vector<uint64_t>& v) -> uint64_t
+             {
+                 return std::accumulate(v.begin(),
+                                        v.end(),
+                                        0ULL);
+             });
+
+    for (size_t t = 0; t < ntables; ++t)
+    {
+        mds::TableInterfacePtr table(db.open("table-"s +
+                                             boost::lexical_cast<std::string>(t)));
+
+        const mds::TableCounters c(table->get_counters(vd::Reset::T));
+
+        // every request went into exactly one batch ...
+        EXPECT_EQ(nrequests,
+                  sum(c.multiset_batch_sizes));
+        EXPECT_EQ(nrequests,
+                  sum(c.multiget_batch_sizes));
+
+        // ... and there cannot be more batches than requests overall
+        EXPECT_GE(ntables * nrequests,
+                  sum(c.global_multiset_batch_sizes));
+        EXPECT_LT(0U,
+                  sum(c.global_multiset_batch_sizes));
+        EXPECT_GE(ntables * nrequests,
+                  sum(c.global_multiget_batch_sizes));
+
+        const mds::TableCounters d(table->get_counters(vd::Reset::F));
+        EXPECT_TRUE(d.multiset_batch_sizes.empty());
+        EXPECT_TRUE(d.multiget_batch_sizes.empty());
+        EXPECT_EQ(c.global_multiset_batch_sizes,
+                  d.global_multiset_batch_sizes);
+    }
+}
+
 TEST_F(RocksTest, cleared_table)
 {
     const auto pair1(std::make_pair("one"s,
@@ -347,6 +441,98 @@ TEST_F(RocksTest, cleared_table)
     }
 }
 
+TEST_F(RocksTest, bulk_load)
+{
+    const std::string nspace("some-namespace");
+    const size_t count = 1024;
+
+    mds::RocksConfig cfg;
+    cfg.shared_block_cache = mds::SharedBlockCache::T;
+    // small enough to have several SST files ingested
+    cfg.bulk_load_buffer_size = 16ULL << 10;
+
+    auto key([](size_t i)
+             {
+                 return "key-"s + boost::lexical_cast<std::string>(i);
+             });
+
+    auto val([](size_t i,
+                size_t round)
+             {
+                 return std::string(64,
+                                    'a' + (i + round) % 26);
+             });
+
+    {
+        mds::RocksDataBase db(path_,
+                              cfg);
+        mds::TableInterfacePtr table(db.open(nspace));
+
+        set(table,
+            mds::Record(mds::Key("old"s),
+                        mds::Value("old"s)));
+
+        table->begin_bulk_load();
+
+        // overwrite records, also ones that were already ingested
+        for (size_t round = 0; round < 2; ++round)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                set(table,
+                    mds::Record(mds::Key(key(i)),
+                                mds::Value(val(i, round))));
+
+                const auto s(get(table,
+                                 mds::Key(key(i))));
+                ASSERT_TRUE(s != boost::none);
+                EXPECT_EQ(val(i, round), *s);
+            }
+        }
+
+        // deletions of records that are already in the DB, in an ingested
+        // file and in the buffer
+        set(table,
+            mds::Record(mds::Key("old"s),
+                        mds::None()));
+        set(table,
+            mds::Record(mds::Key(key(0)),
+                        mds::None()));
+        set(table,
+            mds::Record(mds::Key(key(count - 1)),
+                        mds::None()));
+
+        EXPECT_TRUE(get(table, mds::Key("old"s)) == boost::none);
+        EXPECT_TRUE(get(table, mds::Key(key(0))) == boost::none);
+        EXPECT_TRUE(get(table, mds::Key(key(count - 1))) == boost::none);
+
+        table->end_bulk_load();
+    }
+
+    mds::RocksDataBase db(path_,
+                          cfg);
+    mds::TableInterfacePtr table(db.open(nspace));
+
+    EXPECT_TRUE(get(table, mds::Key("old"s)) == boost::none);
+    EXPECT_TRUE(get(table, mds::Key(key(0))) == boost::none);
+    EXPECT_TRUE(get(table, mds::Key(key(count - 1))) == boost::none);
+
+    for (size_t i = 1; i < count - 1; ++i)
+    {
+        const auto s(get(table,
+                         mds::Key(key(i))));
+        ASSERT_TRUE(s != boost::none);
+        EXPECT_EQ(val(i, 1), *s);
+    }
+
+    // no leftovers
+    for (fs::directory_iterator it(path_); it != fs::directory_iterator(); ++it)
+    {
+        EXPECT_EQ(std::string::npos,
+                  it->path().filename().string().find("bulk-load"));
+    }
+}
+
 TEST_F(RocksTest, dropped_table)
 {
     const auto pair(std::make_pair("key"s,
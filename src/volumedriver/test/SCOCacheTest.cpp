@@ -1252,6 +1252,145 @@ TEST_F(SCOCacheTest, cleanup2)
     }
 }
 
+TEST_F(SCOCacheTest, cleanup_candidates)
+{
+    SCOCacheMountPointPtr mp = getMountPointList().front();
+
+    const backend::Namespace nspace;
+    const uint64_t numSCOs = mpSizeSCO_;
+
+    addNamespace(nspace);
+
+    SCOCacheNamespace* ns = getNSMap()[nspace];
+    ASSERT_TRUE(ns != nullptr);
+
+    for (unsigned i = 1; i <= numSCOs; ++i)
+    {
+        ClusterLocation loc(i);
+        createAndWriteSCO(nspace,
+                          loc.sco(),
+                          scoSize_,
+                          loc.sco().str());
+    }
+
+    EXPECT_EQ(numSCOs * scoSize_, ns->getSize());
+    EXPECT_EQ(0U, ns->getDisposableSize());
+
+    // older SCOs are accessed more often this time around
+    for (unsigned i = 1; i <= numSCOs; ++i)
+    {
+        ClusterLocation loc(i);
+        CachedSCOPtr sco = scoCache_->findSCO(nspace,
+                                              loc.sco());
+        scoCache_->setSCODisposable(sco);
+        sco->incRefCount(10 * (numSCOs - i + 1));
+    }
+
+    EXPECT_EQ(numSCOs * scoSize_, ns->getSize());
+    EXPECT_EQ(numSCOs * scoSize_, ns->getDisposableSize());
+
+    // the coldest one is in use and hence has to be skipped
+    CachedSCOPtr in_use = scoCache_->findSCO(nspace,
+                                             ClusterLocation(numSCOs).sco());
+
+    scoCache_->cleanup();
+
+    EXPECT_EQ(mpSize_ - backoffGap_, mp->getUsedSize());
+    EXPECT_EQ(mp->getUsedSize(), ns->getSize());
+    EXPECT_EQ(mp->getUsedSize(), ns->getDisposableSize());
+
+    SCONameList l;
+    scoCache_->getSCONameList(nspace, l, true);
+    EXPECT_EQ(mpSizeSCO_ - backoffGapSCO_, l.size());
+
+    for (const auto& scoName : l)
+    {
+        EXPECT_TRUE(scoName.number() < mpSizeSCO_ - backoffGapSCO_ or
+                    scoName.number() == numSCOs) << scoName;
+    }
+
+    // once released it's a candidate again
+    in_use = nullptr;
+
+    for (unsigned i = 1; i <= backoffGapSCO_ - triggerGapSCO_ + 1; ++i)
+    {
+        ClusterLocation loc(numSCOs + i);
+        createAndWriteSCO(nspace,
+                          loc.sco(),
+                          scoSize_,
+                          loc.sco().str());
+    }
+
+    scoCache_->cleanup();
+
+    EXPECT_TRUE(nullptr == scoCache_->findSCO(nspace,
+                                              ClusterLocation(numSCOs).sco()));
+}
+
+TEST_F(SCOCacheTest, xvals)
+{
+    const backend::Namespace nspace;
+    const uint64_t numSCOs = mpSizeSCO_ / 2;
+
+    addNamespace(nspace);
+
+    for (unsigned i = 1; i <= numSCOs; ++i)
+    {
+        ClusterLocation loc(i);
+        CachedSCOPtr sco = createAndWriteSCO(nspace,
+                                             loc.sco(),
+                                             scoSize_,
+                                             loc.sco().str());
+        scoCache_->setSCODisposable(sco);
+    }
+
+    auto check([&]() -> SCOAccessData::VectorType
+               {
+                   SCOAccessData sad(nspace);
+                   scoCache_->fillSCOAccessData(sad);
+
+                   const SCOAccessData::VectorType v(sad.getVector());
+                   EXPECT_EQ(numSCOs, v.size());
+
+                   float sum = 0;
+                   for (const auto& p : v)
+                   {
+                       EXPECT_LE(0, p.second);
+                       sum += p.second;
+                   }
+
+                   EXPECT_NEAR(1.0, sum, 0.001);
+                   return v;
+               });
+
+    // the cleanup (re)normalizes the xvals, no matter whether it evicts
+    // anything
+    scoCache_->cleanup();
+    check();
+
+    for (unsigned round = 0; round < 3; ++round)
+    {
+        for (unsigned i = 1; i <= numSCOs; ++i)
+        {
+            CachedSCOPtr sco = scoCache_->findSCO(nspace,
+                                                  ClusterLocation(i).sco());
+            ASSERT_TRUE(sco != nullptr);
+            scoCache_->signalSCOAccessed(sco, i);
+        }
+
+        scoCache_->cleanup();
+
+        const SCOAccessData::VectorType v(check());
+
+        std::map<SCO, float> xvals(v.begin(), v.end());
+        for (unsigned i = 2; i <= numSCOs; ++i)
+        {
+            EXPECT_LT(xvals[ClusterLocation(i - 1).sco()],
+                      xvals[ClusterLocation(i).sco()]);
+        }
+    }
+}
+
 TEST_F(SCOCacheTest, namespaceChoking)
 {
     unsigned min_scos = mpSizeSCO_;
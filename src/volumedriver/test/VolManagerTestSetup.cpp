@@ -1726,8 +1726,15 @@ void
 VolManagerTestSetup::waitForPrefetching(Volume& v) const
 {
     PrefetchData& pd = v.getPrefetchData();
-    while (!pd.scos.empty())
+    while (true)
     {
+        {
+            boost::lock_guard<boost::mutex> g(pd.mut);
+            if (pd.scos.empty() and pd.inflight_ == 0)
+            {
+                break;
+            }
+        }
         sleep(1);
     }
     // Y42 Do an extra sleep here because the queue might be empty but there could